@@ -0,0 +1,119 @@
+#ifndef __CLUSTERED_SH__
+#define __CLUSTERED_SH__
+
+#include "shadows.sh"
+
+// light data written by LightClusters, every buffer is laid out in rows of 1024 texels
+#define CLUSTER_TEXTURE_WIDTH 1024.0
+#define CLUSTER_MAX_LIGHTS 256
+#define CLUSTER_MAX_DIRECTIONAL 4
+
+#define LIGHT_TYPE_SPOT 2.0
+
+uniform vec4 u_clusterGrid;     // clusters x, y, z, directional light count
+uniform vec4 u_clusterDepth;    // slice scale, slice bias, ambient
+uniform vec4 u_clusterTextures; // rows of the light, grid and index textures
+
+SAMPLER2D(s_lightData, 4);
+SAMPLER2D(s_lightGrid, 5);
+SAMPLER2D(s_lightIndices, 6);
+
+vec2 clusterTexel(float _index, float _rows)
+{
+    float row = floor(_index / CLUSTER_TEXTURE_WIDTH);
+    float column = _index - row * CLUSTER_TEXTURE_WIDTH;
+    return (vec2(column, row) + 0.5) / vec2(CLUSTER_TEXTURE_WIDTH, _rows);
+}
+
+vec4 fetchLight(float _light, float _texel)
+{
+    return texture2DLod(s_lightData, clusterTexel(_light * 4.0 + _texel, u_clusterTextures.x), 0.0);
+}
+
+// offset into the index list and light count of the cluster holding the world position
+vec2 fetchCluster(vec3 _worldPos)
+{
+    vec4 clip = mul(u_viewProj, vec4(_worldPos, 1.0));
+    vec2 ndc = clip.xy / clip.w;
+    float depth = max(-mul(u_view, vec4(_worldPos, 1.0)).z, 0.0001);
+
+    vec2 tile = clamp(floor((ndc * 0.5 + 0.5) * u_clusterGrid.xy), vec2(0.0, 0.0), u_clusterGrid.xy - 1.0);
+    float slice = clamp(floor(log(depth) * u_clusterDepth.x + u_clusterDepth.y), 0.0, u_clusterGrid.z - 1.0);
+    float cell = (slice * u_clusterGrid.y + tile.y) * u_clusterGrid.x + tile.x;
+
+    return texture2DLod(s_lightGrid, clusterTexel(cell, u_clusterTextures.y), 0.0).xy;
+}
+
+vec3 shadeLight(vec3 _radiance, vec3 _lightDir, vec3 _normal, vec3 _viewDir, vec3 _albedo, float _roughness)
+{
+    float ndotl = max(dot(_normal, _lightDir), 0.0);
+    vec3 halfDir = normalize(_lightDir + _viewDir);
+    float shininess = exp2(10.0 * (1.0 - _roughness) + 1.0);
+    float specular = pow(max(dot(_normal, halfDir), 0.0), shininess) * (1.0 - _roughness);
+    return _radiance * ndotl * (_albedo + specular);
+}
+
+vec3 shadeLocalLight(float _light, vec3 _worldPos, vec3 _normal, vec3 _viewDir, vec3 _albedo, float _roughness)
+{
+    vec4 positionRange = fetchLight(_light, 0.0);
+    vec4 colorIntensity = fetchLight(_light, 1.0);
+
+    vec3 toLight = positionRange.xyz - _worldPos;
+    float distanceSq = dot(toLight, toLight);
+    vec3 lightDir = toLight * inversesqrt(max(distanceSq, 0.0001));
+
+    // inverse square falloff windowed to reach zero at the range
+    float ratio = distanceSq / (positionRange.w * positionRange.w);
+    float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+    float attenuation = window * window / max(distanceSq, 0.01);
+
+    vec4 typeParams = fetchLight(_light, 3.0);
+    if (typeParams.y == LIGHT_TYPE_SPOT) {
+        vec4 directionSpot = fetchLight(_light, 2.0);
+        float cosAngle = dot(-lightDir, directionSpot.xyz);
+        attenuation *= clamp((cosAngle - typeParams.x) / max(directionSpot.w, 0.0001), 0.0, 1.0);
+    }
+
+    return shadeLight(colorIntensity.rgb * colorIntensity.a * attenuation, lightDir, _normal, _viewDir, _albedo,
+                      _roughness);
+}
+
+vec3 shadeClustered(vec3 _worldPos, vec3 _normal, vec3 _albedo, float _roughness)
+{
+    vec3 cameraPos = mul(u_invView, vec4(0.0, 0.0, 0.0, 1.0)).xyz;
+    vec3 viewDir = normalize(cameraPos - _worldPos);
+    vec3 color = _albedo * u_clusterDepth.z;
+
+    if (u_clusterGrid.x <= 0.0) {
+        return color;
+    }
+
+    for (int i = 0; i < CLUSTER_MAX_DIRECTIONAL; ++i) {
+        if (float(i) >= u_clusterGrid.w) {
+            break;
+        }
+
+        vec4 colorIntensity = fetchLight(float(i), 1.0);
+        vec4 directionSpot = fetchLight(float(i), 2.0);
+        vec4 typeParams = fetchLight(float(i), 3.0);
+
+        // the shadow casting light is flagged in the type texel
+        float shadow = typeParams.z > 0.5 ? shadowVisibility(_worldPos, _normal) : 1.0;
+        color += shadeLight(colorIntensity.rgb * colorIntensity.a * shadow, -directionSpot.xyz, _normal, viewDir,
+                            _albedo, _roughness);
+    }
+
+    vec2 cluster = fetchCluster(_worldPos);
+    for (int j = 0; j < CLUSTER_MAX_LIGHTS; ++j) {
+        if (float(j) >= cluster.y) {
+            break;
+        }
+
+        float light = texture2DLod(s_lightIndices, clusterTexel(cluster.x + float(j), u_clusterTextures.z), 0.0).x;
+        color += shadeLocalLight(light, _worldPos, _normal, viewDir, _albedo, _roughness);
+    }
+
+    return color;
+}
+
+#endif // __CLUSTERED_SH__
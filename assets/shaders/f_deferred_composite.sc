@@ -0,0 +1,9 @@
+$input v_position, v_texcoord0
+
+#include <bgfx_shader.sh>
+
+SAMPLER2D(s_lightAccum, 0);
+
+void main() {
+    gl_FragColor = texture2D(s_lightAccum, v_texcoord0);
+}
@@ -0,0 +1,33 @@
+$input v_position, v_texcoord0
+
+#include <bgfx_shader.sh>
+#include <bgfx_compute.sh>
+#include "shaderlib.sh"
+#include "clustered.sh"
+
+uniform vec4 u_deferredParams; // homogeneous depth, origin bottom left
+
+SAMPLER2D(s_gbufferAlbedo, 0);
+SAMPLER2D(s_gbufferNormal, 1);
+SAMPLER2D(s_gbufferEmissive, 2);
+SAMPLER2D(s_gbufferDepth, 3);
+
+void main() {
+    float depth = texture2D(s_gbufferDepth, v_texcoord0).x;
+    // nothing was drawn here, the clear color stays
+    if (depth >= 1.0) {
+        discard;
+    }
+
+    vec4 albedoRoughness = texture2D(s_gbufferAlbedo, v_texcoord0);
+    vec4 normalMetallic = texture2D(s_gbufferNormal, v_texcoord0);
+    vec3 emissive = texture2D(s_gbufferEmissive, v_texcoord0).rgb;
+
+    float ndcDepth = u_deferredParams.x > 0.5 ? depth * 2.0 - 1.0 : depth;
+    vec4 worldPos = mul(u_invViewProj, vec4(v_position.xy, ndcDepth, 1.0));
+    worldPos.xyz /= worldPos.w;
+    vec3 normal = normalize(normalMetallic.xyz * 2.0 - 1.0);
+
+    vec3 color = shadeClustered(worldPos.xyz, normal, albedoRoughness.rgb, albedoRoughness.a);
+    gl_FragColor = vec4(color + emissive, 1.0);
+}
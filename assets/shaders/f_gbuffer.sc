@@ -0,0 +1,17 @@
+$input v_position, v_normal, v_color0
+
+#include <bgfx_shader.sh>
+
+uniform vec4 u_baseColor;
+uniform vec4 u_emissive;
+uniform vec4 u_materialParams; // metallic, roughness
+
+// albedo and roughness, normal and metallic, emissive
+void main() {
+    vec4 baseColor = u_baseColor * v_color0;
+    vec3 albedo = baseColor.rgb * (1.0 - u_materialParams.x * 0.9);
+
+    gl_FragData[0] = vec4(albedo, u_materialParams.y);
+    gl_FragData[1] = vec4(normalize(v_normal) * 0.5 + 0.5, u_materialParams.x);
+    gl_FragData[2] = vec4(u_emissive.rgb, 1.0);
+}
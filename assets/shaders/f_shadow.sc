@@ -0,0 +1,6 @@
+#include <bgfx_shader.sh>
+
+// depth only, the shadow atlases have no color attachment
+void main() {
+    gl_FragColor = vec4_splat(0.0);
+}
@@ -0,0 +1,19 @@
+$input v_position, v_normal, v_color0
+
+#include <bgfx_shader.sh>
+#include <bgfx_compute.sh>
+#include "shaderlib.sh"
+#include "clustered.sh"
+
+uniform vec4 u_baseColor;
+uniform vec4 u_emissive;
+uniform vec4 u_materialParams; // metallic, roughness
+
+void main() {
+    vec4 baseColor = u_baseColor * v_color0;
+    vec3 albedo = baseColor.rgb * (1.0 - u_materialParams.x * 0.9);
+    vec3 normal = normalize(v_normal);
+
+    vec3 color = shadeClustered(v_position, normal, albedo, u_materialParams.y);
+    gl_FragColor = vec4(color + u_emissive.rgb, baseColor.a);
+}
@@ -0,0 +1,16 @@
+#ifndef __POSITION_SH__
+#define __POSITION_SH__
+
+// the position math of the lit programs and of the depth only programs of their material. A prepass tested with
+// Equal only holds when both compute the same bits, so neither spells it out on its own
+vec4 modelToWorld(mat4 _model, vec3 _position)
+{
+    return mul(_model, vec4(_position, 1.0));
+}
+
+vec4 worldToClip(vec4 _worldPos)
+{
+    return mul(u_viewProj, _worldPos);
+}
+
+#endif // __POSITION_SH__
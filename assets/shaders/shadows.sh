@@ -0,0 +1,48 @@
+#ifndef __SHADOWS_SH__
+#define __SHADOWS_SH__
+
+// cascaded shadow maps written by ShadowMaps, static and dynamic casters live in separate atlases
+#define SHADOW_MAX_CASCADES 4
+
+uniform mat4 u_shadowMatrix[SHADOW_MAX_CASCADES];
+uniform vec4 u_shadowSplits;  // view depth every cascade ends at
+uniform vec4 u_shadowParams;  // cascade count, depth bias, atlas texel size
+uniform vec4 u_shadowOffsets; // world space normal offset of every cascade
+
+SAMPLER2DSHADOW(s_shadowStatic, 7);
+SAMPLER2DSHADOW(s_shadowDynamic, 8);
+
+float sampleShadowAtlases(vec3 _coord)
+{
+    return min(shadow2D(s_shadowStatic, _coord), shadow2D(s_shadowDynamic, _coord));
+}
+
+float shadowVisibility(vec3 _worldPos, vec3 _normal)
+{
+    if (u_shadowParams.x <= 0.0) {
+        return 1.0;
+    }
+
+    float depth = -mul(u_view, vec4(_worldPos, 1.0)).z;
+    float cascade = dot(step(u_shadowSplits, vec4_splat(depth)), vec4_splat(1.0));
+    if (cascade >= u_shadowParams.x) {
+        return 1.0;
+    }
+
+    int index = int(cascade);
+    vec4 offsets = u_shadowOffsets;
+    float offset = index == 0 ? offsets.x : (index == 1 ? offsets.y : (index == 2 ? offsets.z : offsets.w));
+
+    vec4 coord = mul(u_shadowMatrix[index], vec4(_worldPos + _normal * offset, 1.0));
+    coord.z -= u_shadowParams.y;
+
+    // 2x2 taps spaced a texel apart, the compare samplers filter between them
+    vec2 texel = u_shadowParams.zw;
+    float visibility = sampleShadowAtlases(vec3(coord.xy + vec2(-0.5, -0.5) * texel, coord.z))
+                     + sampleShadowAtlases(vec3(coord.xy + vec2( 0.5, -0.5) * texel, coord.z))
+                     + sampleShadowAtlases(vec3(coord.xy + vec2(-0.5,  0.5) * texel, coord.z))
+                     + sampleShadowAtlases(vec3(coord.xy + vec2( 0.5,  0.5) * texel, coord.z));
+    return visibility * 0.25;
+}
+
+#endif // __SHADOWS_SH__
@@ -0,0 +1,10 @@
+$input a_position
+
+#include <bgfx_shader.sh>
+#include "position.sh"
+
+// position only variant of the lit programs, for the depth prepass
+void main()
+{
+    gl_Position = worldToClip(modelToWorld(u_model[0], a_position.xyz));
+}
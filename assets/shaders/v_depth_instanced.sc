@@ -0,0 +1,11 @@
+$input a_position, i_data0, i_data1, i_data2, i_data3
+
+#include <bgfx_shader.sh>
+#include "position.sh"
+
+// position only variant of the instanced lit programs, for the depth prepass
+void main()
+{
+    mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+    gl_Position = worldToClip(modelToWorld(model, a_position.xyz));
+}
@@ -0,0 +1,18 @@
+$input a_position
+$output v_position, v_texcoord0
+
+#include <bgfx_shader.sh>
+
+uniform vec4 u_deferredParams; // homogeneous depth, origin bottom left
+
+// one triangle covering the viewport, the positions are already in clip space
+void main()
+{
+    gl_Position = vec4(a_position.xy, 0.0, 1.0);
+
+    v_position = vec3(a_position.xy, 0.0);
+    v_texcoord0 = a_position.xy * 0.5 + 0.5;
+    if (u_deferredParams.y < 0.5) {
+        v_texcoord0.y = 1.0 - v_texcoord0.y;
+    }
+}
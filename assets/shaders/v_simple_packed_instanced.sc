@@ -0,0 +1,23 @@
+$input a_position, a_normal, a_color0, i_data0, i_data1, i_data2, i_data3, i_data4
+$output v_color0
+
+#include <bgfx_shader.sh>
+#include <bgfx_compute.sh>
+#include "shaderlib.sh"
+#include "position.sh"
+
+void main()
+{
+    mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+    vec4 worldPos = modelToWorld(model, a_position.xyz);
+    gl_Position = worldToClip(worldPos);
+
+    vec3 localNormal = decodeNormalOctahedron(a_normal.xy * 0.5 + 0.5);
+    vec3 normal = normalize(mul(model, vec4(localNormal, 0.0)).xyz);
+    vec3 lightDir = normalize(vec3(0.5, 1.0, 0.5));
+    float ndotl = max(dot(normal, lightDir), 0.2);
+
+    vec4 baseColor = (a_color0.r + a_color0.g + a_color0.b > 0.001) ? a_color0 : vec4(1.0, 1.0, 1.0, 1.0);
+
+    v_color0 = vec4(ndotl, ndotl, ndotl, 1.0) * baseColor * i_data4;
+}
\ No newline at end of file
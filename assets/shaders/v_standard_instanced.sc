@@ -0,0 +1,20 @@
+$input a_position, a_normal, a_color0, i_data0, i_data1, i_data2, i_data3, i_data4
+$output v_position, v_normal, v_color0
+
+#include <bgfx_shader.sh>
+#include <bgfx_compute.sh>
+#include "shaderlib.sh"
+#include "position.sh"
+
+void main()
+{
+    mat4 model = mtxFromCols(i_data0, i_data1, i_data2, i_data3);
+    vec4 worldPos = modelToWorld(model, a_position.xyz);
+    gl_Position = worldToClip(worldPos);
+
+    vec4 baseColor = (a_color0.r + a_color0.g + a_color0.b > 0.001) ? a_color0 : vec4(1.0, 1.0, 1.0, 1.0);
+
+    v_position = worldPos.xyz;
+    v_normal = mul(model, vec4(a_normal, 0.0)).xyz;
+    v_color0 = baseColor * i_data4;
+}
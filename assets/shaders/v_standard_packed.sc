@@ -0,0 +1,22 @@
+$input a_position, a_normal, a_color0
+$output v_position, v_normal, v_color0
+
+#include <bgfx_shader.sh>
+#include <bgfx_compute.sh>
+#include "shaderlib.sh"
+#include "position.sh"
+
+uniform vec4 u_tint;
+
+void main()
+{
+    vec4 worldPos = modelToWorld(u_model[0], a_position.xyz);
+    gl_Position = worldToClip(worldPos);
+
+    vec3 localNormal = decodeNormalOctahedron(a_normal.xy * 0.5 + 0.5);
+    vec4 baseColor = (a_color0.r + a_color0.g + a_color0.b > 0.001) ? a_color0 : vec4(1.0, 1.0, 1.0, 1.0);
+
+    v_position = worldPos.xyz;
+    v_normal = mul(u_model[0], vec4(localNormal, 0.0)).xyz;
+    v_color0 = baseColor * u_tint;
+}
@@ -3,6 +3,11 @@ vec3 a_normal      : NORMAL;
 vec2 a_texcoord0   : TEXCOORD0;
 vec4 a_color0      : COLOR0;
 vec4 a_tangent     : TANGENT;
+vec4 i_data0       : TEXCOORD7;
+vec4 i_data1       : TEXCOORD6;
+vec4 i_data2       : TEXCOORD5;
+vec4 i_data3       : TEXCOORD4;
+vec4 i_data4       : TEXCOORD3;
 
 vec3 v_position    : TEXCOORD1;
 vec3 v_normal      : NORMAL;
@@ -0,0 +1,126 @@
+#include "benchmarks.hpp"
+#include "star/render/mesh_optimizer.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <random>
+#include <glm/glm.hpp>
+
+namespace star::bench {
+    namespace {
+        struct TestMesh {
+            const char *name;
+            std::vector<Vertex> vertices;
+            std::vector<uint16_t> indices;
+        };
+
+        TestMesh make_grid(const uint32_t size) {
+            TestMesh mesh{"grid"};
+            for (uint32_t y = 0; y <= size; ++y) {
+                for (uint32_t x = 0; x <= size; ++x) {
+                    mesh.vertices.push_back({
+                        glm::vec3(static_cast<float>(x), 0.0f, static_cast<float>(y)), glm::vec3(0.0f, 1.0f, 0.0f),
+                        glm::vec2(0.0f), glm::vec4(1.0f)
+                    });
+                }
+            }
+
+            for (uint32_t y = 0; y < size; ++y) {
+                for (uint32_t x = 0; x < size; ++x) {
+                    const auto i = static_cast<uint16_t>(y * (size + 1) + x);
+                    const auto below = static_cast<uint16_t>(i + size + 1);
+                    mesh.indices.insert(mesh.indices.end(), {i, below, static_cast<uint16_t>(i + 1)});
+                    mesh.indices.insert(mesh.indices.end(),
+                                        {static_cast<uint16_t>(i + 1), below, static_cast<uint16_t>(below + 1)});
+                }
+            }
+            return mesh;
+        }
+
+        TestMesh make_sphere(const uint32_t segments) {
+            TestMesh mesh{"sphere"};
+            const float pi = 3.14159265358979f;
+
+            for (uint32_t y = 0; y <= segments; ++y) {
+                const float phi = pi * static_cast<float>(y) / static_cast<float>(segments);
+                for (uint32_t x = 0; x <= segments; ++x) {
+                    const float theta = 2.0f * pi * static_cast<float>(x) / static_cast<float>(segments);
+                    const glm::vec3 position(std::sin(phi) * std::cos(theta), std::cos(phi),
+                                             std::sin(phi) * std::sin(theta));
+                    mesh.vertices.push_back({position, position, glm::vec2(0.0f), glm::vec4(1.0f)});
+                }
+            }
+
+            for (uint32_t y = 0; y < segments; ++y) {
+                for (uint32_t x = 0; x < segments; ++x) {
+                    const auto i = static_cast<uint16_t>(y * (segments + 1) + x);
+                    const auto next = static_cast<uint16_t>(i + segments + 1);
+                    mesh.indices.insert(mesh.indices.end(), {i, static_cast<uint16_t>(i + 1), next});
+                    mesh.indices.insert(mesh.indices.end(),
+                                        {static_cast<uint16_t>(i + 1), static_cast<uint16_t>(next + 1), next});
+                }
+            }
+            return mesh;
+        }
+
+        // what an importer that does not care about ordering tends to hand us
+        TestMesh shuffle_triangles(TestMesh mesh, const char *name) {
+            mesh.name = name;
+
+            const size_t triangle_count = mesh.indices.size() / 3;
+            std::vector<uint32_t> order(triangle_count);
+            for (uint32_t i = 0; i < triangle_count; ++i) {
+                order[i] = i;
+            }
+
+            std::mt19937 rng(1234);
+            std::shuffle(order.begin(), order.end(), rng);
+
+            std::vector<uint16_t> indices;
+            indices.reserve(mesh.indices.size());
+            for (const uint32_t triangle: order) {
+                indices.insert(indices.end(), mesh.indices.begin() + triangle * 3,
+                               mesh.indices.begin() + triangle * 3 + 3);
+            }
+
+            mesh.indices.swap(indices);
+            return mesh;
+        }
+    }
+
+    int run_acmr(const BenchmarkArgs &args) {
+        const uint32_t grid_size = args.get_uint("--grid", 150);
+        const uint32_t sphere_segments = args.get_uint("--segments", 128);
+        const uint32_t cache_size = args.get_uint("--cache", MeshOptimizer::k_cache_size);
+
+        std::vector<TestMesh> meshes;
+        meshes.push_back(make_grid(grid_size));
+        meshes.push_back(shuffle_triangles(make_grid(grid_size), "grid shuffled"));
+        meshes.push_back(make_sphere(sphere_segments));
+        meshes.push_back(shuffle_triangles(make_sphere(sphere_segments), "sphere shuffled"));
+
+        std::printf("acmr: FIFO cache of %u vertices\n", cache_size);
+        std::printf("%-18s %10s %10s %10s %10s %12s\n", "mesh", "triangles", "before", "cache", "full", "time ms");
+
+        for (auto &mesh: meshes) {
+            const float before = MeshOptimizer::compute_acmr(mesh.indices, mesh.vertices.size(), cache_size);
+
+            auto cache_indices = mesh.indices;
+            MeshOptimizer::optimize_vertex_cache(cache_indices, mesh.vertices.size(), nullptr, cache_size);
+            const float after_cache = MeshOptimizer::compute_acmr(cache_indices, mesh.vertices.size(), cache_size);
+
+            auto vertices = mesh.vertices;
+            auto indices = mesh.indices;
+            const auto start = std::chrono::steady_clock::now();
+            MeshOptimizer::optimize(vertices, indices);
+            const auto end = std::chrono::steady_clock::now();
+            const float after_full = MeshOptimizer::compute_acmr(indices, vertices.size(), cache_size);
+
+            std::printf("%-18s %10zu %10.3f %10.3f %10.3f %12.3f\n", mesh.name, mesh.indices.size() / 3, before,
+                        after_cache, after_full, std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        return 0;
+    }
+}
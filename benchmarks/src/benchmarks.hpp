@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace star::bench {
+    class BenchmarkArgs {
+    public:
+        BenchmarkArgs(int argc, const char *argv[], int first);
+
+        bool has_flag(std::string_view name) const;
+
+        uint32_t get_uint(std::string_view name, uint32_t default_value) const;
+
+        std::vector<uint32_t> get_uint_list(std::string_view name, const std::vector<uint32_t> &default_value) const;
+
+        std::string get_string(std::string_view name, std::string_view default_value) const;
+
+    private:
+        const std::string *find_value(std::string_view name) const;
+
+        std::vector<std::string> _args;
+    };
+
+    struct FrameStats {
+        double mean_ms{0.0};
+        double median_ms{0.0};
+        double p95_ms{0.0};
+        double p99_ms{0.0};
+        double min_ms{0.0};
+        double max_ms{0.0};
+    };
+
+    FrameStats compute_frame_stats(std::vector<double> samples_ms);
+
+    bool init_noop_renderer(uint32_t width, uint32_t height, uint16_t max_encoders);
+
+    void shutdown_renderer();
+
+    // operator new calls since the process started, counted by the replacements in main.cpp
+    uint64_t get_allocation_count();
+
+    // peak resident set size of the process, 0 where the platform does not report it
+    uint64_t get_peak_rss_bytes();
+
+    int run_encoding(const BenchmarkArgs &args);
+
+    int run_acmr(const BenchmarkArgs &args);
+
+    int run_scene(const BenchmarkArgs &args);
+}
@@ -0,0 +1,155 @@
+#include "benchmarks.hpp"
+#include "star/app/app.hpp"
+#include "star/scene/scene.hpp"
+#include "star/scene/camera.hpp"
+#include "star/scene/transform.hpp"
+#include "star/render/forward_renderer.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/mesh.hpp"
+#include "star/render/material.hpp"
+#include "star/render/render_chain.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <chrono>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+
+namespace star::bench {
+    namespace {
+        constexpr bgfx::ViewId k_view_id = 1;
+
+        std::vector<uint32_t> default_thread_counts() {
+            std::vector<uint32_t> counts;
+            const auto hardware = static_cast<uint32_t>(ThreadPool::get_hardware_thread_count());
+            for (uint32_t count = 1; count < hardware; count *= 2) {
+                counts.push_back(count);
+            }
+            counts.push_back(hardware);
+            return counts;
+        }
+
+        void populate_scene(Scene &scene, const uint32_t draw_count, const uint32_t mesh_count,
+                            const uint32_t material_count) {
+            std::vector<std::shared_ptr<Mesh> > meshes;
+            for (uint32_t i = 0; i < std::max(mesh_count, 1u); ++i) {
+                meshes.push_back(std::make_shared<Mesh>(
+                    i % 2 == 0 ? Mesh::create_cube(0.5f) : Mesh::create_sphere(0.25f, 8)));
+            }
+
+            std::vector<std::shared_ptr<Material> > materials;
+            for (uint32_t i = 0; i < std::max(material_count, 1u); ++i) {
+                auto material = std::make_shared<UnlitMaterial>();
+                material->set_color(glm::vec4(static_cast<float>(i % 7) / 7.0f, 0.5f, 1.0f, 1.0f));
+                materials.push_back(std::move(material));
+            }
+
+            const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(draw_count))));
+            for (uint32_t i = 0; i < draw_count; ++i) {
+                const auto entity = scene.create_entity();
+
+                auto &transform = scene.add_component<Transform>(entity);
+                transform.set_position(glm::vec3(
+                    static_cast<float>(i % side) - static_cast<float>(side) * 0.5f,
+                    static_cast<float>(i / side % side) - static_cast<float>(side) * 0.5f,
+                    static_cast<float>(i / (side * side)) + 2.0f));
+
+                auto &mesh_renderer = scene.add_component<MeshRenderer>(entity);
+                mesh_renderer.set_mesh(meshes[i % meshes.size()]);
+                mesh_renderer.set_material(materials[i * 7 % materials.size()]);
+            }
+        }
+    }
+
+    int run_encoding(const BenchmarkArgs &args) {
+        const uint32_t draw_count = args.get_uint("--draws", 20000);
+        const uint32_t mesh_count = args.get_uint("--meshes", 16);
+        const uint32_t material_count = args.get_uint("--materials", 32);
+        const uint32_t frame_count = std::max(args.get_uint("--frames", 200), 1u);
+        const uint32_t warmup_count = args.get_uint("--warmup", 20);
+        const bool instancing = args.has_flag("--instancing");
+        const auto thread_counts = args.get_uint_list("--threads", default_thread_counts());
+
+        uint32_t max_threads = 1;
+        for (const uint32_t count: thread_counts) {
+            max_threads = std::max(max_threads, count);
+        }
+
+        if (!init_noop_renderer(1280, 720, static_cast<uint16_t>(max_threads + 1))) {
+            return 1;
+        }
+
+        {
+            App app;
+            Scene scene;
+            scene.init(app);
+
+            Vertex::init();
+
+            const auto camera_entity = scene.create_entity();
+            auto &camera_transform = scene.add_component<Transform>(camera_entity);
+            camera_transform.set_position(glm::vec3(0.0f, 0.0f, -10.0f));
+            camera_transform.look_at(glm::vec3(0.0f));
+
+            auto &camera = scene.add_component<Camera>(camera_entity);
+            camera.set_perspective(60.0f, 0.1f, 1000.0f);
+
+            populate_scene(scene, draw_count, mesh_count, material_count);
+            scene.update(0.0f);
+
+            ForwardRenderer renderer;
+            renderer.init(scene, app);
+            renderer.set_camera(camera);
+            renderer.set_instancing_enabled(instancing);
+            renderer.render_reset(app.get_render_chain());
+            app.get_render_chain().compile(k_view_id, app.get_window().get_size());
+
+            std::printf("encoding: %u draws, %u meshes, %u materials, %u frames, instancing %s\n",
+                        draw_count, mesh_count, material_count, frame_count, instancing ? "on" : "off");
+            std::printf("%8s %12s %12s %12s %12s %10s %12s %12s\n", "threads", "mean ms", "median ms", "p95 ms",
+                        "ns/draw", "speedup", "binds", "skipped");
+
+            double baseline_ms = 0.0;
+            std::vector<double> samples;
+            samples.reserve(frame_count);
+
+            for (const uint32_t thread_count: thread_counts) {
+                renderer.set_encoder_thread_count(thread_count);
+                samples.clear();
+
+                for (uint32_t frame = 0; frame < warmup_count + frame_count; ++frame) {
+                    bgfx::Encoder *encoder = bgfx::begin();
+
+                    const auto start = std::chrono::steady_clock::now();
+                    renderer.render(renderer.get_view_id().value_or(k_view_id), encoder);
+                    const auto end = std::chrono::steady_clock::now();
+
+                    bgfx::end(encoder);
+                    bgfx::frame();
+
+                    if (frame >= warmup_count) {
+                        samples.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+                    }
+                }
+
+                const auto stats = compute_frame_stats(samples);
+                if (baseline_ms == 0.0) {
+                    baseline_ms = stats.median_ms;
+                }
+
+                const auto &encoder_stats = renderer.get_encoder_stats();
+                std::printf("%8u %12.3f %12.3f %12.3f %12.1f %9.2fx %12u %12u\n",
+                            renderer.get_encoder_thread_count(), stats.mean_ms, stats.median_ms, stats.p95_ms,
+                            draw_count > 0 ? stats.median_ms * 1e6 / draw_count : 0.0,
+                            stats.median_ms > 0.0 ? baseline_ms / stats.median_ms : 0.0,
+                            encoder_stats.issued, encoder_stats.skipped);
+            }
+
+            renderer.shutdown();
+            scene.get_registry().clear();
+            scene.shutdown();
+        }
+
+        shutdown_renderer();
+        return 0;
+    }
+}
@@ -0,0 +1,272 @@
+#include "benchmarks.hpp"
+#include "star/render/shader_registry.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <bgfx/bgfx.h>
+#include <spdlog/spdlog.h>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace {
+    std::atomic<uint64_t> g_allocation_count{0};
+
+    void *allocate(const std::size_t size, const std::size_t alignment) {
+        g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+
+        void *ptr = nullptr;
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            ptr = std::malloc(size == 0 ? 1 : size);
+        } else {
+#if defined(_WIN32)
+            ptr = _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+            // aligned_alloc wants the size to be a multiple of the alignment
+            const std::size_t rounded = (std::max<std::size_t>(size, 1) + alignment - 1) / alignment * alignment;
+            ptr = std::aligned_alloc(alignment, rounded);
+#endif
+        }
+
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+
+    void deallocate(void *ptr, const std::size_t alignment) noexcept {
+#if defined(_WIN32)
+        if (alignment > __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            _aligned_free(ptr);
+            return;
+        }
+#endif
+        std::free(ptr);
+    }
+}
+
+// every allocation of the process goes through these, the engine's included
+void *operator new(const std::size_t size) {
+    return allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void *operator new(const std::size_t size, const std::align_val_t alignment) {
+    return allocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    deallocate(ptr, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+}
+
+void operator delete(void *ptr, const std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr, std::size_t, const std::align_val_t alignment) noexcept {
+    deallocate(ptr, static_cast<std::size_t>(alignment));
+}
+
+namespace star::bench {
+    namespace {
+        struct Benchmark {
+            std::string_view name;
+            std::string_view description;
+            int (*run)(const BenchmarkArgs &args);
+        };
+
+        constexpr std::array k_benchmarks{
+            Benchmark{
+                "encoding", "ForwardRenderer draw submission scaling across encoder threads "
+                "[--draws N] [--meshes M] [--materials K] [--frames F] [--threads 1,2,4] [--instancing]",
+                run_encoding
+            },
+            Benchmark{
+                "acmr", "Vertex cache miss ratio before and after MeshOptimizer [--grid N] [--segments N] [--cache N]",
+                run_acmr
+            },
+            Benchmark{
+                "scene", "Scene update, forward rendering and bgfx::frame of a synthetic scene, reported as JSON "
+                "[--entities N] [--meshes M] [--materials K] [--cameras C] [--frames F] [--dynamic PERCENT] "
+                "[--threads T] [--output FILE]",
+                run_scene
+            },
+        };
+
+        void print_usage() {
+            std::printf("usage: star_engine_bench <benchmark> [options]\n\n");
+            for (const auto &benchmark: k_benchmarks) {
+                std::printf("  %-12.*s %.*s\n",
+                            static_cast<int>(benchmark.name.size()), benchmark.name.data(),
+                            static_cast<int>(benchmark.description.size()), benchmark.description.data());
+            }
+        }
+    }
+
+    BenchmarkArgs::BenchmarkArgs(const int argc, const char *argv[], const int first) {
+        for (int i = first; i < argc; ++i) {
+            _args.emplace_back(argv[i]);
+        }
+    }
+
+    bool BenchmarkArgs::has_flag(const std::string_view name) const {
+        return std::ranges::find(_args, name) != _args.end();
+    }
+
+    const std::string *BenchmarkArgs::find_value(const std::string_view name) const {
+        const auto it = std::ranges::find(_args, name);
+        if (it == _args.end() || it + 1 == _args.end()) {
+            return nullptr;
+        }
+        return &*(it + 1);
+    }
+
+    uint32_t BenchmarkArgs::get_uint(const std::string_view name, const uint32_t default_value) const {
+        const auto *value = find_value(name);
+        if (!value) {
+            return default_value;
+        }
+
+        uint32_t result = default_value;
+        if (std::from_chars(value->data(), value->data() + value->size(), result).ec != std::errc{}) {
+            spdlog::warn("Invalid value '{}' for {}, using {}", *value, name, default_value);
+            return default_value;
+        }
+        return result;
+    }
+
+    std::vector<uint32_t> BenchmarkArgs::get_uint_list(const std::string_view name,
+                                                       const std::vector<uint32_t> &default_value) const {
+        const auto *value = find_value(name);
+        if (!value) {
+            return default_value;
+        }
+
+        std::vector<uint32_t> result;
+        const char *begin = value->data();
+        const char *end = value->data() + value->size();
+        while (begin < end) {
+            uint32_t item = 0;
+            const auto [ptr, ec] = std::from_chars(begin, end, item);
+            if (ec != std::errc{}) {
+                spdlog::warn("Invalid list '{}' for {}, using defaults", *value, name);
+                return default_value;
+            }
+
+            result.push_back(item);
+            begin = ptr < end && *ptr == ',' ? ptr + 1 : ptr;
+        }
+        return result;
+    }
+
+    std::string BenchmarkArgs::get_string(const std::string_view name, const std::string_view default_value) const {
+        const auto *value = find_value(name);
+        return value ? *value : std::string(default_value);
+    }
+
+    FrameStats compute_frame_stats(std::vector<double> samples_ms) {
+        FrameStats stats;
+        if (samples_ms.empty()) {
+            return stats;
+        }
+
+        std::ranges::sort(samples_ms);
+
+        double total = 0.0;
+        for (const double sample: samples_ms) {
+            total += sample;
+        }
+
+        const auto percentile = [&samples_ms](const double p) {
+            const auto index = static_cast<size_t>(p * static_cast<double>(samples_ms.size() - 1) + 0.5);
+            return samples_ms[index];
+        };
+
+        stats.mean_ms = total / static_cast<double>(samples_ms.size());
+        stats.median_ms = percentile(0.5);
+        stats.p95_ms = percentile(0.95);
+        stats.p99_ms = percentile(0.99);
+        stats.min_ms = samples_ms.front();
+        stats.max_ms = samples_ms.back();
+        return stats;
+    }
+
+    bool init_noop_renderer(const uint32_t width, const uint32_t height, const uint16_t max_encoders) {
+        bgfx::Init init;
+        init.type = bgfx::RendererType::Noop;
+        init.resolution.width = width;
+        init.resolution.height = height;
+        init.resolution.reset = BGFX_RESET_NONE;
+        init.limits.maxEncoders = std::max(init.limits.maxEncoders, max_encoders);
+
+        if (!bgfx::init(init)) {
+            spdlog::error("Failed to initialize bgfx with the Noop renderer");
+            return false;
+        }
+        return true;
+    }
+
+    void shutdown_renderer() {
+        star::ShaderRegistry::get().shutdown();
+        bgfx::shutdown();
+    }
+
+    uint64_t get_allocation_count() {
+        return g_allocation_count.load(std::memory_order_relaxed);
+    }
+
+    uint64_t get_peak_rss_bytes() {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            return counters.PeakWorkingSetSize;
+        }
+        return 0;
+#else
+        rusage usage{};
+        if (getrusage(RUSAGE_SELF, &usage) != 0) {
+            return 0;
+        }
+#if defined(__APPLE__)
+        return static_cast<uint64_t>(usage.ru_maxrss);
+#else
+        // reported in kilobytes
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+#endif
+    }
+}
+
+int main(const int argc, const char *argv[]) {
+    using namespace star::bench;
+
+    if (argc < 2) {
+        print_usage();
+        return 1;
+    }
+
+    const std::string_view name = argv[1];
+    for (const auto &benchmark: k_benchmarks) {
+        if (benchmark.name == name) {
+            return benchmark.run(BenchmarkArgs(argc, argv, 2));
+        }
+    }
+
+    spdlog::error("Unknown benchmark '{}'", name);
+    print_usage();
+    return 1;
+}
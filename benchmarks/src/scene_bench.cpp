@@ -0,0 +1,248 @@
+#include "benchmarks.hpp"
+#include "star/app/app.hpp"
+#include "star/scene/scene.hpp"
+#include "star/scene/camera.hpp"
+#include "star/scene/transform.hpp"
+#include "star/render/forward_renderer.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/mesh.hpp"
+#include "star/render/material.hpp"
+#include "star/render/render_chain.hpp"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace star::bench {
+    namespace {
+        constexpr bgfx::ViewId k_first_view_id = 1;
+        constexpr float k_delta_time = 1.0f / 60.0f;
+
+        struct SceneConfig {
+            uint32_t entity_count{0};
+            uint32_t mesh_count{0};
+            uint32_t material_count{0};
+            uint32_t camera_count{0};
+            uint32_t frame_count{0};
+            uint32_t warmup_count{0};
+            uint32_t dynamic_percent{0};
+            uint32_t thread_count{0};
+        };
+
+        struct PhaseSamples {
+            std::vector<double> update_ms;
+            std::vector<double> render_ms;
+            std::vector<double> frame_ms;
+            std::vector<double> total_ms;
+        };
+
+        std::vector<Entity> populate_scene(Scene &scene, const SceneConfig &config) {
+            std::vector<std::shared_ptr<Mesh> > meshes;
+            for (uint32_t i = 0; i < std::max(config.mesh_count, 1u); ++i) {
+                meshes.push_back(std::make_shared<Mesh>(
+                    i % 2 == 0 ? Mesh::create_cube(0.5f) : Mesh::create_sphere(0.25f, 8)));
+            }
+
+            std::vector<std::shared_ptr<Material> > materials;
+            for (uint32_t i = 0; i < std::max(config.material_count, 1u); ++i) {
+                auto material = std::make_shared<UnlitMaterial>();
+                material->set_color(glm::vec4(static_cast<float>(i % 7) / 7.0f, 0.5f, 1.0f, 1.0f));
+                materials.push_back(std::move(material));
+            }
+
+            std::vector<Entity> dynamic_entities;
+            const auto side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<float>(config.entity_count))));
+            for (uint32_t i = 0; i < config.entity_count; ++i) {
+                const auto entity = scene.create_entity();
+
+                auto &transform = scene.add_component<Transform>(entity);
+                transform.set_position(glm::vec3(
+                    static_cast<float>(i % side) - static_cast<float>(side) * 0.5f,
+                    static_cast<float>(i / side % side) - static_cast<float>(side) * 0.5f,
+                    static_cast<float>(i / (side * side)) + 2.0f));
+
+                auto &mesh_renderer = scene.add_component<MeshRenderer>(entity);
+                mesh_renderer.set_mesh(meshes[i % meshes.size()]);
+                mesh_renderer.set_material(materials[i * 7 % materials.size()]);
+
+                if (i % 100 < config.dynamic_percent) {
+                    dynamic_entities.push_back(entity);
+                }
+            }
+            return dynamic_entities;
+        }
+
+        // cameras circle the grid so each of them sees it from another side
+        std::vector<Entity> create_cameras(Scene &scene, const SceneConfig &config) {
+            std::vector<Entity> cameras;
+            const float pi = 3.14159265358979f;
+
+            for (uint32_t i = 0; i < std::max(config.camera_count, 1u); ++i) {
+                const float angle = 2.0f * pi * static_cast<float>(i) / static_cast<float>(config.camera_count);
+                const auto entity = scene.create_entity();
+
+                auto &transform = scene.add_component<Transform>(entity);
+                transform.set_position(glm::vec3(std::sin(angle) * 10.0f, 0.0f, -std::cos(angle) * 10.0f));
+                transform.look_at(glm::vec3(0.0f));
+
+                auto &camera = scene.add_component<Camera>(entity);
+                camera.set_perspective(60.0f, 0.1f, 1000.0f);
+
+                auto &renderer = camera.add_component<ForwardRendererComponent>().get_renderer();
+                renderer.set_encoder_thread_count(config.thread_count);
+                cameras.push_back(entity);
+            }
+            return cameras;
+        }
+
+        void write_phase(std::FILE *file, const char *name, const std::vector<double> &samples, const bool last) {
+            const auto stats = compute_frame_stats(samples);
+            std::fprintf(file,
+                         "    \"%s\": {\"mean_ms\": %.4f, \"min_ms\": %.4f, \"p50_ms\": %.4f, \"p95_ms\": %.4f, "
+                         "\"p99_ms\": %.4f, \"max_ms\": %.4f}%s\n",
+                         name, stats.mean_ms, stats.min_ms, stats.median_ms, stats.p95_ms, stats.p99_ms, stats.max_ms,
+                         last ? "" : ",");
+        }
+
+        void write_report(std::FILE *file, const SceneConfig &config, const PhaseSamples &samples,
+                          const uint64_t draw_count, const uint64_t submit_count, const uint64_t allocation_count) {
+            const auto total = compute_frame_stats(samples.total_ms);
+            const double frames = static_cast<double>(std::max(config.frame_count, 1u));
+            const double draws_per_frame = static_cast<double>(draw_count) / frames;
+
+            std::fprintf(file, "{\n");
+            std::fprintf(file, "  \"benchmark\": \"scene\",\n");
+            std::fprintf(file,
+                         "  \"config\": {\"entities\": %u, \"meshes\": %u, \"materials\": %u, \"cameras\": %u, "
+                         "\"frames\": %u, \"warmup\": %u, \"dynamic_percent\": %u, \"threads\": %u},\n",
+                         config.entity_count, config.mesh_count, config.material_count, config.camera_count,
+                         config.frame_count, config.warmup_count, config.dynamic_percent, config.thread_count);
+            std::fprintf(file, "  \"draws_per_frame\": %.1f,\n", draws_per_frame);
+            std::fprintf(file, "  \"submits_per_frame\": %.1f,\n", static_cast<double>(submit_count) / frames);
+            std::fprintf(file, "  \"ns_per_draw\": %.2f,\n",
+                         draws_per_frame > 0.0 ? total.median_ms * 1e6 / draws_per_frame : 0.0);
+            std::fprintf(file, "  \"allocations_per_frame\": %.2f,\n", static_cast<double>(allocation_count) / frames);
+            std::fprintf(file, "  \"peak_rss_bytes\": %llu,\n", static_cast<unsigned long long>(get_peak_rss_bytes()));
+            std::fprintf(file, "  \"frame_time\": {\n");
+            write_phase(file, "total", samples.total_ms, false);
+            write_phase(file, "update", samples.update_ms, false);
+            write_phase(file, "render", samples.render_ms, false);
+            write_phase(file, "frame", samples.frame_ms, true);
+            std::fprintf(file, "  }\n");
+            std::fprintf(file, "}\n");
+        }
+    }
+
+    int run_scene(const BenchmarkArgs &args) {
+        SceneConfig config;
+        config.entity_count = args.get_uint("--entities", 10000);
+        config.mesh_count = args.get_uint("--meshes", 16);
+        config.material_count = args.get_uint("--materials", 32);
+        config.camera_count = std::max(args.get_uint("--cameras", 1), 1u);
+        config.frame_count = std::max(args.get_uint("--frames", 300), 1u);
+        config.warmup_count = args.get_uint("--warmup", 30);
+        config.dynamic_percent = std::min(args.get_uint("--dynamic", 10), 100u);
+        config.thread_count = std::max(args.get_uint("--threads", 1), 1u);
+        const std::string output = args.get_string("--output", "");
+
+        // keeps the report on stdout parseable
+        if (output.empty()) {
+            spdlog::set_default_logger(spdlog::stderr_color_mt("scene_bench"));
+        }
+
+        if (!init_noop_renderer(1280, 720, static_cast<uint16_t>(config.thread_count + 1))) {
+            return 1;
+        }
+
+        PhaseSamples samples;
+        samples.update_ms.reserve(config.frame_count);
+        samples.render_ms.reserve(config.frame_count);
+        samples.frame_ms.reserve(config.frame_count);
+        samples.total_ms.reserve(config.frame_count);
+
+        uint64_t draw_count = 0;
+        uint64_t submit_count = 0;
+        uint64_t allocation_count = 0;
+
+        {
+            App app;
+            Scene scene;
+            scene.init(app);
+
+            Vertex::init();
+
+            const auto dynamic_entities = populate_scene(scene, config);
+            std::vector<const ForwardRenderer *> renderers;
+            for (const Entity entity: create_cameras(scene, config)) {
+                auto &camera = *scene.get_component<Camera>(entity);
+                camera.render_reset(app.get_render_chain());
+                renderers.push_back(&camera.get_component<ForwardRendererComponent>()->get_renderer());
+            }
+            app.get_render_chain().compile(k_first_view_id, app.get_window().get_size());
+
+            using Clock = std::chrono::steady_clock;
+            const auto elapsed_ms = [](const Clock::time_point begin, const Clock::time_point end) {
+                return std::chrono::duration<double, std::milli>(end - begin).count();
+            };
+
+            for (uint32_t frame = 0; frame < config.warmup_count + config.frame_count; ++frame) {
+                const bool measured = frame >= config.warmup_count;
+                const uint64_t allocations_before = get_allocation_count();
+
+                const auto start = Clock::now();
+
+                const float offset = std::sin(static_cast<float>(frame) * k_delta_time) * k_delta_time;
+                for (const Entity entity: dynamic_entities) {
+                    auto &transform = *scene.get_component<Transform>(entity);
+                    transform.set_position(transform.get_position() + glm::vec3(0.0f, offset, 0.0f));
+                }
+                scene.update(k_delta_time);
+                const auto updated = Clock::now();
+
+                scene.render();
+                const auto rendered = Clock::now();
+
+                bgfx::frame();
+                const auto end = Clock::now();
+
+                if (!measured) {
+                    continue;
+                }
+
+                allocation_count += get_allocation_count() - allocations_before;
+                samples.update_ms.push_back(elapsed_ms(start, updated));
+                samples.render_ms.push_back(elapsed_ms(updated, rendered));
+                samples.frame_ms.push_back(elapsed_ms(rendered, end));
+                samples.total_ms.push_back(elapsed_ms(start, end));
+
+                for (const ForwardRenderer *renderer: renderers) {
+                    draw_count += renderer->get_draw_bucket().size();
+                    submit_count += renderer->get_encoder_stats().submits;
+                }
+            }
+
+            scene.get_registry().clear();
+            scene.shutdown();
+        }
+
+        shutdown_renderer();
+
+        std::FILE *file = stdout;
+        if (!output.empty()) {
+            file = std::fopen(output.c_str(), "w");
+            if (!file) {
+                spdlog::error("Failed to open '{}' for writing", output);
+                return 1;
+            }
+        }
+
+        write_report(file, config, samples, draw_count, submit_count, allocation_count);
+
+        if (file != stdout) {
+            std::fclose(file);
+        }
+        return 0;
+    }
+}
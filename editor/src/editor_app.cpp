@@ -7,6 +7,7 @@
 #include "star/app/imgui_component.hpp"
 #include "star/scene/transform.hpp"
 #include "star/render/forward_renderer.hpp"
+#include "star/render/render_chain.hpp"
 #include "star/render/scene_renderer.hpp"
 #include <imgui.h>
 #include <imgui_internal.h>
@@ -14,6 +15,7 @@
 
 #include "star/render/mesh.hpp"
 #include "star/render/renderer_components.hpp"
+#include "star/render/mesh_cache.hpp"
 
 namespace star::editor {
     EditorApp::EditorApp(App &app)
@@ -55,6 +57,7 @@ namespace star::editor {
 
     void EditorApp::shutdown() {
         spdlog::info("Shutting down Star Engine Editor");
+        _app.get_render_chain().remove_views(this);
         _panels.clear();
     }
 
@@ -72,7 +75,7 @@ namespace star::editor {
     void EditorApp::render() const {
     }
 
-    bgfx::ViewId EditorApp::render_reset(const bgfx::ViewId viewId) {
+    void EditorApp::render_reset(RenderChain &chain) {
         ViewportPanel *viewport_panel = nullptr;
         for (const auto &panel: _panels) {
             if (panel->get_name() == "Viewport") {
@@ -81,35 +84,32 @@ namespace star::editor {
             }
         }
 
-        if (viewport_panel && bgfx::isValid(viewport_panel->get_framebuffer())) {
-            if (_editor_camera_entity != entt::null) {
-                const Camera *camera = _active_scene->get_component<Camera>(_editor_camera_entity);
-
-                const auto camera_view_id = viewId;
+        if (!viewport_panel || !bgfx::isValid(viewport_panel->get_framebuffer()) ||
+            _editor_camera_entity == entt::null) {
+            return;
+        }
 
-                bgfx::setViewName(camera_view_id, "Editor Viewport");
-                bgfx::setViewFrameBuffer(camera_view_id, viewport_panel->get_framebuffer());
-                bgfx::setViewRect(camera_view_id, 0, 0,
-                                  static_cast<uint16_t>(viewport_panel->get_width()),
-                                  static_cast<uint16_t>(viewport_panel->get_height()));
-                bgfx::setViewClear(camera_view_id,
-                                   BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH,
-                                   0x303030ff, 1.0f, 0);
+        // the panel keeps the view following its target between resets
+        chain.add_view("Editor Viewport", this, [this, viewport_panel](const bgfx::ViewId view_id) {
+            const Camera *camera = _active_scene->get_component<Camera>(_editor_camera_entity);
 
-                const auto &transform = _active_scene->get_component<Transform>(_editor_camera_entity);
-                const glm::mat4 view = camera->get_view_matrix();
-                const glm::mat4 proj = camera->get_projection_matrix();
-                bgfx::setViewTransform(camera_view_id, &view[0][0], &proj[0][0]);
+            bgfx::setViewName(view_id, "Editor Viewport");
+            bgfx::setViewFrameBuffer(view_id, viewport_panel->get_framebuffer());
+            bgfx::setViewRect(view_id, 0, 0,
+                              static_cast<uint16_t>(viewport_panel->get_width()),
+                              static_cast<uint16_t>(viewport_panel->get_height()));
+            bgfx::setViewClear(view_id,
+                               BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH,
+                               0x303030ff, 1.0f, 0);
 
-                viewport_panel->set_view_id(camera_view_id);
+            const glm::mat4 view = camera->get_view_matrix();
+            const glm::mat4 proj = camera->get_projection_matrix();
+            bgfx::setViewTransform(view_id, &view[0][0], &proj[0][0]);
 
-                camera->render();
+            viewport_panel->set_view_id(view_id);
 
-                return camera_view_id + 1;
-            }
-        }
-
-        return viewId;
+            camera->render();
+        });
     }
 
     void EditorApp::imgui_setup() {
@@ -193,13 +193,14 @@ namespace star::editor {
     void EditorApp::create_test_objects() const {
         Vertex::init();
 
+        auto &mesh_cache = _app.get_or_add_component<MeshCache>();
+
         const auto cube_entity = _active_scene->create_entity();
         auto &cube_transform = _active_scene->add_component<Transform>(cube_entity);
         cube_transform.set_position(glm::vec3(0.0f, 0.0f, 0.0f));
 
         auto &cube_renderer = _active_scene->add_component<MeshRenderer>(cube_entity);
-        Mesh cube_mesh = Mesh::create_cube(1.0f);
-        cube_renderer.set_mesh(std::move(cube_mesh));
+        cube_renderer.set_mesh(mesh_cache.get_cube(1.0f));
 
         // const auto cube_material = std::make_shared<UnlitMaterial>();
         // cube_material->set_color(glm::vec4(0.2f, 0.5f, 1.0f, 1.0f));
@@ -210,8 +211,7 @@ namespace star::editor {
         sphere_transform.set_position(glm::vec3(2.5f, 0.0f, 0.0f));
 
         auto &sphere_renderer = _active_scene->add_component<MeshRenderer>(sphere_entity);
-        Mesh sphere_mesh = Mesh::create_sphere(0.5f, 32);
-        sphere_renderer.set_mesh(std::move(sphere_mesh));
+        sphere_renderer.set_mesh(mesh_cache.get_sphere(0.5f, 32));
 
         const auto sphere_material = std::make_shared<UnlitMaterial>();
         sphere_material->set_color(glm::vec4(1.0f, 0.3f, 0.3f, 1.0f));
@@ -222,8 +222,7 @@ namespace star::editor {
         plane_transform.set_position(glm::vec3(0.0f, -1.0f, 0.0f));
 
         auto &plane_renderer = _active_scene->add_component<MeshRenderer>(plane_entity);
-        Mesh plane_mesh = Mesh::create_plane(10.0f, 10.0f);
-        plane_renderer.set_mesh(std::move(plane_mesh));
+        plane_renderer.set_mesh(mesh_cache.get_plane(10.0f, 10.0f));
 
         const auto plane_material = std::make_shared<UnlitMaterial>();
         plane_material->set_color(glm::vec4(0.3f, 0.3f, 0.3f, 1.0f));
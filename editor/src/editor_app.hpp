@@ -29,7 +29,7 @@ namespace star::editor {
 
         void render() const override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId viewId) override;
+        void render_reset(RenderChain &chain) override;
 
         void imgui_setup() override;
 
@@ -1,28 +1,85 @@
 #include "viewport_panel.hpp"
 #include "editor_context.hpp"
+#include "editor_app.hpp"
 #include <imgui.h>
 
 namespace star::editor
 {
+    namespace
+    {
+        constexpr uint64_t k_target_flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_UV_CLAMP | BGFX_SAMPLER_MIN_POINT |
+                                            BGFX_SAMPLER_MAG_POINT;
+    }
+
     ViewportPanel::ViewportPanel(EditorContext &context)
         : EditorPanel("Viewport", context), _view_id(0)
     {
-        _render_texture = BGFX_INVALID_HANDLE;
-        _framebuffer = BGFX_INVALID_HANDLE;
     }
 
     ViewportPanel::~ViewportPanel()
     {
-        if (bgfx::isValid(_framebuffer))
+        get_pool().release(_target);
+    }
+
+    void ViewportPanel::set_view_id(const bgfx::ViewId view_id)
+    {
+        _view_id = view_id;
+        _has_view = true;
+    }
+
+    bgfx::FrameBufferHandle ViewportPanel::get_framebuffer() const
+    {
+        return get_pool().get(_target).framebuffer;
+    }
+
+    RenderTargetPool &ViewportPanel::get_pool() const
+    {
+        return get_context().get_app()->get_app().get_render_target_pool();
+    }
+
+    void ViewportPanel::update_target(const uint32_t width, const uint32_t height)
+    {
+        auto &pool = get_pool();
+        const glm::uvec2 size{width, height};
+        const bool resized = width != _viewport_width || height != _viewport_height;
+        _settled_frames = resized ? 0 : _settled_frames + 1;
+
+        _viewport_width = width;
+        _viewport_height = height;
+
+        // while the panel is being dragged the larger target is drawn into through a sub-rect, it is only swapped
+        // for a smaller one once the size settled
+        bool reacquire = !pool.fits(_target, size, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8,
+                                    k_target_flags);
+        if (!reacquire && _settled_frames == k_settle_frames)
+        {
+            reacquire = pool.get(_target).size != RenderTargetPool::get_bucket_size(size);
+        }
+
+        if (reacquire)
         {
-            bgfx::destroy(_framebuffer);
+            pool.release(_target);
+            _target = pool.acquire(size, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8, k_target_flags);
         }
-        if (bgfx::isValid(_render_texture))
+
+        if (reacquire || resized)
         {
-            bgfx::destroy(_render_texture);
+            apply_view();
         }
     }
 
+    void ViewportPanel::apply_view() const
+    {
+        if (!_has_view)
+        {
+            return;
+        }
+
+        bgfx::setViewFrameBuffer(_view_id, get_framebuffer());
+        bgfx::setViewRect(_view_id, 0, 0, static_cast<uint16_t>(_viewport_width),
+                          static_cast<uint16_t>(_viewport_height));
+    }
+
     void ViewportPanel::on_imgui_render()
     {
         ImGui::PushStyleVar(ImGuiStyleVar_WindowPadding, ImVec2(0, 0));
@@ -40,39 +97,15 @@ namespace star::editor
 
         if (viewport_size.x > 0 && viewport_size.y > 0)
         {
-            const auto new_width = static_cast<uint32_t>(viewport_size.x);
-            const auto new_height = static_cast<uint32_t>(viewport_size.y);
-
-            if (!_texture_initialized || new_width != _viewport_width || new_height != _viewport_height)
-            {
-                _viewport_width = new_width;
-                _viewport_height = new_height;
-
-                if (bgfx::isValid(_framebuffer))
-                {
-                    bgfx::destroy(_framebuffer);
-                }
-                if (bgfx::isValid(_render_texture))
-                {
-                    bgfx::destroy(_render_texture);
-                }
-
-                _render_texture = bgfx::createTexture2D(
-                    static_cast<uint16_t>(_viewport_width),
-                    static_cast<uint16_t>(_viewport_height),
-                    false,
-                    1,
-                    bgfx::TextureFormat::RGBA8,
-                    BGFX_TEXTURE_RT | BGFX_SAMPLER_MIN_POINT | BGFX_SAMPLER_MAG_POINT);
-
-                _framebuffer = bgfx::createFrameBuffer(1, &_render_texture, true);
-
-                _texture_initialized = true;
-            }
+            update_target(static_cast<uint32_t>(viewport_size.x), static_cast<uint32_t>(viewport_size.y));
 
-            if (bgfx::isValid(_render_texture))
+            const auto &target = get_pool().get(_target);
+            if (target.is_valid())
             {
-                ImGui::Image(_render_texture.idx, viewport_size);
+                // only the top left part of the target holds the image
+                const ImVec2 uv1(static_cast<float>(_viewport_width) / static_cast<float>(target.size.x),
+                                 static_cast<float>(_viewport_height) / static_cast<float>(target.size.y));
+                ImGui::Image(target.color.idx, viewport_size, ImVec2(0, 0), uv1);
             }
         }
 
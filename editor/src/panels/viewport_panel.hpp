@@ -1,6 +1,7 @@
 #pragma once
 
 #include "editor_panel.hpp"
+#include "star/render/render_target_pool.hpp"
 #include <bgfx/bgfx.h>
 
 namespace star::editor
@@ -14,17 +15,24 @@ namespace star::editor
         void on_imgui_render() override;
 
         bgfx::ViewId get_view_id() const { return _view_id; }
-        void set_view_id(const bgfx::ViewId view_id) { _view_id = view_id; }
+        void set_view_id(bgfx::ViewId view_id);
 
-        bgfx::FrameBufferHandle get_framebuffer() const { return _framebuffer; }
+        bgfx::FrameBufferHandle get_framebuffer() const;
         uint32_t get_width() const { return _viewport_width; }
         uint32_t get_height() const { return _viewport_height; }
 
     private:
+        // frames the size has to stay the same before a smaller target replaces a larger one
+        static constexpr uint32_t k_settle_frames = 30;
+
+        RenderTargetPool &get_pool() const;
+        void update_target(uint32_t width, uint32_t height);
+        void apply_view() const;
+
         bgfx::ViewId _view_id;
-        bgfx::TextureHandle _render_texture;
-        bgfx::FrameBufferHandle _framebuffer;
-        bool _texture_initialized = false;
+        bool _has_view = false;
+        RenderTargetId _target;
+        uint32_t _settled_frames = 0;
         uint32_t _viewport_width = 0;
         uint32_t _viewport_height = 0;
     };
@@ -25,6 +25,17 @@ namespace star {
         bool use_fixed_time_step{false};
     };
 
+    struct STAR_EXPORT AppConfig {
+        // no window and no display needed, bgfx runs on the Noop renderer. Also enabled by --headless
+        bool headless{false};
+        // headless only, false skips the render calls while bgfx still flushes resource commands every tick
+        bool headless_render{true};
+        // headless only, updates per second each stepped by a whole tick, 0 runs them back to back
+        float tick_rate{60.0f};
+        // headless only, size reported by the window and used for the backbuffer
+        glm::uvec2 headless_size{1280, 720};
+    };
+
     class STAR_EXPORT IAppDelegate {
     public:
         virtual ~IAppDelegate() = default;
@@ -47,7 +58,9 @@ namespace star {
         virtual void render() const {
         }
 
-        virtual bgfx::ViewId render_reset(const bgfx::ViewId viewId) { return viewId; }
+        // adds the views of the delegate to the chain in front of the components', called on every render reset
+        virtual void render_reset(RenderChain &chain) {
+        }
     };
 
     class STAR_EXPORT IAppDelegateFactory {
@@ -102,6 +115,12 @@ namespace star {
 
         const AppUpdateConfig &get_update_config() const;
 
+        void set_config(const AppConfig &config);
+
+        const AppConfig &get_config() const;
+
+        bool is_headless() const;
+
         void set_clear_color(const glm::vec4 &color);
 
         const glm::vec4 &get_clear_color() const;
@@ -126,6 +145,14 @@ namespace star {
 
         const Window &get_window() const;
 
+        RenderChain &get_render_chain();
+
+        const RenderChain &get_render_chain() const;
+
+        RenderTargetPool &get_render_target_pool();
+
+        const RenderTargetPool &get_render_target_pool() const;
+
         void add_updater(std::unique_ptr<IAppUpdater> &&updater);
 
         void add_updater(IAppUpdater &updater);
@@ -147,6 +174,8 @@ namespace star {
 
         void update_frame(float delta_time);
 
+        void wait_for_tick(std::chrono::steady_clock::time_point &next_tick) const;
+
         void process_events();
 
         void render_reset();
@@ -158,9 +187,15 @@ namespace star {
         App &_app;
         std::unique_ptr<Window> _window;
         std::unique_ptr<Input> _input;
+        std::unique_ptr<RenderChain> _render_chain;
+        std::unique_ptr<RenderTargetPool> _render_target_pool;
+        // views handed out since the last render reset, only those can hold any state
+        bgfx::ViewId _view_count{0};
         bool _running{false};
         bool _paused{false};
         bool _render_reset{false};
+        // the backbuffer changed, the views stay and the chain only follows the new size
+        bool _backbuffer_reset{false};
         glm::uvec2 _render_size{1280, 720};
         VideoMode _video_mode;
         uint32_t _debug_flags{0};
@@ -170,6 +205,7 @@ namespace star {
         glm::vec4 _clear_color{0.3f, 0.3f, 0.3f, 1.0f};
         std::chrono::steady_clock::time_point _last_update{};
         AppUpdateConfig _update_config;
+        AppConfig _config;
         std::unique_ptr<IAppDelegate> _delegate;
         Components _components;
         Updaters _updaters;
@@ -204,6 +240,13 @@ namespace star {
 
         const AppUpdateConfig &get_update_config() const;
 
+        // has to be set before run, the delegate constructor is the last place to change it
+        void set_config(const AppConfig &config) const;
+
+        const AppConfig &get_config() const;
+
+        bool is_headless() const;
+
         void set_clear_color(const Vector4 &color);
 
         const Vector4 &get_clear_color() const;
@@ -242,6 +285,16 @@ namespace star {
 
         const Input &get_input() const;
 
+        // passes added here run after the delegate and components, in views following theirs
+        RenderChain &get_render_chain();
+
+        const RenderChain &get_render_chain() const;
+
+        // framebuffers shared by cameras and tools that render at their own size
+        RenderTargetPool &get_render_target_pool();
+
+        const RenderTargetPool &get_render_target_pool() const;
+
         AssetContext &get_assets();
 
         const AssetContext &get_assets() const;
@@ -27,7 +27,9 @@ namespace star {
         virtual size_t get_type_hash() const { return 0; }
         virtual std::string get_type_name() const { return "IAppComponent"; }
 
-        virtual bgfx::ViewId render_reset(const bgfx::ViewId viewId) { return viewId; }
+        // adds the views of the component to the chain, called on every render reset
+        virtual void render_reset(RenderChain &chain) {
+        }
     };
 
     template<typename T>
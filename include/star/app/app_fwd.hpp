@@ -12,6 +12,7 @@ namespace star {
     class Window;
     class AssetContext;
     class RenderChain;
+    class RenderTargetPool;
 
     class IAppComponent;
     class IAppDelegate;
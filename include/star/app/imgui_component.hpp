@@ -40,7 +40,7 @@ namespace star {
 
         void render() override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id) override;
+        void render_reset(RenderChain &chain) override;
 
         ImGuiContext *get_context() const;
 
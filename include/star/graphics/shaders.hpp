@@ -8,11 +8,113 @@
 #include <essl/v_simple.sc.bin.h>
 #include <spirv/v_simple.sc.bin.h>
 
+#include <glsl/v_simple_instanced.sc.bin.h>
+#include <essl/v_simple_instanced.sc.bin.h>
+#include <spirv/v_simple_instanced.sc.bin.h>
+
+#include <glsl/v_simple_packed.sc.bin.h>
+#include <essl/v_simple_packed.sc.bin.h>
+#include <spirv/v_simple_packed.sc.bin.h>
+
+#include <glsl/v_simple_packed_instanced.sc.bin.h>
+#include <essl/v_simple_packed_instanced.sc.bin.h>
+#include <spirv/v_simple_packed_instanced.sc.bin.h>
+
+#include <glsl/f_standard.sc.bin.h>
+#include <essl/f_standard.sc.bin.h>
+#include <spirv/f_standard.sc.bin.h>
+
+#include <glsl/v_standard.sc.bin.h>
+#include <essl/v_standard.sc.bin.h>
+#include <spirv/v_standard.sc.bin.h>
+
+#include <glsl/v_standard_instanced.sc.bin.h>
+#include <essl/v_standard_instanced.sc.bin.h>
+#include <spirv/v_standard_instanced.sc.bin.h>
+
+#include <glsl/v_standard_packed.sc.bin.h>
+#include <essl/v_standard_packed.sc.bin.h>
+#include <spirv/v_standard_packed.sc.bin.h>
+
+#include <glsl/v_standard_packed_instanced.sc.bin.h>
+#include <essl/v_standard_packed_instanced.sc.bin.h>
+#include <spirv/v_standard_packed_instanced.sc.bin.h>
+
+#include <glsl/f_shadow.sc.bin.h>
+#include <essl/f_shadow.sc.bin.h>
+#include <spirv/f_shadow.sc.bin.h>
+
+#include <glsl/v_shadow.sc.bin.h>
+#include <essl/v_shadow.sc.bin.h>
+#include <spirv/v_shadow.sc.bin.h>
+
+#include <glsl/v_shadow_instanced.sc.bin.h>
+#include <essl/v_shadow_instanced.sc.bin.h>
+#include <spirv/v_shadow_instanced.sc.bin.h>
+
+#include <glsl/v_depth.sc.bin.h>
+#include <essl/v_depth.sc.bin.h>
+#include <spirv/v_depth.sc.bin.h>
+
+#include <glsl/v_depth_instanced.sc.bin.h>
+#include <essl/v_depth_instanced.sc.bin.h>
+#include <spirv/v_depth_instanced.sc.bin.h>
+
+#include <glsl/f_gbuffer.sc.bin.h>
+#include <essl/f_gbuffer.sc.bin.h>
+#include <spirv/f_gbuffer.sc.bin.h>
+
+#include <glsl/v_fullscreen.sc.bin.h>
+#include <essl/v_fullscreen.sc.bin.h>
+#include <spirv/v_fullscreen.sc.bin.h>
+
+#include <glsl/f_deferred_light.sc.bin.h>
+#include <essl/f_deferred_light.sc.bin.h>
+#include <spirv/f_deferred_light.sc.bin.h>
+
+#include <glsl/f_deferred_composite.sc.bin.h>
+#include <essl/f_deferred_composite.sc.bin.h>
+#include <spirv/f_deferred_composite.sc.bin.h>
+
 #if defined(_WIN32)
 #include <dx10/f_simple.sc.bin.h>
 #include <dx10/v_simple.sc.bin.h>
 #include <dx11/f_simple.sc.bin.h>
 #include <dx11/v_simple.sc.bin.h>
+#include <dx10/v_simple_instanced.sc.bin.h>
+#include <dx11/v_simple_instanced.sc.bin.h>
+#include <dx10/v_simple_packed.sc.bin.h>
+#include <dx11/v_simple_packed.sc.bin.h>
+#include <dx10/v_simple_packed_instanced.sc.bin.h>
+#include <dx11/v_simple_packed_instanced.sc.bin.h>
+#include <dx10/f_standard.sc.bin.h>
+#include <dx11/f_standard.sc.bin.h>
+#include <dx10/v_standard.sc.bin.h>
+#include <dx11/v_standard.sc.bin.h>
+#include <dx10/v_standard_instanced.sc.bin.h>
+#include <dx11/v_standard_instanced.sc.bin.h>
+#include <dx10/v_standard_packed.sc.bin.h>
+#include <dx11/v_standard_packed.sc.bin.h>
+#include <dx10/v_standard_packed_instanced.sc.bin.h>
+#include <dx11/v_standard_packed_instanced.sc.bin.h>
+#include <dx10/f_shadow.sc.bin.h>
+#include <dx11/f_shadow.sc.bin.h>
+#include <dx10/v_shadow.sc.bin.h>
+#include <dx11/v_shadow.sc.bin.h>
+#include <dx10/v_shadow_instanced.sc.bin.h>
+#include <dx11/v_shadow_instanced.sc.bin.h>
+#include <dx10/v_depth.sc.bin.h>
+#include <dx11/v_depth.sc.bin.h>
+#include <dx10/v_depth_instanced.sc.bin.h>
+#include <dx11/v_depth_instanced.sc.bin.h>
+#include <dx10/f_gbuffer.sc.bin.h>
+#include <dx11/f_gbuffer.sc.bin.h>
+#include <dx10/v_fullscreen.sc.bin.h>
+#include <dx11/v_fullscreen.sc.bin.h>
+#include <dx10/f_deferred_light.sc.bin.h>
+#include <dx11/f_deferred_light.sc.bin.h>
+#include <dx10/f_deferred_composite.sc.bin.h>
+#include <dx11/f_deferred_composite.sc.bin.h>
 
 #include <glsl/f_imgui.sc.bin.h>
 #include <glsl/v_imgui.sc.bin.h>
@@ -28,6 +130,23 @@
 #if __APPLE__
 #include <mtl/f_simple.sc.bin.h>
 #include <mtl/v_simple.sc.bin.h>
+#include <mtl/v_simple_instanced.sc.bin.h>
+#include <mtl/v_simple_packed.sc.bin.h>
+#include <mtl/v_simple_packed_instanced.sc.bin.h>
+#include <mtl/f_standard.sc.bin.h>
+#include <mtl/v_standard.sc.bin.h>
+#include <mtl/v_standard_instanced.sc.bin.h>
+#include <mtl/v_standard_packed.sc.bin.h>
+#include <mtl/v_standard_packed_instanced.sc.bin.h>
+#include <mtl/f_shadow.sc.bin.h>
+#include <mtl/v_shadow.sc.bin.h>
+#include <mtl/v_shadow_instanced.sc.bin.h>
+#include <mtl/v_depth.sc.bin.h>
+#include <mtl/v_depth_instanced.sc.bin.h>
+#include <mtl/f_gbuffer.sc.bin.h>
+#include <mtl/v_fullscreen.sc.bin.h>
+#include <mtl/f_deferred_light.sc.bin.h>
+#include <mtl/f_deferred_composite.sc.bin.h>
 
 #include <mtl/f_imgui.sc.bin.h>
 #include <mtl/v_imgui.sc.bin.h>
@@ -36,6 +155,27 @@
 
 const bgfx::EmbeddedShader k_simple_vs = BGFX_EMBEDDED_SHADER(v_simple);
 const bgfx::EmbeddedShader k_simple_fs = BGFX_EMBEDDED_SHADER(f_simple);
+const bgfx::EmbeddedShader k_simple_instanced_vs = BGFX_EMBEDDED_SHADER(v_simple_instanced);
+const bgfx::EmbeddedShader k_simple_packed_vs = BGFX_EMBEDDED_SHADER(v_simple_packed);
+const bgfx::EmbeddedShader k_simple_packed_instanced_vs = BGFX_EMBEDDED_SHADER(v_simple_packed_instanced);
+
+const bgfx::EmbeddedShader k_standard_vs = BGFX_EMBEDDED_SHADER(v_standard);
+const bgfx::EmbeddedShader k_standard_fs = BGFX_EMBEDDED_SHADER(f_standard);
+const bgfx::EmbeddedShader k_standard_instanced_vs = BGFX_EMBEDDED_SHADER(v_standard_instanced);
+const bgfx::EmbeddedShader k_standard_packed_vs = BGFX_EMBEDDED_SHADER(v_standard_packed);
+const bgfx::EmbeddedShader k_standard_packed_instanced_vs = BGFX_EMBEDDED_SHADER(v_standard_packed_instanced);
+
+const bgfx::EmbeddedShader k_shadow_vs = BGFX_EMBEDDED_SHADER(v_shadow);
+const bgfx::EmbeddedShader k_shadow_fs = BGFX_EMBEDDED_SHADER(f_shadow);
+const bgfx::EmbeddedShader k_shadow_instanced_vs = BGFX_EMBEDDED_SHADER(v_shadow_instanced);
+
+const bgfx::EmbeddedShader k_depth_vs = BGFX_EMBEDDED_SHADER(v_depth);
+const bgfx::EmbeddedShader k_depth_instanced_vs = BGFX_EMBEDDED_SHADER(v_depth_instanced);
+
+const bgfx::EmbeddedShader k_gbuffer_fs = BGFX_EMBEDDED_SHADER(f_gbuffer);
+const bgfx::EmbeddedShader k_fullscreen_vs = BGFX_EMBEDDED_SHADER(v_fullscreen);
+const bgfx::EmbeddedShader k_deferred_light_fs = BGFX_EMBEDDED_SHADER(f_deferred_light);
+const bgfx::EmbeddedShader k_deferred_composite_fs = BGFX_EMBEDDED_SHADER(f_deferred_composite);
 
 const bgfx::EmbeddedShader k_imgui_fs = BGFX_EMBEDDED_SHADER(f_imgui);
 const bgfx::EmbeddedShader k_imgui_vs = BGFX_EMBEDDED_SHADER(v_imgui);
@@ -0,0 +1,188 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/renderer.hpp"
+#include "star/render/draw_bucket.hpp"
+#include "star/render/draw_collector.hpp"
+#include "star/render/encoder_state.hpp"
+#include "star/render/light_clusters.hpp"
+#include "star/render/shadow_maps.hpp"
+#include "star/render/material.hpp"
+#include "star/render/render_chain.hpp"
+#include "star/utils/memory/optional_ref.hpp"
+#include <array>
+#include <optional>
+#include <string>
+
+namespace star {
+    class Mesh;
+    class MeshRenderer;
+
+    enum class GBufferTarget : uint8_t {
+        // albedo and roughness
+        Albedo,
+        // world space normal and metallic
+        Normal,
+        Emissive,
+        Depth,
+        Count
+    };
+
+    enum class DeferredPass : uint8_t {
+        GBuffer,
+        Lighting,
+        // the draws outside the G-buffer, on top of the lit color
+        Forward,
+        Composite,
+        Count
+    };
+
+    // opaque StandardMaterial draws write their surface into a G-buffer and a fullscreen pass lights every pixel
+    // once with the clustered lights, so the lighting cost no longer grows with the overdraw. Every other draw,
+    // translucent ones included, is drawn forward on top against the G-buffer depth.
+    // The renderer draws through passes of the render chain, which allocates the targets as transients. Passes run
+    // after every view of the chain
+    class STAR_EXPORT DeferredRenderer final : public Renderer {
+    public:
+        DeferredRenderer();
+
+        ~DeferredRenderer() override;
+
+        void init(Scene &scene, App &app) override;
+
+        void shutdown() override;
+
+        void render(bgfx::ViewId view_id, bgfx::Encoder *encoder = nullptr) override;
+
+        void render_reset(RenderChain &chain) override;
+
+        RendererType get_renderer_type() const override { return RendererType::Deferred; }
+        std::string get_renderer_name() const override { return "DeferredRenderer"; }
+
+        // false when the backend lacks the attachments or render target formats the G-buffer needs
+        static bool is_supported();
+
+        bool is_valid() const;
+
+        void set_instancing_enabled(bool enabled);
+
+        bool is_instancing_enabled() const;
+
+        // bindings issued and skipped while encoding the last frame
+        const EncoderStats &get_encoder_stats() const { return _encoder_stats; }
+
+        // takes effect on the next init
+        void set_light_cluster_settings(const LightClusterSettings &settings);
+
+        const LightClusters &get_light_clusters() const { return _light_clusters; }
+
+        // takes effect on the next init
+        void set_shadow_settings(const ShadowSettings &settings);
+
+        ShadowMaps &get_shadow_maps() { return _shadow_maps; }
+
+        const ShadowMaps &get_shadow_maps() const { return _shadow_maps; }
+
+        // invalid until the chain compiled the passes of the first render_reset with a camera
+        bgfx::TextureHandle get_gbuffer_texture(GBufferTarget target) const;
+
+        // the size of the targets the last frame drew into
+        const glm::uvec2 &get_target_size() const { return _target_size; }
+
+        // assigned by the chain, get_view_id stays empty
+        std::optional<bgfx::ViewId> get_pass_view_id(DeferredPass pass) const;
+
+        const std::string &get_pass_name(DeferredPass pass) const;
+
+        // draws that went through the G-buffer and the forward pass in the last frame
+        uint32_t get_deferred_draw_count() const { return static_cast<uint32_t>(_deferred_bucket.size()); }
+
+        uint32_t get_forward_draw_count() const { return static_cast<uint32_t>(_forward_bucket.size()); }
+
+    private:
+        // follows the backbuffer unless the camera draws into a target of its own
+        RenderTargetDesc get_target_desc() const;
+
+        void add_passes(RenderChain &chain);
+
+        void remove_passes(RenderChain &chain);
+
+        void collect_draws();
+
+        void build_batches(const DrawBucket &bucket, bool deferred, std::vector<DrawBatch> &batches) const;
+
+        void submit_batches(bgfx::ViewId view_id, EncoderState &state, const DrawBucket &bucket,
+                            const std::vector<DrawBatch> &batches, bool deferred) const;
+
+        void submit_lighting(bgfx::ViewId view_id, EncoderState &state) const;
+
+        void submit_composite(bgfx::ViewId view_id, EncoderState &state) const;
+
+        DrawBucket _deferred_bucket;
+        DrawBucket _forward_bucket;
+        std::vector<DrawBatch> _deferred_batches;
+        std::vector<DrawBatch> _forward_batches;
+        DrawCollector _collector;
+        EncoderStats _encoder_stats;
+
+        LightClusters _light_clusters;
+        LightClusterSettings _light_cluster_settings;
+        ShadowMaps _shadow_maps;
+        ShadowSettings _shadow_settings;
+
+        // names in the chain, unique per renderer
+        std::string _prefix;
+        std::array<std::string, static_cast<size_t>(DeferredPass::Count)> _pass_names;
+        std::array<std::string, static_cast<size_t>(GBufferTarget::Count)> _gbuffer_names;
+        std::string _light_name;
+        // what the passes were set up with, a change sets them up again
+        RenderTargetDesc _target_desc;
+        uint32_t _clear_rgba{0};
+
+        // set by the setup of the passes, stay valid until the chain sets them up again
+        std::array<RenderResource, static_cast<size_t>(GBufferTarget::Count)> _gbuffer_resources{};
+        RenderResource _light_resource;
+
+        // read back from the chain every frame
+        glm::uvec2 _target_size{0};
+        std::array<bgfx::TextureHandle, static_cast<size_t>(GBufferTarget::Count)> _gbuffer_textures{};
+        bgfx::TextureHandle _light_texture{BGFX_INVALID_HANDLE};
+        bgfx::VertexBufferHandle _fullscreen_triangle{BGFX_INVALID_HANDLE};
+
+        // G-buffer programs of the StandardMaterial inputs, one per variant
+        std::array<Shader, static_cast<size_t>(ShaderVariant::Count)> _gbuffer_shaders;
+        Shader _lighting_shader;
+        Shader _composite_shader;
+
+        std::array<ShaderSampler, static_cast<size_t>(GBufferTarget::Count)> _gbuffer_samplers;
+        ShaderSampler _light_sampler;
+        ShaderUniform _params_uniform;
+
+        bool _instancing_enabled{true};
+    };
+
+    class STAR_EXPORT DeferredRendererComponent final : public ITypeCameraComponent<DeferredRendererComponent> {
+    public:
+        DeferredRendererComponent();
+
+        ~DeferredRendererComponent() override;
+
+        void init(Camera &camera, Scene &scene, App &app) override;
+
+        void shutdown() override;
+
+        void render() override;
+
+        void render_reset(RenderChain &chain) override;
+
+        DeferredRenderer &get_renderer();
+
+        const DeferredRenderer &get_renderer() const;
+
+    private:
+        std::unique_ptr<DeferredRenderer> _renderer;
+        OptionalRef<Camera> _camera;
+        OptionalRef<Scene> _scene;
+        OptionalRef<App> _app;
+    };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace star {
+    class Mesh;
+    class Material;
+
+    // 64-bit draw sort key. Opaque draws are grouped by state first and sorted front-to-back inside a group,
+    // translucent draws are sorted back-to-front first so blending stays correct.
+    //
+    // opaque:      layer:8 | translucent:1 | program:9 | material:14 | mesh:12 | depth:20
+    // translucent: layer:8 | translucent:1 | depth:20  | blend:2     | program:9 | material:14 | mesh:10
+    struct STAR_EXPORT DrawKey final {
+        static constexpr uint32_t k_layer_bits = 8;
+        static constexpr uint32_t k_blend_bits = 2;
+        static constexpr uint32_t k_program_bits = 9;
+        static constexpr uint32_t k_material_bits = 14;
+        static constexpr uint32_t k_mesh_bits = 12;
+        static constexpr uint32_t k_depth_bits = 20;
+
+        static constexpr uint32_t k_depth_max = (1u << k_depth_bits) - 1;
+
+        [[nodiscard]] static uint64_t make_opaque(uint8_t layer, uint32_t material_key, uint32_t mesh,
+                                                  float depth) noexcept;
+
+        [[nodiscard]] static uint64_t make_translucent(uint8_t layer, uint32_t material_key, uint32_t mesh,
+                                                       float depth) noexcept;
+
+        [[nodiscard]] static uint32_t make_material_key(uint32_t blend, uint32_t program, uint32_t material) noexcept;
+
+        [[nodiscard]] static bool is_translucent(uint64_t key) noexcept;
+
+        [[nodiscard]] static uint32_t quantize_depth(float depth) noexcept;
+    };
+
+    struct DrawCall {
+        const Mesh *mesh{nullptr};
+        const Material *material{nullptr};
+        glm::mat4 transform{1.0f};
+        glm::vec4 tint{1.0f};
+    };
+
+    struct DrawItem {
+        uint64_t key{0};
+        uint32_t index{0};
+    };
+
+    class STAR_EXPORT DrawBucket {
+    public:
+        DrawBucket();
+
+        ~DrawBucket();
+
+        void clear();
+
+        void reserve(size_t count);
+
+        void add(uint64_t key, const DrawCall &draw);
+
+        void sort();
+
+        bool empty() const;
+
+        size_t size() const;
+
+        std::span<const DrawItem> get_items() const;
+
+        const DrawCall &get_draw(const DrawItem &item) const;
+
+    private:
+        std::vector<DrawItem> _items;
+        std::vector<DrawItem> _scratch;
+        std::vector<DrawCall> _draws;
+    };
+}
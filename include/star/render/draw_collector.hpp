@@ -0,0 +1,93 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/draw_bucket.hpp"
+#include "star/render/material.hpp"
+#include "star/scene/bounds.hpp"
+#include "star/scene/entity_registry.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace star {
+    class Camera;
+    class MeshRenderer;
+    class Scene;
+
+    // a run of sorted draws sharing a mesh and a batch material, drawn one by one or as a single instanced submit
+    struct DrawBatch {
+        // per instance: model matrix columns followed by the tint, the layout the instanced programs read
+        static constexpr uint16_t k_instance_stride = sizeof(glm::mat4) + sizeof(glm::vec4);
+
+        uint32_t begin{0};
+        uint32_t end{0};
+        bool instanced{false};
+        bool prepass{false};
+        ShaderVariant variant{ShaderVariant::Default};
+        bgfx::InstanceDataBuffer instance_data{};
+    };
+
+    // the program variant a batch of the format is drawn with. Empty for an instanced batch the material has no
+    // instanced program for, and for packed meshes of a material without the packed programs, those draws are
+    // skipped and logged once
+    STAR_EXPORT std::optional<ShaderVariant> select_batch_variant(const Material &material, VertexFormat format,
+                                                                  bool instanced);
+
+    // the end of the run of draws from begin that can share a batch
+    STAR_EXPORT uint32_t find_batch_end(const DrawBucket &bucket, uint32_t begin);
+
+    // splits the draws of the batch into instanced batches as large as the instance data buffer allows. What does
+    // not fit is drawn one by one with the single variant. The instance data is allocated here, allocation is not
+    // safe to race from the encoder threads
+    STAR_EXPORT void add_instanced_batches(const DrawBatch &batch, ShaderVariant single_variant,
+                                           std::vector<DrawBatch> &batches);
+
+    STAR_EXPORT void write_instance_data(const DrawBucket &bucket, const DrawBatch &batch);
+
+    // the renderers a camera may draw this frame, with the level of detail every one of them is drawn with.
+    // Renderers keep one each, so every camera has its own level hysteresis
+    class STAR_EXPORT DrawCollector final {
+    public:
+        struct Candidate {
+            const MeshRenderer *renderer{nullptr};
+            // null for the static batches
+            Entity entity{entt::null};
+            glm::mat4 transform{1.0f};
+        };
+
+        // the visible renderers of the scene and of its static batches, culled by the filter of the camera
+        void collect(Scene &scene, const Camera *camera);
+
+        // the level of a candidate, close to its switch distance the level it was drawn with last frame is kept
+        uint32_t select_lod(uint32_t index, const Camera *camera);
+
+        // forgets the levels of entities that were destroyed or left the view long ago
+        void prune_lods();
+
+        void clear();
+
+        std::span<const Candidate> get_candidates() const { return _candidates; }
+
+        std::span<const BoundingSphere> get_bounds() const { return _bounds; }
+
+        // further culling clears the entries of the candidates it rejects
+        std::vector<uint8_t> &get_visible() { return _visible; }
+
+        const std::vector<uint8_t> &get_visible() const { return _visible; }
+
+    private:
+        struct LodState {
+            uint32_t lod{0};
+            uint32_t frame{0};
+        };
+
+        std::vector<Candidate> _candidates;
+        std::vector<BoundingSphere> _bounds;
+        std::vector<uint8_t> _visible;
+        std::unordered_map<Entity, LodState> _lod_states;
+        uint32_t _lod_frame{0};
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+
+namespace star {
+    struct STAR_EXPORT EncoderStats {
+        // state, texture and buffer bindings that reached the encoder, including the ones clearing a stale binding
+        uint32_t issued{0};
+        // bindings dropped because the encoder already held them
+        uint32_t skipped{0};
+        uint32_t submits{0};
+
+        EncoderStats &operator+=(const EncoderStats &other);
+    };
+
+    // tracks what a bgfx::Encoder has bound and drops repeated texture and buffer sets. Submits keep those
+    // bindings alive through the discard flags, bindings the next draw does not ask for are cleared before it is
+    // submitted. The render state and the uniforms are discarded with every submit, each draw sets them again.
+    // Lives for one stretch of recording on one encoder, everything is discarded when it goes away
+    class STAR_EXPORT EncoderState final {
+    public:
+        explicit EncoderState(bgfx::Encoder &encoder);
+
+        ~EncoderState();
+
+        EncoderState(const EncoderState &) = delete;
+
+        EncoderState &operator=(const EncoderState &) = delete;
+
+        bgfx::Encoder &get_encoder() const { return _encoder; }
+
+        // never skipped, the submit before discarded it
+        void set_state(uint64_t state, uint32_t rgba = 0);
+
+        void set_texture(uint8_t stage, bgfx::UniformHandle sampler, bgfx::TextureHandle texture,
+                         uint32_t flags = UINT32_MAX);
+
+        void set_vertex_buffer(uint8_t stream, bgfx::VertexBufferHandle handle, uint32_t start = 0,
+                               uint32_t count = UINT32_MAX);
+
+        void set_vertex_buffer(uint8_t stream, bgfx::DynamicVertexBufferHandle handle, uint32_t start = 0,
+                               uint32_t count = UINT32_MAX);
+
+        void set_vertex_buffer(uint8_t stream, const bgfx::TransientVertexBuffer *buffer, uint32_t start = 0,
+                               uint32_t count = UINT32_MAX);
+
+        void set_index_buffer(bgfx::IndexBufferHandle handle, uint32_t first = 0, uint32_t count = UINT32_MAX);
+
+        void set_index_buffer(bgfx::DynamicIndexBufferHandle handle, uint32_t first = 0, uint32_t count = UINT32_MAX);
+
+        void set_index_buffer(const bgfx::TransientIndexBuffer *buffer, uint32_t first = 0,
+                              uint32_t count = UINT32_MAX);
+
+        // read by the non-instanced engine shaders, the instanced ones take it from the instance data
+        void set_tint(const glm::vec4 &tint) { _tint = tint; }
+
+        const glm::vec4 &get_tint() const { return _tint; }
+
+        // the transform, instance data and tint belong to a single draw and are never carried over
+        void submit(bgfx::ViewId view_id, bgfx::ProgramHandle program, uint32_t depth = 0);
+
+        // forgets the tracked bindings and discards them on the encoder
+        void reset();
+
+        const EncoderStats &get_stats() const { return _stats; }
+
+    private:
+        enum class BufferKind : uint8_t {
+            None,
+            Static,
+            Dynamic,
+            Transient
+        };
+
+        struct BufferBinding {
+            BufferKind kind{BufferKind::None};
+            uint16_t handle{UINT16_MAX};
+            uint32_t start{0};
+            uint32_t count{0};
+
+            bool operator==(const BufferBinding &other) const = default;
+        };
+
+        struct TextureBinding {
+            uint16_t sampler{UINT16_MAX};
+            uint16_t texture{UINT16_MAX};
+            uint32_t flags{0};
+
+            bool operator==(const TextureBinding &other) const = default;
+        };
+
+        static constexpr uint8_t k_max_streams = 4;
+        static constexpr uint8_t k_max_textures = 16;
+
+        // true when the binding has to be issued
+        bool track(BufferBinding &bound, const BufferBinding &binding, bool &requested);
+
+        void clear_unrequested();
+
+        // sets a tracked binding again after the buffers were discarded
+        void rebind_stream(uint8_t stream);
+
+        void rebind_index();
+
+        bgfx::Encoder &_encoder;
+        EncoderStats _stats;
+
+        std::array<BufferBinding, k_max_streams> _streams{};
+        std::array<bool, k_max_streams> _streams_requested{};
+        BufferBinding _index;
+        bool _index_requested{false};
+
+        // transient buffers are only known by the struct the caller passed, a copy is kept to bind them again
+        std::array<bgfx::TransientVertexBuffer, k_max_streams> _transient_streams{};
+        bgfx::TransientIndexBuffer _transient_index{};
+
+        std::array<TextureBinding, k_max_textures> _textures{};
+        std::array<bool, k_max_textures> _textures_requested{};
+        bool _retained{false};
+        glm::vec4 _tint{1.0f};
+    };
+}
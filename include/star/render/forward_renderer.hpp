@@ -2,12 +2,28 @@
 
 #include "star/export.hpp"
 #include "star/render/renderer.hpp"
+#include "star/render/draw_bucket.hpp"
+#include "star/render/draw_collector.hpp"
+#include "star/render/encoder_state.hpp"
+#include "star/render/light_clusters.hpp"
+#include "star/render/occlusion_culler.hpp"
+#include "star/render/shadow_maps.hpp"
+#include "star/render/material.hpp"
 #include "star/utils/memory/optional_ref.hpp"
+#include "star/utils/thread_pool.hpp"
 
 namespace star {
     class Mesh;
     class Material;
     class Light;
+    class MeshRenderer;
+
+    enum class DepthPrepassMode {
+        Off,
+        On,
+        // on while the estimated overdraw of the opaque draws is above the threshold
+        Auto
+    };
 
     class STAR_EXPORT ForwardRenderer final : public Renderer {
     public:
@@ -21,10 +37,126 @@ namespace star {
 
         void render(bgfx::ViewId view_id, bgfx::Encoder *encoder = nullptr) override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id) override;
+        void render_reset(RenderChain &chain) override;
 
         RendererType get_renderer_type() const override { return RendererType::Forward; }
         std::string get_renderer_name() const override { return "ForwardRenderer"; }
+
+        const DrawBucket &get_draw_bucket() const { return _bucket; }
+
+        void set_instancing_enabled(bool enabled);
+
+        bool is_instancing_enabled() const;
+
+        // total number of threads encoding draws, including the calling one
+        void set_encoder_thread_count(uint32_t count);
+
+        uint32_t get_encoder_thread_count() const;
+
+        // bindings issued and skipped while encoding the last frame, summed over every encoder
+        const EncoderStats &get_encoder_stats() const { return _encoder_stats; }
+
+        // takes effect on the next init
+        void set_light_cluster_settings(const LightClusterSettings &settings);
+
+        const LightClusters &get_light_clusters() const { return _light_clusters; }
+
+        // takes effect on the next init
+        void set_shadow_settings(const ShadowSettings &settings);
+
+        ShadowMaps &get_shadow_maps() { return _shadow_maps; }
+
+        const ShadowMaps &get_shadow_maps() const { return _shadow_maps; }
+
+        // opaque draws lay down their depth with a position only program first, the lit pass then only shades the
+        // visible pixels
+        void set_depth_prepass_mode(DepthPrepassMode mode);
+
+        DepthPrepassMode get_depth_prepass_mode() const { return _prepass_mode; }
+
+        // overdraw the Auto mode switches the prepass on at, as summed screen coverage of the opaque draws
+        void set_depth_prepass_threshold(float threshold);
+
+        float get_depth_prepass_threshold() const { return _prepass_threshold; }
+
+        // depth test of the lit pass behind the prepass, Equal only holds when both programs transform alike
+        void set_depth_prepass_function(DepthFunc func);
+
+        DepthFunc get_depth_prepass_function() const { return _prepass_function; }
+
+        bool is_depth_prepass_active() const { return _prepass_active; }
+
+        // summed screen coverage of the opaque draws of the last frame
+        float get_estimated_overdraw() const { return _estimated_overdraw; }
+
+        // draws that passed the frustum test are tested against the largest draws visible in the last frame
+        void set_occlusion_culling_enabled(bool enabled);
+
+        bool is_occlusion_culling_enabled() const { return _occlusion_enabled; }
+
+        // takes effect on the next init
+        void set_occlusion_settings(const OcclusionSettings &settings);
+
+        const OcclusionCuller &get_occlusion_culler() const { return _occlusion_culler; }
+
+        // draws the occlusion test removed in the last frame
+        uint32_t get_occluded_count() const { return _occluded_count; }
+
+    private:
+        struct EncodeChunk {
+            uint32_t begin{0};
+            uint32_t end{0};
+            bool deferred{false};
+            EncoderStats stats;
+        };
+
+        void collect_draws();
+
+        void cull_occluded();
+
+        void build_light_clusters();
+
+        void build_batches();
+
+        void build_chunks(uint32_t max_chunks);
+
+        void update_depth_prepass();
+
+        void encode_parallel(bgfx::ViewId view_id, bgfx::Encoder &encoder);
+
+        void encode_batches(bgfx::ViewId view_id, bgfx::Encoder &encoder, EncodeChunk &chunk) const;
+
+        void submit_single(bgfx::ViewId view_id, EncoderState &state, const DrawBatch &batch) const;
+
+        void submit_instanced(bgfx::ViewId view_id, EncoderState &state, const DrawBatch &batch) const;
+
+        void submit_prepass(bgfx::ViewId view_id, EncoderState &state, const DrawBatch &batch) const;
+
+        DrawBucket _bucket;
+        DrawCollector _collector;
+        std::vector<DrawBatch> _batches;
+        std::vector<EncodeChunk> _chunks;
+        EncoderStats _encoder_stats;
+        LightClusters _light_clusters;
+        LightClusterSettings _light_cluster_settings;
+        ShadowMaps _shadow_maps;
+        ShadowSettings _shadow_settings;
+        std::optional<bgfx::ViewId> _prepass_view_id;
+        DepthPrepassMode _prepass_mode{DepthPrepassMode::Auto};
+        float _prepass_threshold{2.0f};
+        DepthFunc _prepass_function{DepthFunc::LessEqual};
+        float _estimated_overdraw{0.0f};
+        bool _prepass_active{false};
+        OcclusionCuller _occlusion_culler;
+        OcclusionSettings _occlusion_settings;
+        // renderers that passed every test in the last frame, sorted, the occluders are picked from them
+        std::vector<const MeshRenderer *> _occlusion_visible;
+        std::vector<std::pair<float, uint32_t>> _occluder_candidates;
+        uint32_t _occluded_count{0};
+        bool _occlusion_enabled{true};
+        std::unique_ptr<ThreadPool> _encoder_pool;
+        uint32_t _encoder_thread_count{1};
+        bool _instancing_enabled{true};
     };
 
     class STAR_EXPORT ForwardRendererComponent final : public ITypeCameraComponent<ForwardRendererComponent> {
@@ -39,7 +171,7 @@ namespace star {
 
         void render() override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id) override;
+        void render_reset(RenderChain &chain) override;
 
         ForwardRenderer &get_renderer();
 
@@ -50,6 +182,5 @@ namespace star {
         OptionalRef<Camera> _camera;
         OptionalRef<Scene> _scene;
         OptionalRef<App> _app;
-        std::optional<bgfx::ViewId> _view_id;
     };
 }
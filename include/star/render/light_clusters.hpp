@@ -0,0 +1,164 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/shader.hpp"
+#include "star/scene/entity_registry.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace star {
+    class EncoderState;
+    class ThreadPool;
+
+    struct LightClusterSettings {
+        uint32_t clusters_x{16};
+        uint32_t clusters_y{9};
+        // slices are spread logarithmically between the near and far clip
+        uint32_t clusters_z{24};
+        uint32_t max_lights{4096};
+        // ambient term of the lit shaders
+        float ambient{0.2f};
+    };
+
+    // splits the view frustum into froxels and lists the point and spot lights touching each of them, so the lit
+    // shaders only loop over the lights of the pixel's cluster. Light data, the per cluster offset and count grid
+    // and the packed light indices go to the GPU as float textures
+    class STAR_EXPORT LightClusters final {
+    public:
+        // shader side loop limits, the shaders hard code the same numbers
+        static constexpr uint32_t k_max_lights_per_cluster = 256;
+        static constexpr uint32_t k_max_directional_lights = 4;
+
+        LightClusters();
+
+        ~LightClusters();
+
+        LightClusters(const LightClusters &) = delete;
+
+        LightClusters &operator=(const LightClusters &) = delete;
+
+        bool init(const LightClusterSettings &settings = {});
+
+        void shutdown();
+
+        bool is_valid() const;
+
+        // reads every enabled Light of the scene, positions and directions come from the Transform
+        void collect(const EntityRegistry &registry);
+
+        // assigns the collected lights to the clusters of the view, slices run on the pool when there is one
+        void build(const glm::mat4 &view, const glm::mat4 &projection, float near_clip, float far_clip,
+                   ThreadPool *pool = nullptr);
+
+        // copies the result into the textures, has to run on the thread that owns the bgfx frame
+        void upload();
+
+        // sets the light textures and uniforms for the next draw
+        void bind(EncoderState &state) const;
+
+        uint32_t get_light_count() const;
+
+        uint32_t get_directional_light_count() const;
+
+        uint32_t get_index_count() const;
+
+        // number of lights assigned to one cluster by the last build
+        uint32_t get_cluster_light_count(uint32_t x, uint32_t y, uint32_t z) const;
+
+        const LightClusterSettings &get_settings() const { return _settings; }
+
+    private:
+        // world space shape of a point or spot light
+        struct LightSource {
+            glm::vec3 position{0.0f};
+            float range{0.0f};
+            glm::vec3 direction{0.0f, 0.0f, -1.0f};
+            float cos_angle{-1.0f};
+            bool spot{false};
+        };
+
+        struct LightVolume {
+            glm::vec3 center{0.0f};
+            float radius{0.0f};
+            glm::vec3 direction{0.0f, 0.0f, -1.0f};
+            float cos_angle{-1.0f};
+            float sin_angle{0.0f};
+            bool spot{false};
+            uint32_t z_begin{0};
+            uint32_t z_end{0};
+            uint32_t x_begin{0};
+            uint32_t x_end{0};
+            uint32_t y_begin{0};
+            uint32_t y_end{0};
+        };
+
+        // structure of arrays so a row of clusters is tested against a light in one go
+        struct ClusterBounds {
+            std::vector<float> min_x, min_y, min_z;
+            std::vector<float> max_x, max_y, max_z;
+            std::vector<float> center_x, center_y, center_z, radius;
+
+            void resize(size_t count);
+        };
+
+        // one slice worth of assignments, lists are local to the slice until they are merged
+        struct SliceScratch {
+            // cluster and light, two entries per hit
+            std::vector<uint32_t> pairs;
+            std::vector<uint32_t> counts;
+            std::vector<uint32_t> offsets;
+            std::vector<uint32_t> indices;
+        };
+
+        void update_cluster_bounds(const glm::mat4 &projection, float near_clip, float far_clip);
+
+        void prepare_volumes(const glm::mat4 &view, const glm::mat4 &projection);
+
+        void assign_slice(uint32_t slice);
+
+        void merge_slices();
+
+        bool create_index_texture(uint32_t capacity);
+
+        LightClusterSettings _settings;
+
+        // directional lights first, four texels per light
+        std::vector<glm::vec4> _light_data;
+        // the clustered lights, in the order they follow the directional ones
+        std::vector<LightSource> _sources;
+        uint32_t _directional_count{0};
+        bool _light_overflow_logged{false};
+
+        std::vector<LightVolume> _volumes;
+        ClusterBounds _bounds;
+        glm::mat4 _bounds_projection{0.0f};
+        float _bounds_near{0.0f};
+        float _bounds_far{0.0f};
+        float _slice_scale{0.0f};
+        float _slice_bias{0.0f};
+
+        std::vector<SliceScratch> _slices;
+        // offset into the index list and light count per cluster
+        std::vector<glm::vec2> _grid;
+        std::vector<float> _indices;
+        uint32_t _index_count{0};
+        bool _index_overflow_logged{false};
+
+        glm::vec4 _grid_params{0.0f};
+        glm::vec4 _depth_params{0.0f};
+        glm::vec4 _texture_params{0.0f};
+
+        bgfx::TextureHandle _light_texture{BGFX_INVALID_HANDLE};
+        bgfx::TextureHandle _grid_texture{BGFX_INVALID_HANDLE};
+        bgfx::TextureHandle _index_texture{BGFX_INVALID_HANDLE};
+        uint32_t _index_capacity{0};
+
+        ShaderSampler _light_sampler;
+        ShaderSampler _grid_sampler;
+        ShaderSampler _index_sampler;
+        ShaderUniform _grid_uniform;
+        ShaderUniform _depth_uniform;
+        ShaderUniform _texture_uniform;
+    };
+}
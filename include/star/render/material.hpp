@@ -2,11 +2,18 @@
 
 #include "star/export.hpp"
 #include <glm/glm.hpp>
+#include <array>
+#include <memory>
+#include <optional>
+#include <vector>
 
 #include "shader.hpp"
+#include "star/render/mesh.hpp"
+#include "star/render/texture.hpp"
 
 namespace star {
     class Shader;
+    class EncoderState;
 
     enum class MaterialType {
         Unlit,
@@ -38,6 +45,88 @@ namespace star {
         CCW
     };
 
+    enum class ShaderVariant : uint8_t {
+        Default,
+        Instanced,
+        // octahedral normals of the Half and Quantized vertex formats
+        Packed,
+        PackedInstanced,
+        Count
+    };
+
+    STAR_EXPORT ShaderVariant get_shader_variant(VertexFormat format, bool instanced);
+
+    // uniform values of a material packed into one float array, sorted by uniform handle so bind uploads them
+    // without any lookups
+    class STAR_EXPORT MaterialParameterBlock {
+    public:
+        bool set(bgfx::UniformHandle handle, bgfx::UniformType::Enum type, const float *data, uint16_t count = 1);
+
+        bool has(bgfx::UniformHandle handle) const;
+
+        // nullptr when the block holds no value for the handle
+        const float *get(bgfx::UniformHandle handle) const;
+
+        void remove(bgfx::UniformHandle handle);
+
+        void clear();
+
+        bool empty() const;
+
+        size_t get_size() const;
+
+        // calls fn(handle, data, count) once per uniform in handle order, values in overrides replace the ones of
+        // this block
+        template<typename Fn>
+        void for_each(const MaterialParameterBlock *overrides, Fn &&fn) const;
+
+        // the skipped uniform is left for the caller to set
+        void apply(bgfx::Encoder &encoder, const MaterialParameterBlock *overrides = nullptr,
+                   bgfx::UniformHandle skip = BGFX_INVALID_HANDLE) const;
+
+    private:
+        struct Entry {
+            bgfx::UniformHandle handle{BGFX_INVALID_HANDLE};
+            uint16_t count{0};
+            uint32_t offset{0};
+            uint32_t size{0};
+        };
+
+        std::vector<Entry>::iterator find(bgfx::UniformHandle handle);
+
+        std::vector<Entry>::const_iterator find(bgfx::UniformHandle handle) const;
+
+        std::vector<Entry> _entries;
+        std::vector<float> _data;
+    };
+
+    template<typename Fn>
+    void MaterialParameterBlock::for_each(const MaterialParameterBlock *overrides, Fn &&fn) const {
+        if (!overrides || overrides->_entries.empty()) {
+            for (const auto &entry: _entries) {
+                fn(entry.handle, _data.data() + entry.offset, entry.count);
+            }
+            return;
+        }
+
+        // both sides are sorted by handle, walk them together so every uniform comes up once
+        auto own = _entries.begin();
+        auto other = overrides->_entries.begin();
+        while (own != _entries.end() || other != overrides->_entries.end()) {
+            if (other == overrides->_entries.end() || (own != _entries.end() && own->handle.idx < other->handle.idx)) {
+                fn(own->handle, _data.data() + own->offset, own->count);
+                ++own;
+                continue;
+            }
+
+            if (own != _entries.end() && own->handle.idx == other->handle.idx) {
+                ++own;
+            }
+            fn(other->handle, overrides->_data.data() + other->offset, other->count);
+            ++other;
+        }
+    }
+
     class STAR_EXPORT Material {
     public:
         Material();
@@ -52,16 +141,40 @@ namespace star {
 
         Material &operator=(Material &&other) noexcept;
 
-        bool set_shader(Shader &&shader);
+        bool set_shader(Shader &&shader, ShaderVariant variant = ShaderVariant::Default);
+
+        bool has_shader(ShaderVariant variant) const;
+
+        // position only program of the depth prepass, it has to compute gl_Position exactly like the lit programs
+        // do or the Equal test of the lit pass fails. Instances use the one of their parent
+        bool set_depth_shader(Shader &&shader, bool instanced = false);
+
+        const Shader &get_depth_shader(bool instanced) const;
+
+        bool set_texture(UniformId sampler, bgfx::TextureHandle texture, uint32_t flags = BGFX_SAMPLER_NONE);
+
+        bool set_texture(std::string_view sampler_name, bgfx::TextureHandle texture,
+                         uint32_t flags = BGFX_SAMPLER_NONE);
+
+        // binds the placeholder of the cache until the texture is uploaded
+        bool set_texture(UniformId sampler, std::shared_ptr<const Texture> texture,
+                         uint32_t flags = BGFX_SAMPLER_NONE);
 
-        bool set_texture(const std::string &sampler_name, bgfx::TextureHandle texture,
+        bool set_texture(std::string_view sampler_name, std::shared_ptr<const Texture> texture,
                          uint32_t flags = BGFX_SAMPLER_NONE);
 
-        bool set_uniform(const std::string &name, const glm::vec4 &value);
+        // the UniformId overloads skip hashing the name, none of them allocate once the value exists
+        bool set_uniform(UniformId id, const glm::vec4 &value);
+
+        bool set_uniform(UniformId id, const glm::mat4 &value);
 
-        bool set_uniform(const std::string &name, const glm::mat4 &value);
+        bool set_uniform(UniformId id, const float *data, uint16_t count);
 
-        bool set_uniform(const std::string &name, const float *data, uint16_t count);
+        bool set_uniform(std::string_view name, const glm::vec4 &value);
+
+        bool set_uniform(std::string_view name, const glm::mat4 &value);
+
+        bool set_uniform(std::string_view name, const float *data, uint16_t count);
 
         void set_blend_mode(BlendMode mode);
 
@@ -83,14 +196,67 @@ namespace star {
 
         CullMode get_cull_mode() const;
 
-        void bind(bgfx::Encoder *encoder, uint8_t view_id) const;
+        const MaterialParameterBlock &get_parameters() const;
+
+        // uploads the parameter block through the encoder, then submits
+        void bind(bgfx::Encoder *encoder, uint8_t view_id, ShaderVariant variant = ShaderVariant::Default,
+                  uint32_t depth = 0) const;
+
+        // state and textures the encoder already holds from the previous draw are not set again. A depth override
+        // replaces the depth test and drops the depth write, for draws whose depth a prepass already laid down.
+        // Instanced batches whose instance data carries the batch color of every draw leave the color uniform white
+        void bind(EncoderState &state, uint8_t view_id, ShaderVariant variant = ShaderVariant::Default,
+                  uint32_t depth = 0, std::optional<DepthFunc> depth_override = std::nullopt,
+                  bool batch_color = false) const;
+
+        // binds the render state, textures and parameters of the material but submits a program of the caller's,
+        // for passes that draw the same inputs differently. The extra state is added to the material's
+        void bind(EncoderState &state, uint8_t view_id, bgfx::ProgramHandle program, uint32_t depth = 0,
+                  uint64_t extra_state = 0, bool batch_color = false) const;
+
+        // the material instanced batches of this one bind. An instance overriding nothing but the color of its
+        // parent is drawn in the parent's batches, anything else only batches with itself
+        const Material &get_batch_material() const;
+
+        // the color the instance data multiplies into the tint when drawn in a batch of get_batch_material
+        glm::vec4 get_batch_color() const;
 
         virtual MaterialType get_type() const = 0;
 
+        bool is_translucent() const;
+
+        // opaque, writing its depth with a Less or LessEqual test and with a depth shader, so a depth prepass gives
+        // the same result
+        bool supports_depth_prepass() const;
+
+        // depth only state with the culling of this material
+        uint64_t get_depth_prepass_state() const;
+
+        uint32_t get_id() const;
+
         uint32_t generate_sort_key() const;
 
     protected:
+        // the material that provides the programs, render state and textures
+        virtual const Material &get_base() const { return *this; }
+
+        // the uniform set_color and the like write, batches move it into the instance data
+        virtual UniformId get_color_uniform() const { return {}; }
+
+        bool set_parameter(UniformId id, bgfx::UniformType::Enum type, const float *data, uint16_t count);
+
+        TextureSampler *get_or_add_texture(UniformId sampler_id);
+
+        Shader &get_shader(ShaderVariant variant);
+
+        const Shader &get_shader(ShaderVariant variant) const;
+
         Shader _shader;
+        std::array<Shader, static_cast<size_t>(ShaderVariant::Count) - 1> _variant_shaders;
+        // single and instanced, the packed formats share them
+        std::array<Shader, 2> _depth_shaders;
+
+        uint32_t _id{0};
 
         uint64_t _state{BGFX_STATE_DEFAULT};
         bool _depth_test{true};
@@ -99,7 +265,41 @@ namespace star {
         BlendMode _blend_mode{BlendMode::Opaque};
         CullMode _cull_mode{CullMode::CCW};
 
+        MaterialParameterBlock _parameters;
+        // sorted by stage
+        std::vector<TextureSampler> _textures;
+
         void update_state();
+
+    private:
+        const ShaderUniform *get_batch_color_uniform() const;
+
+        void submit(EncoderState &state, uint8_t view_id, bgfx::ProgramHandle program, uint32_t depth,
+                    uint64_t render_state, bool batch_color) const;
+    };
+
+    // shares the programs, render state, textures and uniforms of its parent and overrides some of the textures and
+    // uniforms. Render state set on the instance is ignored. Instances that only override the color are instanced
+    // together with their parent, see Material::get_batch_material
+    class STAR_EXPORT MaterialInstance final : public Material {
+    public:
+        // a null parent is logged and leaves an instance without shaders
+        explicit MaterialInstance(std::shared_ptr<Material> parent);
+
+        ~MaterialInstance() override;
+
+        MaterialType get_type() const override;
+
+        const std::shared_ptr<Material> &get_parent() const;
+
+        // drops the uniform and texture overrides, the instance batches with its parent again
+        void clear_overrides();
+
+    protected:
+        const Material &get_base() const override;
+
+    private:
+        std::shared_ptr<Material> _parent;
     };
 
     class STAR_EXPORT UnlitMaterial final : public Material {
@@ -114,6 +314,9 @@ namespace star {
 
         glm::vec4 get_color() const;
 
+    protected:
+        UniformId get_color_uniform() const override { return k_uniform_color; }
+
     private:
         glm::vec4 _color{1.0f, 1.0f, 1.0f, 1.0f};
     };
@@ -142,6 +345,9 @@ namespace star {
 
         glm::vec3 get_emissive() const;
 
+    protected:
+        UniformId get_color_uniform() const override { return k_uniform_base_color; }
+
     private:
         glm::vec4 _base_color{1.0f, 1.0f, 1.0f, 1.0f};
         float _metallic{0.0f};
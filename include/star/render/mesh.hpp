@@ -1,13 +1,28 @@
 #pragma once
 
 #include "star/export.hpp"
+#include "star/scene/bounds.hpp"
 #include <bgfx/bgfx.h>
 #include <glm/glm.hpp>
+#include <span>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace star {
+    class EncoderState;
+
+    enum class VertexFormat : uint8_t {
+        // float position, normal, uv and color, 60 bytes
+        Standard,
+        // half position and uv, octahedral snorm16 normal, rgba8 color, 20 bytes
+        Half,
+        // snorm16 position relative to the mesh bounds, otherwise like Half, 20 bytes
+        Quantized,
+        // picked by Mesh::create from the vertex data
+        Auto
+    };
+
     struct Vertex {
         glm::vec3 position;
         glm::vec3 normal;
@@ -16,9 +31,39 @@ namespace star {
 
         static void init();
 
+        static const bgfx::VertexLayout &get_layout(VertexFormat format);
+
         static bgfx::VertexLayout ms_layout;
     };
 
+    // shared by the Half and Quantized formats, position holds halfs or snorm16 depending on the format
+    struct PackedVertex {
+        uint16_t position[4];
+        int16_t normal[2];
+        uint16_t texcoord[2];
+        uint8_t color[4];
+
+        // the position is stored relative to the dequantization, xyz is subtracted and w divides
+        static PackedVertex pack(const Vertex &vertex, VertexFormat format, const glm::vec4 &dequantization);
+
+        static bgfx::VertexLayout ms_half_layout;
+        static bgfx::VertexLayout ms_quantized_layout;
+    };
+
+    struct MeshBuildOptions {
+        VertexFormat format{VertexFormat::Standard};
+        // runs MeshOptimizer on a copy of the data before upload, ignored for non-indexed meshes
+        bool optimize{false};
+        // keeps the uploaded vertices and indices around, needed to simplify the mesh later
+        bool keep_cpu_data{false};
+
+        bool operator==(const MeshBuildOptions &other) const = default;
+    };
+
+    struct MeshBuildOptionsHash {
+        size_t operator()(const MeshBuildOptions &options) const;
+    };
+
     class STAR_EXPORT IMesh {
     public:
         virtual ~IMesh() = default;
@@ -34,7 +79,7 @@ namespace star {
     public:
         Mesh();
 
-        ~Mesh();
+        virtual ~Mesh();
 
         Mesh(const Mesh &) = delete;
 
@@ -44,30 +89,141 @@ namespace star {
 
         Mesh &operator=(Mesh &&other) noexcept;
 
-        bool create(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices);
+        bool create(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices,
+                    const MeshBuildOptions &options = {});
 
-        bool create(const std::vector<Vertex> &vertices);
+        bool create(const std::vector<Vertex> &vertices, const MeshBuildOptions &options = {});
 
-        static Mesh create_cube(float size = 1.0f);
+        static Mesh create_cube(float size = 1.0f, const MeshBuildOptions &options = {});
 
-        static Mesh create_sphere(float radius = 1.0f, uint32_t segments = 16);
+        static Mesh create_sphere(float radius = 1.0f, uint32_t segments = 16, const MeshBuildOptions &options = {});
 
-        static Mesh create_plane(float width = 1.0f, float height = 1.0f);
+        static Mesh create_plane(float width = 1.0f, float height = 1.0f, const MeshBuildOptions &options = {});
 
         bool draw(bgfx::Encoder *encoder) const;
 
-        bool is_valid() const;
+        // binds the buffers, the state skips the ones the encoder already holds
+        virtual bool draw(EncoderState &state) const;
+
+        virtual bool is_valid() const;
 
         uint32_t get_vertex_count() const;
 
         uint32_t get_index_count() const;
 
+        virtual uint16_t get_sort_id() const;
+
+        const Aabb &get_aabb() const;
+
+        const BoundingSphere &get_bounding_sphere() const;
+
+        VertexFormat get_vertex_format() const;
+
+        // maps the stored positions back to mesh space, identity for the Standard format
+        glm::mat4 get_dequantization_matrix() const;
+
+        bool has_cpu_data() const;
+
+        const std::vector<Vertex> &get_cpu_vertices() const;
+
+        const std::vector<uint16_t> &get_cpu_indices() const;
+
+    protected:
+        void compute_bounds(std::span<const Vertex> vertices);
+
+        uint32_t _vertex_count{0};
+        uint32_t _index_count{0};
+        Aabb _aabb;
+        BoundingSphere _bounding_sphere;
+
     private:
         void destroy();
 
         bgfx::VertexBufferHandle _vbh{BGFX_INVALID_HANDLE};
         bgfx::IndexBufferHandle _ibh{BGFX_INVALID_HANDLE};
-        uint32_t _vertex_count{0};
-        uint32_t _index_count{0};
+        VertexFormat _format{VertexFormat::Standard};
+        glm::vec4 _dequantization{0.0f, 0.0f, 0.0f, 1.0f};
+        std::vector<Vertex> _cpu_vertices;
+        std::vector<uint16_t> _cpu_indices;
+    };
+
+    // Standard format geometry in dynamic buffers, for meshes that change every now and then
+    class STAR_EXPORT DynamicMesh final : public Mesh {
+    public:
+        DynamicMesh();
+
+        ~DynamicMesh() override;
+
+        // buffers grow on demand, the counts only avoid reallocations for the first updates
+        bool create(uint32_t vertex_capacity, uint32_t index_capacity);
+
+        bool create(std::span<const Vertex> vertices, std::span<const uint16_t> indices);
+
+        // the drawn range grows to cover every update, bounds grow with the written vertices
+        bool update_vertices(uint32_t first_vertex, std::span<const Vertex> vertices);
+
+        bool update_indices(uint32_t first_index, std::span<const uint16_t> indices);
+
+        // shrinks or grows the drawn range without touching the buffer contents
+        void set_draw_counts(uint32_t vertex_count, uint32_t index_count);
+
+        // replaces the grown bounds with tight ones when the caller knows them
+        void set_bounds(const Aabb &aabb);
+
+        using Mesh::draw;
+
+        bool draw(EncoderState &state) const override;
+
+        bool is_valid() const override;
+
+        uint16_t get_sort_id() const override;
+
+    private:
+        void destroy();
+
+        void grow_bounds(std::span<const Vertex> vertices);
+
+        bgfx::DynamicVertexBufferHandle _dvbh{BGFX_INVALID_HANDLE};
+        bgfx::DynamicIndexBufferHandle _dibh{BGFX_INVALID_HANDLE};
+        bool _has_bounds{false};
+    };
+
+    // Standard format geometry copied into transient buffers, for meshes rebuilt every frame. Like the bgfx
+    // buffers behind it the data only lives until the end of the frame update was called in, the mesh stops being
+    // valid once end_frame reports that frame as submitted. Update has to run on the thread that owns the bgfx frame
+    class STAR_EXPORT TransientMesh final : public Mesh {
+    public:
+        TransientMesh();
+
+        ~TransientMesh() override;
+
+        // takes what bgfx::frame returned, every mesh updated before it stops being valid
+        static void end_frame(uint32_t frame);
+
+        // returns false when this frame has no transient memory left for the geometry
+        bool update(std::span<const Vertex> vertices, std::span<const uint16_t> indices = {});
+
+        void clear();
+
+        using Mesh::draw;
+
+        bool draw(EncoderState &state) const override;
+
+        bool is_valid() const override;
+
+        uint16_t get_sort_id() const override;
+
+    private:
+        bgfx::TransientVertexBuffer _tvb{};
+        bgfx::TransientIndexBuffer _tib{};
+        uint32_t _frame{0};
+        uint16_t _sort_id{0};
+        bool _valid{false};
+    };
+
+    struct MeshLod {
+        std::shared_ptr<Mesh> mesh;
+        // used while the object covers at least this fraction of the viewport height
+        float screen_size{0.0f};
     };
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/app/app_component.hpp"
+#include "star/render/mesh.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace star {
+    enum class MeshPrimitive : uint8_t {
+        Cube,
+        Sphere,
+        Plane
+    };
+
+    struct MeshCacheKey {
+        MeshPrimitive primitive{MeshPrimitive::Cube};
+        glm::vec2 size{0.0f};
+        uint32_t segments{0};
+        MeshBuildOptions options;
+
+        bool operator==(const MeshCacheKey &other) const = default;
+    };
+
+    struct MeshCacheKeyHash {
+        size_t operator()(const MeshCacheKey &key) const;
+    };
+
+    // hands out one shared Mesh per primitive and parameters, entries nobody else references are evicted on update
+    class STAR_EXPORT MeshCache final : public ITypeAppComponent<MeshCache> {
+    public:
+        MeshCache();
+
+        ~MeshCache() override;
+
+        MeshCache(const MeshCache &) = delete;
+
+        MeshCache &operator=(const MeshCache &) = delete;
+
+        void shutdown() override;
+
+        void update(float delta_time) override;
+
+        std::shared_ptr<Mesh> get_cube(float size = 1.0f, const MeshBuildOptions &options = {});
+
+        std::shared_ptr<Mesh> get_sphere(float radius = 1.0f, uint32_t segments = 16,
+                                         const MeshBuildOptions &options = {});
+
+        std::shared_ptr<Mesh> get_plane(float width = 1.0f, float height = 1.0f, const MeshBuildOptions &options = {});
+
+        std::shared_ptr<Mesh> get(const MeshCacheKey &key);
+
+        // returns the number of meshes released
+        size_t evict_unused();
+
+        void clear();
+
+        size_t get_size() const;
+
+    private:
+        static Mesh build(const MeshCacheKey &key);
+
+        mutable std::mutex _mutex;
+        std::unordered_map<MeshCacheKey, std::shared_ptr<Mesh>, MeshCacheKeyHash> _meshes;
+    };
+}
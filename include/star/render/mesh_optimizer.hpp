@@ -0,0 +1,38 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/mesh.hpp"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace star {
+    // CPU only and deterministic, the same input always produces the same output. Index lists that are not whole
+    // triangles or point past the vertices are logged and left unchanged
+    class STAR_EXPORT MeshOptimizer final {
+    public:
+        static constexpr uint32_t k_cache_size = 16;
+
+        // Tipsify reordering for the post-transform cache, fills clusters with the first triangle of every
+        // run that had to restart from a dead end
+        static void optimize_vertex_cache(std::vector<uint16_t> &indices, size_t vertex_count,
+                                          std::vector<uint32_t> *clusters = nullptr,
+                                          uint32_t cache_size = k_cache_size);
+
+        // sorts clusters so outward facing ones draw first, clusters are split further while the cache
+        // miss ratio stays within threshold of the unsplit order
+        static void optimize_overdraw(std::vector<uint16_t> &indices, const std::vector<Vertex> &vertices,
+                                      const std::vector<uint32_t> &clusters, float threshold = 1.05f,
+                                      uint32_t cache_size = k_cache_size);
+
+        // reorders vertices by first use and drops the ones no triangle references
+        static void optimize_vertex_fetch(std::vector<Vertex> &vertices, std::vector<uint16_t> &indices);
+
+        // all of the above, in order
+        static void optimize(std::vector<Vertex> &vertices, std::vector<uint16_t> &indices);
+
+        // average cache misses per triangle for a FIFO cache of the given size
+        static float compute_acmr(std::span<const uint16_t> indices, size_t vertex_count,
+                                  uint32_t cache_size = k_cache_size);
+    };
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/mesh.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace star {
+    struct LodChainSettings {
+        // including the source mesh
+        uint32_t level_count{4};
+        // index count of every level relative to the one before it
+        float reduction{0.5f};
+        // largest error a level may reach, relative to the mesh extents
+        float max_error{0.05f};
+        // screen size at which level 0 hands over, every further level halves it
+        float screen_size{0.5f};
+        // the last level stops drawing below this screen size, 0 draws it at any distance
+        float cull_screen_size{0.0f};
+    };
+
+    class STAR_EXPORT MeshSimplifier final {
+    public:
+        // edge collapse ordered by quadric error, vertices collapse onto existing ones so the result indexes the
+        // same vertex data. Stops at target_index_count or before a collapse would exceed max_error, relative to
+        // the mesh extents. Attribute seams are kept and open borders only collapse along themselves
+        static std::vector<uint16_t> simplify(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices,
+                                              size_t target_index_count, float max_error = 0.05f,
+                                              float *result_error = nullptr);
+
+        // level 0 is the source itself, which has to be created with keep_cpu_data
+        static std::vector<MeshLod> build_lod_chain(const std::shared_ptr<Mesh> &source,
+                                                    const LodChainSettings &settings = {});
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/scene/bounds.hpp"
+#include <glm/glm.hpp>
+#include <span>
+#include <vector>
+
+namespace star {
+    class Mesh;
+    class ThreadPool;
+
+    struct OcclusionSettings {
+        // resolution of the software depth buffer, rounded up to whole tiles
+        uint16_t width{320};
+        uint16_t height{192};
+        // occluders drawn per frame, the largest on screen are picked first
+        uint32_t max_occluders{32};
+        // projected radius in clip space heights a draw needs to be used as an occluder
+        float min_occluder_size{0.1f};
+        // meshes with more triangles are not worth rasterizing on the CPU
+        uint32_t max_occluder_triangles{4096};
+    };
+
+    // software occlusion culling. The largest occluders are rasterized into a small tiled depth buffer, a pyramid
+    // of the farthest depths is built on top of it and bounding boxes are tested against the level their screen
+    // rect fits in. Occluders need their CPU side geometry, see MeshBuildOptions::keep_cpu_data
+    class STAR_EXPORT OcclusionCuller final {
+    public:
+        static constexpr uint32_t k_tile_width = 8;
+        static constexpr uint32_t k_tile_height = 4;
+
+        OcclusionCuller();
+
+        ~OcclusionCuller();
+
+        OcclusionCuller(const OcclusionCuller &) = delete;
+
+        OcclusionCuller &operator=(const OcclusionCuller &) = delete;
+
+        bool init(const OcclusionSettings &settings = {});
+
+        void shutdown();
+
+        bool is_valid() const;
+
+        // drops the occluders of the last view, the view-projection has a -1..1 clip depth range
+        void begin(const glm::mat4 &view_projection);
+
+        // queues a mesh for the next rasterize, false when it has no CPU geometry or the occluder budget is used up
+        bool add_occluder(const Mesh &mesh, const glm::mat4 &model);
+
+        // draws the queued occluders and builds the depth pyramid, bands of the buffer run on the pool when there
+        // is one
+        void rasterize(ThreadPool *pool = nullptr);
+
+        bool is_visible(const Aabb &aabb) const;
+
+        // writes 0 for every volume hidden behind the occluders, volumes that are already 0 are not tested. Returns
+        // the number of visible volumes
+        size_t cull(std::span<const BoundingSphere> spheres, std::span<uint8_t> visible,
+                    ThreadPool *pool = nullptr) const;
+
+        size_t cull(std::span<const Aabb> aabbs, std::span<uint8_t> visible, ThreadPool *pool = nullptr) const;
+
+        // clip space depth the occluders left at a pixel, 1 where none was drawn
+        float get_depth(uint32_t x, uint32_t y) const;
+
+        uint32_t get_width() const { return _width; }
+
+        uint32_t get_height() const { return _height; }
+
+        uint32_t get_occluder_count() const { return _occluder_count; }
+
+        // triangles that reached the rasterizer in the last rasterize, after clipping
+        uint32_t get_triangle_count() const { return _triangle_count; }
+
+        const OcclusionSettings &get_settings() const { return _settings; }
+
+    private:
+        // edge functions a * x + b * y + c are positive inside, depth is a plane over the screen as well
+        struct Triangle {
+            glm::vec3 edge_a{0.0f};
+            glm::vec3 edge_b{0.0f};
+            glm::vec3 edge_c{0.0f};
+            glm::vec3 depth{0.0f};
+            uint16_t min_tile_x{0};
+            uint16_t min_tile_y{0};
+            uint16_t max_tile_x{0};
+            uint16_t max_tile_y{0};
+        };
+
+        struct Occluder {
+            const Mesh *mesh{nullptr};
+            glm::mat4 model_view_projection{1.0f};
+            std::vector<glm::vec4> positions;
+            std::vector<Triangle> triangles;
+        };
+
+        void setup_occluder(Occluder &occluder) const;
+
+        void setup_triangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c,
+                            std::vector<Triangle> &triangles) const;
+
+        void add_triangle(const glm::vec3 &a, glm::vec3 b, glm::vec3 c, std::vector<Triangle> &triangles) const;
+
+        void rasterize_band(uint32_t first_tile_row, uint32_t end_tile_row);
+
+        void rasterize_tile(const Triangle &triangle, uint32_t tile_x, uint32_t tile_y);
+
+        void build_pyramid_rows(uint32_t first_row, uint32_t end_row);
+
+        void build_pyramid_level(uint32_t level);
+
+        bool is_rect_visible(const glm::vec2 &min, const glm::vec2 &max, float depth) const;
+
+        OcclusionSettings _settings;
+        glm::mat4 _view_projection{1.0f};
+
+        uint32_t _width{0};
+        uint32_t _height{0};
+        uint32_t _tiles_x{0};
+        uint32_t _tiles_y{0};
+        // tile after tile, rows of k_tile_width pixels inside a tile
+        std::vector<float> _depth;
+
+        // farthest depth of 2x2 texels of the level below, level 0 covers 2x2 pixels
+        std::vector<float> _pyramid;
+        std::vector<uint32_t> _level_offsets;
+        std::vector<glm::uvec2> _level_sizes;
+
+        std::vector<Occluder> _occluders;
+        uint32_t _occluder_count{0};
+        uint32_t _triangle_count{0};
+        bool _rasterized{false};
+    };
+}
@@ -0,0 +1,249 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace star {
+    class RenderChain;
+
+    struct RenderTargetDesc {
+        // a zero width or height follows the backbuffer size times the scale
+        uint16_t width{0};
+        uint16_t height{0};
+        glm::vec2 scale{1.0f};
+        bgfx::TextureFormat::Enum format{bgfx::TextureFormat::RGBA8};
+        uint64_t flags{BGFX_TEXTURE_RT | BGFX_SAMPLER_UV_CLAMP};
+
+        bool is_relative() const { return width == 0 || height == 0; }
+
+        glm::uvec2 get_size(const glm::uvec2 &backbuffer_size) const;
+
+        bool operator==(const RenderTargetDesc &other) const = default;
+    };
+
+    // index of a texture in the chain, stays the same until the passes are set up again
+    struct RenderResource {
+        static constexpr uint32_t k_invalid = UINT32_MAX;
+
+        uint32_t index{k_invalid};
+
+        bool is_valid() const { return index != k_invalid; }
+
+        bool operator==(const RenderResource &other) const = default;
+    };
+
+    // what a pass hands to the chain while it is set up. Resources are looked up by name, a pass can only use the
+    // ones created or imported before it
+    class STAR_EXPORT RenderPassBuilder final {
+    public:
+        // a transient texture, its memory is shared with other transients whose lifetimes do not overlap so the
+        // first pass writing it has to clear it
+        RenderResource create(const std::string &name, const RenderTargetDesc &desc);
+
+        // sampled by the pass
+        RenderResource read(const std::string &name);
+
+        // attached to the framebuffer of the pass in call order, the backbuffer can not be mixed with textures
+        RenderResource write(const std::string &name);
+
+        void set_clear(uint16_t flags, uint32_t rgba = 0, float depth = 1.0f, uint8_t stencil = 0);
+
+        void set_view_mode(bgfx::ViewMode::Enum mode);
+
+        // the pass is kept even when nothing reads what it writes
+        void set_side_effect();
+
+    private:
+        friend class RenderChain;
+
+        RenderPassBuilder(RenderChain &chain, uint32_t pass);
+
+        RenderChain &_chain;
+        uint32_t _pass;
+    };
+
+    struct RenderPassContext {
+        bgfx::ViewId view_id{0};
+        bgfx::Encoder &encoder;
+        const RenderChain &chain;
+        // size of the attachments, the backbuffer size when the pass draws into it
+        glm::uvec2 size{0};
+    };
+
+    struct RenderChainStats {
+        uint32_t pass_count{0};
+        uint32_t culled_pass_count{0};
+        uint32_t transient_count{0};
+        // textures actually allocated for the transients after aliasing
+        uint32_t texture_count{0};
+        // passes whose view was configured again by the last compile
+        uint32_t rebuilt_pass_count{0};
+        uint32_t view_count{0};
+        // views whose owner configured them again in the last compile
+        uint32_t configured_view_count{0};
+    };
+
+    // render graph of the app. Passes declare the textures they read and write, compile drops the passes nothing
+    // depends on, gives the rest consecutive views in declaration order, shares textures between transients that
+    // are never alive at the same time and builds the framebuffers. A resize only touches the passes using
+    // textures that follow the backbuffer size.
+    // The cameras, the forward renderers and the app components add their views on a render reset. Those run in
+    // front of the passes, are set up by their owners and are only configured again when their id moves or on a
+    // resize. The deferred renderer and ImGui draw through passes
+    class STAR_EXPORT RenderChain final {
+    public:
+        using SetupFunction = std::function<void(RenderPassBuilder &)>;
+        using ExecuteFunction = std::function<void(const RenderPassContext &)>;
+        using ViewFunction = std::function<void(bgfx::ViewId)>;
+
+        // always available, written by the passes presenting to the screen
+        static constexpr const char *k_backbuffer = "backbuffer";
+
+        RenderChain();
+
+        ~RenderChain();
+
+        RenderChain(const RenderChain &) = delete;
+
+        RenderChain &operator=(const RenderChain &) = delete;
+
+        // passes run in the order they were added, a pass with the same name is replaced in place
+        void add_pass(const std::string &name, SetupFunction setup, ExecuteFunction execute);
+
+        bool remove_pass(const std::string &name);
+
+        bool has_pass(const std::string &name) const;
+
+        // a view the owner sets up and draws into itself. Views take consecutive ids in the order they were added,
+        // the name only labels them and does not have to be unique
+        void add_view(const std::string &name, const void *owner, ViewFunction configure);
+
+        // owners going away drop their views, the views after them move up on the next compile
+        void remove_views(const void *owner);
+
+        // a render reset adds all views again
+        void clear_views();
+
+        // a texture owned outside the chain, passes writing it are never culled
+        void import_texture(const std::string &name, bgfx::TextureHandle handle, const RenderTargetDesc &desc);
+
+        bool remove_texture(const std::string &name);
+
+        // sets the passes up again on the next compile
+        void invalidate();
+
+        bool is_dirty() const { return _dirty || _views_dirty; }
+
+        // assigns the ids from first_view on, views first, and returns the first id after them
+        bgfx::ViewId compile(bgfx::ViewId first_view, const glm::uvec2 &backbuffer_size);
+
+        // runs the passes that survived the last compile
+        void render(bgfx::Encoder &encoder) const;
+
+        // destroys every texture and framebuffer, the passes stay
+        void shutdown();
+
+        RenderResource find_resource(const std::string &name) const;
+
+        bgfx::TextureHandle get_texture(RenderResource resource) const;
+
+        bgfx::TextureHandle get_texture(const std::string &name) const;
+
+        // empty while the pass is culled or not compiled yet
+        std::optional<bgfx::ViewId> get_view_id(const std::string &name) const;
+
+        bool is_pass_culled(const std::string &name) const;
+
+        const RenderChainStats &get_stats() const { return _stats; }
+
+    private:
+        friend class RenderPassBuilder;
+
+        struct Resource {
+            std::string name;
+            RenderTargetDesc desc;
+            bool imported{false};
+            bgfx::TextureHandle imported_handle{BGFX_INVALID_HANDLE};
+            // index into the textures, UINT32_MAX for imports
+            uint32_t texture{UINT32_MAX};
+            uint32_t first_pass{UINT32_MAX};
+            uint32_t last_pass{0};
+        };
+
+        struct Pass {
+            std::string name;
+            SetupFunction setup;
+            ExecuteFunction execute;
+            std::vector<uint32_t> reads;
+            std::vector<uint32_t> writes;
+            std::vector<uint32_t> creates;
+            uint16_t clear_flags{BGFX_CLEAR_NONE};
+            uint32_t clear_rgba{0};
+            float clear_depth{1.0f};
+            uint8_t clear_stencil{0};
+            bgfx::ViewMode::Enum view_mode{bgfx::ViewMode::Sequential};
+            bool side_effect{false};
+            bool culled{false};
+            std::optional<bgfx::ViewId> view_id;
+            bgfx::FrameBufferHandle framebuffer{BGFX_INVALID_HANDLE};
+            glm::uvec2 size{0};
+        };
+
+        struct View {
+            std::string name;
+            const void *owner{nullptr};
+            ViewFunction configure;
+            std::optional<bgfx::ViewId> view_id;
+        };
+
+        struct Texture {
+            RenderTargetDesc desc;
+            glm::uvec2 size{0};
+            bgfx::TextureHandle handle{BGFX_INVALID_HANDLE};
+            // last pass using it, a transient first used after this one can take it over
+            uint32_t last_pass{0};
+        };
+
+        RenderResource add_resource(uint32_t pass, const std::string &name, const RenderTargetDesc &desc);
+
+        RenderResource use_resource(uint32_t pass, const std::string &name, bool write);
+
+        void setup_passes();
+
+        void cull_passes();
+
+        void allocate_textures();
+
+        void resize_textures(std::vector<uint8_t> &resized);
+
+        bgfx::ViewId assign_views(bgfx::ViewId first_view, bool resized);
+
+        void configure_pass(Pass &pass);
+
+        void release_framebuffer(Pass &pass);
+
+        void release_textures();
+
+        bool uses_texture(const Pass &pass, const std::vector<uint8_t> &textures) const;
+
+        std::vector<View> _views;
+        std::vector<Pass> _passes;
+        std::vector<Resource> _resources;
+        std::vector<Texture> _textures;
+        // imports survive a new setup, the passes only refer to them
+        std::vector<Resource> _imports;
+
+        glm::uvec2 _backbuffer_size{0};
+        bgfx::ViewId _first_view{0};
+        bgfx::ViewId _end_view{0};
+        bool _dirty{true};
+        bool _views_dirty{false};
+        bool _compiled{false};
+        RenderChainStats _stats;
+    };
+}
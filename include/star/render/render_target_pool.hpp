@@ -0,0 +1,106 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+namespace star {
+    struct RenderTarget {
+        bgfx::FrameBufferHandle framebuffer{BGFX_INVALID_HANDLE};
+        bgfx::TextureHandle color{BGFX_INVALID_HANDLE};
+        bgfx::TextureHandle depth{BGFX_INVALID_HANDLE};
+        // allocated size, the requested size rounded up to the bucket
+        glm::uvec2 size{0};
+
+        bool is_valid() const { return bgfx::isValid(framebuffer); }
+    };
+
+    struct RenderTargetId {
+        static constexpr uint32_t k_invalid = UINT32_MAX;
+
+        uint32_t index{k_invalid};
+        // bumped on every release, so an id kept past its release does not reach whoever acquires the slot next
+        uint32_t generation{0};
+
+        bool is_valid() const { return index != k_invalid; }
+
+        bool operator==(const RenderTargetId &other) const = default;
+    };
+
+    // framebuffers handed out by size bucket, color format, depth format and flags. A released target goes back
+    // to the pool for the next request with the same key and is only destroyed after it sat unused for a while,
+    // so a size that keeps changing does not create and destroy GPU memory every frame
+    class STAR_EXPORT RenderTargetPool final {
+    public:
+        // sizes are rounded up to a multiple of this on both axes
+        static constexpr uint32_t k_size_granularity = 64;
+
+        RenderTargetPool();
+
+        ~RenderTargetPool();
+
+        RenderTargetPool(const RenderTargetPool &) = delete;
+
+        RenderTargetPool &operator=(const RenderTargetPool &) = delete;
+
+        // no depth attachment with a depth format of Count
+        RenderTargetId acquire(const glm::uvec2 &size,
+                               bgfx::TextureFormat::Enum color_format = bgfx::TextureFormat::RGBA8,
+                               bgfx::TextureFormat::Enum depth_format = bgfx::TextureFormat::D24S8,
+                               uint64_t flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_UV_CLAMP);
+
+        void release(RenderTargetId id);
+
+        // an invalid target for released or unknown ids
+        const RenderTarget &get(RenderTargetId id) const;
+
+        // true when the target holds the size with the same formats and flags
+        bool fits(RenderTargetId id, const glm::uvec2 &size, bgfx::TextureFormat::Enum color_format,
+                  bgfx::TextureFormat::Enum depth_format, uint64_t flags) const;
+
+        // advances the frame and destroys the targets nobody acquired for longer than the idle limit
+        void update();
+
+        // destroys every target, the ones still acquired included
+        void shutdown();
+
+        void set_max_idle_frames(uint32_t frames);
+
+        uint32_t get_max_idle_frames() const { return _max_idle_frames; }
+
+        static glm::uvec2 get_bucket_size(const glm::uvec2 &size);
+
+        uint32_t get_target_count() const;
+
+        uint32_t get_free_count() const;
+
+        // targets created since the pool started, grows only when no pooled target could be reused
+        uint32_t get_created_count() const { return _created_count; }
+
+    private:
+        struct Entry {
+            RenderTarget target;
+            bgfx::TextureFormat::Enum color_format{bgfx::TextureFormat::Count};
+            bgfx::TextureFormat::Enum depth_format{bgfx::TextureFormat::Count};
+            uint64_t flags{0};
+            bool acquired{false};
+            uint32_t generation{0};
+            // frame it was released in, the GPU may still draw into it until the next one
+            uint64_t release_frame{0};
+        };
+
+        // null unless the id is the current acquisition of its slot
+        const Entry *find(RenderTargetId id) const;
+
+        bool create(Entry &entry, const glm::uvec2 &size) const;
+
+        static void destroy(Entry &entry);
+
+        std::vector<Entry> _entries;
+        std::vector<uint32_t> _free_slots;
+        uint64_t _frame{0};
+        uint32_t _max_idle_frames{120};
+        uint32_t _created_count{0};
+    };
+}
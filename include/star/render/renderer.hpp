@@ -10,6 +10,7 @@
 
 namespace star {
     class App;
+    class RenderChain;
     class Scene;
     class Transform;
     class Mesh;
@@ -31,7 +32,9 @@ namespace star {
         virtual void update(float delta_time) {
         }
 
-        virtual bgfx::ViewId render_reset(bgfx::ViewId view_id) { return view_id; }
+        // adds the views the renderer draws into, they are removed again on shutdown
+        virtual void render_reset(RenderChain &chain) {
+        }
 
         virtual void render(bgfx::ViewId view_id, bgfx::Encoder *encoder = nullptr) {
         }
@@ -53,7 +56,7 @@ namespace star {
 
         void update(float delta_time) override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id) override;
+        void render_reset(RenderChain &chain) override;
 
         void render(bgfx::ViewId view_id, bgfx::Encoder *encoder = nullptr) override;
 
@@ -69,6 +72,9 @@ namespace star {
 
         OptionalRef<Camera> get_camera() const;
 
+        // view the renderer draws the camera into, set once the chain configured the views of render_reset
+        std::optional<bgfx::ViewId> get_view_id() const { return _view_id; }
+
         virtual void on_window_resize(uint32_t width, uint32_t height) {
         }
 
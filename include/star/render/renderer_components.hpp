@@ -3,41 +3,75 @@
 #include "star/export.hpp"
 #include "star/render/mesh.hpp"
 #include "star/render/material.hpp"
+#include <limits>
 #include <memory>
 
 namespace star {
     class STAR_EXPORT MeshRenderer {
     public:
+        static constexpr uint32_t k_invalid_lod = std::numeric_limits<uint32_t>::max();
+
         MeshRenderer();
 
         ~MeshRenderer();
 
+        // replaces the LOD chain with a single level
         void set_mesh(Mesh &&mesh);
 
         void set_mesh(std::shared_ptr<Mesh> mesh);
 
         Mesh *get_mesh() const;
 
+        // levels are kept sorted from the largest screen size down, level 0 is what get_mesh returns
+        void set_lods(std::vector<MeshLod> lods);
+
+        const std::vector<MeshLod> &get_lods() const;
+
+        uint32_t get_lod_count() const;
+
+        Mesh *get_lod_mesh(uint32_t lod) const;
+
+        // fraction of a threshold the screen size has to move past it before the level changes
+        void set_lod_hysteresis(float hysteresis);
+
+        float get_lod_hysteresis() const;
+
+        // returns get_lod_count() once the object is smaller than the last threshold and should not draw
+        uint32_t select_lod(float screen_size, uint32_t current_lod = k_invalid_lod) const;
+
         void set_material(std::shared_ptr<Material> material);
 
         Material *get_material() const;
 
+        const std::shared_ptr<Material> &get_shared_material() const;
+
         void set_visible(bool visible);
 
         bool is_visible() const;
 
+        void set_cast_shadows(bool cast);
+
+        bool get_cast_shadows() const;
+
         void set_layer(uint8_t layer);
 
         uint8_t get_layer() const;
 
-        uint32_t generate_sort_key() const;
+        void set_tint(const glm::vec4 &tint);
+
+        const glm::vec4 &get_tint() const;
+
+        uint64_t generate_sort_key(float depth, uint32_t lod = 0) const;
 
         bool render(bgfx::Encoder *encoder);
 
     private:
-        std::shared_ptr<Mesh> _mesh;
+        std::vector<MeshLod> _lods;
         std::shared_ptr<Material> _material;
+        glm::vec4 _tint{1.0f};
+        float _lod_hysteresis{0.1f};
         bool _visible{true};
+        bool _cast_shadows{true};
         uint8_t _layer{0};
     };
 
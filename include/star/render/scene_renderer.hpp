@@ -18,7 +18,7 @@ namespace star {
 
         void update(float delta_time) override;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id) override;
+        void render_reset(RenderChain &chain) override;
 
         ForwardRenderer &get_renderer();
 
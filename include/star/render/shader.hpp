@@ -1,45 +1,62 @@
 #pragma once
 
 #include "star/export.hpp"
+#include "star/render/uniform_id.hpp"
 #include <bgfx/embedded_shader.h>
+#include <memory>
+#include <vector>
 
 namespace star {
-    struct TextureSampler;
-
+    // the handle is owned by the ShaderRegistry and shared by every program reading the uniform
     struct ShaderUniform {
         bgfx::UniformHandle handle{BGFX_INVALID_HANDLE};
+        UniformId id;
         std::string name;
         bgfx::UniformType::Enum type{bgfx::UniformType::Count};
         uint16_t num{1};
 
-        ShaderUniform() = default;
+        bool is_valid() const;
+    };
 
-        ShaderUniform(const std::string &uniform_name, bgfx::UniformType::Enum uniform_type, uint16_t count = 1);
+    struct ShaderSampler {
+        bgfx::UniformHandle handle{BGFX_INVALID_HANDLE};
+        UniformId id;
+        std::string name;
+        uint8_t stage{0};
 
-        ~ShaderUniform();
+        bool is_valid() const;
+    };
 
-        ShaderUniform(const ShaderUniform &) = delete;
+    // a linked program and the uniforms and samplers it reads, shared by every Shader loaded from the same binaries
+    struct STAR_EXPORT ShaderProgram {
+        bgfx::ProgramHandle handle{BGFX_INVALID_HANDLE};
+        uint64_t hash{0};
+        // both sorted by id
+        std::vector<ShaderUniform> uniforms;
+        std::vector<ShaderSampler> samplers;
 
-        ShaderUniform &operator=(const ShaderUniform &) = delete;
+        ShaderProgram() = default;
 
-        ShaderUniform(ShaderUniform &&other) noexcept;
+        ~ShaderProgram();
 
-        ShaderUniform &operator=(ShaderUniform &&other) noexcept;
+        ShaderProgram(const ShaderProgram &) = delete;
 
-        bool is_valid() const;
+        ShaderProgram &operator=(const ShaderProgram &) = delete;
 
+        // destroys the handle and drops the slots, whose handles belong to the registry
         void destroy();
     };
 
+    // refcounted handle to a program from the ShaderRegistry, copies share the program
     class STAR_EXPORT Shader {
     public:
         Shader();
 
         ~Shader();
 
-        Shader(const Shader &) = delete;
+        Shader(const Shader &other);
 
-        Shader &operator=(const Shader &) = delete;
+        Shader &operator=(const Shader &other);
 
         Shader(Shader &&other) noexcept;
 
@@ -49,22 +66,23 @@ namespace star {
 
         bool load(const bgfx::EmbeddedShader &vs, const bgfx::EmbeddedShader &fs);
 
+        void reset();
+
         bool is_valid() const;
 
         bgfx::ProgramHandle get_handle() const;
 
-        ShaderUniform *get_uniform(const std::string &name);
+        uint64_t get_hash() const;
 
-        TextureSampler *get_sampler(const std::string &name);
+        const ShaderUniform *get_uniform(UniformId id) const;
 
-        std::unordered_map<std::string, ShaderUniform> _uniforms;
-        std::unordered_map<std::string, TextureSampler> _samplers;
+        const ShaderUniform *get_uniform(std::string_view name) const;
 
-    private:
-        void destroy();
+        const ShaderSampler *get_sampler(UniformId id) const;
 
-        void init_uniforms();
+        const ShaderSampler *get_sampler(std::string_view name) const;
 
-        bgfx::ProgramHandle _program{BGFX_INVALID_HANDLE};
+    private:
+        std::shared_ptr<const ShaderProgram> _program;
     };
 }
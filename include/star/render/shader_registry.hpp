@@ -0,0 +1,54 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/shader.hpp"
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace star {
+    // process wide cache of linked programs keyed by the hash of their shader binaries, and of the uniform and
+    // sampler handles they read keyed by name. Programs are released once the last Shader referencing them goes
+    class STAR_EXPORT ShaderRegistry final {
+    public:
+        static ShaderRegistry &get();
+
+        ShaderRegistry(const ShaderRegistry &) = delete;
+
+        ShaderRegistry &operator=(const ShaderRegistry &) = delete;
+
+        // the memory is consumed whether or not the program was already loaded
+        std::shared_ptr<const ShaderProgram> acquire(const bgfx::Memory *vs_data, const bgfx::Memory *fs_data);
+
+        std::shared_ptr<const ShaderProgram> acquire(const bgfx::EmbeddedShader &vs, const bgfx::EmbeddedShader &fs);
+
+        // created on first use, handles stay valid until shutdown
+        ShaderUniform get_uniform(const std::string &name, bgfx::UniformType::Enum type, uint16_t num = 1);
+
+        ShaderSampler get_sampler(const std::string &name, uint8_t stage);
+
+        size_t get_program_count() const;
+
+        size_t get_uniform_count() const;
+
+        // destroys the shared uniform handles and the programs still referenced, has to run before bgfx shuts
+        // down. Shaders outliving it stay invalid until they load again
+        void shutdown();
+
+    private:
+        ShaderRegistry();
+
+        ~ShaderRegistry();
+
+        std::shared_ptr<const ShaderProgram> find(uint64_t hash);
+
+        std::shared_ptr<const ShaderProgram> link(uint64_t hash, bgfx::ShaderHandle vsh, bgfx::ShaderHandle fsh);
+
+        void init_slots(ShaderProgram &program);
+
+        mutable std::mutex _mutex;
+        std::unordered_map<uint64_t, std::weak_ptr<ShaderProgram> > _programs;
+        std::unordered_map<std::string, ShaderUniform> _uniforms;
+        std::unordered_map<std::string, ShaderSampler> _samplers;
+    };
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/render/shader.hpp"
+#include "star/scene/bounds.hpp"
+#include "star/scene/entity_registry.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <array>
+#include <string>
+#include <vector>
+
+namespace star {
+    class EncoderState;
+    class Mesh;
+    class RenderChain;
+    class RenderPassBuilder;
+    class StaticBatcher;
+
+    struct ShadowSettings {
+        uint32_t cascade_count{4};
+        // size of one cascade, the cascades share one atlas
+        uint16_t resolution{1024};
+        // view depth the last cascade ends at, clamped to the far clip
+        float distance{100.0f};
+        // blend between uniform (0) and logarithmic (1) split distances
+        float split_lambda{0.75f};
+        // how far towards the light casters outside a cascade are still drawn into it
+        float caster_distance{100.0f};
+        // fraction of its radius a cascade may lag behind the camera before it is refit, the cascades are padded
+        // by the same amount so the view stays covered
+        float refit_threshold{0.1f};
+        float depth_bias{0.001f};
+        // receiver offset along the normal, in shadow map texels
+        float normal_bias{1.5f};
+    };
+
+    // cascaded shadow maps for the first directional Light that casts shadows. Static casters (StaticTag and the
+    // StaticBatcher batches) and dynamic casters go to two separate atlases, the static one is only redrawn when a
+    // static object changes or a cascade is refit. Lit shaders take the closer of the two depths
+    class STAR_EXPORT ShadowMaps final {
+    public:
+        static constexpr uint32_t k_max_cascades = 4;
+
+        ShadowMaps();
+
+        ~ShadowMaps();
+
+        ShadowMaps(const ShadowMaps &) = delete;
+
+        ShadowMaps &operator=(const ShadowMaps &) = delete;
+
+        bool init(const ShadowSettings &settings = {});
+
+        void shutdown();
+
+        bool is_valid() const;
+
+        // adds a static and a dynamic view per cascade for the owner, they have to come before the views sampling
+        // the maps
+        void render_reset(RenderChain &chain, const void *owner);
+
+        // for owners drawing through chain passes: adds the cascades as passes named after the prefix, in front of
+        // the passes added after it. The static atlas is imported, it keeps its casters between frames, the
+        // dynamic one is a transient of the chain
+        void add_passes(RenderChain &chain, const std::string &prefix);
+
+        // has to run before shutdown when the passes were added
+        void remove_passes(RenderChain &chain);
+
+        // declares the atlases of add_passes as read by a pass sampling them
+        void read_atlases(RenderPassBuilder &builder) const;
+
+        // fits the cascades to the camera and draws the casters that need it
+        void render(const EntityRegistry &registry, const StaticBatcher *batcher, const glm::mat4 &view,
+                    const glm::mat4 &projection, float near_clip, float far_clip, bgfx::Encoder &encoder);
+
+        // sets the shadow atlases and uniforms for the next draw
+        void bind(EncoderState &state) const;
+
+        // redraws the static casters on the next render, for changes that do not show in the transform versions
+        void invalidate_static();
+
+        // false while no directional light casts shadows
+        bool is_active() const { return _active; }
+
+        uint32_t get_cascade_count() const { return _settings.cascade_count; }
+
+        // view depth each cascade ends at
+        float get_cascade_split(uint32_t cascade) const;
+
+        // number of times a cascade's static casters were drawn since init
+        uint32_t get_static_redraw_count() const { return _static_redraws; }
+
+        // casters drawn by the last render, static ones only count when they were redrawn
+        uint32_t get_caster_draw_count() const { return _caster_draws; }
+
+        const ShadowSettings &get_settings() const { return _settings; }
+
+    private:
+        struct Cascade {
+            glm::mat4 view{1.0f};
+            glm::mat4 projection{1.0f};
+            // world to atlas texture coordinates and depth
+            glm::mat4 shadow_matrix{1.0f};
+            Frustum frustum;
+            // light space center, snapped to texels
+            glm::vec3 center{0.0f};
+            float radius{0.0f};
+            float split{0.0f};
+            bool fitted{false};
+            bool static_dirty{true};
+        };
+
+        struct Caster {
+            const Mesh *mesh{nullptr};
+            glm::mat4 transform{1.0f};
+            uint64_t state{0};
+        };
+
+        bool find_light(const EntityRegistry &registry, glm::vec3 &direction) const;
+
+        void fit_cascades(const glm::vec3 &direction, const glm::mat4 &view, const glm::mat4 &projection,
+                          float near_clip, float far_clip);
+
+        uint64_t hash_static_casters(const EntityRegistry &registry, const StaticBatcher *batcher) const;
+
+        void collect_casters(const EntityRegistry &registry, const StaticBatcher *batcher, bool static_casters);
+
+        void draw_casters(bgfx::ViewId view_id, const Cascade &cascade, EncoderState &state);
+
+        bool create_view_targets();
+
+        void destroy_view_targets();
+
+        // reads the views and the dynamic atlas of the passes back from the chain
+        bool update_pass_views();
+
+        void set_cascade_rect(bgfx::ViewId view_id, uint32_t cascade) const;
+
+        ShadowSettings _settings;
+
+        std::array<Cascade, k_max_cascades> _cascades{};
+        glm::vec3 _light_direction{0.0f};
+        uint64_t _static_hash{0};
+        bool _active{false};
+
+        std::vector<Caster> _casters;
+        std::vector<BoundingSphere> _caster_bounds;
+        std::vector<uint8_t> _caster_visible;
+        std::vector<uint32_t> _caster_order;
+
+        uint16_t _atlas_width{0};
+        uint16_t _atlas_height{0};
+        bgfx::TextureFormat::Enum _atlas_format{bgfx::TextureFormat::D16};
+        bgfx::TextureHandle _static_atlas{BGFX_INVALID_HANDLE};
+        // owned while the views are used, the chain's transient while the passes are
+        bgfx::TextureHandle _dynamic_atlas{BGFX_INVALID_HANDLE};
+        // the views only, the chain builds the framebuffers of the passes
+        bgfx::FrameBufferHandle _static_framebuffer{BGFX_INVALID_HANDLE};
+        bgfx::FrameBufferHandle _dynamic_framebuffer{BGFX_INVALID_HANDLE};
+        std::array<bgfx::ViewId, k_max_cascades> _static_views{};
+        std::array<bgfx::ViewId, k_max_cascades> _dynamic_views{};
+        bool _has_views{false};
+
+        // set between add_passes and remove_passes
+        RenderChain *_chain{nullptr};
+        std::array<std::string, k_max_cascades> _static_pass_names;
+        std::array<std::string, k_max_cascades> _dynamic_pass_names;
+        std::string _dynamic_clear_pass_name;
+        std::string _static_atlas_name;
+        std::string _dynamic_atlas_name;
+        // cascades redrawn this frame, their passes clear them
+        std::array<bool, k_max_cascades> _static_redrawn{};
+
+        Shader _depth_shader;
+        Shader _depth_instanced_shader;
+
+        uint32_t _static_redraws{0};
+        uint32_t _caster_draws{0};
+
+        std::array<glm::mat4, k_max_cascades> _shadow_matrices{};
+        glm::vec4 _splits{0.0f};
+        glm::vec4 _params{0.0f};
+        glm::vec4 _offsets{0.0f};
+
+        ShaderSampler _static_sampler;
+        ShaderSampler _dynamic_sampler;
+        ShaderUniform _matrix_uniform;
+        ShaderUniform _split_uniform;
+        ShaderUniform _param_uniform;
+        ShaderUniform _offset_uniform;
+    };
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "star/export.hpp"
+#include "star/scene/scene.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace star {
+    // marks an entity that never moves, its MeshRenderer gets merged into a StaticBatcher batch
+    struct STAR_EXPORT StaticTag {
+    };
+
+    // added by StaticBatcher to the entities a batch currently draws, renderers skip them
+    struct STAR_EXPORT StaticBatched {
+    };
+
+    struct STAR_EXPORT StaticBatch {
+        // world space geometry, drawn with an identity transform
+        MeshRenderer renderer;
+        uint32_t entity_count{0};
+    };
+
+    // merges the geometry of StaticTag entities into one mesh per material and layer. Vertices are pre-transformed
+    // and the tint is baked into the vertex color. Source meshes need keep_cpu_data, the ones without it, meshes
+    // over 65536 vertices, entities with more than one LOD and translucent materials keep drawing individually
+    class STAR_EXPORT StaticBatcher final : public ITypeSceneComponent<StaticBatcher> {
+    public:
+        StaticBatcher();
+
+        ~StaticBatcher() override;
+
+        void init(Scene &scene, App &app) override;
+
+        void shutdown() override;
+
+        // picks up finished bakes and starts a new one on the worker thread once the static entities changed
+        void update(float delta_time) override;
+
+        // bakes on the calling thread, for scene build time
+        void build();
+
+        // for changes that are not visible from the outside, like a new mesh assigned to a static MeshRenderer
+        void mark_dirty();
+
+        bool is_building() const;
+
+        const std::vector<std::unique_ptr<StaticBatch> > &get_batches() const;
+
+        struct Source {
+            Entity entity{entt::null};
+            std::shared_ptr<Mesh> mesh;
+            std::shared_ptr<Material> material;
+            glm::mat4 model{1.0f};
+            glm::vec4 tint{1.0f};
+            uint8_t layer{0};
+            uint32_t transform_version{0};
+        };
+
+        struct BakedGeometry {
+            std::shared_ptr<Material> material;
+            uint8_t layer{0};
+            uint32_t entity_count{0};
+            std::vector<Vertex> vertices;
+            std::vector<uint16_t> indices;
+        };
+
+        // CPU only, one geometry per layer and material, split wherever the next source would overflow the 16 bit
+        // indices. Mirroring models get their triangles turned around
+        static std::vector<BakedGeometry> bake(const std::vector<Source> &sources);
+
+    private:
+        struct BakeResult {
+            uint32_t generation{0};
+            std::vector<Source> sources;
+            std::vector<BakedGeometry> geometry;
+        };
+
+        std::vector<Source> gather_sources() const;
+
+        void start_bake();
+
+        void apply(BakeResult &&result);
+
+        bool sources_changed() const;
+
+        void on_static_changed(EntityRegistry &registry, Entity entity);
+
+        void on_renderer_changed(EntityRegistry &registry, Entity entity);
+
+        Scene *_scene{nullptr};
+        std::unique_ptr<ThreadPool> _worker;
+        std::mutex _result_mutex;
+        std::optional<BakeResult> _result;
+        std::atomic<bool> _building{false};
+        bool _dirty{true};
+        uint32_t _generation{0};
+        std::vector<Source> _baked;
+        std::vector<std::unique_ptr<StaticBatch> > _batches;
+    };
+}
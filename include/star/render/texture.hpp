@@ -1,29 +1,146 @@
 #pragma once
 
+#include "star/export.hpp"
+#include "star/app/app_component.hpp"
+#include <bgfx/bgfx.h>
+#include <glm/glm.hpp>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace bimg {
+    struct ImageContainer;
+}
+
 namespace star {
+    class Texture;
+    class ThreadPool;
+
+    // a texture bound to one of the sampler slots of a material's shader
     struct TextureSampler {
         bgfx::TextureHandle handle{BGFX_INVALID_HANDLE};
+        // looked up on every bind while set, so a texture still loading is swapped in once it is uploaded
+        std::shared_ptr<const Texture> texture;
         bgfx::UniformHandle sampler{BGFX_INVALID_HANDLE};
-        std::string name;
         uint8_t stage{0};
         uint32_t flags{BGFX_SAMPLER_NONE};
 
-        TextureSampler() = default;
+        bgfx::TextureHandle get_handle() const;
+
+        bool is_valid() const;
+    };
 
-        TextureSampler(const std::string &sampler_name, uint8_t texture_stage = 0);
+    enum class TextureState : uint8_t {
+        Loading,
+        Ready,
+        Failed
+    };
 
-        ~TextureSampler();
+    struct TextureLoadOptions {
+        uint64_t flags{BGFX_TEXTURE_NONE | BGFX_SAMPLER_NONE};
+        // builds the mip chain of 8 bit 2D images that come without one
+        bool generate_mips{true};
+    };
 
-        TextureSampler(const TextureSampler &) = delete;
+    // an image file decoded by bimg. Until it is uploaded the handle is the placeholder of the cache that loaded it
+    class STAR_EXPORT Texture final {
+    public:
+        Texture(std::string path, bgfx::TextureHandle placeholder);
 
-        TextureSampler &operator=(const TextureSampler &) = delete;
+        ~Texture();
 
-        TextureSampler(TextureSampler &&other) noexcept;
+        Texture(const Texture &) = delete;
 
-        TextureSampler &operator=(TextureSampler &&other) noexcept;
+        Texture &operator=(const Texture &) = delete;
 
-        bool is_valid() const;
+        const std::string &get_path() const { return _path; }
+
+        TextureState get_state() const { return _state.load(std::memory_order_acquire); }
+
+        bool is_ready() const { return get_state() == TextureState::Ready; }
+
+        bgfx::TextureHandle get_handle() const;
+
+        glm::uvec3 get_size() const { return _size; }
+
+        uint8_t get_mip_count() const { return _mip_count; }
+
+        bgfx::TextureFormat::Enum get_format() const { return _format; }
+
+    private:
+        friend class TextureCache;
 
         void destroy();
+
+        std::string _path;
+        bgfx::TextureHandle _handle{BGFX_INVALID_HANDLE};
+        bgfx::TextureHandle _placeholder{BGFX_INVALID_HANDLE};
+        std::atomic<TextureState> _state{TextureState::Loading};
+        glm::uvec3 _size{0};
+        uint8_t _mip_count{0};
+        bgfx::TextureFormat::Enum _format{bgfx::TextureFormat::Unknown};
+    };
+
+    // hands out one shared Texture per path. Reading, decoding and mip generation run on worker threads, the
+    // finished images are uploaded on update without another copy. Entries nobody else references are evicted
+    class STAR_EXPORT TextureCache final : public ITypeAppComponent<TextureCache> {
+    public:
+        explicit TextureCache(size_t thread_count = 0);
+
+        ~TextureCache() override;
+
+        TextureCache(const TextureCache &) = delete;
+
+        TextureCache &operator=(const TextureCache &) = delete;
+
+        void init(App &app) override;
+
+        void shutdown() override;
+
+        void update(float delta_time) override;
+
+        // the options of the first load of a path are the ones used. Null before init, the textures would
+        // otherwise keep an invalid placeholder
+        std::shared_ptr<Texture> load(const std::string &path, const TextureLoadOptions &options = {});
+
+        // uploads the images the workers finished, returns how many
+        size_t upload_pending();
+
+        // blocks until every queued file is decoded, they still have to be uploaded
+        void wait_idle() const;
+
+        // returns the number of textures released
+        size_t evict_unused();
+
+        void clear();
+
+        size_t get_size() const;
+
+        size_t get_loading_count() const;
+
+        bgfx::TextureHandle get_placeholder() const { return _placeholder; }
+
+    private:
+        struct Decoded {
+            std::shared_ptr<Texture> texture;
+            bimg::ImageContainer *image{nullptr};
+            uint64_t flags{0};
+        };
+
+        // "a/../b.png" and "b.png", or either separator, end up as one texture
+        static std::string normalize_path(const std::string &path);
+
+        void decode(const std::shared_ptr<Texture> &texture, const TextureLoadOptions &options);
+
+        std::unique_ptr<ThreadPool> _pool;
+        bgfx::TextureHandle _placeholder{BGFX_INVALID_HANDLE};
+        std::atomic<bool> _cancelled{false};
+        std::atomic<size_t> _loading_count{0};
+        mutable std::mutex _mutex;
+        std::unordered_map<std::string, std::shared_ptr<Texture> > _textures;
+        std::vector<Decoded> _decoded;
     };
 }
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <compare>
+#include <cstdint>
+#include <string_view>
+
+namespace star {
+    // a uniform or sampler name hashed with FNV-1a, constant ids are hashed at compile time
+    struct UniformId {
+        uint32_t hash{0};
+
+        constexpr UniformId() = default;
+
+        constexpr explicit UniformId(const std::string_view name)
+            : hash(hash_name(name)) {
+        }
+
+        static constexpr uint32_t hash_name(const std::string_view name) {
+            uint32_t result = 0x811c9dc5u;
+            for (const char c: name) {
+                result ^= static_cast<uint8_t>(c);
+                result *= 0x01000193u;
+            }
+            return result;
+        }
+
+        constexpr bool is_valid() const { return hash != 0; }
+
+        constexpr auto operator<=>(const UniformId &other) const = default;
+    };
+
+    constexpr UniformId k_uniform_color{"u_color"};
+    constexpr UniformId k_uniform_base_color{"u_baseColor"};
+    constexpr UniformId k_uniform_emissive{"u_emissive"};
+    constexpr UniformId k_uniform_material_params{"u_materialParams"};
+    constexpr UniformId k_uniform_tint{"u_tint"};
+
+    constexpr UniformId k_sampler_color{"s_texColor"};
+    constexpr UniformId k_sampler_normal{"s_texNormal"};
+    constexpr UniformId k_sampler_metallic_roughness{"s_texMetallicRoughness"};
+    constexpr UniformId k_sampler_emissive{"s_texEmissive"};
+}
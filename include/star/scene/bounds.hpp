@@ -0,0 +1,88 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <glm/glm.hpp>
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace star {
+    class Transform;
+
+    struct STAR_EXPORT Aabb {
+        glm::vec3 min{0.0f};
+        glm::vec3 max{0.0f};
+
+        glm::vec3 get_center() const { return (min + max) * 0.5f; }
+        glm::vec3 get_extents() const { return (max - min) * 0.5f; }
+
+        Aabb transform(const glm::mat4 &matrix) const;
+
+        bool operator==(const Aabb &other) const = default;
+    };
+
+    // exactly 16 bytes so batches can be loaded straight into SIMD registers
+    struct STAR_EXPORT BoundingSphere {
+        glm::vec3 center{0.0f};
+        float radius{0.0f};
+
+        BoundingSphere transform(const glm::mat4 &matrix) const;
+
+        bool operator==(const BoundingSphere &other) const = default;
+    };
+
+    class STAR_EXPORT Frustum {
+    public:
+        enum Plane : uint8_t {
+            Left,
+            Right,
+            Bottom,
+            Top,
+            Near,
+            Far,
+            Count
+        };
+
+        Frustum();
+
+        // planes of a view-projection matrix with a -1..1 clip depth range, normals pointing inwards
+        static Frustum from_matrix(const glm::mat4 &view_projection);
+
+        const glm::vec4 &get_plane(Plane plane) const { return _planes[plane]; }
+
+        bool intersects(const BoundingSphere &sphere, uint32_t plane_count = Count) const;
+
+        bool intersects(const Aabb &aabb, uint32_t plane_count = Count) const;
+
+        // writes 1 for every volume touching the frustum and 0 otherwise, returns the number of visible volumes
+        size_t cull(std::span<const BoundingSphere> spheres, std::span<uint8_t> visible,
+                    uint32_t plane_count = Count) const;
+
+        size_t cull(std::span<const Aabb> aabbs, std::span<uint8_t> visible, uint32_t plane_count = Count) const;
+
+    private:
+        std::array<glm::vec4, Count> _planes;
+    };
+
+    // world space bounds of an entity, only recomputed when the transform version or the local bounds change
+    class STAR_EXPORT WorldBounds {
+    public:
+        bool update(const Transform *transform, const Aabb &local_aabb, const BoundingSphere &local_sphere);
+
+        void invalidate();
+
+        bool is_valid() const { return _valid; }
+
+        const Aabb &get_aabb() const { return _aabb; }
+
+        const BoundingSphere &get_sphere() const { return _sphere; }
+
+    private:
+        Aabb _aabb;
+        BoundingSphere _sphere;
+        Aabb _local_aabb;
+        BoundingSphere _local_sphere;
+        uint32_t _transform_version{0};
+        bool _valid{false};
+    };
+}
@@ -4,9 +4,12 @@
 #include <glm/glm.hpp>
 
 #include "entity_registry.hpp"
+#include "star/render/render_target_pool.hpp"
+#include "star/scene/bounds.hpp"
 
 namespace star {
     class App;
+    class RenderChain;
     class Scene;
     class Transform;
 
@@ -31,7 +34,9 @@ namespace star {
         virtual void update(float delta_time) {
         }
 
-        virtual bgfx::ViewId render_reset(bgfx::ViewId view_id) { return view_id; }
+        // adds the views the component draws the camera into
+        virtual void render_reset(RenderChain &chain) {
+        }
 
         virtual void before_render_view(bgfx::ViewId view_id, bgfx::Encoder &encoder) {
         }
@@ -61,17 +66,44 @@ namespace star {
     public:
         virtual ~ICullingFilter() = default;
 
+        virtual void set_view_projection(const glm::mat4 &view_projection) {
+        }
+
         virtual bool is_visible(const glm::vec3 &position, float radius) const = 0;
+
+        // batch tests, writes 1 into visible for every volume that passes and returns how many passed
+        virtual size_t cull(std::span<const BoundingSphere> spheres, std::span<uint8_t> visible) const;
+
+        virtual size_t cull(std::span<const Aabb> aabbs, std::span<uint8_t> visible) const;
     };
 
+    // tests against the side planes only, depth is ignored
     class STAR_EXPORT Culling2D final : public ICullingFilter {
     public:
+        void set_view_projection(const glm::mat4 &view_projection) override;
+
         bool is_visible(const glm::vec3 &position, float radius) const override;
+
+        size_t cull(std::span<const BoundingSphere> spheres, std::span<uint8_t> visible) const override;
+
+        size_t cull(std::span<const Aabb> aabbs, std::span<uint8_t> visible) const override;
+
+    private:
+        Frustum _frustum;
     };
 
     class STAR_EXPORT Culling3D final : public ICullingFilter {
     public:
+        void set_view_projection(const glm::mat4 &view_projection) override;
+
         bool is_visible(const glm::vec3 &position, float radius) const override;
+
+        size_t cull(std::span<const BoundingSphere> spheres, std::span<uint8_t> visible) const override;
+
+        size_t cull(std::span<const Aabb> aabbs, std::span<uint8_t> visible) const override;
+
+    private:
+        Frustum _frustum;
     };
 
     class CameraImpl {
@@ -94,6 +126,10 @@ namespace star {
 
         void set_ortho(const glm::vec2 &size, float near_clip, float far_clip);
 
+        float get_near_clip() const { return _near_clip; }
+
+        float get_far_clip() const { return _far_clip; }
+
         void set_viewport(const glm::vec4 &viewport);
 
         const glm::vec4 &get_viewport() const { return _viewport; }
@@ -106,7 +142,16 @@ namespace star {
 
         uint16_t get_clear_flags() const { return _clear_flags; }
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        void set_render_target(const glm::uvec2 &size, bgfx::TextureFormat::Enum color_format,
+                               bgfx::TextureFormat::Enum depth_format);
+
+        void clear_render_target();
+
+        const RenderTarget *get_render_target() const;
+
+        glm::uvec2 get_render_size() const;
+
+        void render_reset(RenderChain &chain);
 
         void render() const;
 
@@ -122,6 +167,10 @@ namespace star {
 
         const ICullingFilter *get_culling_filter() const;
 
+        const Frustum &get_frustum() const;
+
+        float get_screen_size(const BoundingSphere &sphere) const;
+
         glm::vec3 screen_to_world_point(const glm::vec2 &screen_pos, float depth) const;
 
         glm::vec2 world_to_screen_point(const glm::vec3 &world_pos) const;
@@ -152,6 +201,12 @@ namespace star {
     private:
         void update_matrices() const;
 
+        void set_view_rect(bgfx::ViewId view_id) const;
+
+        void update_render_target();
+
+        bgfx::FrameBufferHandle get_framebuffer() const;
+
         Camera &_camera;
         Scene *_scene{nullptr};
         App *_app{nullptr};
@@ -170,6 +225,13 @@ namespace star {
         glm::vec4 _clear_color{0.2f, 0.2f, 0.2f, 1.0f};
         uint16_t _clear_flags{BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH};
 
+        std::optional<glm::uvec2> _target_size;
+        // the size the views were last reset for
+        std::optional<glm::uvec2> _reset_target_size;
+        bgfx::TextureFormat::Enum _target_color_format{bgfx::TextureFormat::RGBA8};
+        bgfx::TextureFormat::Enum _target_depth_format{bgfx::TextureFormat::D24S8};
+        RenderTargetId _target;
+
         std::vector<std::unique_ptr<ICameraComponent> > _components;
 
         std::unique_ptr<ICullingFilter> _culling_filter;
@@ -177,8 +239,7 @@ namespace star {
         mutable bool _matrices_dirty{true};
         mutable glm::mat4 _view_matrix{1.0f};
         mutable glm::mat4 _projection_matrix{1.0f};
-
-        bgfx::ViewId _view_id{0};
+        mutable Frustum _frustum;
     };
 
     class STAR_EXPORT Camera {
@@ -201,6 +262,10 @@ namespace star {
 
         ProjectionType get_projection_type() const;
 
+        float get_near_clip() const;
+
+        float get_far_clip() const;
+
         void set_viewport(const glm::vec4 &viewport);
 
         const glm::vec4 &get_viewport() const;
@@ -213,7 +278,22 @@ namespace star {
 
         uint16_t get_clear_flags() const;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        // draws into a framebuffer from the app's RenderTargetPool instead of the backbuffer, the viewport is
+        // relative to the size given here. No depth attachment with a depth format of Count
+        void set_render_target(const glm::uvec2 &size,
+                               bgfx::TextureFormat::Enum color_format = bgfx::TextureFormat::RGBA8,
+                               bgfx::TextureFormat::Enum depth_format = bgfx::TextureFormat::D24S8);
+
+        void clear_render_target();
+
+        // null while the camera draws into the backbuffer, the target may be larger than the render size
+        const RenderTarget *get_render_target() const;
+
+        // size the viewport is relative to, the target size or the window size
+        glm::uvec2 get_render_size() const;
+
+        // adds the views of the camera components to the chain, in the order the components were added
+        void render_reset(RenderChain &chain);
 
         CameraImpl *get_impl() const {
             return _impl.get();
@@ -250,6 +330,11 @@ namespace star {
 
         const ICullingFilter *get_culling_filter() const;
 
+        const Frustum &get_frustum() const;
+
+        // projected diameter of a world space sphere as a fraction of the viewport height
+        float get_screen_size(const BoundingSphere &sphere) const;
+
         glm::vec3 screen_to_world_point(const glm::vec2 &screen_pos, float depth = 0.0f) const;
 
         glm::vec2 world_to_screen_point(const glm::vec3 &world_pos) const;
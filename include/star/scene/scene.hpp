@@ -41,7 +41,8 @@ namespace star {
         virtual void update(float delta_time) {
         }
 
-        virtual bgfx::ViewId render_reset(bgfx::ViewId view_id) { return view_id; }
+        virtual void render_reset(RenderChain &chain) {
+        }
 
         virtual size_t get_scene_component_type() const { return 0; }
         virtual std::string get_scene_component_name() const { return "ISceneComponent"; }
@@ -71,9 +72,9 @@ namespace star {
 
         void render();
 
-        void update(float delta_time) const;
+        void update(float delta_time);
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        void render_reset(RenderChain &chain);
 
         void set_paused(bool paused);
 
@@ -103,13 +104,11 @@ namespace star {
 
         const EntityRegistry &get_registry() const;
 
-        void set_view_id(bgfx::ViewId view_id);
-
-        bgfx::ViewId get_view_id() const;
-
         std::string to_string() const;
 
     private:
+        void update_world_bounds();
+
         void on_camera_constructed(EntityRegistry &registry, Entity entity) const;
 
         void on_camera_destroyed(EntityRegistry &registry, Entity entity) const;
@@ -121,7 +120,6 @@ namespace star {
         ISceneDelegate *_delegate{nullptr};
         EntityRegistry _registry;
         std::vector<std::unique_ptr<ISceneComponent> > _components;
-        bgfx::ViewId _view_id{0};
     };
 
     class STAR_EXPORT Scene {
@@ -138,7 +136,8 @@ namespace star {
 
         void update(float delta_time) const;
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        // adds the views of the cameras, then the ones of the scene components
+        void render_reset(RenderChain &chain);
 
         void set_paused(bool paused) const;
 
@@ -223,6 +222,8 @@ namespace star {
 
         void shutdown() override;
 
+        void render_reset(RenderChain &chain) override;
+
         Scene *get_scene();
 
         const Scene *get_scene() const;
@@ -53,15 +53,20 @@ namespace star {
 
         glm::vec3 inverse_transform_vector(const glm::vec3 &vector) const;
 
+        // bumped on every change so dependent data can tell when it is stale
+        uint32_t get_version() const;
+
     private:
         glm::vec3 _position{0.0f};
         glm::quat _rotation{1.0f, 0.0f, 0.0f, 0.0f};
         glm::vec3 _scale{1.0f};
 
+        uint32_t _version{1};
+
         mutable bool _matrix_dirty{true};
         mutable glm::mat4 _model_matrix{1.0f};
 
-        void mark_dirty() const;
+        void mark_dirty();
 
         void update_matrices() const;
     };
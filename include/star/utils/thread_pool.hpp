@@ -0,0 +1,45 @@
+#pragma once
+
+#include "star/export.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace star {
+    class STAR_EXPORT ThreadPool {
+    public:
+        using Task = std::function<void()>;
+
+        explicit ThreadPool(size_t thread_count = 0);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        size_t get_thread_count() const;
+
+        void submit(Task &&task);
+
+        void parallel_for(size_t job_count, const std::function<void(size_t)> &job);
+
+        void wait_idle();
+
+        static size_t get_hardware_thread_count();
+
+    private:
+        void worker_loop();
+
+        std::vector<std::thread> _threads;
+        std::deque<Task> _tasks;
+        std::mutex _mutex;
+        std::condition_variable _task_available;
+        std::condition_variable _idle;
+        size_t _active_tasks{0};
+        bool _stopping{false};
+    };
+}
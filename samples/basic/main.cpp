@@ -7,6 +7,7 @@
 #include "star/render/scene_renderer.hpp"
 #include "star/render/renderer_components.hpp"
 #include "star/render/mesh.hpp"
+#include "star/render/mesh_cache.hpp"
 #include "star/render/material.hpp"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
@@ -51,8 +52,7 @@ public:
 
         Vertex::init();
 
-        Mesh cube_mesh = Mesh::create_cube(1.0f);
-        mesh_renderer.set_mesh(std::move(cube_mesh));
+        mesh_renderer.set_mesh(_app.get_or_add_component<MeshCache>().get_cube(1.0f));
 
         const auto material = std::make_shared<UnlitMaterial>();
         material->set_color(glm::vec4(0.2f, 0.5f, 1.0f, 1.0f));
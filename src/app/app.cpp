@@ -3,23 +3,36 @@
 #include "star/app/app.hpp"
 #include "star/app/window.hpp"
 #include "star/app/input.hpp"
+#include "star/render/mesh.hpp"
+#include "star/render/render_chain.hpp"
+#include "star/render/render_target_pool.hpp"
+#include "star/render/shader_registry.hpp"
 
 #include <spdlog/spdlog.h>
 
 namespace star {
     int32_t main(const int32_t argc, const char *argv[], std::unique_ptr<IAppDelegateFactory> &&factory) {
-        if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD)) {
-            spdlog::error("SDL initialization failed: {}", SDL_GetError());
-            return 1;
-        }
-
+        const CmdArgs args(argv, argc);
         const auto app = std::make_unique<App>();
 
+        if (std::ranges::any_of(args, [](const char *arg) { return std::string_view(arg) == "--headless"; })) {
+            AppConfig config = app->get_config();
+            config.headless = true;
+            app->set_config(config);
+        }
+
         if (factory) {
             app->set_delegate(factory->create_delegate(*app));
         }
 
-        const CmdArgs args(argv, argc);
+        // only the quit events are needed without a display
+        const SDL_InitFlags sdl_flags = app->is_headless()
+                                            ? SDL_INIT_EVENTS
+                                            : SDL_INIT_VIDEO | SDL_INIT_AUDIO | SDL_INIT_GAMEPAD;
+        if (!SDL_Init(sdl_flags)) {
+            spdlog::error("SDL initialization failed: {}", SDL_GetError());
+            return 1;
+        }
 
         const auto result = app->run(args);
 
@@ -30,7 +43,9 @@ namespace star {
     AppImpl::AppImpl(App &app)
         : _app(app)
           , _window(std::make_unique<Window>())
-          , _input(std::make_unique<Input>()) {
+          , _input(std::make_unique<Input>())
+          , _render_chain(std::make_unique<RenderChain>())
+          , _render_target_pool(std::make_unique<RenderTargetPool>()) {
         _input->get_keyboard().add_listener(*this);
     }
 
@@ -43,11 +58,19 @@ namespace star {
             return 1;
         }
 
+        const bool fixed_tick = _config.headless && _config.tick_rate > 0.0f;
+        auto next_tick = std::chrono::steady_clock::now();
+
         while (_running) {
             const auto current_time = std::chrono::high_resolution_clock::now();
-            const auto delta_time = std::chrono::duration<float>(current_time - _last_update).count();
+            auto delta_time = std::chrono::duration<float>(current_time - _last_update).count();
             _last_update = current_time;
 
+            // a simulation stepped by whole ticks stays the same however long a tick actually took
+            if (fixed_tick) {
+                delta_time = 1.0f / _config.tick_rate;
+            }
+
             process_events();
 
             if (!_paused) {
@@ -56,7 +79,11 @@ namespace star {
 
             render_frame();
 
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (fixed_tick) {
+                wait_for_tick(next_tick);
+            } else if (!_config.headless) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
         }
 
         shutdown();
@@ -64,7 +91,10 @@ namespace star {
     }
 
     bool AppImpl::initialize(const CmdArgs &args) {
-        if (!_window->init(_video_mode)) {
+        if (_config.headless) {
+            _window->set_size(_config.headless_size);
+            _render_size = _window->get_size();
+        } else if (!_window->init(_video_mode)) {
             spdlog::error("Failed to initialize window");
             return false;
         }
@@ -104,6 +134,9 @@ namespace star {
             _delegate.reset();
         }
 
+        _render_chain->shutdown();
+        _render_target_pool->shutdown();
+        ShaderRegistry::get().shutdown();
         bgfx::shutdown();
 
         _window->shutdown();
@@ -139,16 +172,44 @@ namespace star {
             _render_size = size;
             _video_mode = video_mode;
             _active_reset_flags = _reset_flags;
-            request_render_reset();
+            _backbuffer_reset = true;
         }
 
         if (_render_reset) {
             _render_reset = false;
+            _backbuffer_reset = false;
             render_reset();
+        } else if (_backbuffer_reset || _render_chain->is_dirty()) {
+            if (_backbuffer_reset) {
+                _backbuffer_reset = false;
+                bgfx::reset(size.x, size.y, _active_reset_flags);
+            }
+
+            // the views a shrinking chain gave up are left to the next render reset
+            _view_count = std::max(_view_count, _render_chain->compile(0, size));
+        }
+    }
+
+    void AppImpl::wait_for_tick(std::chrono::steady_clock::time_point &next_tick) const {
+        next_tick += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<float>(1.0f / _config.tick_rate));
+
+        // a tick that ran over does not make the following ones run back to back to catch up
+        const auto now = std::chrono::steady_clock::now();
+        if (next_tick < now) {
+            next_tick = now;
+            return;
         }
+        std::this_thread::sleep_until(next_tick);
     }
 
     void AppImpl::render_frame() {
+        if (_config.headless && !_config.headless_render) {
+            TransientMesh::end_frame(bgfx::frame());
+            _render_target_pool->update();
+            return;
+        }
+
         if (_delegate) {
             _delegate->pre_render();
         }
@@ -164,75 +225,86 @@ namespace star {
             component->render();
         }
 
+        auto &encoder = *bgfx::begin();
+        _render_chain->render(encoder);
+        bgfx::end(&encoder);
+
         if (_delegate) {
             _delegate->post_render();
         }
 
-        bgfx::frame();
+        TransientMesh::end_frame(bgfx::frame());
+        _render_target_pool->update();
     }
 
     void AppImpl::render_reset() {
         const auto size = _window->get_size();
         bgfx::reset(size.x, size.y, _active_reset_flags);
 
-        const auto numViews = bgfx::getCaps()->limits.maxViews;
-        for (bgfx::ViewId i = 0; i < numViews; ++i) {
+        for (bgfx::ViewId i = 0; i < _view_count; ++i) {
             bgfx::resetView(i);
         }
 
-        bgfx::ViewId id = 0;
-
-        bgfx::setViewName(id, "App clear");
-        bgfx::setViewRect(id, 0, 0, bgfx::BackbufferRatio::Equal);
-        constexpr uint16_t clearFlags = BGFX_CLEAR_DEPTH | BGFX_CLEAR_COLOR | BGFX_CLEAR_STENCIL;
-        static constexpr uint8_t clearColor = 1;
-        bgfx::setViewClear(id, clearFlags, 1.F, 0U,
-                           clearColor, clearColor, clearColor, clearColor,
-                           clearColor, clearColor, clearColor, clearColor);
-        ++id;
+        // the frame touches view 0, it has to stay the clear view
+        _render_chain->clear_views();
+        _render_chain->add_view("App clear", this, [](const bgfx::ViewId id) {
+            bgfx::setViewName(id, "App clear");
+            bgfx::setViewRect(id, 0, 0, bgfx::BackbufferRatio::Equal);
+            constexpr uint16_t clearFlags = BGFX_CLEAR_DEPTH | BGFX_CLEAR_COLOR | BGFX_CLEAR_STENCIL;
+            static constexpr uint8_t clearColor = 1;
+            bgfx::setViewClear(id, clearFlags, 1.F, 0U,
+                               clearColor, clearColor, clearColor, clearColor,
+                               clearColor, clearColor, clearColor, clearColor);
+        });
 
         if (_delegate) {
-            id = _delegate->render_reset(id);
+            _delegate->render_reset(*_render_chain);
         }
 
         for (const auto &component: Components(_components)) {
-            id = component->render_reset(id);
+            component->render_reset(*_render_chain);
         }
+
+        _view_count = _render_chain->compile(0, size);
     }
 
     void AppImpl::bgfx_init() const {
         bgfx::Init init;
         bgfx::PlatformData platform_data{};
 
-        if (_renderer_type != bgfx::RendererType::Count) {
+        if (_config.headless) {
+            // nothing to present to, the renderer only has to accept the calls
+            init.type = bgfx::RendererType::Noop;
+        } else if (_renderer_type != bgfx::RendererType::Count) {
             init.type = _renderer_type;
         }
 
-        SDL_Window *window = _window->get_native_handle();
+        // the Noop backend has no swap chain, the platform data stays zeroed
+        if (!_config.headless) {
+            SDL_Window *window = _window->get_native_handle();
+            const SDL_PropertiesID properties = SDL_GetWindowProperties(window);
 
-        // TODO: MOVE IT FOR PLATFORM SPECIFIC ABSTRACTION
+            // TODO: MOVE IT FOR PLATFORM SPECIFIC ABSTRACTION
 #if defined(STAR_PLATFORM_WINDOWS)
-        const auto hwnd = static_cast<HWND>(SDL_GetPointerProperty(SDL_GetWindowProperties(window),
-                                                                   SDL_PROP_WINDOW_WIN32_HWND_POINTER,
-                                                                   nullptr));
-        platform_data.nwh = hwnd;
+            platform_data.nwh = SDL_GetPointerProperty(properties, SDL_PROP_WINDOW_WIN32_HWND_POINTER, nullptr);
 #elif defined(STAR_PLATFORM_LINUX)
-    if (SDL_strcmp(SDL_GetCurrentVideoDriver(), "x11") == 0) {
-        Display *xdisplay = (Display *)SDL_GetPointerProperty(SDL_GetWindowProperties(sdl_window), SDL_PROP_WINDOW_X11_DISPLAY_POINTER, NULL);
-        Window xwindow = (Window)SDL_GetNumberProperty(SDL_GetWindowProperties(sdl_window), SDL_PROP_WINDOW_X11_WINDOW_NUMBER, 0);
-        if (xdisplay && xwindow) {
-            platform_data.ndt = xdisplay;
-            platform_data.nwh = (void *)(uintptr_t)xwindow;
-        }
-    } else if (SDL_strcmp(SDL_GetCurrentVideoDriver(), "wayland") == 0) {
-        struct wl_display *display = (struct wl_display *)SDL_GetPointerProperty(SDL_GetWindowProperties(sdl_window), SDL_PROP_WINDOW_WAYLAND_DISPLAY_POINTER, NULL);
-        struct wl_surface *surface = (struct wl_surface *)SDL_GetPointerProperty(SDL_GetWindowProperties(sdl_window), SDL_PROP_WINDOW_WAYLAND_SURFACE_POINTER, NULL);
-        if (display && surface) {
-            platform_data.ndt = xdisplay;
-            platform_data.nwh = (void *)(uintptr_t)xwindow;
-        }
-    }
+            if (SDL_strcmp(SDL_GetCurrentVideoDriver(), "x11") == 0) {
+                void *display = SDL_GetPointerProperty(properties, SDL_PROP_WINDOW_X11_DISPLAY_POINTER, nullptr);
+                const auto x11_window = SDL_GetNumberProperty(properties, SDL_PROP_WINDOW_X11_WINDOW_NUMBER, 0);
+                if (display && x11_window) {
+                    platform_data.ndt = display;
+                    platform_data.nwh = reinterpret_cast<void *>(static_cast<uintptr_t>(x11_window));
+                }
+            } else if (SDL_strcmp(SDL_GetCurrentVideoDriver(), "wayland") == 0) {
+                void *display = SDL_GetPointerProperty(properties, SDL_PROP_WINDOW_WAYLAND_DISPLAY_POINTER, nullptr);
+                void *surface = SDL_GetPointerProperty(properties, SDL_PROP_WINDOW_WAYLAND_SURFACE_POINTER, nullptr);
+                if (display && surface) {
+                    platform_data.ndt = display;
+                    platform_data.nwh = surface;
+                }
+            }
 #endif
+        }
 
         init.platformData = platform_data;
         init.debug = _debug_flags;
@@ -318,6 +390,22 @@ namespace star {
         return _update_config;
     }
 
+    void AppImpl::set_config(const AppConfig &config) {
+        if (_running) {
+            spdlog::warn("AppImpl::set_config - The config can only be changed before the app runs");
+            return;
+        }
+        _config = config;
+    }
+
+    const AppConfig &AppImpl::get_config() const {
+        return _config;
+    }
+
+    bool AppImpl::is_headless() const {
+        return _config.headless;
+    }
+
     void AppImpl::set_clear_color(const glm::vec4 &color) {
         _clear_color = color;
     }
@@ -400,6 +488,22 @@ namespace star {
         return *_window;
     }
 
+    RenderChain &AppImpl::get_render_chain() {
+        return *_render_chain;
+    }
+
+    const RenderChain &AppImpl::get_render_chain() const {
+        return *_render_chain;
+    }
+
+    RenderTargetPool &AppImpl::get_render_target_pool() {
+        return *_render_target_pool;
+    }
+
+    const RenderTargetPool &AppImpl::get_render_target_pool() const {
+        return *_render_target_pool;
+    }
+
     // AssetContext& AppImpl::get_assets() {
     // }
     //
@@ -495,6 +599,18 @@ namespace star {
         return _impl->get_update_config();
     }
 
+    void App::set_config(const AppConfig &config) const {
+        _impl->set_config(config);
+    }
+
+    const AppConfig &App::get_config() const {
+        return _impl->get_config();
+    }
+
+    bool App::is_headless() const {
+        return _impl->is_headless();
+    }
+
     void App::set_clear_color(const Vector4 &color) {
         _impl->set_clear_color(color);
     }
@@ -538,6 +654,22 @@ namespace star {
         return _impl->get_input();
     }
 
+    RenderChain &App::get_render_chain() {
+        return _impl->get_render_chain();
+    }
+
+    const RenderChain &App::get_render_chain() const {
+        return _impl->get_render_chain();
+    }
+
+    RenderTargetPool &App::get_render_target_pool() {
+        return _impl->get_render_target_pool();
+    }
+
+    const RenderTargetPool &App::get_render_target_pool() const {
+        return _impl->get_render_target_pool();
+    }
+
     // AssetContext& App::get_assets() {
     //     return _impl->get_assets();
     // }
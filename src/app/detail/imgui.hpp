@@ -67,7 +67,9 @@ namespace star
 
         ~ImguiRenderPass();
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        void render_reset(RenderChain &chain);
+
+        void remove_pass(RenderChain &chain);
 
         void render() const;
 
@@ -76,7 +78,7 @@ namespace star
     private:
         IImguiRenderer &_renderer;
         ImGuiContext *_imgui;
-        std::optional<bgfx::ViewId> _view_id;
+        RenderChain *_chain{nullptr};
         bgfx::TextureHandle _fonts_texture;
         bgfx::ProgramHandle _program;
         bgfx::VertexLayout _vertex_layout;
@@ -100,7 +102,7 @@ namespace star
 
         void shutdown();
 
-        bgfx::ViewId render_reset(bgfx::ViewId view_id);
+        void render_reset(RenderChain &chain);
 
         void render() const;
 
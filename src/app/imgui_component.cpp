@@ -3,6 +3,7 @@
 #include "star/app/app.hpp"
 #include "star/app/window.hpp"
 #include "star/app/input.hpp"
+#include "star/render/render_chain.hpp"
 #include <imgui.h>
 #include <bgfx/bgfx.h>
 #include <bgfx/embedded_shader.h>
@@ -11,6 +12,11 @@
 
 namespace star
 {
+    namespace
+    {
+        constexpr const char *k_pass_name = "ImGui";
+    }
+
     ImguiTextureData::ImguiTextureData(const bgfx::TextureHandle &handle)
         : handle{handle}, alpha_blend{false}, mip{0}
     {
@@ -101,12 +107,23 @@ namespace star
         io.Fonts->SetTexID(_fonts_texture.idx);
     }
 
-    bgfx::ViewId ImguiRenderPass::render_reset(bgfx::ViewId view_id)
+    void ImguiRenderPass::render_reset(RenderChain &chain)
     {
-        bgfx::setViewName(view_id, "ImGui");
-        bgfx::setViewMode(view_id, bgfx::ViewMode::Sequential);
-        _view_id = view_id;
-        return ++view_id;
+        // a pass, the views all run before the passes of the renderers. Added again on every reset so it stays
+        // behind the passes of the components reset before it
+        _chain = &chain;
+        chain.remove_pass(k_pass_name);
+        chain.add_pass(k_pass_name, [](RenderPassBuilder &builder)
+        {
+            builder.write(RenderChain::k_backbuffer);
+            builder.set_view_mode(bgfx::ViewMode::Sequential);
+        }, nullptr);
+    }
+
+    void ImguiRenderPass::remove_pass(RenderChain &chain)
+    {
+        chain.remove_pass(k_pass_name);
+        _chain = nullptr;
     }
 
     void ImguiRenderPass::render() const
@@ -133,7 +150,8 @@ namespace star
 
     bool ImguiRenderPass::render(bgfx::Encoder &encoder, ImDrawData *draw_data) const
     {
-        if (!_view_id)
+        const auto pass_view_id = _chain ? _chain->get_view_id(k_pass_name) : std::nullopt;
+        if (!pass_view_id)
         {
             return false;
         }
@@ -148,7 +166,7 @@ namespace star
             return false;
         }
 
-        const auto view_id = _view_id.value();
+        const auto view_id = pass_view_id.value();
 
         float ortho[16];
         bx::mtxOrtho(ortho,
@@ -401,6 +419,10 @@ namespace star
         if (_app)
         {
             _app->get_input().get_keyboard().remove_listener(*this);
+            if (_render_pass)
+            {
+                _render_pass->remove_pass(_app->get_render_chain());
+            }
         }
 
         _app.reset();
@@ -413,13 +435,12 @@ namespace star
         }
     }
 
-    bgfx::ViewId ImGuiComponentImpl::render_reset(bgfx::ViewId view_id)
+    void ImGuiComponentImpl::render_reset(RenderChain &chain)
     {
         if (_render_pass)
         {
-            return _render_pass->render_reset(view_id);
+            _render_pass->render_reset(chain);
         }
-        return view_id;
     }
 
     void ImGuiComponentImpl::render() const
@@ -559,9 +580,9 @@ namespace star
         _impl->shutdown();
     }
 
-    bgfx::ViewId ImGuiComponent::render_reset(const bgfx::ViewId view_id)
+    void ImGuiComponent::render_reset(RenderChain &chain)
     {
-        return _impl->render_reset(view_id);
+        _impl->render_reset(chain);
     }
 
     void ImGuiComponent::render()
@@ -79,10 +79,11 @@ namespace star {
     }
 
     void Window::WindowImpl::set_size(const glm::uvec2 &size) {
+        // without a window the size is only reported back, headless apps render at it
         if (_window) {
             SDL_SetWindowSize(_window, size.x, size.y);
-            _video_mode.size = size;
         }
+        _video_mode.size = size;
     }
 
     glm::uvec2 Window::WindowImpl::get_size() const {
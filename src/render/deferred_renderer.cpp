@@ -0,0 +1,531 @@
+#include "star/core/common.hpp"
+#include "star/render/deferred_renderer.hpp"
+#include "star/app/app.hpp"
+#include "star/graphics/shaders.hpp"
+#include "star/render/draw_collector.hpp"
+#include "star/render/render_chain.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/shader_registry.hpp"
+#include "star/render/static_batcher.hpp"
+#include "star/scene/camera.hpp"
+#include "star/scene/scene.hpp"
+#include <algorithm>
+#include <atomic>
+
+namespace star {
+    namespace {
+        constexpr uint64_t k_target_flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_POINT | BGFX_SAMPLER_UV_CLAMP;
+
+        constexpr uint8_t k_composite_stage = 0;
+
+        std::atomic<uint32_t> s_next_renderer_id{0};
+
+        bool is_target_format_supported(const bgfx::TextureFormat::Enum format) {
+            constexpr uint32_t k_required = BGFX_CAPS_FORMAT_TEXTURE_2D | BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER;
+            return (bgfx::getCaps()->formats[format] & k_required) == k_required;
+        }
+
+        bgfx::TextureFormat::Enum select_format(const bgfx::TextureFormat::Enum preferred,
+                                                const bgfx::TextureFormat::Enum fallback) {
+            return is_target_format_supported(preferred) ? preferred : fallback;
+        }
+
+        // the packing of Camera::configure_view
+        uint32_t pack_color(const glm::vec4 &color) {
+            return static_cast<uint32_t>(color.r * 255) << 24 | static_cast<uint32_t>(color.g * 255) << 16 |
+                   static_cast<uint32_t>(color.b * 255) << 8 | static_cast<uint32_t>(color.a * 255);
+        }
+
+        template<typename Handle>
+        void destroy_handle(Handle &handle) {
+            if (bgfx::isValid(handle)) {
+                bgfx::destroy(handle);
+                handle = BGFX_INVALID_HANDLE;
+            }
+        }
+    }
+
+    DeferredRenderer::DeferredRenderer()
+        // the chain finds passes and textures by name, each renderer adds its own
+        : _prefix("Deferred " + std::to_string(s_next_renderer_id.fetch_add(1, std::memory_order_relaxed))) {
+        _gbuffer_textures.fill(BGFX_INVALID_HANDLE);
+        _pass_names = {_prefix + " GBuffer", _prefix + " Lighting", _prefix + " Forward", _prefix + " Composite"};
+        _gbuffer_names = {_prefix + " Albedo", _prefix + " Normal", _prefix + " Emissive", _prefix + " Depth"};
+        _light_name = _prefix + " Light";
+    }
+
+    DeferredRenderer::~DeferredRenderer() {
+        destroy_handle(_fullscreen_triangle);
+    }
+
+    bool DeferredRenderer::is_supported() {
+        const bgfx::Caps *caps = bgfx::getCaps();
+        return caps && caps->limits.maxFBAttachments >= static_cast<uint32_t>(GBufferTarget::Count) &&
+               is_target_format_supported(bgfx::TextureFormat::RGBA8) &&
+               (is_target_format_supported(bgfx::TextureFormat::D32F) ||
+                is_target_format_supported(bgfx::TextureFormat::D24S8));
+    }
+
+    void DeferredRenderer::init(Scene &scene, App &app) {
+        Renderer::init(scene, app);
+
+        if (!is_supported()) {
+            spdlog::error("DeferredRenderer::init - The backend cannot render into the G-buffer targets");
+            return;
+        }
+
+        if (!_light_clusters.init(_light_cluster_settings)) {
+            spdlog::warn("DeferredRenderer - Light clusters are unavailable, only the ambient term is lit");
+        }
+
+        if (!_shadow_maps.init(_shadow_settings)) {
+            spdlog::warn("DeferredRenderer - Shadow maps are unavailable, lights cast no shadows");
+        }
+
+        const std::array vertex_shaders = {
+            &k_standard_vs, &k_standard_instanced_vs, &k_standard_packed_vs, &k_standard_packed_instanced_vs
+        };
+        bool loaded = _lighting_shader.load(k_fullscreen_vs, k_deferred_light_fs) &&
+                      _composite_shader.load(k_fullscreen_vs, k_deferred_composite_fs);
+        for (size_t i = 0; i < vertex_shaders.size(); ++i) {
+            loaded = loaded && _gbuffer_shaders[i].load(*vertex_shaders[i], k_gbuffer_fs);
+        }
+
+        if (!loaded) {
+            spdlog::error("DeferredRenderer::init - Failed to load the deferred programs");
+            shutdown();
+            return;
+        }
+
+        auto &registry = ShaderRegistry::get();
+        _gbuffer_samplers[static_cast<size_t>(GBufferTarget::Albedo)] = registry.get_sampler("s_gbufferAlbedo", 0);
+        _gbuffer_samplers[static_cast<size_t>(GBufferTarget::Normal)] = registry.get_sampler("s_gbufferNormal", 1);
+        _gbuffer_samplers[static_cast<size_t>(GBufferTarget::Emissive)] = registry.get_sampler("s_gbufferEmissive", 2);
+        _gbuffer_samplers[static_cast<size_t>(GBufferTarget::Depth)] = registry.get_sampler("s_gbufferDepth", 3);
+        _light_sampler = registry.get_sampler("s_lightAccum", k_composite_stage);
+        _params_uniform = registry.get_uniform("u_deferredParams", bgfx::UniformType::Vec4);
+
+        // one triangle covering the whole viewport, the rasterizer clips what lies outside
+        constexpr std::array<glm::vec3, 3> k_vertices = {
+            glm::vec3(-1.0f, -1.0f, 0.0f), glm::vec3(3.0f, -1.0f, 0.0f), glm::vec3(-1.0f, 3.0f, 0.0f)
+        };
+        bgfx::VertexLayout layout;
+        layout.begin().add(bgfx::Attrib::Position, 3, bgfx::AttribType::Float).end();
+        _fullscreen_triangle = bgfx::createVertexBuffer(bgfx::copy(k_vertices.data(), sizeof(k_vertices)), layout);
+
+        spdlog::debug("Deferred renderer initialized");
+    }
+
+    void DeferredRenderer::shutdown() {
+        if (_app) {
+            remove_passes(_app->get_render_chain());
+        }
+        destroy_handle(_fullscreen_triangle);
+        for (auto &shader: _gbuffer_shaders) {
+            shader.reset();
+        }
+        _lighting_shader.reset();
+        _composite_shader.reset();
+        _collector.clear();
+        _shadow_maps.shutdown();
+        _light_clusters.shutdown();
+        Renderer::shutdown();
+        spdlog::debug("Deferred renderer shut down");
+    }
+
+    bool DeferredRenderer::is_valid() const {
+        return bgfx::isValid(_fullscreen_triangle) && _lighting_shader.is_valid() && _composite_shader.is_valid();
+    }
+
+    RenderTargetDesc DeferredRenderer::get_target_desc() const {
+        RenderTargetDesc desc;
+        desc.flags = k_target_flags;
+
+        const glm::vec4 &viewport = _camera->get_viewport();
+        if (_camera->get_render_target()) {
+            const glm::uvec2 size = glm::max(glm::uvec2(glm::vec2(_camera->get_render_size()) *
+                                                         glm::vec2(viewport.z, viewport.w)), glm::uvec2(1));
+            desc.width = static_cast<uint16_t>(size.x);
+            desc.height = static_cast<uint16_t>(size.y);
+        } else {
+            desc.scale = glm::vec2(viewport.z, viewport.w);
+        }
+        return desc;
+    }
+
+    void DeferredRenderer::render_reset(RenderChain &chain) {
+        _view_id.reset();
+        if (!_camera || !_app || !is_valid()) {
+            remove_passes(chain);
+            return;
+        }
+
+        add_passes(chain);
+    }
+
+    void DeferredRenderer::add_passes(RenderChain &chain) {
+        _target_desc = get_target_desc();
+        _clear_rgba = pack_color(_camera->get_clear_color());
+
+        // the shadow passes have to run before the passes sampling them
+        _shadow_maps.add_passes(chain, _prefix);
+
+        chain.add_pass(get_pass_name(DeferredPass::GBuffer), [this](RenderPassBuilder &builder) {
+            const std::array formats = {
+                bgfx::TextureFormat::RGBA8,
+                select_format(bgfx::TextureFormat::RGB10A2, bgfx::TextureFormat::RGBA8),
+                bgfx::TextureFormat::RGBA8,
+                select_format(bgfx::TextureFormat::D32F, bgfx::TextureFormat::D24S8),
+            };
+            for (size_t i = 0; i < formats.size(); ++i) {
+                RenderTargetDesc desc = _target_desc;
+                desc.format = formats[i];
+                _gbuffer_resources[i] = builder.create(_gbuffer_names[i], desc);
+            }
+
+            // attached in the order of the G-buffer shader outputs
+            for (const auto &name: _gbuffer_names) {
+                builder.write(name);
+            }
+            builder.set_clear(BGFX_CLEAR_COLOR | BGFX_CLEAR_DEPTH, 0, 1.0f);
+        }, nullptr);
+
+        chain.add_pass(get_pass_name(DeferredPass::Lighting), [this](RenderPassBuilder &builder) {
+            for (const auto &name: _gbuffer_names) {
+                builder.read(name);
+            }
+            _shadow_maps.read_atlases(builder);
+
+            RenderTargetDesc desc = _target_desc;
+            desc.format = select_format(bgfx::TextureFormat::RGBA16F, bgfx::TextureFormat::RGBA8);
+            _light_resource = builder.create(_light_name, desc);
+            builder.write(_light_name);
+
+            // the camera clear color ends up wherever the G-buffer stayed empty
+            builder.set_clear(BGFX_CLEAR_COLOR, _clear_rgba);
+        }, nullptr);
+
+        // the lit color with the G-buffer depth, for the forward draws
+        chain.add_pass(get_pass_name(DeferredPass::Forward), [this](RenderPassBuilder &builder) {
+            _shadow_maps.read_atlases(builder);
+            builder.write(_light_name);
+            builder.write(_gbuffer_names[static_cast<size_t>(GBufferTarget::Depth)]);
+        }, nullptr);
+
+        // set up on the backbuffer, render points the view at the viewport and target of the camera
+        chain.add_pass(get_pass_name(DeferredPass::Composite), [this](RenderPassBuilder &builder) {
+            builder.read(_light_name);
+            builder.write(RenderChain::k_backbuffer);
+        }, nullptr);
+    }
+
+    void DeferredRenderer::remove_passes(RenderChain &chain) {
+        for (const auto &name: _pass_names) {
+            chain.remove_pass(name);
+        }
+        _shadow_maps.remove_passes(chain);
+
+        _gbuffer_resources = {};
+        _light_resource = {};
+    }
+
+    void DeferredRenderer::render(const bgfx::ViewId view_id, bgfx::Encoder *encoder) {
+        if (!_visible || !_scene || !_camera || !_app || !encoder) {
+            return;
+        }
+
+        const auto lighting_view = get_pass_view_id(DeferredPass::Lighting);
+        const auto forward_view = get_pass_view_id(DeferredPass::Forward);
+        const auto composite_view = get_pass_view_id(DeferredPass::Composite);
+        if (!lighting_view || !forward_view || !composite_view) {
+            return;
+        }
+
+        // a new viewport or target sets the passes up again on the next compile, this frame keeps the old targets
+        auto &chain = _app->get_render_chain();
+        if (const RenderTargetDesc desc = get_target_desc(); desc != _target_desc) {
+            _target_desc = desc;
+            chain.invalidate();
+        }
+
+        for (size_t i = 0; i < _gbuffer_textures.size(); ++i) {
+            _gbuffer_textures[i] = chain.get_texture(_gbuffer_resources[i]);
+        }
+        _light_texture = chain.get_texture(_light_resource);
+        if (!bgfx::isValid(_light_texture) ||
+            std::ranges::any_of(_gbuffer_textures, [](const auto handle) { return !bgfx::isValid(handle); })) {
+            return;
+        }
+        _target_size = _target_desc.get_size(_camera->get_render_size());
+
+        _camera->configure_view(*composite_view, get_pass_name(DeferredPass::Composite));
+
+        const glm::mat4 view = _camera->get_view_matrix();
+        const glm::mat4 projection = _camera->get_projection_matrix();
+        for (const bgfx::ViewId id: {view_id, *lighting_view, *forward_view}) {
+            bgfx::setViewTransform(id, &view[0][0], &projection[0][0]);
+        }
+
+        _shadow_maps.render(_scene->get_registry(), _scene->get_scene_component<StaticBatcher>(), view, projection,
+                            _camera->get_near_clip(), _camera->get_far_clip(), *encoder);
+
+        collect_draws();
+
+        if (_light_clusters.is_valid()) {
+            _light_clusters.collect(_scene->get_registry());
+            _light_clusters.build(view, projection, _camera->get_near_clip(), _camera->get_far_clip(), nullptr);
+            _light_clusters.upload();
+        }
+
+        _deferred_bucket.sort();
+        _forward_bucket.sort();
+        build_batches(_deferred_bucket, true, _deferred_batches);
+        build_batches(_forward_bucket, false, _forward_batches);
+
+        EncoderState state(*encoder);
+        submit_batches(view_id, state, _deferred_bucket, _deferred_batches, true);
+        submit_lighting(*lighting_view, state);
+        submit_batches(*forward_view, state, _forward_bucket, _forward_batches, false);
+        submit_composite(*composite_view, state);
+        _encoder_stats = state.get_stats();
+    }
+
+    void DeferredRenderer::collect_draws() {
+        _deferred_bucket.clear();
+        _forward_bucket.clear();
+
+        const glm::mat4 view = _camera->get_view_matrix();
+        const float near_clip = _camera->get_near_clip();
+        const float far_clip = _camera->get_far_clip();
+        const float depth_range = far_clip > near_clip ? far_clip - near_clip : 1.0f;
+
+        _collector.collect(*_scene, _camera.ptr());
+
+        const auto candidates = _collector.get_candidates();
+        const auto &visible = _collector.get_visible();
+
+        for (uint32_t i = 0; i < candidates.size(); ++i) {
+            if (!visible[i]) {
+                continue;
+            }
+
+            const auto &[mesh_renderer, entity, model] = candidates[i];
+
+            const uint32_t lod = _collector.select_lod(i, _camera.ptr());
+            const Mesh *mesh = mesh_renderer->get_lod_mesh(lod);
+            if (!mesh || !mesh->is_valid()) {
+                continue;
+            }
+
+            const float view_depth = -(view * model[3]).z;
+            const float depth = (view_depth - near_clip) / depth_range;
+
+            const glm::mat4 transform = mesh->get_vertex_format() == VertexFormat::Standard
+                                            ? model
+                                            : model * mesh->get_dequantization_matrix();
+
+            // only the standard lighting model fits in the G-buffer, everything else keeps its own program
+            const Material *material = mesh_renderer->get_material();
+            DrawBucket &bucket = material->get_type() == MaterialType::Standard && material->supports_depth_prepass()
+                                     ? _deferred_bucket
+                                     : _forward_bucket;
+
+            bucket.add(mesh_renderer->generate_sort_key(depth, lod),
+                       {mesh, material, transform, mesh_renderer->get_tint()});
+        }
+
+        _collector.prune_lods();
+    }
+
+    void DeferredRenderer::build_batches(const DrawBucket &bucket, const bool deferred,
+                                         std::vector<DrawBatch> &batches) const {
+        batches.clear();
+
+        const bool instancing = _instancing_enabled && (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0;
+        const auto items = bucket.get_items();
+        const auto count = static_cast<uint32_t>(items.size());
+
+        uint32_t begin = 0;
+        while (begin < count) {
+            const auto &first = bucket.get_draw(items[begin]);
+            const uint32_t end = find_batch_end(bucket, begin);
+
+            // the G-buffer programs exist for every variant
+            const VertexFormat format = first.mesh->get_vertex_format();
+            const auto single_variant = deferred
+                                            ? get_shader_variant(format, false)
+                                            : select_batch_variant(*first.material, format, false);
+            if (!single_variant) {
+                begin = end;
+                continue;
+            }
+
+            const auto instanced_variant = deferred
+                                               ? get_shader_variant(format, true)
+                                               : select_batch_variant(*first.material, format, true);
+
+            if (!instancing || !instanced_variant) {
+                batches.push_back({begin, end, false, false, *single_variant});
+            } else {
+                const size_t first_batch = batches.size();
+                add_instanced_batches({begin, end, true, false, *instanced_variant}, *single_variant, batches);
+                for (size_t i = first_batch; i < batches.size(); ++i) {
+                    if (batches[i].instanced) {
+                        write_instance_data(bucket, batches[i]);
+                    }
+                }
+            }
+
+            begin = end;
+        }
+    }
+
+    void DeferredRenderer::submit_batches(const bgfx::ViewId view_id, EncoderState &state, const DrawBucket &bucket,
+                                          const std::vector<DrawBatch> &batches, const bool deferred) const {
+        const auto items = bucket.get_items();
+
+        for (const auto &batch: batches) {
+            // an instanced batch is a single submit of its first draw
+            const uint32_t end = batch.instanced ? batch.begin + 1 : batch.end;
+            for (uint32_t i = batch.begin; i < end; ++i) {
+                const auto &draw = bucket.get_draw(items[i]);
+
+                if (batch.instanced) {
+                    state.get_encoder().setInstanceDataBuffer(&batch.instance_data);
+                } else {
+                    state.get_encoder().setTransform(&draw.transform[0][0]);
+                    state.set_tint(draw.tint);
+                }
+                draw.mesh->draw(state);
+
+                // instances that only override the color draw in their parent's batch
+                const Material &material = batch.instanced ? draw.material->get_batch_material() : *draw.material;
+                if (deferred) {
+                    const Shader &shader = _gbuffer_shaders[static_cast<size_t>(batch.variant)];
+                    // roughness is stored in the alpha of the albedo target
+                    material.bind(state, view_id, shader.get_handle(), i, BGFX_STATE_WRITE_A, batch.instanced);
+                } else {
+                    _light_clusters.bind(state);
+                    _shadow_maps.bind(state);
+                    material.bind(state, view_id, batch.variant, i, std::nullopt, batch.instanced);
+                }
+            }
+        }
+    }
+
+    void DeferredRenderer::submit_lighting(const bgfx::ViewId view_id, EncoderState &state) const {
+        const bgfx::Caps *caps = bgfx::getCaps();
+        const glm::vec4 params(caps->homogeneousDepth ? 1.0f : 0.0f, caps->originBottomLeft ? 1.0f : 0.0f, 0.0f,
+                               0.0f);
+
+        for (size_t i = 0; i < _gbuffer_samplers.size(); ++i) {
+            state.set_texture(_gbuffer_samplers[i].stage, _gbuffer_samplers[i].handle, _gbuffer_textures[i]);
+        }
+        _light_clusters.bind(state);
+        _shadow_maps.bind(state);
+
+        state.get_encoder().setUniform(_params_uniform.handle, &params);
+        state.set_vertex_buffer(0, _fullscreen_triangle);
+        state.set_state(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+        state.submit(view_id, _lighting_shader.get_handle());
+    }
+
+    void DeferredRenderer::submit_composite(const bgfx::ViewId view_id, EncoderState &state) const {
+        const glm::vec4 params(0.0f, bgfx::getCaps()->originBottomLeft ? 1.0f : 0.0f, 0.0f, 0.0f);
+
+        state.set_texture(_light_sampler.stage, _light_sampler.handle, _light_texture);
+        state.get_encoder().setUniform(_params_uniform.handle, &params);
+        state.set_vertex_buffer(0, _fullscreen_triangle);
+        state.set_state(BGFX_STATE_WRITE_RGB | BGFX_STATE_WRITE_A);
+        state.submit(view_id, _composite_shader.get_handle());
+    }
+
+    bgfx::TextureHandle DeferredRenderer::get_gbuffer_texture(const GBufferTarget target) const {
+        if (target == GBufferTarget::Count || !_app) {
+            return BGFX_INVALID_HANDLE;
+        }
+        return _app->get_render_chain().get_texture(_gbuffer_resources[static_cast<size_t>(target)]);
+    }
+
+    std::optional<bgfx::ViewId> DeferredRenderer::get_pass_view_id(const DeferredPass pass) const {
+        if (pass == DeferredPass::Count || !_app) {
+            return std::nullopt;
+        }
+        return _app->get_render_chain().get_view_id(get_pass_name(pass));
+    }
+
+    const std::string &DeferredRenderer::get_pass_name(const DeferredPass pass) const {
+        return _pass_names[static_cast<size_t>(pass)];
+    }
+
+    void DeferredRenderer::set_instancing_enabled(const bool enabled) {
+        _instancing_enabled = enabled;
+    }
+
+    bool DeferredRenderer::is_instancing_enabled() const {
+        return _instancing_enabled;
+    }
+
+    void DeferredRenderer::set_light_cluster_settings(const LightClusterSettings &settings) {
+        _light_cluster_settings = settings;
+    }
+
+    void DeferredRenderer::set_shadow_settings(const ShadowSettings &settings) {
+        _shadow_settings = settings;
+    }
+
+    DeferredRendererComponent::DeferredRendererComponent()
+        : _renderer(std::make_unique<DeferredRenderer>()) {
+    }
+
+    DeferredRendererComponent::~DeferredRendererComponent() = default;
+
+    void DeferredRendererComponent::init(Camera &camera, Scene &scene, App &app) {
+        _camera = camera;
+        _scene = scene;
+        _app = app;
+
+        _renderer->init(scene, app);
+        _renderer->set_camera(camera);
+    }
+
+    void DeferredRendererComponent::shutdown() {
+        if (_renderer) {
+            _renderer->shutdown();
+        }
+
+        _camera = nullptr;
+        _scene = nullptr;
+        _app = nullptr;
+    }
+
+    void DeferredRendererComponent::render() {
+        if (!_scene || !_camera || !_camera->is_valid() || !_camera->is_enabled()) {
+            return;
+        }
+
+        // nothing runs before the chain compiled the passes of the first reset
+        const auto view_id = _renderer->get_pass_view_id(DeferredPass::GBuffer);
+        if (!view_id) {
+            return;
+        }
+
+        auto &encoder = *bgfx::begin();
+
+        _renderer->render(*view_id, &encoder);
+
+        bgfx::end(&encoder);
+    }
+
+    void DeferredRendererComponent::render_reset(RenderChain &chain) {
+        _renderer->render_reset(chain);
+    }
+
+    DeferredRenderer &DeferredRendererComponent::get_renderer() {
+        return *_renderer;
+    }
+
+    const DeferredRenderer &DeferredRendererComponent::get_renderer() const {
+        return *_renderer;
+    }
+}
@@ -0,0 +1,130 @@
+#include "star/render/draw_bucket.hpp"
+#include <algorithm>
+#include <array>
+
+namespace star {
+    namespace {
+        constexpr uint64_t mask(const uint32_t bits) {
+            return (uint64_t{1} << bits) - 1;
+        }
+    }
+
+    uint64_t DrawKey::make_opaque(const uint8_t layer, const uint32_t material_key, const uint32_t mesh,
+                                  const float depth) noexcept {
+        const uint64_t state = material_key & mask(k_program_bits + k_material_bits);
+
+        return static_cast<uint64_t>(layer) << 56 |
+               state << 32 |
+               (mesh & mask(k_mesh_bits)) << 20 |
+               quantize_depth(depth);
+    }
+
+    uint64_t DrawKey::make_translucent(const uint8_t layer, const uint32_t material_key, const uint32_t mesh,
+                                       const float depth) noexcept {
+        const uint64_t state = material_key & mask(k_blend_bits + k_program_bits + k_material_bits);
+        const uint64_t inverted_depth = k_depth_max - quantize_depth(depth);
+
+        return static_cast<uint64_t>(layer) << 56 |
+               uint64_t{1} << 55 |
+               inverted_depth << 35 |
+               state << 10 |
+               (mesh & mask(10));
+    }
+
+    uint32_t DrawKey::make_material_key(const uint32_t blend, const uint32_t program, const uint32_t material) noexcept {
+        return (blend & static_cast<uint32_t>(mask(k_blend_bits))) << (k_program_bits + k_material_bits) |
+               (program & static_cast<uint32_t>(mask(k_program_bits))) << k_material_bits |
+               (material & static_cast<uint32_t>(mask(k_material_bits)));
+    }
+
+    bool DrawKey::is_translucent(const uint64_t key) noexcept {
+        return (key >> 55 & 1) != 0;
+    }
+
+    uint32_t DrawKey::quantize_depth(const float depth) noexcept {
+        const float clamped = std::clamp(depth, 0.0f, 1.0f);
+        return static_cast<uint32_t>(clamped * static_cast<float>(k_depth_max));
+    }
+
+    DrawBucket::DrawBucket() = default;
+
+    DrawBucket::~DrawBucket() = default;
+
+    void DrawBucket::clear() {
+        _items.clear();
+        _draws.clear();
+    }
+
+    void DrawBucket::reserve(const size_t count) {
+        _items.reserve(count);
+        _scratch.reserve(count);
+        _draws.reserve(count);
+    }
+
+    void DrawBucket::add(const uint64_t key, const DrawCall &draw) {
+        _items.push_back({key, static_cast<uint32_t>(_draws.size())});
+        _draws.push_back(draw);
+    }
+
+    void DrawBucket::sort() {
+        const size_t count = _items.size();
+        if (count < 2) {
+            return;
+        }
+
+        std::array<std::array<uint32_t, 256>, 8> histograms{};
+        for (const auto &item: _items) {
+            for (size_t pass = 0; pass < 8; ++pass) {
+                ++histograms[pass][item.key >> (pass * 8) & 0xFF];
+            }
+        }
+
+        _scratch.resize(count);
+        DrawItem *src = _items.data();
+        DrawItem *dst = _scratch.data();
+
+        for (size_t pass = 0; pass < 8; ++pass) {
+            auto &histogram = histograms[pass];
+            const uint32_t first_digit = src[0].key >> (pass * 8) & 0xFF;
+
+            // every key shares this byte, the pass would not move anything
+            if (histogram[first_digit] == count) {
+                continue;
+            }
+
+            uint32_t offset = 0;
+            for (auto &bin: histogram) {
+                const uint32_t bin_count = bin;
+                bin = offset;
+                offset += bin_count;
+            }
+
+            for (size_t i = 0; i < count; ++i) {
+                const auto &item = src[i];
+                dst[histogram[item.key >> (pass * 8) & 0xFF]++] = item;
+            }
+
+            std::swap(src, dst);
+        }
+
+        if (src != _items.data()) {
+            std::copy_n(src, count, _items.data());
+        }
+    }
+
+    bool DrawBucket::empty() const {
+        return _items.empty();
+    }
+
+    size_t DrawBucket::size() const {
+        return _items.size();
+    }
+
+    std::span<const DrawItem> DrawBucket::get_items() const {
+        return _items;
+    }
+
+    const DrawCall &DrawBucket::get_draw(const DrawItem &item) const {
+        return _draws[item.index];
+    }
+}
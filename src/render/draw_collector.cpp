@@ -0,0 +1,185 @@
+#include "star/core/common.hpp"
+#include "star/render/draw_collector.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/static_batcher.hpp"
+#include "star/scene/camera.hpp"
+#include "star/scene/scene.hpp"
+#include "star/scene/transform.hpp"
+
+namespace star {
+    namespace {
+        // a material without the packed programs is reported once per vertex format, not every frame. Keyed by id,
+        // the address of a destroyed material can come back as the next one
+        bool report_missing_variant(const Material &material, const VertexFormat format) {
+            static std::mutex mutex;
+            static std::set<std::pair<uint32_t, VertexFormat> > reported;
+
+            std::lock_guard lock(mutex);
+            return reported.emplace(material.get_id(), format).second;
+        }
+    }
+
+    std::optional<ShaderVariant> select_batch_variant(const Material &material, const VertexFormat format,
+                                                      const bool instanced) {
+        const ShaderVariant variant = get_shader_variant(format, instanced);
+        if (material.has_shader(variant)) {
+            return variant;
+        }
+
+        // the batch draws one by one with the single variant
+        if (instanced) {
+            return std::nullopt;
+        }
+
+        // the Default program is what every material is built around, a missing one is the material's problem
+        if (variant == ShaderVariant::Default) {
+            return variant;
+        }
+
+        // the Default program would read the octahedral normals as floats, the draw is refused instead
+        if (report_missing_variant(material, format)) {
+            spdlog::warn("select_batch_variant - Material {} has no packed program for vertex format {}, its "
+                         "draws of packed meshes are skipped. Build those meshes with VertexFormat::Standard",
+                         material.get_id(), static_cast<uint32_t>(format));
+        }
+        return std::nullopt;
+    }
+
+    uint32_t find_batch_end(const DrawBucket &bucket, const uint32_t begin) {
+        const auto items = bucket.get_items();
+        const auto count = static_cast<uint32_t>(items.size());
+        if (begin >= count) {
+            return count;
+        }
+
+        // instances that only override the color batch with their parent
+        const auto &first = bucket.get_draw(items[begin]);
+        const Material *material = &first.material->get_batch_material();
+
+        uint32_t end = begin + 1;
+        while (end < count) {
+            const auto &draw = bucket.get_draw(items[end]);
+            if (draw.mesh != first.mesh || &draw.material->get_batch_material() != material) {
+                break;
+            }
+            ++end;
+        }
+        return end;
+    }
+
+    void add_instanced_batches(const DrawBatch &batch, const ShaderVariant single_variant,
+                               std::vector<DrawBatch> &batches) {
+        uint32_t next = batch.begin;
+        while (next < batch.end) {
+            const uint32_t available = bgfx::getAvailInstanceDataBuffer(batch.end - next,
+                                                                        DrawBatch::k_instance_stride);
+            if (available == 0) {
+                spdlog::warn("add_instanced_batches - Instance data buffer exhausted, drawing {} instances "
+                             "individually", batch.end - next);
+                batches.push_back({next, batch.end, false, batch.prepass, single_variant});
+                break;
+            }
+
+            auto &instanced = batches.emplace_back(
+                DrawBatch{next, next + available, true, batch.prepass, batch.variant});
+            bgfx::allocInstanceDataBuffer(&instanced.instance_data, available, DrawBatch::k_instance_stride);
+            next += available;
+        }
+    }
+
+    void write_instance_data(const DrawBucket &bucket, const DrawBatch &batch) {
+        const auto items = bucket.get_items();
+
+        uint8_t *data = batch.instance_data.data;
+        for (uint32_t i = batch.begin; i < batch.end; ++i) {
+            const auto &draw = bucket.get_draw(items[i]);
+            const glm::vec4 tint = draw.tint * draw.material->get_batch_color();
+            std::memcpy(data, &draw.transform[0][0], sizeof(glm::mat4));
+            std::memcpy(data + sizeof(glm::mat4), &tint[0], sizeof(glm::vec4));
+            data += DrawBatch::k_instance_stride;
+        }
+    }
+
+    void DrawCollector::collect(Scene &scene, const Camera *camera) {
+        _candidates.clear();
+        _bounds.clear();
+
+        auto &registry = scene.get_registry();
+        auto entities = registry.view<MeshRenderer>(entt::exclude<StaticBatched>);
+        _candidates.reserve(entities.size_hint());
+        _bounds.reserve(entities.size_hint());
+
+        for (auto entity: entities) {
+            const auto &mesh_renderer = entities.get<MeshRenderer>(entity);
+
+            const Mesh *mesh = mesh_renderer.get_mesh();
+            if (!mesh_renderer.is_visible() || !mesh || !mesh->is_valid() || !mesh_renderer.get_material()) {
+                continue;
+            }
+
+            glm::mat4 model(1.0f);
+            if (const auto *transform = registry.try_get<Transform>(entity)) {
+                model = transform->get_model_matrix();
+            }
+
+            const auto *bounds = registry.try_get<WorldBounds>(entity);
+
+            _candidates.push_back({&mesh_renderer, entity, model});
+            _bounds.push_back(bounds && bounds->is_valid()
+                                  ? bounds->get_sphere()
+                                  : mesh->get_bounding_sphere().transform(model));
+        }
+
+        if (const auto *batcher = scene.get_scene_component<StaticBatcher>()) {
+            for (const auto &batch: batcher->get_batches()) {
+                const Mesh *mesh = batch->renderer.get_mesh();
+                if (!batch->renderer.is_visible() || !mesh || !mesh->is_valid()) {
+                    continue;
+                }
+
+                _candidates.push_back({&batch->renderer, entt::null, glm::mat4(1.0f)});
+                _bounds.push_back(mesh->get_bounding_sphere());
+            }
+        }
+
+        _visible.assign(_candidates.size(), 1);
+        if (const ICullingFilter *filter = camera ? camera->get_culling_filter() : nullptr) {
+            filter->cull(_bounds, _visible);
+        }
+
+        ++_lod_frame;
+    }
+
+    uint32_t DrawCollector::select_lod(const uint32_t index, const Camera *camera) {
+        const auto &candidate = _candidates[index];
+        const MeshRenderer &mesh_renderer = *candidate.renderer;
+        if (mesh_renderer.get_lod_count() <= 1 || !camera) {
+            return 0;
+        }
+
+        const float screen_size = camera->get_screen_size(_bounds[index]);
+        const auto [it, inserted] = _lod_states.try_emplace(candidate.entity);
+        auto &state = it->second;
+
+        // a state older than one frame means the entity was culled, its last level says nothing anymore
+        const uint32_t current = inserted || state.frame + 1 != _lod_frame ? MeshRenderer::k_invalid_lod : state.lod;
+        state.lod = mesh_renderer.select_lod(screen_size, current);
+        state.frame = _lod_frame;
+        return state.lod;
+    }
+
+    void DrawCollector::prune_lods() {
+        if (_lod_states.size() > _candidates.size() * 2) {
+            std::erase_if(_lod_states, [this](const auto &entry) {
+                return entry.second.frame != _lod_frame;
+            });
+        }
+    }
+
+    void DrawCollector::clear() {
+        _candidates.clear();
+        _bounds.clear();
+        _visible.clear();
+        _lod_states.clear();
+    }
+}
@@ -0,0 +1,226 @@
+#include "star/core/common.hpp"
+#include "star/render/encoder_state.hpp"
+
+namespace star {
+    namespace {
+        // everything a draw sets anew is discarded, the state discard also drops the uniforms set for the draw.
+        // Only the buffers and textures stay bound for the next draw
+        constexpr uint8_t k_submit_discard = BGFX_DISCARD_STATE | BGFX_DISCARD_TRANSFORM | BGFX_DISCARD_INSTANCE_DATA;
+    }
+
+    EncoderStats &EncoderStats::operator+=(const EncoderStats &other) {
+        issued += other.issued;
+        skipped += other.skipped;
+        submits += other.submits;
+        return *this;
+    }
+
+    EncoderState::EncoderState(bgfx::Encoder &encoder)
+        : _encoder(encoder) {
+    }
+
+    EncoderState::~EncoderState() {
+        if (_retained) {
+            _encoder.discard(BGFX_DISCARD_ALL);
+        }
+    }
+
+    void EncoderState::set_state(const uint64_t state, const uint32_t rgba) {
+        _encoder.setState(state, rgba);
+        ++_stats.issued;
+    }
+
+    void EncoderState::set_texture(const uint8_t stage, const bgfx::UniformHandle sampler,
+                                   const bgfx::TextureHandle texture, const uint32_t flags) {
+        if (stage >= k_max_textures) {
+            _encoder.setTexture(stage, sampler, texture, flags);
+            ++_stats.issued;
+            return;
+        }
+
+        _textures_requested[stage] = true;
+
+        const TextureBinding binding{sampler.idx, texture.idx, flags};
+        if (_textures[stage] == binding) {
+            ++_stats.skipped;
+            return;
+        }
+
+        _encoder.setTexture(stage, sampler, texture, flags);
+        _textures[stage] = binding;
+        ++_stats.issued;
+    }
+
+    void EncoderState::set_vertex_buffer(const uint8_t stream, const bgfx::VertexBufferHandle handle,
+                                         const uint32_t start, const uint32_t count) {
+        if (stream >= k_max_streams ||
+            track(_streams[stream], {BufferKind::Static, handle.idx, start, count}, _streams_requested[stream])) {
+            _encoder.setVertexBuffer(stream, handle, start, count);
+        }
+    }
+
+    void EncoderState::set_vertex_buffer(const uint8_t stream, const bgfx::DynamicVertexBufferHandle handle,
+                                         const uint32_t start, const uint32_t count) {
+        if (stream >= k_max_streams ||
+            track(_streams[stream], {BufferKind::Dynamic, handle.idx, start, count}, _streams_requested[stream])) {
+            _encoder.setVertexBuffer(stream, handle, start, count);
+        }
+    }
+
+    void EncoderState::set_vertex_buffer(const uint8_t stream, const bgfx::TransientVertexBuffer *buffer,
+                                         const uint32_t start, const uint32_t count) {
+        if (stream >= k_max_streams) {
+            _encoder.setVertexBuffer(stream, buffer, start, count);
+            return;
+        }
+
+        const BufferBinding binding{BufferKind::Transient, buffer->handle.idx, buffer->startVertex + start, count};
+        _transient_streams[stream] = *buffer;
+        if (track(_streams[stream], binding, _streams_requested[stream])) {
+            _encoder.setVertexBuffer(stream, buffer, start, count);
+        }
+    }
+
+    void EncoderState::set_index_buffer(const bgfx::IndexBufferHandle handle, const uint32_t first,
+                                        const uint32_t count) {
+        if (track(_index, {BufferKind::Static, handle.idx, first, count}, _index_requested)) {
+            _encoder.setIndexBuffer(handle, first, count);
+        }
+    }
+
+    void EncoderState::set_index_buffer(const bgfx::DynamicIndexBufferHandle handle, const uint32_t first,
+                                        const uint32_t count) {
+        if (track(_index, {BufferKind::Dynamic, handle.idx, first, count}, _index_requested)) {
+            _encoder.setIndexBuffer(handle, first, count);
+        }
+    }
+
+    void EncoderState::set_index_buffer(const bgfx::TransientIndexBuffer *buffer, const uint32_t first,
+                                        const uint32_t count) {
+        _transient_index = *buffer;
+        if (track(_index, {BufferKind::Transient, buffer->handle.idx, buffer->startIndex + first, count},
+                  _index_requested)) {
+            _encoder.setIndexBuffer(buffer, first, count);
+        }
+    }
+
+    void EncoderState::submit(const bgfx::ViewId view_id, const bgfx::ProgramHandle program, const uint32_t depth) {
+        clear_unrequested();
+
+        _encoder.submit(view_id, program, depth, k_submit_discard);
+        _retained = true;
+        ++_stats.submits;
+
+        _streams_requested.fill(false);
+        _index_requested = false;
+        _textures_requested.fill(false);
+        _tint = glm::vec4(1.0f);
+    }
+
+    void EncoderState::reset() {
+        if (_retained) {
+            _encoder.discard(BGFX_DISCARD_ALL);
+            _retained = false;
+        }
+
+        _streams.fill({});
+        _streams_requested.fill(false);
+        _index = {};
+        _index_requested = false;
+        _textures.fill({});
+        _textures_requested.fill(false);
+        _tint = glm::vec4(1.0f);
+    }
+
+    bool EncoderState::track(BufferBinding &bound, const BufferBinding &binding, bool &requested) {
+        requested = true;
+
+        if (bound == binding) {
+            ++_stats.skipped;
+            return false;
+        }
+
+        bound = binding;
+        ++_stats.issued;
+        return true;
+    }
+
+    void EncoderState::clear_unrequested() {
+        bool stale_buffers = !_index_requested && _index.kind != BufferKind::None;
+        for (uint8_t stream = 0; stream < k_max_streams; ++stream) {
+            stale_buffers |= !_streams_requested[stream] && _streams[stream].kind != BufferKind::None;
+        }
+
+        // bgfx has no way to unbind a single stream or the index buffer, both are dropped together and the
+        // buffers this draw asked for are bound again
+        if (stale_buffers) {
+            _encoder.discard(BGFX_DISCARD_INDEX_BUFFER | BGFX_DISCARD_VERTEX_STREAMS);
+            ++_stats.issued;
+
+            for (uint8_t stream = 0; stream < k_max_streams; ++stream) {
+                if (_streams_requested[stream]) {
+                    rebind_stream(stream);
+                } else {
+                    _streams[stream] = {};
+                }
+            }
+
+            if (_index_requested) {
+                rebind_index();
+            } else {
+                _index = {};
+            }
+        }
+
+        // the sampler has to be a valid uniform, only the texture may be invalid
+        for (uint8_t stage = 0; stage < k_max_textures; ++stage) {
+            if (!_textures_requested[stage] && _textures[stage].texture != UINT16_MAX) {
+                _encoder.setTexture(stage, bgfx::UniformHandle{_textures[stage].sampler},
+                                    bgfx::TextureHandle BGFX_INVALID_HANDLE);
+                _textures[stage] = {};
+                ++_stats.issued;
+            }
+        }
+    }
+
+    void EncoderState::rebind_stream(const uint8_t stream) {
+        const BufferBinding &binding = _streams[stream];
+        switch (binding.kind) {
+            case BufferKind::Static:
+                _encoder.setVertexBuffer(stream, bgfx::VertexBufferHandle{binding.handle}, binding.start,
+                                         binding.count);
+                break;
+            case BufferKind::Dynamic:
+                _encoder.setVertexBuffer(stream, bgfx::DynamicVertexBufferHandle{binding.handle}, binding.start,
+                                         binding.count);
+                break;
+            case BufferKind::Transient: {
+                const bgfx::TransientVertexBuffer &buffer = _transient_streams[stream];
+                _encoder.setVertexBuffer(stream, &buffer, binding.start - buffer.startVertex, binding.count);
+                break;
+            }
+            case BufferKind::None:
+                return;
+        }
+
+        ++_stats.issued;
+    }
+
+    void EncoderState::rebind_index() {
+        switch (_index.kind) {
+            case BufferKind::Static:
+                _encoder.setIndexBuffer(bgfx::IndexBufferHandle{_index.handle}, _index.start, _index.count);
+                break;
+            case BufferKind::Dynamic:
+                _encoder.setIndexBuffer(bgfx::DynamicIndexBufferHandle{_index.handle}, _index.start, _index.count);
+                break;
+            case BufferKind::Transient:
+                _encoder.setIndexBuffer(&_transient_index, _index.start - _transient_index.startIndex, _index.count);
+                break;
+            case BufferKind::None:
+                return;
+        }
+
+        ++_stats.issued;
+    }
+}
@@ -3,55 +3,518 @@
 #include "star/scene/camera.hpp"
 #include "star/app/app.hpp"
 #include <algorithm>
+#include <glm/gtc/constants.hpp>
 #include <spdlog/spdlog.h>
 
+#include "star/render/draw_collector.hpp"
 #include "star/render/material.hpp"
+#include "star/render/render_chain.hpp"
 #include "star/render/renderer_components.hpp"
-#include "star/scene/transform.hpp"
+#include "star/render/static_batcher.hpp"
 
 namespace star {
+    namespace {
+        // below this many draws per thread the encoder hand-off costs more than it saves
+        constexpr uint32_t k_min_draws_per_chunk = 256;
+
+        // the Auto prepass stays on until the overdraw drops this far below the threshold, so it does not flip
+        // every frame around it
+        constexpr float k_prepass_hysteresis = 0.8f;
+    }
+
     ForwardRenderer::ForwardRenderer() = default;
 
     ForwardRenderer::~ForwardRenderer() = default;
 
     void ForwardRenderer::init(Scene &scene, App &app) {
         Renderer::init(scene, app);
+
+        if (!_light_clusters.init(_light_cluster_settings)) {
+            spdlog::warn("ForwardRenderer - Light clusters are unavailable, only the ambient term is lit");
+        }
+
+        if (!_shadow_maps.init(_shadow_settings)) {
+            spdlog::warn("ForwardRenderer - Shadow maps are unavailable, lights cast no shadows");
+        }
+
+        if (!_occlusion_culler.init(_occlusion_settings)) {
+            spdlog::warn("ForwardRenderer - Occlusion culler is unavailable, only the frustum culls draws");
+        }
+
         spdlog::debug("Forward renderer initialized");
     }
 
     void ForwardRenderer::shutdown() {
+        _prepass_active = false;
+        _occlusion_culler.shutdown();
+        _occlusion_visible.clear();
+        _collector.clear();
+        _shadow_maps.shutdown();
+        _light_clusters.shutdown();
         Renderer::shutdown();
         spdlog::debug("Forward renderer shut down");
     }
 
-    bgfx::ViewId ForwardRenderer::render_reset(bgfx::ViewId view_id) {
+    void ForwardRenderer::render_reset(RenderChain &chain) {
         _view_id.reset();
+        _prepass_view_id.reset();
         if (!_camera) {
-            return view_id;
+            return;
         }
 
-        _camera->configure_view(view_id, "Forward");
-        _view_id = view_id;
-        return ++view_id;
+        // the shadow views have to run before the view sampling them
+        _shadow_maps.render_reset(chain, this);
+
+        // the prepass view is touched every frame and clears for the camera, the lit view draws on top of it
+        chain.add_view("Forward Prepass", this, [this](const bgfx::ViewId view_id) {
+            _camera->configure_view(view_id, "Forward Prepass");
+            bgfx::setViewMode(view_id, bgfx::ViewMode::DepthAscending);
+            _prepass_view_id = view_id;
+        });
+
+        chain.add_view("Forward", this, [this](const bgfx::ViewId view_id) {
+            _camera->configure_view(view_id, "Forward");
+            bgfx::setViewClear(view_id, BGFX_CLEAR_NONE);
+            // draws are submitted with their sorted position as depth so the order stays the same
+            // no matter which encoder recorded them
+            bgfx::setViewMode(view_id, bgfx::ViewMode::DepthAscending);
+            _view_id = view_id;
+        });
     }
 
     void ForwardRenderer::render(const bgfx::ViewId view_id, bgfx::Encoder *encoder) {
-        auto entities = _scene->get_registry().view<MeshRenderer>();
-        for (auto entity: entities) {
-            auto &mesh_renderer = entities.get<MeshRenderer>(entity);
+        if (!_visible || !_scene || !encoder) {
+            return;
+        }
+
+        if (_camera) {
+            const glm::mat4 view = _camera->get_view_matrix();
+            const glm::mat4 projection = _camera->get_projection_matrix();
+            bgfx::setViewTransform(view_id, &view[0][0], &projection[0][0]);
+
+            if (_prepass_view_id) {
+                bgfx::setViewTransform(*_prepass_view_id, &view[0][0], &projection[0][0]);
+                encoder->touch(*_prepass_view_id);
+            }
+
+            _shadow_maps.render(_scene->get_registry(), _scene->get_scene_component<StaticBatcher>(), view, projection,
+                                _camera->get_near_clip(), _camera->get_far_clip(), *encoder);
+        }
+
+        collect_draws();
+        update_depth_prepass();
+        build_light_clusters();
+        _bucket.sort();
+        build_batches();
+        encode_parallel(view_id, *encoder);
+    }
+
+    void ForwardRenderer::build_light_clusters() {
+        if (!_light_clusters.is_valid()) {
+            return;
+        }
+
+        _light_clusters.collect(_scene->get_registry());
+
+        if (_camera) {
+            _light_clusters.build(_camera->get_view_matrix(), _camera->get_projection_matrix(),
+                                  _camera->get_near_clip(), _camera->get_far_clip(), _encoder_pool.get());
+        } else {
+            _light_clusters.build(glm::mat4(1.0f), glm::mat4(1.0f), 0.0f, 1.0f, _encoder_pool.get());
+        }
+
+        _light_clusters.upload();
+    }
+
+    void ForwardRenderer::update_depth_prepass() {
+        if (!_prepass_view_id) {
+            _prepass_active = false;
+            return;
+        }
+
+        switch (_prepass_mode) {
+            case DepthPrepassMode::Off:
+                _prepass_active = false;
+                break;
+            case DepthPrepassMode::On:
+                _prepass_active = true;
+                break;
+            case DepthPrepassMode::Auto:
+                _prepass_active = _estimated_overdraw >
+                                  (_prepass_active ? _prepass_threshold * k_prepass_hysteresis : _prepass_threshold);
+                break;
+        }
+    }
+
+    void ForwardRenderer::collect_draws() {
+        _bucket.clear();
+        _estimated_overdraw = 0.0f;
+
+        glm::mat4 view(1.0f);
+        float near_clip = 0.0f;
+        float far_clip = 1.0f;
+        // screen size is the projected radius in clip space heights, the ellipse it spans covers this fraction
+        // of the viewport per squared unit
+        float coverage_scale = 0.0f;
+
+        if (_camera) {
+            view = _camera->get_view_matrix();
+            near_clip = _camera->get_near_clip();
+            far_clip = _camera->get_far_clip();
+
+            const glm::mat4 &projection = _camera->get_projection_matrix();
+            if (projection[1][1] != 0.0f) {
+                coverage_scale = glm::pi<float>() * 0.25f * projection[0][0] / projection[1][1];
+            }
+        }
+
+        const float depth_range = far_clip > near_clip ? far_clip - near_clip : 1.0f;
 
-            if (!mesh_renderer.is_visible()) {
+        _collector.collect(*_scene, _camera.ptr());
+        cull_occluded();
+
+        const auto candidates = _collector.get_candidates();
+        const auto bounds = _collector.get_bounds();
+        const auto &visible = _collector.get_visible();
+
+        _bucket.reserve(candidates.size());
+        for (uint32_t i = 0; i < candidates.size(); ++i) {
+            if (!visible[i]) {
+                continue;
+            }
+
+            const auto &[mesh_renderer, entity, model] = candidates[i];
+
+            const uint32_t lod = _collector.select_lod(i, _camera.ptr());
+            const Mesh *mesh = mesh_renderer->get_lod_mesh(lod);
+            if (!mesh || !mesh->is_valid()) {
                 continue;
             }
 
-            if (!mesh_renderer.render(encoder)) {
+            if (coverage_scale > 0.0f && mesh_renderer->get_material()->supports_depth_prepass()) {
+                const float screen_size = std::min(_camera->get_screen_size(bounds[i]), 2.0f);
+                _estimated_overdraw += std::min(screen_size * screen_size * coverage_scale, 1.0f);
+            }
+
+            const float view_depth = -(view * model[3]).z;
+            const float depth = (view_depth - near_clip) / depth_range;
+
+            const glm::mat4 transform = mesh->get_vertex_format() == VertexFormat::Standard
+                                            ? model
+                                            : model * mesh->get_dequantization_matrix();
+
+            _bucket.add(mesh_renderer->generate_sort_key(depth, lod),
+                        {mesh, mesh_renderer->get_material(), transform, mesh_renderer->get_tint()});
+        }
+
+        _collector.prune_lods();
+    }
+
+    void ForwardRenderer::cull_occluded() {
+        _occluded_count = 0;
+
+        if (!_occlusion_enabled || !_camera || !_occlusion_culler.is_valid()) {
+            _occlusion_visible.clear();
+            return;
+        }
+
+        _occlusion_culler.begin(_camera->get_projection_matrix() * _camera->get_view_matrix());
+
+        const auto candidates = _collector.get_candidates();
+        const auto bounds = _collector.get_bounds();
+        auto &visible = _collector.get_visible();
+
+        // what was visible last frame most likely still is, the largest of those on screen hide the most
+        _occluder_candidates.clear();
+        const float min_size = _occlusion_culler.get_settings().min_occluder_size;
+        for (uint32_t i = 0; i < candidates.size(); ++i) {
+            const MeshRenderer *renderer = candidates[i].renderer;
+            const Mesh *mesh = renderer->get_mesh();
+            const Material *material = renderer->get_material();
+
+            if (!visible[i] || !mesh->has_cpu_data() || !material || !material->supports_depth_prepass() ||
+                !std::ranges::binary_search(_occlusion_visible, renderer)) {
                 continue;
             }
+
+            const float screen_size = _camera->get_screen_size(bounds[i]);
+            if (screen_size >= min_size) {
+                _occluder_candidates.emplace_back(screen_size, i);
+            }
+        }
+
+        const auto occluder_count = std::min<size_t>(_occluder_candidates.size(),
+                                                     _occlusion_culler.get_settings().max_occluders);
+        std::ranges::partial_sort(_occluder_candidates, _occluder_candidates.begin() + occluder_count,
+                                  std::ranges::greater{}, &std::pair<float, uint32_t>::first);
+
+        for (size_t i = 0; i < occluder_count; ++i) {
+            const auto &candidate = candidates[_occluder_candidates[i].second];
+            _occlusion_culler.add_occluder(*candidate.renderer->get_mesh(), candidate.transform);
         }
+
+        _occlusion_culler.rasterize(_encoder_pool.get());
+
+        const auto before = static_cast<size_t>(std::ranges::count(visible, uint8_t{1}));
+        const size_t after = _occlusion_culler.cull(bounds, visible, _encoder_pool.get());
+        _occluded_count = static_cast<uint32_t>(before - after);
+
+        _occlusion_visible.clear();
+        for (uint32_t i = 0; i < candidates.size(); ++i) {
+            if (visible[i]) {
+                _occlusion_visible.push_back(candidates[i].renderer);
+            }
+        }
+        std::ranges::sort(_occlusion_visible);
+    }
+
+    void ForwardRenderer::build_batches() {
+        _batches.clear();
+
+        const bool instancing = _instancing_enabled && (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0;
+        const auto items = _bucket.get_items();
+        const auto count = static_cast<uint32_t>(items.size());
+
+        uint32_t begin = 0;
+        while (begin < count) {
+            const auto &first = _bucket.get_draw(items[begin]);
+            const uint32_t end = find_batch_end(_bucket, begin);
+
+            const VertexFormat format = first.mesh->get_vertex_format();
+            const auto single_variant = select_batch_variant(*first.material, format, false);
+            if (!single_variant) {
+                begin = end;
+                continue;
+            }
+
+            const auto instanced_variant = select_batch_variant(*first.material, format, true);
+            // the depth shaders are the base's, every draw of the batch shares them
+            const bool prepass = _prepass_active && first.material->supports_depth_prepass();
+
+            if (!instancing || !instanced_variant) {
+                _batches.push_back({begin, end, false, prepass, *single_variant});
+            } else {
+                const bool instanced_prepass = prepass && first.material->get_depth_shader(true).is_valid();
+                add_instanced_batches({begin, end, true, instanced_prepass, *instanced_variant}, *single_variant,
+                                      _batches);
+            }
+
+            begin = end;
+        }
+    }
+
+    void ForwardRenderer::build_chunks(const uint32_t max_chunks) {
+        _chunks.clear();
+
+        const auto draw_count = static_cast<uint32_t>(_bucket.size());
+        const auto batch_count = static_cast<uint32_t>(_batches.size());
+        const uint32_t chunk_count = std::clamp((draw_count + k_min_draws_per_chunk - 1) / k_min_draws_per_chunk,
+                                                1u, std::max(max_chunks, 1u));
+        const uint32_t draws_per_chunk = (draw_count + chunk_count - 1) / chunk_count;
+
+        uint32_t begin = 0;
+        uint32_t draws = 0;
+        for (uint32_t i = 0; i < batch_count; ++i) {
+            draws += _batches[i].end - _batches[i].begin;
+            if (draws >= draws_per_chunk && _chunks.size() + 1 < chunk_count) {
+                _chunks.push_back({begin, i + 1});
+                begin = i + 1;
+                draws = 0;
+            }
+        }
+
+        if (begin < batch_count) {
+            _chunks.push_back({begin, batch_count});
+        }
+    }
+
+    void ForwardRenderer::encode_parallel(const bgfx::ViewId view_id, bgfx::Encoder &encoder) {
+        const uint32_t max_encoders = bgfx::getCaps()->limits.maxEncoders;
+        const uint32_t thread_count = _encoder_pool ? std::min(_encoder_thread_count, max_encoders) : 1;
+
+        build_chunks(thread_count);
+        _encoder_stats = {};
+
+        if (_chunks.size() <= 1) {
+            for (auto &chunk: _chunks) {
+                encode_batches(view_id, encoder, chunk);
+                _encoder_stats += chunk.stats;
+            }
+            return;
+        }
+
+        const auto caller = std::this_thread::get_id();
+        _encoder_pool->parallel_for(_chunks.size(), [this, view_id, &encoder, caller](const size_t index) {
+            auto &chunk = _chunks[index];
+            if (std::this_thread::get_id() == caller) {
+                encode_batches(view_id, encoder, chunk);
+                return;
+            }
+
+            bgfx::Encoder *worker_encoder = bgfx::begin(true);
+            if (!worker_encoder) {
+                chunk.deferred = true;
+                return;
+            }
+
+            encode_batches(view_id, *worker_encoder, chunk);
+            bgfx::end(worker_encoder);
+        });
+
+        // bgfx ran out of encoders, record what is left on the calling thread
+        for (auto &chunk: _chunks) {
+            if (chunk.deferred) {
+                encode_batches(view_id, encoder, chunk);
+            }
+            _encoder_stats += chunk.stats;
+        }
+    }
+
+    void ForwardRenderer::encode_batches(const bgfx::ViewId view_id, bgfx::Encoder &encoder,
+                                         EncodeChunk &chunk) const {
+        EncoderState state(encoder);
+
+        for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            if (_batches[i].instanced) {
+                write_instance_data(_bucket, _batches[i]);
+            }
+        }
+
+        // the whole chunk's depth goes first so the lit draws do not rebind their textures after every prepass draw
+        if (_prepass_active) {
+            for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+                if (_batches[i].prepass) {
+                    submit_prepass(*_prepass_view_id, state, _batches[i]);
+                }
+            }
+        }
+
+        for (uint32_t i = chunk.begin; i < chunk.end; ++i) {
+            const auto &batch = _batches[i];
+            if (batch.instanced) {
+                submit_instanced(view_id, state, batch);
+            } else {
+                submit_single(view_id, state, batch);
+            }
+        }
+
+        chunk.stats = state.get_stats();
+    }
+
+    void ForwardRenderer::submit_single(const bgfx::ViewId view_id, EncoderState &state,
+                                        const DrawBatch &batch) const {
+        const auto items = _bucket.get_items();
+        const auto depth_override = batch.prepass ? std::optional(_prepass_function) : std::nullopt;
+
+        for (uint32_t i = batch.begin; i < batch.end; ++i) {
+            const auto &draw = _bucket.get_draw(items[i]);
+
+            state.get_encoder().setTransform(&draw.transform[0][0]);
+            state.set_tint(draw.tint);
+            draw.mesh->draw(state);
+            _light_clusters.bind(state);
+            _shadow_maps.bind(state);
+            draw.material->bind(state, view_id, batch.variant, i, depth_override);
+        }
+    }
+
+    void ForwardRenderer::submit_instanced(const bgfx::ViewId view_id, EncoderState &state,
+                                           const DrawBatch &batch) const {
+        const auto items = _bucket.get_items();
+        const auto &first = _bucket.get_draw(items[batch.begin]);
+        const auto depth_override = batch.prepass ? std::optional(_prepass_function) : std::nullopt;
+
+        first.mesh->draw(state);
+        state.get_encoder().setInstanceDataBuffer(&batch.instance_data);
+        _light_clusters.bind(state);
+        _shadow_maps.bind(state);
+        first.material->get_batch_material().bind(state, view_id, batch.variant, batch.begin, depth_override, true);
+    }
+
+    void ForwardRenderer::submit_prepass(const bgfx::ViewId view_id, EncoderState &state,
+                                         const DrawBatch &batch) const {
+        const auto items = _bucket.get_items();
+        const auto &first = _bucket.get_draw(items[batch.begin]);
+
+        if (batch.instanced) {
+            first.mesh->draw(state);
+            state.get_encoder().setInstanceDataBuffer(&batch.instance_data);
+            state.set_state(first.material->get_depth_prepass_state());
+            state.submit(view_id, first.material->get_depth_shader(true).get_handle(), batch.begin);
+            return;
+        }
+
+        for (uint32_t i = batch.begin; i < batch.end; ++i) {
+            const auto &draw = _bucket.get_draw(items[i]);
+
+            state.get_encoder().setTransform(&draw.transform[0][0]);
+            draw.mesh->draw(state);
+            state.set_state(draw.material->get_depth_prepass_state());
+            state.submit(view_id, draw.material->get_depth_shader(false).get_handle(), i);
+        }
+    }
+
+    void ForwardRenderer::set_instancing_enabled(const bool enabled) {
+        _instancing_enabled = enabled;
+    }
+
+    bool ForwardRenderer::is_instancing_enabled() const {
+        return _instancing_enabled;
+    }
+
+    void ForwardRenderer::set_encoder_thread_count(uint32_t count) {
+        count = std::max(count, 1u);
+        if (count == _encoder_thread_count) {
+            return;
+        }
+
+        _encoder_thread_count = count;
+        _encoder_pool.reset();
+
+        if (count > 1) {
+            _encoder_pool = std::make_unique<ThreadPool>(count - 1);
+        }
+    }
+
+    uint32_t ForwardRenderer::get_encoder_thread_count() const {
+        return _encoder_thread_count;
+    }
+
+    void ForwardRenderer::set_light_cluster_settings(const LightClusterSettings &settings) {
+        _light_cluster_settings = settings;
+    }
+
+    void ForwardRenderer::set_shadow_settings(const ShadowSettings &settings) {
+        _shadow_settings = settings;
+    }
+
+    void ForwardRenderer::set_occlusion_culling_enabled(const bool enabled) {
+        _occlusion_enabled = enabled;
+    }
+
+    void ForwardRenderer::set_occlusion_settings(const OcclusionSettings &settings) {
+        _occlusion_settings = settings;
+    }
+
+    void ForwardRenderer::set_depth_prepass_mode(const DepthPrepassMode mode) {
+        _prepass_mode = mode;
+    }
+
+    void ForwardRenderer::set_depth_prepass_threshold(const float threshold) {
+        _prepass_threshold = std::max(threshold, 0.0f);
+    }
+
+    void ForwardRenderer::set_depth_prepass_function(const DepthFunc func) {
+        if (func != DepthFunc::Equal && func != DepthFunc::LessEqual) {
+            spdlog::warn("ForwardRenderer::set_depth_prepass_function - Only Equal and LessEqual keep the prepass "
+                         "depth visible");
+            return;
+        }
+        _prepass_function = func;
     }
 
     ForwardRendererComponent::ForwardRendererComponent()
-        : _renderer(std::make_unique<ForwardRenderer>()), _view_id(0) {
+        : _renderer(std::make_unique<ForwardRenderer>()) {
     }
 
     ForwardRendererComponent::~ForwardRendererComponent() = default;
@@ -62,6 +525,7 @@ namespace star {
         _app = app;
 
         _renderer->init(scene, app);
+        _renderer->set_camera(camera);
     }
 
     void ForwardRendererComponent::shutdown() {
@@ -79,16 +543,21 @@ namespace star {
             return;
         }
 
-        const auto view_id = _view_id.value();
+        // nothing runs before the chain configured the views of the first reset
+        const auto view_id = _renderer->get_view_id();
+        if (!view_id) {
+            return;
+        }
+
         auto &encoder = *bgfx::begin();
 
-        _renderer->render(view_id, &encoder);
+        _renderer->render(*view_id, &encoder);
 
         bgfx::end(&encoder);
     }
 
-    bgfx::ViewId ForwardRendererComponent::render_reset(const bgfx::ViewId view_id) {
-        return _renderer->render_reset(view_id);
+    void ForwardRendererComponent::render_reset(RenderChain &chain) {
+        _renderer->render_reset(chain);
     }
 
     ForwardRenderer &ForwardRendererComponent::get_renderer() {
@@ -0,0 +1,655 @@
+#include "star/core/common.hpp"
+#include "star/render/light_clusters.hpp"
+#include "star/render/encoder_state.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/shader_registry.hpp"
+#include "star/scene/transform.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <bit>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_CLUSTERS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace star {
+    namespace {
+        // every buffer is laid out in rows of this many texels, the shaders hard code it as well
+        constexpr uint32_t k_texture_width = 1024;
+        constexpr uint32_t k_texels_per_light = 4;
+        constexpr uint32_t k_initial_index_rows = 64;
+
+        // orthographic cameras may put the near plane at zero, the log slices need a positive start
+        constexpr float k_min_slice_depth = 0.05f;
+
+        constexpr uint64_t k_texture_flags = BGFX_SAMPLER_POINT | BGFX_SAMPLER_UV_CLAMP;
+
+        constexpr uint8_t k_light_stage = 4;
+        constexpr uint8_t k_grid_stage = 5;
+        constexpr uint8_t k_index_stage = 6;
+
+        uint32_t rows_for(const size_t texels) {
+            return std::max(static_cast<uint32_t>((texels + k_texture_width - 1) / k_texture_width), 1u);
+        }
+
+        bool supports_format(const bgfx::TextureFormat::Enum format) {
+            return (bgfx::getCaps()->formats[format] & BGFX_CAPS_FORMAT_TEXTURE_2D) != 0;
+        }
+
+        bgfx::TextureHandle create_texture(const uint32_t rows, const bgfx::TextureFormat::Enum format,
+                                           const char *name) {
+            const bgfx::TextureHandle handle = bgfx::createTexture2D(k_texture_width, static_cast<uint16_t>(rows),
+                                                                     false, 1, format, k_texture_flags);
+            if (bgfx::isValid(handle)) {
+                bgfx::setName(handle, name);
+            }
+            return handle;
+        }
+
+        void update_texture(const bgfx::TextureHandle handle, const void *data, const uint32_t rows,
+                            const uint32_t texel_size) {
+            if (!bgfx::isValid(handle) || rows == 0) {
+                return;
+            }
+
+            const uint32_t size = rows * k_texture_width * texel_size;
+            bgfx::updateTexture2D(handle, 0, 0, 0, 0, k_texture_width, static_cast<uint16_t>(rows),
+                                  bgfx::copy(data, size));
+        }
+
+        void destroy_texture(bgfx::TextureHandle &handle) {
+            if (bgfx::isValid(handle)) {
+                bgfx::destroy(handle);
+                handle = BGFX_INVALID_HANDLE;
+            }
+        }
+
+        glm::vec3 unproject(const glm::mat4 &inverse_projection, const float x, const float y, const float z) {
+            const glm::vec4 point = inverse_projection * glm::vec4(x, y, z, 1.0f);
+            return glm::vec3(point) / point.w;
+        }
+
+        // cone against the bounding sphere of a cluster, both in view space
+        bool cone_intersects_sphere(const glm::vec3 &tip, const glm::vec3 &direction, const float range,
+                                    const float cos_angle, const float sin_angle, const glm::vec3 &center,
+                                    const float radius) {
+            const glm::vec3 to_center = center - tip;
+            const float length_sq = glm::dot(to_center, to_center);
+            const float along = glm::dot(to_center, direction);
+            const float distance = cos_angle * std::sqrt(std::max(length_sq - along * along, 0.0f)) -
+                                   along * sin_angle;
+
+            return distance <= radius && along <= radius + range && along >= -radius;
+        }
+    }
+
+    void LightClusters::ClusterBounds::resize(const size_t count) {
+        for (auto *values: {&min_x, &min_y, &min_z, &max_x, &max_y, &max_z, &center_x, &center_y, &center_z, &radius}) {
+            values->assign(count, 0.0f);
+        }
+    }
+
+    LightClusters::LightClusters() = default;
+
+    LightClusters::~LightClusters() {
+        shutdown();
+    }
+
+    bool LightClusters::init(const LightClusterSettings &settings) {
+        shutdown();
+
+        if (settings.clusters_x == 0 || settings.clusters_y == 0 || settings.clusters_z == 0 ||
+            settings.max_lights == 0) {
+            spdlog::error("LightClusters::init - Cluster counts and light budget have to be positive");
+            return false;
+        }
+
+        if (!supports_format(bgfx::TextureFormat::RGBA32F) || !supports_format(bgfx::TextureFormat::RG32F) ||
+            !supports_format(bgfx::TextureFormat::R32F)) {
+            spdlog::error("LightClusters::init - Float textures are not supported by the renderer");
+            return false;
+        }
+
+        _settings = settings;
+
+        const uint32_t cluster_count = _settings.clusters_x * _settings.clusters_y * _settings.clusters_z;
+        const uint32_t light_rows = rows_for(static_cast<size_t>(_settings.max_lights) * k_texels_per_light);
+        const uint32_t grid_rows = rows_for(cluster_count);
+        const uint32_t max_rows = bgfx::getCaps()->limits.maxTextureSize;
+
+        if (light_rows > max_rows || grid_rows > max_rows) {
+            spdlog::error("LightClusters::init - {} lights and {} clusters do not fit the texture limits",
+                          _settings.max_lights, cluster_count);
+            return false;
+        }
+
+        _light_texture = create_texture(light_rows, bgfx::TextureFormat::RGBA32F, "LightClusters.Lights");
+        _grid_texture = create_texture(grid_rows, bgfx::TextureFormat::RG32F, "LightClusters.Grid");
+
+        if (!bgfx::isValid(_light_texture) || !bgfx::isValid(_grid_texture) ||
+            !create_index_texture(k_initial_index_rows * k_texture_width)) {
+            spdlog::error("LightClusters::init - Failed to create the light textures");
+            shutdown();
+            return false;
+        }
+
+        auto &registry = ShaderRegistry::get();
+        _light_sampler = registry.get_sampler("s_lightData", k_light_stage);
+        _grid_sampler = registry.get_sampler("s_lightGrid", k_grid_stage);
+        _index_sampler = registry.get_sampler("s_lightIndices", k_index_stage);
+        _grid_uniform = registry.get_uniform("u_clusterGrid", bgfx::UniformType::Vec4);
+        _depth_uniform = registry.get_uniform("u_clusterDepth", bgfx::UniformType::Vec4);
+        _texture_uniform = registry.get_uniform("u_clusterTextures", bgfx::UniformType::Vec4);
+
+        _grid.assign(static_cast<size_t>(grid_rows) * k_texture_width, glm::vec2(0.0f));
+        _slices.resize(_settings.clusters_z);
+        _bounds_projection = glm::mat4(0.0f);
+
+        _texture_params = glm::vec4(static_cast<float>(light_rows), static_cast<float>(grid_rows),
+                                    static_cast<float>(_index_capacity / k_texture_width), 0.0f);
+        return true;
+    }
+
+    void LightClusters::shutdown() {
+        destroy_texture(_light_texture);
+        destroy_texture(_grid_texture);
+        destroy_texture(_index_texture);
+        _index_capacity = 0;
+
+        _light_data.clear();
+        _sources.clear();
+        _directional_count = 0;
+        _volumes.clear();
+        _slices.clear();
+        _grid.clear();
+        _indices.clear();
+        _index_count = 0;
+        _grid_params = glm::vec4(0.0f);
+    }
+
+    bool LightClusters::is_valid() const {
+        return bgfx::isValid(_light_texture) && bgfx::isValid(_grid_texture) && bgfx::isValid(_index_texture);
+    }
+
+    void LightClusters::collect(const EntityRegistry &registry) {
+        _light_data.clear();
+        _sources.clear();
+        _directional_count = 0;
+
+        if (!is_valid()) {
+            return;
+        }
+
+        const auto lights = registry.view<Light>();
+        const auto add_light = [this, &registry](const Entity entity, const Light &light, const bool shadowed) {
+            glm::mat4 model(1.0f);
+            if (const auto *transform = registry.try_get<Transform>(entity)) {
+                model = transform->get_model_matrix();
+            }
+
+            const glm::vec3 position(model[3]);
+            const glm::vec3 direction = glm::normalize(glm::mat3(model) * glm::vec3(0.0f, 0.0f, -1.0f));
+            const float cos_outer = glm::cos(glm::radians(light.get_outer_angle()));
+
+            glm::vec4 position_range(position, 0.0f);
+            glm::vec4 color_intensity;
+            glm::vec4 direction_spot(direction, 0.0f);
+            light.get_light_data(position_range, color_intensity, direction_spot);
+
+            _light_data.push_back(position_range);
+            _light_data.push_back(color_intensity);
+            _light_data.push_back(direction_spot);
+            _light_data.emplace_back(cos_outer, static_cast<float>(light.get_type()), shadowed ? 1.0f : 0.0f, 0.0f);
+
+            return LightSource{
+                position, light.get_range(), direction, cos_outer, light.get_type() == LightType::Spot
+            };
+        };
+
+        // directional lights go first so the shaders find them without a cluster lookup
+        bool shadow_found = false;
+        for (const auto [entity, light]: lights.each()) {
+            if (!light.is_enabled() || light.get_type() != LightType::Directional) {
+                continue;
+            }
+            if (_directional_count == k_max_directional_lights) {
+                break;
+            }
+
+            // ShadowMaps renders the first directional light that casts shadows
+            const bool shadowed = !shadow_found && light.get_cast_shadows();
+            shadow_found = shadow_found || shadowed;
+
+            add_light(entity, light, shadowed);
+            ++_directional_count;
+        }
+
+        for (const auto [entity, light]: lights.each()) {
+            if (!light.is_enabled() || light.get_type() == LightType::Directional || light.get_range() <= 0.0f) {
+                continue;
+            }
+
+            if (_directional_count + _sources.size() >= _settings.max_lights) {
+                if (!_light_overflow_logged) {
+                    spdlog::warn("LightClusters - More than {} lights in the scene, the rest are ignored",
+                                 _settings.max_lights);
+                    _light_overflow_logged = true;
+                }
+                break;
+            }
+
+            _sources.push_back(add_light(entity, light, false));
+        }
+    }
+
+    void LightClusters::build(const glm::mat4 &view, const glm::mat4 &projection, const float near_clip,
+                              const float far_clip, ThreadPool *pool) {
+        _index_count = 0;
+
+        if (!is_valid()) {
+            return;
+        }
+
+        update_cluster_bounds(projection, near_clip, far_clip);
+        prepare_volumes(view, projection);
+
+        if (pool && pool->get_thread_count() > 0 && !_volumes.empty()) {
+            pool->parallel_for(_settings.clusters_z, [this](const size_t slice) {
+                assign_slice(static_cast<uint32_t>(slice));
+            });
+        } else {
+            for (uint32_t slice = 0; slice < _settings.clusters_z; ++slice) {
+                assign_slice(slice);
+            }
+        }
+
+        merge_slices();
+
+        _grid_params = glm::vec4(static_cast<float>(_settings.clusters_x), static_cast<float>(_settings.clusters_y),
+                                 static_cast<float>(_settings.clusters_z), static_cast<float>(_directional_count));
+        _depth_params = glm::vec4(_slice_scale, _slice_bias, _settings.ambient, 0.0f);
+    }
+
+    void LightClusters::upload() {
+        if (!is_valid()) {
+            return;
+        }
+
+        if (_index_count > _index_capacity) {
+            // grow ahead of the need so a slowly rising light count does not recreate the texture every frame
+            const uint32_t capacity = std::max(_index_count, _index_capacity * 2);
+            if (!create_index_texture(capacity)) {
+                spdlog::error("LightClusters::upload - Failed to grow the index texture to {} entries", capacity);
+                _grid_params = glm::vec4(0.0f);
+                return;
+            }
+            _texture_params.z = static_cast<float>(_index_capacity / k_texture_width);
+        }
+
+        if (!_light_data.empty()) {
+            const uint32_t rows = rows_for(_light_data.size());
+            _light_data.resize(static_cast<size_t>(rows) * k_texture_width, glm::vec4(0.0f));
+            update_texture(_light_texture, _light_data.data(), rows, sizeof(glm::vec4));
+        }
+
+        update_texture(_grid_texture, _grid.data(), rows_for(_grid.size()), sizeof(glm::vec2));
+
+        if (_index_count > 0) {
+            const uint32_t rows = rows_for(_index_count);
+            _indices.resize(static_cast<size_t>(rows) * k_texture_width, 0.0f);
+            update_texture(_index_texture, _indices.data(), rows, sizeof(float));
+        }
+    }
+
+    void LightClusters::bind(EncoderState &state) const {
+        if (!is_valid()) {
+            return;
+        }
+
+        state.set_texture(_light_sampler.stage, _light_sampler.handle, _light_texture);
+        state.set_texture(_grid_sampler.stage, _grid_sampler.handle, _grid_texture);
+        state.set_texture(_index_sampler.stage, _index_sampler.handle, _index_texture);
+
+        auto &encoder = state.get_encoder();
+        encoder.setUniform(_grid_uniform.handle, &_grid_params);
+        encoder.setUniform(_depth_uniform.handle, &_depth_params);
+        encoder.setUniform(_texture_uniform.handle, &_texture_params);
+    }
+
+    uint32_t LightClusters::get_light_count() const {
+        return _directional_count + static_cast<uint32_t>(_sources.size());
+    }
+
+    uint32_t LightClusters::get_directional_light_count() const {
+        return _directional_count;
+    }
+
+    uint32_t LightClusters::get_index_count() const {
+        return _index_count;
+    }
+
+    uint32_t LightClusters::get_cluster_light_count(const uint32_t x, const uint32_t y, const uint32_t z) const {
+        if (x >= _settings.clusters_x || y >= _settings.clusters_y || z >= _settings.clusters_z || _grid.empty()) {
+            return 0;
+        }
+
+        const size_t cell = (static_cast<size_t>(z) * _settings.clusters_y + y) * _settings.clusters_x + x;
+        return static_cast<uint32_t>(_grid[cell].y);
+    }
+
+    void LightClusters::update_cluster_bounds(const glm::mat4 &projection, float near_clip, float far_clip) {
+        near_clip = std::max(near_clip, k_min_slice_depth);
+        far_clip = std::max(far_clip, near_clip * 1.01f);
+
+        if (projection == _bounds_projection && near_clip == _bounds_near && far_clip == _bounds_far) {
+            return;
+        }
+
+        _bounds_projection = projection;
+        _bounds_near = near_clip;
+        _bounds_far = far_clip;
+
+        const uint32_t size_x = _settings.clusters_x;
+        const uint32_t size_y = _settings.clusters_y;
+        const uint32_t size_z = _settings.clusters_z;
+
+        const float log_ratio = std::log(far_clip / near_clip);
+        _slice_scale = static_cast<float>(size_z) / log_ratio;
+        _slice_bias = -static_cast<float>(size_z) * std::log(near_clip) / log_ratio;
+
+        // two points per tile corner give the corner line for perspective and orthographic projections alike
+        const glm::mat4 inverse_projection = glm::inverse(projection);
+        const uint32_t corner_count = (size_x + 1) * (size_y + 1);
+        std::vector<glm::vec3> line_start(corner_count);
+        std::vector<glm::vec3> line_step(corner_count);
+
+        for (uint32_t y = 0; y <= size_y; ++y) {
+            for (uint32_t x = 0; x <= size_x; ++x) {
+                const float ndc_x = -1.0f + 2.0f * static_cast<float>(x) / static_cast<float>(size_x);
+                const float ndc_y = -1.0f + 2.0f * static_cast<float>(y) / static_cast<float>(size_y);
+                const glm::vec3 a = unproject(inverse_projection, ndc_x, ndc_y, 0.0f);
+                const glm::vec3 b = unproject(inverse_projection, ndc_x, ndc_y, 1.0f);
+
+                // point on the line per unit of view depth, depth runs along -z
+                const uint32_t corner = y * (size_x + 1) + x;
+                line_step[corner] = (b - a) / (a.z - b.z);
+                line_start[corner] = a + line_step[corner] * a.z;
+            }
+        }
+
+        _bounds.resize(static_cast<size_t>(size_x) * size_y * size_z);
+
+        for (uint32_t z = 0; z < size_z; ++z) {
+            const float depths[2] = {
+                near_clip * std::pow(far_clip / near_clip, static_cast<float>(z) / static_cast<float>(size_z)),
+                near_clip * std::pow(far_clip / near_clip, static_cast<float>(z + 1) / static_cast<float>(size_z))
+            };
+
+            for (uint32_t y = 0; y < size_y; ++y) {
+                for (uint32_t x = 0; x < size_x; ++x) {
+                    glm::vec3 min(std::numeric_limits<float>::max());
+                    glm::vec3 max(std::numeric_limits<float>::lowest());
+
+                    for (const uint32_t corner: {y * (size_x + 1) + x, y * (size_x + 1) + x + 1,
+                                                 (y + 1) * (size_x + 1) + x, (y + 1) * (size_x + 1) + x + 1}) {
+                        for (const float depth: depths) {
+                            const glm::vec3 point = line_start[corner] + line_step[corner] * depth;
+                            min = glm::min(min, point);
+                            max = glm::max(max, point);
+                        }
+                    }
+
+                    const size_t cluster = (static_cast<size_t>(z) * size_y + y) * size_x + x;
+                    const glm::vec3 center = (min + max) * 0.5f;
+
+                    _bounds.min_x[cluster] = min.x;
+                    _bounds.min_y[cluster] = min.y;
+                    _bounds.min_z[cluster] = min.z;
+                    _bounds.max_x[cluster] = max.x;
+                    _bounds.max_y[cluster] = max.y;
+                    _bounds.max_z[cluster] = max.z;
+                    _bounds.center_x[cluster] = center.x;
+                    _bounds.center_y[cluster] = center.y;
+                    _bounds.center_z[cluster] = center.z;
+                    _bounds.radius[cluster] = glm::length(max - center);
+                }
+            }
+        }
+    }
+
+    void LightClusters::prepare_volumes(const glm::mat4 &view, const glm::mat4 &projection) {
+        _volumes.clear();
+        _volumes.reserve(_sources.size());
+
+        const auto size_x = static_cast<float>(_settings.clusters_x);
+        const auto size_y = static_cast<float>(_settings.clusters_y);
+        const auto max_slice = static_cast<int32_t>(_settings.clusters_z) - 1;
+
+        const auto slice_of = [this, max_slice](const float depth) {
+            const auto slice = static_cast<int32_t>(std::floor(std::log(depth) * _slice_scale + _slice_bias));
+            return static_cast<uint32_t>(std::clamp(slice, 0, max_slice));
+        };
+
+        const auto tile_of = [](const float ndc, const float size) {
+            const auto tile = static_cast<int32_t>(std::floor((ndc * 0.5f + 0.5f) * size));
+            return static_cast<uint32_t>(std::clamp(tile, 0, static_cast<int32_t>(size) - 1));
+        };
+
+        for (const auto &source: _sources) {
+            LightVolume volume;
+            volume.center = glm::vec3(view * glm::vec4(source.position, 1.0f));
+            volume.radius = source.range;
+
+            const float depth_min = -volume.center.z - volume.radius;
+            const float depth_max = -volume.center.z + volume.radius;
+            if (depth_max < _bounds_near || depth_min > _bounds_far) {
+                volume.z_end = 0;
+                _volumes.push_back(volume);
+                continue;
+            }
+
+            volume.z_begin = depth_min <= _bounds_near ? 0 : slice_of(depth_min);
+            volume.z_end = slice_of(depth_max) + 1;
+            volume.x_begin = 0;
+            volume.x_end = _settings.clusters_x;
+            volume.y_begin = 0;
+            volume.y_end = _settings.clusters_y;
+
+            // a sphere reaching past the near plane can cover any tile, everything else is narrowed on screen
+            if (depth_min > _bounds_near) {
+                glm::vec2 ndc_min(std::numeric_limits<float>::max());
+                glm::vec2 ndc_max(std::numeric_limits<float>::lowest());
+
+                for (uint32_t corner = 0; corner < 8; ++corner) {
+                    const glm::vec3 offset((corner & 1) ? volume.radius : -volume.radius,
+                                           (corner & 2) ? volume.radius : -volume.radius,
+                                           (corner & 4) ? volume.radius : -volume.radius);
+                    const glm::vec4 clip = projection * glm::vec4(volume.center + offset, 1.0f);
+                    const glm::vec2 ndc = glm::vec2(clip) / clip.w;
+                    ndc_min = glm::min(ndc_min, ndc);
+                    ndc_max = glm::max(ndc_max, ndc);
+                }
+
+                if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f) {
+                    volume.z_end = 0;
+                    _volumes.push_back(volume);
+                    continue;
+                }
+
+                volume.x_begin = tile_of(ndc_min.x, size_x);
+                volume.x_end = tile_of(ndc_max.x, size_x) + 1;
+                volume.y_begin = tile_of(ndc_min.y, size_y);
+                volume.y_end = tile_of(ndc_max.y, size_y) + 1;
+            }
+
+            if (source.spot) {
+                volume.spot = true;
+                volume.direction = glm::normalize(glm::mat3(view) * source.direction);
+                volume.cos_angle = source.cos_angle;
+                volume.sin_angle = std::sqrt(std::max(1.0f - source.cos_angle * source.cos_angle, 0.0f));
+            }
+
+            _volumes.push_back(volume);
+        }
+    }
+
+    void LightClusters::assign_slice(const uint32_t slice) {
+        auto &scratch = _slices[slice];
+        scratch.pairs.clear();
+
+        const uint32_t size_x = _settings.clusters_x;
+        const uint32_t slice_clusters = size_x * _settings.clusters_y;
+        const size_t slice_base = static_cast<size_t>(slice) * slice_clusters;
+
+        for (uint32_t light = 0; light < _volumes.size(); ++light) {
+            const auto &volume = _volumes[light];
+            if (slice < volume.z_begin || slice >= volume.z_end) {
+                continue;
+            }
+
+            const glm::vec3 &c = volume.center;
+            const float radius_sq = volume.radius * volume.radius;
+            const auto add_hit = [&](const uint32_t local) {
+                const size_t cluster = slice_base + local;
+                if (volume.spot &&
+                    !cone_intersects_sphere(c, volume.direction, volume.radius, volume.cos_angle, volume.sin_angle,
+                                            {_bounds.center_x[cluster], _bounds.center_y[cluster],
+                                             _bounds.center_z[cluster]}, _bounds.radius[cluster])) {
+                    return;
+                }
+                scratch.pairs.push_back(local);
+                scratch.pairs.push_back(light);
+            };
+
+            for (uint32_t y = volume.y_begin; y < volume.y_end; ++y) {
+                const uint32_t row = y * size_x;
+                const size_t base = slice_base + row;
+                uint32_t x = volume.x_begin;
+
+#if defined(STAR_CLUSTERS_SSE)
+                const __m128 cx = _mm_set1_ps(c.x);
+                const __m128 cy = _mm_set1_ps(c.y);
+                const __m128 cz = _mm_set1_ps(c.z);
+                const __m128 r2 = _mm_set1_ps(radius_sq);
+                const __m128 zero = _mm_setzero_ps();
+
+                for (; x + 4 <= volume.x_end; x += 4) {
+                    const size_t i = base + x;
+                    const __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_bounds.min_x[i]), cx),
+                                                            _mm_sub_ps(cx, _mm_loadu_ps(&_bounds.max_x[i]))), zero);
+                    const __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_bounds.min_y[i]), cy),
+                                                            _mm_sub_ps(cy, _mm_loadu_ps(&_bounds.max_y[i]))), zero);
+                    const __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&_bounds.min_z[i]), cz),
+                                                            _mm_sub_ps(cz, _mm_loadu_ps(&_bounds.max_z[i]))), zero);
+                    const __m128 distance_sq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                                          _mm_mul_ps(dz, dz));
+
+                    int mask = _mm_movemask_ps(_mm_cmple_ps(distance_sq, r2));
+                    while (mask != 0) {
+                        const int lane = std::countr_zero(static_cast<unsigned>(mask));
+                        add_hit(row + x + static_cast<uint32_t>(lane));
+                        mask &= mask - 1;
+                    }
+                }
+#endif
+
+                for (; x < volume.x_end; ++x) {
+                    const size_t i = base + x;
+                    const float dx = std::max({_bounds.min_x[i] - c.x, c.x - _bounds.max_x[i], 0.0f});
+                    const float dy = std::max({_bounds.min_y[i] - c.y, c.y - _bounds.max_y[i], 0.0f});
+                    const float dz = std::max({_bounds.min_z[i] - c.z, c.z - _bounds.max_z[i], 0.0f});
+                    if (dx * dx + dy * dy + dz * dz <= radius_sq) {
+                        add_hit(row + x);
+                    }
+                }
+            }
+        }
+
+        // counting sort of the hits into one list per cluster, lights past the shader limit are dropped
+        scratch.counts.assign(slice_clusters, 0);
+        for (size_t i = 0; i < scratch.pairs.size(); i += 2) {
+            ++scratch.counts[scratch.pairs[i]];
+        }
+
+        scratch.offsets.resize(slice_clusters);
+        uint32_t total = 0;
+        for (uint32_t local = 0; local < slice_clusters; ++local) {
+            scratch.counts[local] = std::min(scratch.counts[local], k_max_lights_per_cluster);
+            scratch.offsets[local] = total;
+            total += scratch.counts[local];
+        }
+
+        scratch.indices.resize(total);
+        std::vector<uint32_t> &cursor = scratch.counts;
+        std::ranges::fill(cursor, 0u);
+        for (size_t i = 0; i < scratch.pairs.size(); i += 2) {
+            const uint32_t local = scratch.pairs[i];
+            const uint32_t next = cursor[local];
+            if (next < k_max_lights_per_cluster) {
+                scratch.indices[scratch.offsets[local] + next] = scratch.pairs[i + 1];
+                ++cursor[local];
+            }
+        }
+    }
+
+    void LightClusters::merge_slices() {
+        const uint32_t slice_clusters = _settings.clusters_x * _settings.clusters_y;
+        const size_t max_indices = static_cast<size_t>(bgfx::getCaps()->limits.maxTextureSize) * k_texture_width;
+
+        size_t total = 0;
+        for (const auto &scratch: _slices) {
+            total += scratch.indices.size();
+        }
+
+        if (total > max_indices && !_index_overflow_logged) {
+            spdlog::warn("LightClusters - {} light indices exceed the texture limit of {}, clusters are truncated",
+                         total, max_indices);
+            _index_overflow_logged = true;
+        }
+
+        total = std::min(total, max_indices);
+        if (_indices.size() < total) {
+            _indices.resize(total);
+        }
+
+        uint32_t base = 0;
+        for (uint32_t slice = 0; slice < _settings.clusters_z; ++slice) {
+            const auto &scratch = _slices[slice];
+            glm::vec2 *cells = &_grid[static_cast<size_t>(slice) * slice_clusters];
+
+            const auto available = static_cast<uint32_t>(total - base);
+            const auto copied = std::min(static_cast<uint32_t>(scratch.indices.size()), available);
+
+            for (uint32_t local = 0; local < slice_clusters; ++local) {
+                const uint32_t offset = scratch.offsets.empty() ? 0 : scratch.offsets[local];
+                const uint32_t count = scratch.counts.empty() ? 0 : scratch.counts[local];
+                const uint32_t kept = offset >= copied ? 0 : std::min(count, copied - offset);
+                cells[local] = glm::vec2(static_cast<float>(base + offset), static_cast<float>(kept));
+            }
+
+            // the shaders index the lights after the directional ones
+            for (uint32_t i = 0; i < copied; ++i) {
+                _indices[base + i] = static_cast<float>(scratch.indices[i] + _directional_count);
+            }
+
+            base += copied;
+        }
+
+        _index_count = base;
+    }
+
+    bool LightClusters::create_index_texture(const uint32_t capacity) {
+        destroy_texture(_index_texture);
+        _index_capacity = 0;
+
+        const uint32_t rows = std::min<uint32_t>(rows_for(capacity), bgfx::getCaps()->limits.maxTextureSize);
+
+        _index_texture = create_texture(rows, bgfx::TextureFormat::R32F, "LightClusters.Indices");
+        if (!bgfx::isValid(_index_texture)) {
+            return false;
+        }
+
+        _index_capacity = rows * k_texture_width;
+        return true;
+    }
+}
@@ -2,9 +2,153 @@
 #include "star/render/material.hpp"
 #include "star/graphics/shaders.hpp"
 #include "star/render/texture.hpp"
+#include "star/render/draw_bucket.hpp"
+#include "star/render/encoder_state.hpp"
 
 namespace star {
-    Material::Material() {
+    namespace {
+        std::atomic<uint32_t> s_next_material_id{1};
+
+        uint32_t get_uniform_size(const bgfx::UniformType::Enum type) {
+            switch (type) {
+                case bgfx::UniformType::Vec4:
+                    return 4;
+                case bgfx::UniformType::Mat3:
+                    return 9;
+                case bgfx::UniformType::Mat4:
+                    return 16;
+                default:
+                    return 0;
+            }
+        }
+
+        uint64_t get_depth_test_state(const DepthFunc func) {
+            switch (func) {
+                case DepthFunc::Less:
+                    return BGFX_STATE_DEPTH_TEST_LESS;
+                case DepthFunc::LessEqual:
+                    return BGFX_STATE_DEPTH_TEST_LEQUAL;
+                case DepthFunc::Equal:
+                    return BGFX_STATE_DEPTH_TEST_EQUAL;
+                case DepthFunc::GreaterEqual:
+                    return BGFX_STATE_DEPTH_TEST_GEQUAL;
+                case DepthFunc::Greater:
+                    return BGFX_STATE_DEPTH_TEST_GREATER;
+                case DepthFunc::NotEqual:
+                    return BGFX_STATE_DEPTH_TEST_NOTEQUAL;
+                case DepthFunc::Always:
+                    return BGFX_STATE_DEPTH_TEST_ALWAYS;
+                case DepthFunc::Never:
+                    return BGFX_STATE_DEPTH_TEST_NEVER;
+            }
+            return 0;
+        }
+    }
+
+    ShaderVariant get_shader_variant(const VertexFormat format, const bool instanced) {
+        if (format == VertexFormat::Half || format == VertexFormat::Quantized) {
+            return instanced ? ShaderVariant::PackedInstanced : ShaderVariant::Packed;
+        }
+        return instanced ? ShaderVariant::Instanced : ShaderVariant::Default;
+    }
+
+    bool MaterialParameterBlock::set(const bgfx::UniformHandle handle, const bgfx::UniformType::Enum type,
+                                     const float *data, const uint16_t count) {
+        const uint32_t size = get_uniform_size(type) * count;
+        if (!bgfx::isValid(handle) || !data || size == 0) {
+            return false;
+        }
+
+        auto it = find(handle);
+        if (it != _entries.end() && it->handle.idx == handle.idx && it->size != size) {
+            remove(handle);
+            it = find(handle);
+        }
+
+        if (it == _entries.end() || it->handle.idx != handle.idx) {
+            Entry entry;
+            entry.handle = handle;
+            entry.count = count;
+            entry.offset = static_cast<uint32_t>(_data.size());
+            entry.size = size;
+            _entries.insert(it, entry);
+            _data.insert(_data.end(), data, data + size);
+            return true;
+        }
+
+        std::memcpy(_data.data() + it->offset, data, size * sizeof(float));
+        return true;
+    }
+
+    bool MaterialParameterBlock::has(const bgfx::UniformHandle handle) const {
+        const auto it = find(handle);
+        return it != _entries.end() && it->handle.idx == handle.idx;
+    }
+
+    const float *MaterialParameterBlock::get(const bgfx::UniformHandle handle) const {
+        const auto it = find(handle);
+        if (it == _entries.end() || it->handle.idx != handle.idx) {
+            return nullptr;
+        }
+        return _data.data() + it->offset;
+    }
+
+    void MaterialParameterBlock::remove(const bgfx::UniformHandle handle) {
+        const auto it = find(handle);
+        if (it == _entries.end() || it->handle.idx != handle.idx) {
+            return;
+        }
+
+        const uint32_t offset = it->offset;
+        const uint32_t size = it->size;
+        _data.erase(_data.begin() + offset, _data.begin() + offset + size);
+        _entries.erase(it);
+
+        for (auto &entry: _entries) {
+            if (entry.offset > offset) {
+                entry.offset -= size;
+            }
+        }
+    }
+
+    void MaterialParameterBlock::clear() {
+        _entries.clear();
+        _data.clear();
+    }
+
+    bool MaterialParameterBlock::empty() const {
+        return _entries.empty();
+    }
+
+    size_t MaterialParameterBlock::get_size() const {
+        return _entries.size();
+    }
+
+    void MaterialParameterBlock::apply(bgfx::Encoder &encoder, const MaterialParameterBlock *overrides,
+                                       const bgfx::UniformHandle skip) const {
+        for_each(overrides, [&](const bgfx::UniformHandle handle, const float *data, const uint16_t count) {
+            if (handle.idx != skip.idx) {
+                encoder.setUniform(handle, data, count);
+            }
+        });
+    }
+
+    std::vector<MaterialParameterBlock::Entry>::iterator MaterialParameterBlock::find(
+        const bgfx::UniformHandle handle) {
+        return std::ranges::lower_bound(_entries, handle.idx, {}, [](const Entry &entry) {
+            return entry.handle.idx;
+        });
+    }
+
+    std::vector<MaterialParameterBlock::Entry>::const_iterator MaterialParameterBlock::find(
+        const bgfx::UniformHandle handle) const {
+        return std::ranges::lower_bound(_entries, handle.idx, {}, [](const Entry &entry) {
+            return entry.handle.idx;
+        });
+    }
+
+    Material::Material()
+        : _id(s_next_material_id.fetch_add(1, std::memory_order_relaxed)) {
         update_state();
     }
 
@@ -12,75 +156,170 @@ namespace star {
 
     Material::Material(Material &&other) noexcept
         : _shader(std::move(other._shader))
+          , _variant_shaders(std::move(other._variant_shaders))
+          , _depth_shaders(std::move(other._depth_shaders))
+          , _id(other._id)
           , _state(other._state)
           , _depth_test(other._depth_test)
           , _depth_write(other._depth_write)
           , _depth_func(other._depth_func)
           , _blend_mode(other._blend_mode)
-          , _cull_mode(other._cull_mode) {
+          , _cull_mode(other._cull_mode)
+          , _parameters(std::move(other._parameters))
+          , _textures(std::move(other._textures)) {
     }
 
     Material &Material::operator=(Material &&other) noexcept {
         if (this != &other) {
             _shader = std::move(other._shader);
+            _variant_shaders = std::move(other._variant_shaders);
+            _depth_shaders = std::move(other._depth_shaders);
+            _id = other._id;
             _state = other._state;
             _depth_test = other._depth_test;
             _depth_write = other._depth_write;
             _depth_func = other._depth_func;
             _blend_mode = other._blend_mode;
             _cull_mode = other._cull_mode;
+            _parameters = std::move(other._parameters);
+            _textures = std::move(other._textures);
         }
         return *this;
     }
 
-    bool Material::set_shader(Shader &&shader) {
+    bool Material::set_shader(Shader &&shader, const ShaderVariant variant) {
+        if (!shader.is_valid() || variant == ShaderVariant::Count) {
+            return false;
+        }
+
+        get_shader(variant) = std::move(shader);
+        return true;
+    }
+
+    bool Material::has_shader(const ShaderVariant variant) const {
+        return variant != ShaderVariant::Count && get_shader(variant).is_valid();
+    }
+
+    bool Material::set_depth_shader(Shader &&shader, const bool instanced) {
         if (!shader.is_valid()) {
             return false;
         }
 
-        _shader = std::move(shader);
+        _depth_shaders[instanced ? 1 : 0] = std::move(shader);
         return true;
     }
 
-    bool Material::set_texture(const std::string &sampler_name, bgfx::TextureHandle texture, uint32_t flags) {
-        TextureSampler *sampler = _shader.get_sampler(sampler_name);
+    const Shader &Material::get_depth_shader(const bool instanced) const {
+        return get_base()._depth_shaders[instanced ? 1 : 0];
+    }
+
+    Shader &Material::get_shader(const ShaderVariant variant) {
+        if (variant == ShaderVariant::Default) {
+            return _shader;
+        }
+        return _variant_shaders[static_cast<size_t>(variant) - 1];
+    }
+
+    const Shader &Material::get_shader(const ShaderVariant variant) const {
+        const Material &base = get_base();
+        if (variant == ShaderVariant::Default) {
+            return base._shader;
+        }
+        return base._variant_shaders[static_cast<size_t>(variant) - 1];
+    }
+
+    TextureSampler *Material::get_or_add_texture(const UniformId sampler_id) {
+        const ShaderSampler *sampler = get_base()._shader.get_sampler(sampler_id);
+        if (!sampler) {
+            return nullptr;
+        }
+
+        auto it = std::ranges::lower_bound(_textures, sampler->stage, {}, &TextureSampler::stage);
+        if (it == _textures.end() || it->stage != sampler->stage) {
+            it = _textures.insert(it, TextureSampler{});
+        }
+
+        it->sampler = sampler->handle;
+        it->stage = sampler->stage;
+        return &*it;
+    }
+
+    bool Material::set_texture(const UniformId sampler_id, const bgfx::TextureHandle texture, const uint32_t flags) {
+        TextureSampler *sampler = get_or_add_texture(sampler_id);
         if (!sampler) {
             return false;
         }
 
         sampler->handle = texture;
+        sampler->texture.reset();
         sampler->flags = flags;
         return true;
     }
 
-    bool Material::set_uniform(const std::string &name, const glm::vec4 &value) {
-        const ShaderUniform *uniform = _shader.get_uniform(name);
-        if (!uniform || uniform->type != bgfx::UniformType::Vec4) {
+    bool Material::set_texture(const std::string_view sampler_name, const bgfx::TextureHandle texture,
+                               const uint32_t flags) {
+        return set_texture(UniformId(sampler_name), texture, flags);
+    }
+
+    bool Material::set_texture(const UniformId sampler_id, std::shared_ptr<const Texture> texture,
+                               const uint32_t flags) {
+        TextureSampler *sampler = get_or_add_texture(sampler_id);
+        if (!sampler) {
             return false;
         }
 
-        bgfx::setUniform(uniform->handle, &value);
+        sampler->handle = BGFX_INVALID_HANDLE;
+        sampler->texture = std::move(texture);
+        sampler->flags = flags;
         return true;
     }
 
-    bool Material::set_uniform(const std::string &name, const glm::mat4 &value) {
-        ShaderUniform *uniform = _shader.get_uniform(name);
-        if (!uniform || uniform->type != bgfx::UniformType::Mat4) {
+    bool Material::set_texture(const std::string_view sampler_name, std::shared_ptr<const Texture> texture,
+                               const uint32_t flags) {
+        return set_texture(UniformId(sampler_name), std::move(texture), flags);
+    }
+
+    bool Material::set_uniform(const UniformId id, const glm::vec4 &value) {
+        return set_parameter(id, bgfx::UniformType::Vec4, &value.x, 1);
+    }
+
+    bool Material::set_uniform(const UniformId id, const glm::mat4 &value) {
+        return set_parameter(id, bgfx::UniformType::Mat4, &value[0].x, 1);
+    }
+
+    bool Material::set_uniform(const UniformId id, const float *data, const uint16_t count) {
+        const ShaderUniform *uniform = get_base()._shader.get_uniform(id);
+        if (!uniform) {
             return false;
         }
 
-        bgfx::setUniform(uniform->handle, &value);
-        return true;
+        return _parameters.set(uniform->handle, uniform->type, data, count);
     }
 
-    bool Material::set_uniform(const std::string &name, const float *data, uint16_t count) {
-        ShaderUniform *uniform = _shader.get_uniform(name);
-        if (!uniform) {
+    bool Material::set_uniform(const std::string_view name, const glm::vec4 &value) {
+        return set_uniform(UniformId(name), value);
+    }
+
+    bool Material::set_uniform(const std::string_view name, const glm::mat4 &value) {
+        return set_uniform(UniformId(name), value);
+    }
+
+    bool Material::set_uniform(const std::string_view name, const float *data, const uint16_t count) {
+        return set_uniform(UniformId(name), data, count);
+    }
+
+    bool Material::set_parameter(const UniformId id, const bgfx::UniformType::Enum type, const float *data,
+                                 const uint16_t count) {
+        const ShaderUniform *uniform = get_base()._shader.get_uniform(id);
+        if (!uniform || uniform->type != type) {
             return false;
         }
 
-        bgfx::setUniform(uniform->handle, data, count);
-        return true;
+        return _parameters.set(uniform->handle, type, data, count);
+    }
+
+    const MaterialParameterBlock &Material::get_parameters() const {
+        return _parameters;
     }
 
     void Material::set_blend_mode(BlendMode mode) {
@@ -128,61 +367,148 @@ namespace star {
         return _cull_mode;
     }
 
-    void Material::bind(bgfx::Encoder *encoder, uint8_t view_id) const {
-        if (!_shader.is_valid()) {
+    void Material::bind(bgfx::Encoder *encoder, const uint8_t view_id, const ShaderVariant variant,
+                        const uint32_t depth) const {
+        EncoderState state(*encoder);
+        bind(state, view_id, variant, depth);
+    }
+
+    void Material::bind(EncoderState &state, const uint8_t view_id, const ShaderVariant variant,
+                        const uint32_t depth, const std::optional<DepthFunc> depth_override,
+                        const bool batch_color) const {
+        const Shader &shader = get_shader(variant);
+        if (!shader.is_valid()) {
             spdlog::warn("Material::bind - Invalid shader");
             return;
         }
 
-        encoder->setState(_state);
+        uint64_t render_state = get_base()._state;
+        if (depth_override) {
+            // the depth is already in place, it is only tested
+            render_state &= ~(BGFX_STATE_DEPTH_TEST_MASK | BGFX_STATE_WRITE_Z);
+            render_state |= get_depth_test_state(*depth_override);
+        }
+
+        submit(state, view_id, shader.get_handle(), depth, render_state, batch_color);
+    }
+
+    void Material::bind(EncoderState &state, const uint8_t view_id, const bgfx::ProgramHandle program,
+                        const uint32_t depth, const uint64_t extra_state, const bool batch_color) const {
+        if (!bgfx::isValid(program)) {
+            spdlog::warn("Material::bind - Invalid program");
+            return;
+        }
+
+        submit(state, view_id, program, depth, get_base()._state | extra_state, batch_color);
+    }
 
-        for (const auto &sampler: _shader._samplers | std::views::values) {
-            if (bgfx::isValid(sampler.handle)) {
-                encoder->setTexture(sampler.stage, sampler.sampler, sampler.handle, sampler.flags);
+    const Material &Material::get_batch_material() const {
+        const Material &base = get_base();
+        if (&base == this || !_textures.empty()) {
+            return *this;
+        }
+
+        if (_parameters.empty()) {
+            return base;
+        }
+
+        const ShaderUniform *color = get_batch_color_uniform();
+        return color && _parameters.get_size() == 1 && _parameters.has(color->handle) ? base : *this;
+    }
+
+    glm::vec4 Material::get_batch_color() const {
+        const ShaderUniform *color = get_batch_color_uniform();
+        if (!color) {
+            return glm::vec4(1.0f);
+        }
+
+        const float *value = _parameters.get(color->handle);
+        if (!value) {
+            value = get_base()._parameters.get(color->handle);
+        }
+        return value ? glm::vec4(value[0], value[1], value[2], value[3]) : glm::vec4(1.0f);
+    }
+
+    const ShaderUniform *Material::get_batch_color_uniform() const {
+        const Material &base = get_base();
+        const UniformId id = base.get_color_uniform();
+        return id.is_valid() ? base._shader.get_uniform(id) : nullptr;
+    }
+
+    void Material::submit(EncoderState &state, const uint8_t view_id, const bgfx::ProgramHandle program,
+                          const uint32_t depth, const uint64_t render_state, const bool batch_color) const {
+        const Material &base = get_base();
+        const bool instance = &base != this;
+        state.set_state(render_state);
+
+        for (const auto &texture: base._textures) {
+            // instance textures replace the parent's on the same stage
+            if (instance && std::ranges::binary_search(_textures, texture.stage, {}, &TextureSampler::stage)) {
+                continue;
+            }
+            if (texture.is_valid()) {
+                state.set_texture(texture.stage, texture.sampler, texture.get_handle(), texture.flags);
             }
         }
 
-        encoder->submit(view_id, _shader.get_handle());
+        if (instance) {
+            for (const auto &texture: _textures) {
+                if (texture.is_valid()) {
+                    state.set_texture(texture.stage, texture.sampler, texture.get_handle(), texture.flags);
+                }
+            }
+        }
+
+        // a batched color comes with the instance data, the uniform is set to white instead of the parameter
+        const ShaderUniform *color = batch_color ? get_batch_color_uniform() : nullptr;
+        base._parameters.apply(state.get_encoder(), instance ? &_parameters : nullptr,
+                               color ? color->handle : bgfx::UniformHandle BGFX_INVALID_HANDLE);
+
+        if (color) {
+            const glm::vec4 white(1.0f);
+            state.get_encoder().setUniform(color->handle, &white[0]);
+        }
+
+        // set on every draw, the uniform would otherwise keep whatever tint the draw sorted before this one had
+        if (const ShaderUniform *tint = base._shader.get_uniform(k_uniform_tint)) {
+            state.get_encoder().setUniform(tint->handle, &state.get_tint()[0]);
+        }
+
+        state.submit(view_id, program, depth);
     }
 
-    uint32_t Material::generate_sort_key() const {
-        const uint32_t type_key = static_cast<uint32_t>(get_type()) << 24;
-        const uint32_t blend_key = static_cast<uint32_t>(_blend_mode) << 20;
-        const uint32_t shader_key = _shader.is_valid() ? static_cast<uint32_t>(_shader.get_handle().idx & 0xFFFFF) : 0;
+    bool Material::is_translucent() const {
+        return get_base()._blend_mode != BlendMode::Opaque;
+    }
 
-        return type_key | blend_key | shader_key;
+    bool Material::supports_depth_prepass() const {
+        const Material &base = get_base();
+        return base._blend_mode == BlendMode::Opaque && base._depth_test && base._depth_write &&
+               (base._depth_func == DepthFunc::Less || base._depth_func == DepthFunc::LessEqual) &&
+               base._depth_shaders[0].is_valid();
+    }
+
+    uint64_t Material::get_depth_prepass_state() const {
+        return BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS | (get_base()._state & BGFX_STATE_CULL_MASK);
+    }
+
+    uint32_t Material::get_id() const {
+        return _id;
+    }
+
+    uint32_t Material::generate_sort_key() const {
+        const Material &base = get_base();
+        const uint32_t program = base._shader.is_valid() ? base._shader.get_handle().idx : 0;
+        // instances that batch with their parent sort next to it
+        return DrawKey::make_material_key(static_cast<uint32_t>(base._blend_mode), program,
+                                          get_batch_material()._id);
     }
 
     void Material::update_state() {
         _state = BGFX_STATE_WRITE_RGB | BGFX_STATE_MSAA;
 
         if (_depth_test) {
-            switch (_depth_func) {
-                case DepthFunc::Less:
-                    _state |= BGFX_STATE_DEPTH_TEST_LESS;
-                    break;
-                case DepthFunc::LessEqual:
-                    _state |= BGFX_STATE_DEPTH_TEST_LEQUAL;
-                    break;
-                case DepthFunc::Equal:
-                    _state |= BGFX_STATE_DEPTH_TEST_EQUAL;
-                    break;
-                case DepthFunc::GreaterEqual:
-                    _state |= BGFX_STATE_DEPTH_TEST_GEQUAL;
-                    break;
-                case DepthFunc::Greater:
-                    _state |= BGFX_STATE_DEPTH_TEST_GREATER;
-                    break;
-                case DepthFunc::NotEqual:
-                    _state |= BGFX_STATE_DEPTH_TEST_NOTEQUAL;
-                    break;
-                case DepthFunc::Always:
-                    _state |= BGFX_STATE_DEPTH_TEST_ALWAYS;
-                    break;
-                case DepthFunc::Never:
-                    _state |= BGFX_STATE_DEPTH_TEST_NEVER;
-                    break;
-            }
+            _state |= get_depth_test_state(_depth_func);
         }
 
         if (_depth_write) {
@@ -215,15 +541,55 @@ namespace star {
         }
     }
 
+    MaterialInstance::MaterialInstance(std::shared_ptr<Material> parent)
+        : _parent(std::move(parent)) {
+        if (!_parent) {
+            spdlog::error("MaterialInstance - Null parent, the instance has no shaders and draws nothing");
+            return;
+        }
+
+        // an instance of an instance starts from its overrides and shares the same base
+        if (const auto *instance = dynamic_cast<const MaterialInstance *>(_parent.get())) {
+            _parameters = instance->_parameters;
+            _textures = instance->_textures;
+            _parent = instance->_parent;
+        }
+    }
+
+    MaterialInstance::~MaterialInstance() = default;
+
+    MaterialType MaterialInstance::get_type() const {
+        return _parent ? _parent->get_type() : MaterialType::Custom;
+    }
+
+    const std::shared_ptr<Material> &MaterialInstance::get_parent() const {
+        return _parent;
+    }
+
+    void MaterialInstance::clear_overrides() {
+        _parameters.clear();
+        _textures.clear();
+    }
+
+    const Material &MaterialInstance::get_base() const {
+        return _parent ? *_parent : *this;
+    }
+
     UnlitMaterial::UnlitMaterial() {
         _shader.load(k_simple_vs, k_simple_fs);
+        get_shader(ShaderVariant::Instanced).load(k_simple_instanced_vs, k_simple_fs);
+        get_shader(ShaderVariant::Packed).load(k_simple_packed_vs, k_simple_fs);
+        get_shader(ShaderVariant::PackedInstanced).load(k_simple_packed_instanced_vs, k_simple_fs);
+        _depth_shaders[0].load(k_depth_vs, k_shadow_fs);
+        _depth_shaders[1].load(k_depth_instanced_vs, k_shadow_fs);
+        set_uniform(k_uniform_color, _color);
     }
 
     UnlitMaterial::~UnlitMaterial() = default;
 
     void UnlitMaterial::set_color(const glm::vec4 &color) {
         _color = color;
-        set_uniform("u_color", _color);
+        set_uniform(k_uniform_color, _color);
     }
 
     glm::vec4 UnlitMaterial::get_color() const {
@@ -231,13 +597,22 @@ namespace star {
     }
 
     StandardMaterial::StandardMaterial() {
+        _shader.load(k_standard_vs, k_standard_fs);
+        get_shader(ShaderVariant::Instanced).load(k_standard_instanced_vs, k_standard_fs);
+        get_shader(ShaderVariant::Packed).load(k_standard_packed_vs, k_standard_fs);
+        get_shader(ShaderVariant::PackedInstanced).load(k_standard_packed_instanced_vs, k_standard_fs);
+        _depth_shaders[0].load(k_depth_vs, k_shadow_fs);
+        _depth_shaders[1].load(k_depth_instanced_vs, k_shadow_fs);
+        set_uniform(k_uniform_base_color, _base_color);
+        set_uniform(k_uniform_material_params, glm::vec4(_metallic, _roughness, 0.0f, 0.0f));
+        set_uniform(k_uniform_emissive, glm::vec4(_emissive, 1.0f));
     }
 
     StandardMaterial::~StandardMaterial() = default;
 
     void StandardMaterial::set_base_color(const glm::vec4 &color) {
         _base_color = color;
-        set_uniform("u_baseColor", _base_color);
+        set_uniform(k_uniform_base_color, _base_color);
     }
 
     glm::vec4 StandardMaterial::get_base_color() const {
@@ -247,7 +622,7 @@ namespace star {
     void StandardMaterial::set_metallic(float value) {
         _metallic = glm::clamp(value, 0.0f, 1.0f);
         glm::vec4 params(_metallic, _roughness, 0.0f, 0.0f);
-        set_uniform("u_materialParams", params);
+        set_uniform(k_uniform_material_params, params);
     }
 
     float StandardMaterial::get_metallic() const {
@@ -257,7 +632,7 @@ namespace star {
     void StandardMaterial::set_roughness(float value) {
         _roughness = glm::clamp(value, 0.0f, 1.0f);
         glm::vec4 params(_metallic, _roughness, 0.0f, 0.0f);
-        set_uniform("u_materialParams", params);
+        set_uniform(k_uniform_material_params, params);
     }
 
     float StandardMaterial::get_roughness() const {
@@ -266,7 +641,7 @@ namespace star {
 
     void StandardMaterial::set_emissive(const glm::vec3 &value) {
         _emissive = value;
-        set_uniform("u_emissive", glm::vec4(_emissive, 1.0f));
+        set_uniform(k_uniform_emissive, glm::vec4(_emissive, 1.0f));
     }
 
     glm::vec3 StandardMaterial::get_emissive() const {
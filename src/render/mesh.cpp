@@ -1,9 +1,53 @@
 #include "star/render/mesh.hpp"
+#include "star/render/encoder_state.hpp"
+#include "star/render/mesh_optimizer.hpp"
+#include <bx/math.h>
 #include <glm/gtc/constants.hpp>
 #include <spdlog/spdlog.h>
 
 namespace star {
+    namespace {
+        // what bgfx::frame returned last, transient meshes filled since then are still valid
+        std::atomic<uint32_t> s_transient_frame{0};
+        std::atomic<uint32_t> s_next_transient_sort_id{0};
+
+        int16_t to_snorm16(const float value) {
+            return static_cast<int16_t>(std::round(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+        }
+
+        uint8_t to_unorm8(const float value) {
+            return static_cast<uint8_t>(std::round(std::clamp(value, 0.0f, 1.0f) * 255.0f));
+        }
+
+        glm::vec2 encode_octahedral(const glm::vec3 &normal) {
+            const float l1 = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+            if (l1 <= 0.0f) {
+                return glm::vec2(0.0f);
+            }
+
+            glm::vec2 encoded = glm::vec2(normal) / l1;
+            if (normal.z < 0.0f) {
+                encoded = glm::vec2(
+                    (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f),
+                    (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f));
+            }
+            return encoded;
+        }
+
+        VertexFormat resolve_format(const VertexFormat format, const Aabb &aabb) {
+            if (format != VertexFormat::Auto) {
+                return format;
+            }
+
+            // flat along every axis leaves nothing to quantize against
+            const glm::vec3 extents = aabb.get_extents();
+            return std::max({extents.x, extents.y, extents.z}) > 0.0f ? VertexFormat::Quantized : VertexFormat::Half;
+        }
+    }
+
     bgfx::VertexLayout Vertex::ms_layout;
+    bgfx::VertexLayout PackedVertex::ms_half_layout;
+    bgfx::VertexLayout PackedVertex::ms_quantized_layout;
 
     void Vertex::init() {
         ms_layout
@@ -13,6 +57,66 @@ namespace star {
                 .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Float)
                 .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Float)
                 .end();
+
+        PackedVertex::ms_half_layout
+                .begin()
+                .add(bgfx::Attrib::Position, 4, bgfx::AttribType::Half)
+                .add(bgfx::Attrib::Normal, 2, bgfx::AttribType::Int16, true)
+                .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Half)
+                .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+                .end();
+
+        PackedVertex::ms_quantized_layout
+                .begin()
+                .add(bgfx::Attrib::Position, 4, bgfx::AttribType::Int16, true)
+                .add(bgfx::Attrib::Normal, 2, bgfx::AttribType::Int16, true)
+                .add(bgfx::Attrib::TexCoord0, 2, bgfx::AttribType::Half)
+                .add(bgfx::Attrib::Color0, 4, bgfx::AttribType::Uint8, true)
+                .end();
+    }
+
+    const bgfx::VertexLayout &Vertex::get_layout(const VertexFormat format) {
+        switch (format) {
+            case VertexFormat::Half:
+                return PackedVertex::ms_half_layout;
+            case VertexFormat::Quantized:
+                return PackedVertex::ms_quantized_layout;
+            default:
+                return ms_layout;
+        }
+    }
+
+    PackedVertex PackedVertex::pack(const Vertex &vertex, const VertexFormat format, const glm::vec4 &dequantization) {
+        PackedVertex packed{};
+
+        const glm::vec3 position = (vertex.position - glm::vec3(dequantization)) / dequantization.w;
+        for (int i = 0; i < 3; ++i) {
+            packed.position[i] = format == VertexFormat::Quantized
+                                     ? static_cast<uint16_t>(to_snorm16(position[i]))
+                                     : bx::halfFromFloat(position[i]);
+        }
+        packed.position[3] = format == VertexFormat::Quantized
+                                 ? static_cast<uint16_t>(to_snorm16(1.0f))
+                                 : bx::halfFromFloat(1.0f);
+
+        const glm::vec2 normal = encode_octahedral(vertex.normal);
+        packed.normal[0] = to_snorm16(normal.x);
+        packed.normal[1] = to_snorm16(normal.y);
+
+        packed.texcoord[0] = bx::halfFromFloat(vertex.texcoord.x);
+        packed.texcoord[1] = bx::halfFromFloat(vertex.texcoord.y);
+
+        for (int i = 0; i < 4; ++i) {
+            packed.color[i] = to_unorm8(vertex.color[i]);
+        }
+
+        return packed;
+    }
+
+    size_t MeshBuildOptionsHash::operator()(const MeshBuildOptions &options) const {
+        // every field fits in its own bits, equal options are the only ones hashing the same
+        return static_cast<size_t>(options.format) | static_cast<size_t>(options.optimize) << 8 |
+               static_cast<size_t>(options.keep_cpu_data) << 9;
     }
 
     Mesh::Mesh() = default;
@@ -22,10 +126,16 @@ namespace star {
     }
 
     Mesh::Mesh(Mesh &&other) noexcept
-        : _vbh(other._vbh)
+        : _vertex_count(other._vertex_count)
+          , _index_count(other._index_count)
+          , _aabb(other._aabb)
+          , _bounding_sphere(other._bounding_sphere)
+          , _vbh(other._vbh)
           , _ibh(other._ibh)
-          , _vertex_count(other._vertex_count)
-          , _index_count(other._index_count) {
+          , _format(other._format)
+          , _dequantization(other._dequantization)
+          , _cpu_vertices(std::move(other._cpu_vertices))
+          , _cpu_indices(std::move(other._cpu_indices)) {
         other._vbh = BGFX_INVALID_HANDLE;
         other._ibh = BGFX_INVALID_HANDLE;
         other._vertex_count = 0;
@@ -40,6 +150,12 @@ namespace star {
             _ibh = other._ibh;
             _vertex_count = other._vertex_count;
             _index_count = other._index_count;
+            _aabb = other._aabb;
+            _bounding_sphere = other._bounding_sphere;
+            _format = other._format;
+            _dequantization = other._dequantization;
+            _cpu_vertices = std::move(other._cpu_vertices);
+            _cpu_indices = std::move(other._cpu_indices);
 
             other._vbh = BGFX_INVALID_HANDLE;
             other._ibh = BGFX_INVALID_HANDLE;
@@ -49,7 +165,18 @@ namespace star {
         return *this;
     }
 
-    bool Mesh::create(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices) {
+    bool Mesh::create(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices,
+                      const MeshBuildOptions &options) {
+        if (options.optimize && !indices.empty()) {
+            auto optimized_vertices = vertices;
+            auto optimized_indices = indices;
+            MeshOptimizer::optimize(optimized_vertices, optimized_indices);
+
+            auto upload_options = options;
+            upload_options.optimize = false;
+            return create(optimized_vertices, optimized_indices, upload_options);
+        }
+
         destroy();
 
         if (vertices.empty()) {
@@ -57,9 +184,30 @@ namespace star {
             return false;
         }
 
-        const bgfx::Memory *vbmem = bgfx::copy(vertices.data(),
-                                               static_cast<uint32_t>(vertices.size() * sizeof(Vertex)));
-        _vbh = bgfx::createVertexBuffer(vbmem, Vertex::ms_layout);
+        compute_bounds(vertices);
+
+        _format = resolve_format(options.format, _aabb);
+
+        const bgfx::Memory *vbmem = nullptr;
+        if (_format == VertexFormat::Standard) {
+            _dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            vbmem = bgfx::copy(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(Vertex)));
+        } else {
+            // uniform scale keeps normals valid under the dequantization transform
+            const glm::vec3 extents = _aabb.get_extents();
+            const float scale = _format == VertexFormat::Quantized
+                                    ? std::max({extents.x, extents.y, extents.z, 1e-6f})
+                                    : 1.0f;
+            _dequantization = glm::vec4(_aabb.get_center(), scale);
+
+            vbmem = bgfx::alloc(static_cast<uint32_t>(vertices.size() * sizeof(PackedVertex)));
+            auto *packed = reinterpret_cast<PackedVertex *>(vbmem->data);
+            for (const auto &vertex: vertices) {
+                *packed++ = PackedVertex::pack(vertex, _format, _dequantization);
+            }
+        }
+
+        _vbh = bgfx::createVertexBuffer(vbmem, Vertex::get_layout(_format));
 
         if (!indices.empty()) {
             const bgfx::Memory *ibmem = bgfx::copy(indices.data(),
@@ -70,14 +218,19 @@ namespace star {
         _vertex_count = static_cast<uint32_t>(vertices.size());
         _index_count = static_cast<uint32_t>(indices.size());
 
+        if (options.keep_cpu_data) {
+            _cpu_vertices = vertices;
+            _cpu_indices = indices;
+        }
+
         return is_valid();
     }
 
-    bool Mesh::create(const std::vector<Vertex> &vertices) {
-        return create(vertices, {});
+    bool Mesh::create(const std::vector<Vertex> &vertices, const MeshBuildOptions &options) {
+        return create(vertices, {}, options);
     }
 
-    Mesh Mesh::create_cube(float size) {
+    Mesh Mesh::create_cube(float size, const MeshBuildOptions &options) {
         std::vector<Vertex> vertices;
         std::vector<uint16_t> indices;
 
@@ -185,11 +338,11 @@ namespace star {
         indices.push_back(23);
 
         Mesh mesh;
-        mesh.create(vertices, indices);
+        mesh.create(vertices, indices, options);
         return mesh;
     }
 
-    Mesh Mesh::create_sphere(float radius, uint32_t segments) {
+    Mesh Mesh::create_sphere(float radius, uint32_t segments, const MeshBuildOptions &options) {
         std::vector<Vertex> vertices;
         std::vector<uint16_t> indices;
 
@@ -280,11 +433,11 @@ namespace star {
         }
 
         Mesh mesh;
-        mesh.create(vertices, indices);
+        mesh.create(vertices, indices, options);
         return mesh;
     }
 
-    Mesh Mesh::create_plane(float width, float height) {
+    Mesh Mesh::create_plane(float width, float height, const MeshBuildOptions &options) {
         std::vector<Vertex> vertices;
         std::vector<uint16_t> indices;
 
@@ -321,17 +474,22 @@ namespace star {
         indices.push_back(3);
 
         Mesh mesh;
-        mesh.create(vertices, indices);
+        mesh.create(vertices, indices, options);
         return mesh;
     }
 
     bool Mesh::draw(bgfx::Encoder *encoder) const {
+        EncoderState state(*encoder);
+        return draw(state);
+    }
+
+    bool Mesh::draw(EncoderState &state) const {
         if (!is_valid()) return false;
 
-        encoder->setVertexBuffer(0, _vbh);
+        state.set_vertex_buffer(0, _vbh);
 
         if (bgfx::isValid(_ibh)) {
-            encoder->setIndexBuffer(_ibh);
+            state.set_index_buffer(_ibh);
         }
 
         return true;
@@ -349,6 +507,61 @@ namespace star {
         return _index_count;
     }
 
+    uint16_t Mesh::get_sort_id() const {
+        return _vbh.idx;
+    }
+
+    const Aabb &Mesh::get_aabb() const {
+        return _aabb;
+    }
+
+    const BoundingSphere &Mesh::get_bounding_sphere() const {
+        return _bounding_sphere;
+    }
+
+    VertexFormat Mesh::get_vertex_format() const {
+        return _format;
+    }
+
+    glm::mat4 Mesh::get_dequantization_matrix() const {
+        glm::mat4 matrix(_dequantization.w);
+        matrix[3] = glm::vec4(glm::vec3(_dequantization), 1.0f);
+        return matrix;
+    }
+
+    void Mesh::compute_bounds(const std::span<const Vertex> vertices) {
+        _aabb = {};
+        _bounding_sphere = {};
+        if (vertices.empty()) {
+            return;
+        }
+
+        _aabb.min = vertices.front().position;
+        _aabb.max = _aabb.min;
+        for (const auto &vertex: vertices) {
+            _aabb.min = glm::min(_aabb.min, vertex.position);
+            _aabb.max = glm::max(_aabb.max, vertex.position);
+        }
+
+        _bounding_sphere.center = _aabb.get_center();
+        for (const auto &vertex: vertices) {
+            _bounding_sphere.radius = std::max(_bounding_sphere.radius,
+                                               glm::length(vertex.position - _bounding_sphere.center));
+        }
+    }
+
+    bool Mesh::has_cpu_data() const {
+        return !_cpu_vertices.empty();
+    }
+
+    const std::vector<Vertex> &Mesh::get_cpu_vertices() const {
+        return _cpu_vertices;
+    }
+
+    const std::vector<uint16_t> &Mesh::get_cpu_indices() const {
+        return _cpu_indices;
+    }
+
     void Mesh::destroy() {
         if (bgfx::isValid(_ibh)) {
             bgfx::destroy(_ibh);
@@ -362,5 +575,218 @@ namespace star {
 
         _vertex_count = 0;
         _index_count = 0;
+        _aabb = {};
+        _bounding_sphere = {};
+        _format = VertexFormat::Standard;
+        _dequantization = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        _cpu_vertices.clear();
+        _cpu_indices.clear();
+    }
+
+    DynamicMesh::DynamicMesh() = default;
+
+    DynamicMesh::~DynamicMesh() {
+        destroy();
+    }
+
+    bool DynamicMesh::create(const uint32_t vertex_capacity, const uint32_t index_capacity) {
+        destroy();
+
+        _dvbh = bgfx::createDynamicVertexBuffer(std::max(vertex_capacity, 1u), Vertex::ms_layout,
+                                                BGFX_BUFFER_ALLOW_RESIZE);
+        if (index_capacity > 0) {
+            _dibh = bgfx::createDynamicIndexBuffer(index_capacity, BGFX_BUFFER_ALLOW_RESIZE);
+        }
+
+        return is_valid();
+    }
+
+    bool DynamicMesh::create(const std::span<const Vertex> vertices, const std::span<const uint16_t> indices) {
+        if (!create(static_cast<uint32_t>(vertices.size()), static_cast<uint32_t>(indices.size()))) {
+            return false;
+        }
+
+        return update_vertices(0, vertices) && (indices.empty() || update_indices(0, indices));
+    }
+
+    bool DynamicMesh::update_vertices(const uint32_t first_vertex, const std::span<const Vertex> vertices) {
+        if (!is_valid()) {
+            spdlog::error("DynamicMesh - Cannot update vertices before create");
+            return false;
+        }
+        if (vertices.empty()) {
+            return true;
+        }
+
+        bgfx::update(_dvbh, first_vertex, bgfx::copy(vertices.data(),
+                                                     static_cast<uint32_t>(vertices.size_bytes())));
+        _vertex_count = std::max(_vertex_count, first_vertex + static_cast<uint32_t>(vertices.size()));
+        grow_bounds(vertices);
+        return true;
+    }
+
+    bool DynamicMesh::update_indices(const uint32_t first_index, const std::span<const uint16_t> indices) {
+        if (!is_valid()) {
+            spdlog::error("DynamicMesh - Cannot update indices before create");
+            return false;
+        }
+        if (indices.empty()) {
+            return true;
+        }
+
+        if (!bgfx::isValid(_dibh)) {
+            _dibh = bgfx::createDynamicIndexBuffer(first_index + static_cast<uint32_t>(indices.size()),
+                                                   BGFX_BUFFER_ALLOW_RESIZE);
+        }
+
+        bgfx::update(_dibh, first_index, bgfx::copy(indices.data(), static_cast<uint32_t>(indices.size_bytes())));
+        _index_count = std::max(_index_count, first_index + static_cast<uint32_t>(indices.size()));
+        return true;
+    }
+
+    void DynamicMesh::set_draw_counts(const uint32_t vertex_count, const uint32_t index_count) {
+        _vertex_count = vertex_count;
+        _index_count = bgfx::isValid(_dibh) ? index_count : 0;
+    }
+
+    void DynamicMesh::set_bounds(const Aabb &aabb) {
+        _aabb = aabb;
+        _bounding_sphere = {aabb.get_center(), glm::length(aabb.get_extents())};
+        _has_bounds = true;
+    }
+
+    bool DynamicMesh::draw(EncoderState &state) const {
+        if (!is_valid() || _vertex_count == 0) {
+            return false;
+        }
+
+        state.set_vertex_buffer(0, _dvbh, 0, _vertex_count);
+        if (bgfx::isValid(_dibh) && _index_count > 0) {
+            state.set_index_buffer(_dibh, 0, _index_count);
+        }
+
+        return true;
+    }
+
+    bool DynamicMesh::is_valid() const {
+        return bgfx::isValid(_dvbh);
+    }
+
+    uint16_t DynamicMesh::get_sort_id() const {
+        return _dvbh.idx;
+    }
+
+    void DynamicMesh::destroy() {
+        if (bgfx::isValid(_dibh)) {
+            bgfx::destroy(_dibh);
+            _dibh = BGFX_INVALID_HANDLE;
+        }
+
+        if (bgfx::isValid(_dvbh)) {
+            bgfx::destroy(_dvbh);
+            _dvbh = BGFX_INVALID_HANDLE;
+        }
+
+        _vertex_count = 0;
+        _index_count = 0;
+        _aabb = {};
+        _bounding_sphere = {};
+        _has_bounds = false;
+    }
+
+    void DynamicMesh::grow_bounds(const std::span<const Vertex> vertices) {
+        Aabb aabb = _aabb;
+        if (!_has_bounds) {
+            aabb.min = vertices.front().position;
+            aabb.max = aabb.min;
+        }
+
+        for (const auto &vertex: vertices) {
+            aabb.min = glm::min(aabb.min, vertex.position);
+            aabb.max = glm::max(aabb.max, vertex.position);
+        }
+
+        set_bounds(aabb);
+    }
+
+    TransientMesh::TransientMesh()
+        // counted down from the top of the range. The draw key keeps only the low 12 (opaque) or 10 (translucent)
+        // bits of it, so these can share a key with a buffer handle index. A shared key only groups two meshes
+        // next to each other, the draws stay correct
+        : _sort_id(static_cast<uint16_t>(UINT16_MAX -
+                                         s_next_transient_sort_id.fetch_add(1, std::memory_order_relaxed))) {
+    }
+
+    TransientMesh::~TransientMesh() = default;
+
+    void TransientMesh::end_frame(const uint32_t frame) {
+        s_transient_frame.store(frame, std::memory_order_relaxed);
+    }
+
+    bool TransientMesh::update(const std::span<const Vertex> vertices, const std::span<const uint16_t> indices) {
+        clear();
+
+        if (vertices.empty()) {
+            return false;
+        }
+
+        const auto vertex_count = static_cast<uint32_t>(vertices.size());
+        const auto index_count = static_cast<uint32_t>(indices.size());
+
+        const bool available = indices.empty()
+                                   ? bgfx::getAvailTransientVertexBuffer(vertex_count, Vertex::ms_layout) ==
+                                     vertex_count
+                                   : bgfx::allocTransientBuffers(&_tvb, Vertex::ms_layout, vertex_count, &_tib,
+                                                                 index_count);
+        if (!available) {
+            spdlog::warn("TransientMesh - Out of transient buffer space for {} vertices and {} indices",
+                         vertex_count, index_count);
+            return false;
+        }
+
+        if (indices.empty()) {
+            bgfx::allocTransientVertexBuffer(&_tvb, vertex_count, Vertex::ms_layout);
+        } else {
+            std::memcpy(_tib.data, indices.data(), indices.size_bytes());
+        }
+        std::memcpy(_tvb.data, vertices.data(), vertices.size_bytes());
+
+        _vertex_count = vertex_count;
+        _index_count = index_count;
+        compute_bounds(vertices);
+        _frame = s_transient_frame.load(std::memory_order_relaxed);
+        _valid = true;
+        return true;
+    }
+
+    void TransientMesh::clear() {
+        _tvb = {};
+        _tib = {};
+        _vertex_count = 0;
+        _index_count = 0;
+        _valid = false;
+    }
+
+    bool TransientMesh::draw(EncoderState &state) const {
+        if (!is_valid()) {
+            return false;
+        }
+
+        state.set_vertex_buffer(0, &_tvb);
+        if (_index_count > 0) {
+            state.set_index_buffer(&_tib);
+        }
+
+        return true;
+    }
+
+    bool TransientMesh::is_valid() const {
+        // the transient memory was handed back to bgfx with the frame it was allocated in
+        return _valid && _frame == s_transient_frame.load(std::memory_order_relaxed);
+    }
+
+    uint16_t TransientMesh::get_sort_id() const {
+        // every transient mesh shares the one transient vertex buffer handle
+        return _sort_id;
     }
 }
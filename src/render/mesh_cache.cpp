@@ -0,0 +1,91 @@
+#include "star/render/mesh_cache.hpp"
+#include <bit>
+#include <spdlog/spdlog.h>
+
+namespace star {
+    namespace {
+        void hash_combine(size_t &seed, const size_t value) {
+            seed ^= value + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+        }
+
+        // -0 compares equal to 0 and has to hash the same
+        uint32_t hash_float(const float value) {
+            return std::bit_cast<uint32_t>(value == 0.0f ? 0.0f : value);
+        }
+    }
+
+    size_t MeshCacheKeyHash::operator()(const MeshCacheKey &key) const {
+        size_t seed = static_cast<size_t>(key.primitive);
+        hash_combine(seed, hash_float(key.size.x));
+        hash_combine(seed, hash_float(key.size.y));
+        hash_combine(seed, key.segments);
+        hash_combine(seed, MeshBuildOptionsHash{}(key.options));
+        return seed;
+    }
+
+    MeshCache::MeshCache() = default;
+
+    MeshCache::~MeshCache() = default;
+
+    void MeshCache::shutdown() {
+        clear();
+    }
+
+    void MeshCache::update(float delta_time) {
+        evict_unused();
+    }
+
+    std::shared_ptr<Mesh> MeshCache::get_cube(const float size, const MeshBuildOptions &options) {
+        return get({MeshPrimitive::Cube, glm::vec2(size, 0.0f), 0, options});
+    }
+
+    std::shared_ptr<Mesh> MeshCache::get_sphere(const float radius, const uint32_t segments,
+                                                const MeshBuildOptions &options) {
+        return get({MeshPrimitive::Sphere, glm::vec2(radius, 0.0f), segments, options});
+    }
+
+    std::shared_ptr<Mesh> MeshCache::get_plane(const float width, const float height, const MeshBuildOptions &options) {
+        return get({MeshPrimitive::Plane, glm::vec2(width, height), 0, options});
+    }
+
+    std::shared_ptr<Mesh> MeshCache::get(const MeshCacheKey &key) {
+        std::lock_guard lock(_mutex);
+
+        auto &mesh = _meshes[key];
+        if (!mesh) {
+            mesh = std::make_shared<Mesh>(build(key));
+            if (!mesh->is_valid()) {
+                spdlog::error("MeshCache - Failed to build primitive {}", static_cast<int>(key.primitive));
+            }
+        }
+        return mesh;
+    }
+
+    size_t MeshCache::evict_unused() {
+        std::lock_guard lock(_mutex);
+        return std::erase_if(_meshes, [](const auto &entry) {
+            return entry.second.use_count() == 1;
+        });
+    }
+
+    void MeshCache::clear() {
+        std::lock_guard lock(_mutex);
+        _meshes.clear();
+    }
+
+    size_t MeshCache::get_size() const {
+        std::lock_guard lock(_mutex);
+        return _meshes.size();
+    }
+
+    Mesh MeshCache::build(const MeshCacheKey &key) {
+        switch (key.primitive) {
+            case MeshPrimitive::Sphere:
+                return Mesh::create_sphere(key.size.x, key.segments, key.options);
+            case MeshPrimitive::Plane:
+                return Mesh::create_plane(key.size.x, key.size.y, key.options);
+            default:
+                return Mesh::create_cube(key.size.x, key.options);
+        }
+    }
+}
@@ -0,0 +1,337 @@
+#include "star/render/mesh_optimizer.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <spdlog/spdlog.h>
+
+namespace star {
+    namespace {
+        // FIFO post-transform cache, a vertex hits while fewer than cache_size insertions happened since its own
+        class FifoCache {
+        public:
+            FifoCache(const size_t vertex_count, const uint32_t cache_size)
+                : _stamps(vertex_count, 0), _cache_size(cache_size), _time(cache_size + 1) {
+            }
+
+            bool access(const uint32_t vertex) {
+                if (_time - _stamps[vertex] <= _cache_size) {
+                    return true;
+                }
+                _stamps[vertex] = _time++;
+                return false;
+            }
+
+            uint32_t access_triangle(const uint16_t *triangle) {
+                return static_cast<uint32_t>(!access(triangle[0])) +
+                       static_cast<uint32_t>(!access(triangle[1])) +
+                       static_cast<uint32_t>(!access(triangle[2]));
+            }
+
+            void clear() {
+                _time += _cache_size + 1;
+            }
+
+        private:
+            std::vector<uint64_t> _stamps;
+            uint64_t _cache_size;
+            uint64_t _time;
+        };
+
+        struct ClusterSortData {
+            uint32_t cluster{0};
+            float key{0.0f};
+        };
+
+        // everything below indexes per vertex and per triangle arrays without checking again
+        bool validate_indices(const std::span<const uint16_t> indices, const size_t vertex_count,
+                              const char *function) {
+            if (indices.size() % 3 != 0) {
+                spdlog::error("MeshOptimizer::{} - {} indices are not a triangle list, left unchanged", function,
+                              indices.size());
+                return false;
+            }
+
+            const auto it = std::ranges::find_if(indices, [vertex_count](const uint16_t index) {
+                return index >= vertex_count;
+            });
+            if (it != indices.end()) {
+                spdlog::error("MeshOptimizer::{} - Index {} is out of range of {} vertices, left unchanged", function,
+                              *it, vertex_count);
+                return false;
+            }
+            return true;
+        }
+    }
+
+    void MeshOptimizer::optimize_vertex_cache(std::vector<uint16_t> &indices, const size_t vertex_count,
+                                              std::vector<uint32_t> *clusters, const uint32_t cache_size) {
+        const size_t triangle_count = indices.size() / 3;
+        if (clusters) {
+            clusters->clear();
+        }
+        if (triangle_count == 0 || !validate_indices(indices, vertex_count, "optimize_vertex_cache")) {
+            return;
+        }
+
+        std::vector<uint32_t> live(vertex_count, 0);
+        for (const uint16_t index: indices) {
+            ++live[index];
+        }
+
+        std::vector<uint32_t> offsets(vertex_count + 1, 0);
+        std::partial_sum(live.begin(), live.end(), offsets.begin() + 1);
+
+        std::vector<uint32_t> adjacency(triangle_count * 3);
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < triangle_count * 3; ++i) {
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+
+        std::vector<uint64_t> cache_time(vertex_count, 0);
+        std::vector<uint8_t> emitted(triangle_count, 0);
+        std::vector<uint32_t> dead_end;
+        std::vector<uint32_t> candidates;
+        std::vector<uint16_t> result;
+        dead_end.reserve(triangle_count * 3);
+        result.reserve(triangle_count * 3);
+
+        uint64_t time = cache_size + 1;
+        size_t scan = 0;
+
+        const auto skip_dead_end = [&]() -> int64_t {
+            while (!dead_end.empty()) {
+                const uint32_t vertex = dead_end.back();
+                dead_end.pop_back();
+                if (live[vertex] > 0) {
+                    return vertex;
+                }
+            }
+
+            for (; scan < vertex_count; ++scan) {
+                if (live[scan] > 0) {
+                    return static_cast<int64_t>(scan);
+                }
+            }
+            return -1;
+        };
+
+        int64_t fanning = skip_dead_end();
+        bool restarted = true;
+
+        while (fanning >= 0) {
+            if (restarted && clusters) {
+                clusters->push_back(static_cast<uint32_t>(result.size() / 3));
+            }
+
+            candidates.clear();
+            const auto vertex = static_cast<size_t>(fanning);
+            for (uint32_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+                const uint32_t triangle = adjacency[i];
+                if (emitted[triangle]) {
+                    continue;
+                }
+
+                for (uint32_t corner = 0; corner < 3; ++corner) {
+                    const uint16_t v = indices[triangle * 3 + corner];
+                    dead_end.push_back(v);
+                    candidates.push_back(v);
+                    --live[v];
+
+                    if (time - cache_time[v] > cache_size) {
+                        cache_time[v] = time++;
+                    }
+
+                    result.push_back(v);
+                }
+
+                emitted[triangle] = 1;
+            }
+
+            int64_t best = -1;
+            int64_t best_priority = -1;
+            for (const uint32_t candidate: candidates) {
+                if (live[candidate] == 0) {
+                    continue;
+                }
+
+                int64_t priority = 0;
+                const auto age = static_cast<int64_t>(time - cache_time[candidate]);
+                if (age + 2 * static_cast<int64_t>(live[candidate]) <= static_cast<int64_t>(cache_size)) {
+                    priority = age;
+                }
+
+                if (priority > best_priority) {
+                    best_priority = priority;
+                    best = candidate;
+                }
+            }
+
+            restarted = best < 0;
+            fanning = restarted ? skip_dead_end() : best;
+        }
+
+        indices.swap(result);
+    }
+
+    void MeshOptimizer::optimize_overdraw(std::vector<uint16_t> &indices, const std::vector<Vertex> &vertices,
+                                          const std::vector<uint32_t> &clusters, const float threshold,
+                                          const uint32_t cache_size) {
+        const auto triangle_count = static_cast<uint32_t>(indices.size() / 3);
+        if (triangle_count == 0 || !validate_indices(indices, vertices.size(), "optimize_overdraw")) {
+            return;
+        }
+
+        std::vector<uint32_t> hard = clusters;
+        if (hard.empty() || hard.front() != 0) {
+            hard.insert(hard.begin(), 0);
+        }
+        hard.push_back(triangle_count);
+
+        // split the hard clusters wherever a fresh cache would not cost more than threshold
+        FifoCache cache(vertices.size(), cache_size);
+        std::vector<uint32_t> boundaries;
+
+        for (size_t c = 0; c + 1 < hard.size(); ++c) {
+            const uint32_t start = hard[c];
+            const uint32_t end = hard[c + 1];
+            if (start >= end) {
+                continue;
+            }
+
+            cache.clear();
+            uint32_t cluster_misses = 0;
+            for (uint32_t t = start; t < end; ++t) {
+                cluster_misses += cache.access_triangle(&indices[t * 3]);
+            }
+            const float cluster_acmr = static_cast<float>(cluster_misses) / static_cast<float>(end - start);
+
+            boundaries.push_back(start);
+            cache.clear();
+
+            uint32_t sub_start = start;
+            uint32_t misses = 0;
+            for (uint32_t t = start; t < end; ++t) {
+                misses += cache.access_triangle(&indices[t * 3]);
+
+                const auto triangles = static_cast<float>(t - sub_start + 1);
+                if (t + 1 < end && static_cast<float>(misses) <= threshold * cluster_acmr * triangles) {
+                    boundaries.push_back(t + 1);
+                    sub_start = t + 1;
+                    misses = 0;
+                    cache.clear();
+                }
+            }
+        }
+        boundaries.push_back(triangle_count);
+
+        const auto position = [&vertices](const uint16_t index) {
+            return vertices[index].position;
+        };
+
+        glm::vec3 mesh_centroid(0.0f);
+        float mesh_area = 0.0f;
+        for (uint32_t t = 0; t < triangle_count; ++t) {
+            const glm::vec3 a = position(indices[t * 3 + 0]);
+            const glm::vec3 b = position(indices[t * 3 + 1]);
+            const glm::vec3 c = position(indices[t * 3 + 2]);
+            const float area = glm::length(glm::cross(b - a, c - a));
+            mesh_centroid += (a + b + c) * (area / 3.0f);
+            mesh_area += area;
+        }
+        mesh_centroid = mesh_area > 0.0f ? mesh_centroid / mesh_area : mesh_centroid;
+
+        const auto cluster_count = static_cast<uint32_t>(boundaries.size() - 1);
+        std::vector<ClusterSortData> sort_data(cluster_count);
+
+        for (uint32_t c = 0; c < cluster_count; ++c) {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+
+            for (uint32_t t = boundaries[c]; t < boundaries[c + 1]; ++t) {
+                const glm::vec3 a = position(indices[t * 3 + 0]);
+                const glm::vec3 b = position(indices[t * 3 + 1]);
+                const glm::vec3 v = position(indices[t * 3 + 2]);
+                const glm::vec3 face = glm::cross(b - a, v - a);
+                const float face_area = glm::length(face);
+
+                centroid += (a + b + v) * (face_area / 3.0f);
+                normal += face;
+                area += face_area;
+            }
+
+            centroid = area > 0.0f ? centroid / area : centroid;
+            const float normal_length = glm::length(normal);
+            normal = normal_length > 0.0f ? normal / normal_length : normal;
+
+            sort_data[c] = {c, glm::dot(centroid - mesh_centroid, normal)};
+        }
+
+        std::ranges::stable_sort(sort_data, [](const ClusterSortData &a, const ClusterSortData &b) {
+            return a.key > b.key;
+        });
+
+        std::vector<uint16_t> result;
+        result.reserve(indices.size());
+        for (const auto &[cluster, key]: sort_data) {
+            result.insert(result.end(), indices.begin() + boundaries[cluster] * 3,
+                          indices.begin() + boundaries[cluster + 1] * 3);
+        }
+
+        indices.swap(result);
+    }
+
+    void MeshOptimizer::optimize_vertex_fetch(std::vector<Vertex> &vertices, std::vector<uint16_t> &indices) {
+        constexpr uint32_t k_unused = std::numeric_limits<uint32_t>::max();
+
+        if (!validate_indices(indices, vertices.size(), "optimize_vertex_fetch")) {
+            return;
+        }
+
+        std::vector<uint32_t> remap(vertices.size(), k_unused);
+        uint32_t next = 0;
+
+        for (auto &index: indices) {
+            if (remap[index] == k_unused) {
+                remap[index] = next++;
+            }
+            index = static_cast<uint16_t>(remap[index]);
+        }
+
+        std::vector<Vertex> result(next);
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            if (remap[i] != k_unused) {
+                result[remap[i]] = vertices[i];
+            }
+        }
+
+        vertices.swap(result);
+    }
+
+    void MeshOptimizer::optimize(std::vector<Vertex> &vertices, std::vector<uint16_t> &indices) {
+        if (indices.empty() || !validate_indices(indices, vertices.size(), "optimize")) {
+            return;
+        }
+
+        std::vector<uint32_t> clusters;
+        optimize_vertex_cache(indices, vertices.size(), &clusters);
+        optimize_overdraw(indices, vertices, clusters);
+        optimize_vertex_fetch(vertices, indices);
+    }
+
+    float MeshOptimizer::compute_acmr(const std::span<const uint16_t> indices, const size_t vertex_count,
+                                      const uint32_t cache_size) {
+        const size_t triangle_count = indices.size() / 3;
+        if (triangle_count == 0 || !validate_indices(indices, vertex_count, "compute_acmr")) {
+            return 0.0f;
+        }
+
+        FifoCache cache(vertex_count, cache_size);
+        size_t misses = 0;
+        for (size_t t = 0; t < triangle_count; ++t) {
+            misses += cache.access_triangle(&indices[t * 3]);
+        }
+
+        return static_cast<float>(misses) / static_cast<float>(triangle_count);
+    }
+}
@@ -0,0 +1,377 @@
+#include "star/render/mesh_simplifier.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+#include <spdlog/spdlog.h>
+
+namespace star {
+    namespace {
+        // open borders get a plane perpendicular to the surface, weighted so they hold their shape
+        constexpr double k_border_weight = 10.0;
+
+        struct Quadric {
+            double a00{0.0}, a11{0.0}, a22{0.0}, a01{0.0}, a02{0.0}, a12{0.0};
+            double b0{0.0}, b1{0.0}, b2{0.0};
+            double c{0.0};
+            double weight{0.0};
+
+            void add_plane(const glm::vec3 &normal, const float distance, const double plane_weight) {
+                const double x = normal.x, y = normal.y, z = normal.z, d = distance;
+                a00 += plane_weight * x * x;
+                a11 += plane_weight * y * y;
+                a22 += plane_weight * z * z;
+                a01 += plane_weight * x * y;
+                a02 += plane_weight * x * z;
+                a12 += plane_weight * y * z;
+                b0 += plane_weight * x * d;
+                b1 += plane_weight * y * d;
+                b2 += plane_weight * z * d;
+                c += plane_weight * d * d;
+                weight += plane_weight;
+            }
+
+            void add(const Quadric &other) {
+                a00 += other.a00;
+                a11 += other.a11;
+                a22 += other.a22;
+                a01 += other.a01;
+                a02 += other.a02;
+                a12 += other.a12;
+                b0 += other.b0;
+                b1 += other.b1;
+                b2 += other.b2;
+                c += other.c;
+                weight += other.weight;
+            }
+
+            // weighted mean of the squared distances to the accumulated planes
+            double evaluate(const glm::vec3 &point) const {
+                const double x = point.x, y = point.y, z = point.z;
+                const double error = a00 * x * x + a11 * y * y + a22 * z * z
+                                     + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+                                     + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+                return weight > 0.0 ? std::abs(error) / weight : 0.0;
+            }
+        };
+
+        struct Collapse {
+            uint32_t from{0};
+            uint32_t to{0};
+            double error{0.0};
+        };
+
+        uint64_t make_edge_key(const uint32_t a, const uint32_t b) {
+            return static_cast<uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+        }
+
+        // vertices sharing a position are wedges of one surface point, maps every vertex to the first of them
+        std::vector<uint32_t> build_position_remap(const std::vector<Vertex> &vertices) {
+            struct PositionKey {
+                uint32_t bits[3];
+
+                bool operator==(const PositionKey &other) const {
+                    return std::memcmp(bits, other.bits, sizeof(bits)) == 0;
+                }
+            };
+
+            struct PositionHash {
+                size_t operator()(const PositionKey &key) const {
+                    return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+                }
+            };
+
+            std::unordered_map<PositionKey, uint32_t, PositionHash> first_vertex;
+            first_vertex.reserve(vertices.size());
+
+            std::vector<uint32_t> remap(vertices.size());
+            for (uint32_t i = 0; i < vertices.size(); ++i) {
+                PositionKey key{};
+                std::memcpy(key.bits, &vertices[i].position, sizeof(key.bits));
+                remap[i] = first_vertex.try_emplace(key, i).first->second;
+            }
+            return remap;
+        }
+
+        glm::vec3 triangle_normal(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+            return glm::cross(b - a, c - a);
+        }
+    }
+
+    std::vector<uint16_t> MeshSimplifier::simplify(const std::vector<Vertex> &vertices,
+                                                   const std::vector<uint16_t> &indices,
+                                                   const size_t target_index_count, const float max_error,
+                                                   float *result_error) {
+        if (result_error) {
+            *result_error = 0.0f;
+        }
+
+        std::vector<uint16_t> result = indices;
+        if (indices.size() % 3 != 0 || indices.size() <= target_index_count || vertices.empty()) {
+            return result;
+        }
+
+        // errors are measured in a unit sized copy so max_error means the same for every mesh
+        glm::vec3 min = vertices.front().position;
+        glm::vec3 max = min;
+        for (const auto &vertex: vertices) {
+            min = glm::min(min, vertex.position);
+            max = glm::max(max, vertex.position);
+        }
+        const glm::vec3 size = max - min;
+        const float extent = std::max({size.x, size.y, size.z});
+        const float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+        std::vector<glm::vec3> positions(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            positions[i] = (vertices[i].position - min) * scale;
+        }
+
+        const std::vector<uint32_t> wedge = build_position_remap(vertices);
+
+        // a point with more than one wedge sits on an attribute seam, moving it would tear the seam open
+        std::vector<uint32_t> wedge_count(vertices.size(), 0);
+        for (const uint32_t first: wedge) {
+            ++wedge_count[first];
+        }
+
+        std::vector<Quadric> quadrics(vertices.size());
+        std::unordered_map<uint64_t, uint32_t> edge_use;
+        edge_use.reserve(indices.size());
+
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            const uint32_t a = wedge[indices[t + 0]];
+            const uint32_t b = wedge[indices[t + 1]];
+            const uint32_t c = wedge[indices[t + 2]];
+
+            glm::vec3 normal = triangle_normal(positions[a], positions[b], positions[c]);
+            const float area = glm::length(normal);
+            if (area <= 0.0f) {
+                continue;
+            }
+            normal /= area;
+
+            Quadric plane;
+            plane.add_plane(normal, -glm::dot(normal, positions[a]), area);
+            quadrics[a].add(plane);
+            quadrics[b].add(plane);
+            quadrics[c].add(plane);
+
+            ++edge_use[make_edge_key(a, b)];
+            ++edge_use[make_edge_key(b, c)];
+            ++edge_use[make_edge_key(c, a)];
+        }
+
+        for (size_t t = 0; t < indices.size(); t += 3) {
+            const uint32_t corners[3] = {wedge[indices[t + 0]], wedge[indices[t + 1]], wedge[indices[t + 2]]};
+            const glm::vec3 normal = triangle_normal(positions[corners[0]], positions[corners[1]],
+                                                     positions[corners[2]]);
+            if (glm::length(normal) <= 0.0f) {
+                continue;
+            }
+
+            for (uint32_t e = 0; e < 3; ++e) {
+                const uint32_t a = corners[e];
+                const uint32_t b = corners[(e + 1) % 3];
+                if (edge_use[make_edge_key(a, b)] != 1) {
+                    continue;
+                }
+
+                const glm::vec3 edge = positions[b] - positions[a];
+                const float length = glm::length(edge);
+                glm::vec3 border_normal = glm::cross(edge, normal);
+                const float border_length = glm::length(border_normal);
+                if (length <= 0.0f || border_length <= 0.0f) {
+                    continue;
+                }
+                border_normal /= border_length;
+
+                Quadric border;
+                border.add_plane(border_normal, -glm::dot(border_normal, positions[a]),
+                                 k_border_weight * length * length);
+                quadrics[a].add(border);
+                quadrics[b].add(border);
+            }
+        }
+
+        const size_t target_triangles = target_index_count / 3;
+        const double max_error_squared = static_cast<double>(max_error) * max_error;
+        double worst_error = 0.0;
+
+        std::vector<Collapse> collapses;
+        std::vector<uint32_t> remap(vertices.size());
+        std::vector<uint8_t> pass_locked(vertices.size());
+        std::vector<uint32_t> triangle_offsets(vertices.size() + 1);
+        std::vector<uint32_t> vertex_triangles;
+
+        while (result.size() / 3 > target_triangles) {
+            const size_t triangle_count = result.size() / 3;
+
+            std::ranges::fill(triangle_offsets, 0);
+            for (const uint16_t index: result) {
+                ++triangle_offsets[index + 1];
+            }
+            std::partial_sum(triangle_offsets.begin(), triangle_offsets.end(), triangle_offsets.begin());
+
+            vertex_triangles.resize(result.size());
+            std::vector<uint32_t> cursor(triangle_offsets.begin(), triangle_offsets.end() - 1);
+            for (uint32_t i = 0; i < result.size(); ++i) {
+                vertex_triangles[cursor[result[i]]++] = i / 3;
+            }
+
+            collapses.clear();
+            for (size_t t = 0; t < result.size(); t += 3) {
+                for (uint32_t e = 0; e < 3; ++e) {
+                    const uint32_t from = result[t + e];
+                    const uint32_t to = result[t + (e + 1) % 3];
+
+                    for (const auto &[u, v]: {std::pair{from, to}, std::pair{to, from}}) {
+                        if (wedge_count[wedge[u]] > 1 || wedge[u] == wedge[v]) {
+                            continue;
+                        }
+
+                        Quadric combined = quadrics[wedge[u]];
+                        combined.add(quadrics[wedge[v]]);
+                        collapses.push_back({u, v, combined.evaluate(positions[v])});
+                    }
+                }
+            }
+
+            // ties broken by vertex index so the output never depends on the sort implementation
+            std::ranges::sort(collapses, [](const Collapse &a, const Collapse &b) {
+                if (a.error != b.error) {
+                    return a.error < b.error;
+                }
+                return a.from != b.from ? a.from < b.from : a.to < b.to;
+            });
+
+            std::iota(remap.begin(), remap.end(), 0u);
+            std::ranges::fill(pass_locked, 0);
+
+            size_t removed = 0;
+            size_t applied = 0;
+
+            for (const auto &[u, v, error]: collapses) {
+                if (triangle_count - removed <= target_triangles) {
+                    break;
+                }
+                if (error > max_error_squared) {
+                    break;
+                }
+                if (pass_locked[u] || pass_locked[v]) {
+                    continue;
+                }
+
+                size_t shared = 0;
+                bool flips = false;
+                for (uint32_t i = triangle_offsets[u]; i < triangle_offsets[u + 1] && !flips; ++i) {
+                    const uint16_t *triangle = &result[vertex_triangles[i] * 3];
+                    if (triangle[0] == v || triangle[1] == v || triangle[2] == v) {
+                        ++shared;
+                        continue;
+                    }
+
+                    glm::vec3 corners[3] = {positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]};
+                    const glm::vec3 before = triangle_normal(corners[0], corners[1], corners[2]);
+                    for (auto &corner: corners) {
+                        if (corner == positions[u]) {
+                            corner = positions[v];
+                        }
+                    }
+                    const glm::vec3 after = triangle_normal(corners[0], corners[1], corners[2]);
+                    flips = glm::dot(before, after) <= 0.0f;
+                }
+
+                if (flips) {
+                    continue;
+                }
+
+                remap[u] = v;
+                quadrics[wedge[v]].add(quadrics[wedge[u]]);
+                worst_error = std::max(worst_error, error);
+                removed += shared;
+                ++applied;
+
+                // the neighbourhood changed, its remaining candidates are stale until the next pass
+                for (uint32_t i = triangle_offsets[u]; i < triangle_offsets[u + 1]; ++i) {
+                    const uint16_t *triangle = &result[vertex_triangles[i] * 3];
+                    pass_locked[triangle[0]] = 1;
+                    pass_locked[triangle[1]] = 1;
+                    pass_locked[triangle[2]] = 1;
+                }
+            }
+
+            if (applied == 0) {
+                break;
+            }
+
+            size_t write = 0;
+            for (size_t t = 0; t < result.size(); t += 3) {
+                const auto a = static_cast<uint16_t>(remap[result[t + 0]]);
+                const auto b = static_cast<uint16_t>(remap[result[t + 1]]);
+                const auto c = static_cast<uint16_t>(remap[result[t + 2]]);
+                if (wedge[a] == wedge[b] || wedge[b] == wedge[c] || wedge[c] == wedge[a]) {
+                    continue;
+                }
+
+                result[write++] = a;
+                result[write++] = b;
+                result[write++] = c;
+            }
+            result.resize(write);
+        }
+
+        if (result_error) {
+            *result_error = static_cast<float>(std::sqrt(worst_error));
+        }
+        return result;
+    }
+
+    std::vector<MeshLod> MeshSimplifier::build_lod_chain(const std::shared_ptr<Mesh> &source,
+                                                         const LodChainSettings &settings) {
+        std::vector<MeshLod> lods;
+        if (!source || !source->is_valid()) {
+            return lods;
+        }
+
+        lods.push_back({source, settings.screen_size});
+
+        const auto &vertices = source->get_cpu_vertices();
+        const auto &indices = source->get_cpu_indices();
+        if (!source->has_cpu_data() || indices.empty()) {
+            spdlog::error("MeshSimplifier - Source mesh has no CPU side indexed data, create it with keep_cpu_data");
+            lods.back().screen_size = settings.cull_screen_size;
+            return lods;
+        }
+
+        MeshBuildOptions options;
+        options.format = source->get_vertex_format();
+        options.optimize = true;
+
+        size_t previous_count = indices.size();
+        for (uint32_t level = 1; level < settings.level_count; ++level) {
+            const auto target = static_cast<size_t>(static_cast<float>(previous_count) * settings.reduction) / 3 * 3;
+
+            float error = 0.0f;
+            const auto lod_indices = simplify(vertices, indices, target, settings.max_error, &error);
+            if (lod_indices.empty() || lod_indices.size() >= previous_count) {
+                break;
+            }
+
+            auto mesh = std::make_shared<Mesh>();
+            if (!mesh->create(vertices, lod_indices, options)) {
+                break;
+            }
+
+            spdlog::debug("MeshSimplifier - LOD {}: {} -> {} triangles, error {:.4f}", level, indices.size() / 3,
+                          lod_indices.size() / 3, error);
+
+            lods.push_back({std::move(mesh), lods.back().screen_size * 0.5f});
+            previous_count = lod_indices.size();
+        }
+
+        lods.back().screen_size = settings.cull_screen_size;
+        return lods;
+    }
+}
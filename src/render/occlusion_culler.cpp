@@ -0,0 +1,601 @@
+#include "star/core/common.hpp"
+#include "star/render/occlusion_culler.hpp"
+#include "star/render/mesh.hpp"
+#include "star/utils/thread_pool.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_OCCLUSION_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace star {
+    namespace {
+        constexpr uint32_t k_tile_size = OcclusionCuller::k_tile_width * OcclusionCuller::k_tile_height;
+
+        constexpr float k_cleared_depth = 1.0f;
+
+        // triangles are clipped this far outside the viewport, in viewport sizes, so the screen coordinates stay
+        // small enough for the edge functions to be exact
+        constexpr float k_guard_band = 2.0f;
+
+        // near plane and the four guard band planes
+        constexpr uint32_t k_clip_planes = 5;
+        constexpr uint32_t k_max_clip_vertices = 3 + k_clip_planes;
+
+        // a rect is tested against at most this many pyramid texels per axis
+        constexpr uint32_t k_max_test_texels = 4;
+
+        constexpr size_t k_volumes_per_job = 256;
+
+        // positive inside the plane
+        float clip_distance(const glm::vec4 &vertex, const uint32_t plane) {
+            switch (plane) {
+                case 0:
+                    return vertex.z + vertex.w;
+                case 1:
+                    return k_guard_band * vertex.w - vertex.x;
+                case 2:
+                    return k_guard_band * vertex.w + vertex.x;
+                case 3:
+                    return k_guard_band * vertex.w - vertex.y;
+                default:
+                    return k_guard_band * vertex.w + vertex.y;
+            }
+        }
+
+        Aabb to_aabb(const Aabb &aabb) {
+            return aabb;
+        }
+
+        Aabb to_aabb(const BoundingSphere &sphere) {
+            return {sphere.center - glm::vec3(sphere.radius), sphere.center + glm::vec3(sphere.radius)};
+        }
+
+        template<typename Volume>
+        size_t cull_volumes(const OcclusionCuller &culler, const std::span<const Volume> volumes,
+                            const std::span<uint8_t> visible, ThreadPool *pool) {
+            const size_t count = std::min(volumes.size(), visible.size());
+
+            if (culler.get_occluder_count() > 0) {
+                const auto job = [&culler, volumes, visible, count](const size_t index) {
+                    const size_t end = std::min((index + 1) * k_volumes_per_job, count);
+                    for (size_t i = index * k_volumes_per_job; i < end; ++i) {
+                        if (visible[i] && !culler.is_visible(to_aabb(volumes[i]))) {
+                            visible[i] = 0;
+                        }
+                    }
+                };
+
+                const size_t job_count = (count + k_volumes_per_job - 1) / k_volumes_per_job;
+                if (pool && pool->get_thread_count() > 0 && job_count > 1) {
+                    pool->parallel_for(job_count, job);
+                } else {
+                    for (size_t index = 0; index < job_count; ++index) {
+                        job(index);
+                    }
+                }
+            }
+
+            return static_cast<size_t>(std::ranges::count_if(visible.first(count), [](const uint8_t value) {
+                return value != 0;
+            }));
+        }
+    }
+
+    OcclusionCuller::OcclusionCuller() = default;
+
+    OcclusionCuller::~OcclusionCuller() = default;
+
+    bool OcclusionCuller::init(const OcclusionSettings &settings) {
+        shutdown();
+
+        if (settings.width == 0 || settings.height == 0) {
+            spdlog::error("OcclusionCuller::init - Depth buffer size must not be zero");
+            return false;
+        }
+
+        _settings = settings;
+        _tiles_x = (settings.width + k_tile_width - 1) / k_tile_width;
+        _tiles_y = (settings.height + k_tile_height - 1) / k_tile_height;
+        _width = _tiles_x * k_tile_width;
+        _height = _tiles_y * k_tile_height;
+        _depth.assign(static_cast<size_t>(_width) * _height, k_cleared_depth);
+
+        // whole tiles always halve evenly into the first level
+        glm::uvec2 size(_width / 2, _height / 2);
+        uint32_t offset = 0;
+        while (true) {
+            _level_offsets.push_back(offset);
+            _level_sizes.push_back(size);
+            offset += size.x * size.y;
+            if (size.x == 1 && size.y == 1) {
+                break;
+            }
+            size = glm::uvec2((size.x + 1) / 2, (size.y + 1) / 2);
+        }
+        _pyramid.assign(offset, k_cleared_depth);
+
+        return true;
+    }
+
+    void OcclusionCuller::shutdown() {
+        _depth.clear();
+        _pyramid.clear();
+        _level_offsets.clear();
+        _level_sizes.clear();
+        _occluders.clear();
+        _occluder_count = 0;
+        _triangle_count = 0;
+        _width = _height = 0;
+        _tiles_x = _tiles_y = 0;
+        _rasterized = false;
+    }
+
+    bool OcclusionCuller::is_valid() const {
+        return !_depth.empty();
+    }
+
+    void OcclusionCuller::begin(const glm::mat4 &view_projection) {
+        _view_projection = view_projection;
+        _occluder_count = 0;
+        _triangle_count = 0;
+        _rasterized = false;
+    }
+
+    bool OcclusionCuller::add_occluder(const Mesh &mesh, const glm::mat4 &model) {
+        if (!is_valid() || _occluder_count >= _settings.max_occluders || !mesh.has_cpu_data()) {
+            return false;
+        }
+
+        const auto &indices = mesh.get_cpu_indices();
+        const size_t triangles = (indices.empty() ? mesh.get_cpu_vertices().size() : indices.size()) / 3;
+        if (triangles == 0 || triangles > _settings.max_occluder_triangles) {
+            return false;
+        }
+
+        if (_occluders.size() <= _occluder_count) {
+            _occluders.emplace_back();
+        }
+
+        auto &occluder = _occluders[_occluder_count++];
+        occluder.mesh = &mesh;
+        occluder.model_view_projection = _view_projection * model;
+        return true;
+    }
+
+    void OcclusionCuller::rasterize(ThreadPool *pool) {
+        if (!is_valid()) {
+            return;
+        }
+
+        _rasterized = true;
+        if (_occluder_count == 0) {
+            return;
+        }
+
+        const bool threaded = pool && pool->get_thread_count() > 0;
+
+        if (threaded && _occluder_count > 1) {
+            pool->parallel_for(_occluder_count, [this](const size_t index) {
+                setup_occluder(_occluders[index]);
+            });
+        } else {
+            for (uint32_t i = 0; i < _occluder_count; ++i) {
+                setup_occluder(_occluders[i]);
+            }
+        }
+
+        _triangle_count = 0;
+        for (uint32_t i = 0; i < _occluder_count; ++i) {
+            _triangle_count += static_cast<uint32_t>(_occluders[i].triangles.size());
+        }
+
+        // every band owns its tile rows and the pyramid rows above them, so bands never write the same memory
+        const uint32_t band_count = threaded
+                                        ? std::min(static_cast<uint32_t>(pool->get_thread_count() + 1) * 2, _tiles_y)
+                                        : 1;
+        const auto band = [this, band_count](const size_t index) {
+            const uint32_t first = static_cast<uint32_t>(index) * _tiles_y / band_count;
+            const uint32_t end = static_cast<uint32_t>(index + 1) * _tiles_y / band_count;
+            rasterize_band(first, end);
+            build_pyramid_rows(first * k_tile_height / 2, end * k_tile_height / 2);
+        };
+
+        if (band_count > 1) {
+            pool->parallel_for(band_count, band);
+        } else {
+            band(0);
+        }
+
+        for (uint32_t level = 1; level < _level_sizes.size(); ++level) {
+            build_pyramid_level(level);
+        }
+    }
+
+    void OcclusionCuller::setup_occluder(Occluder &occluder) const {
+        occluder.triangles.clear();
+
+        const auto &vertices = occluder.mesh->get_cpu_vertices();
+        const auto &indices = occluder.mesh->get_cpu_indices();
+
+        // shared vertices are only transformed once
+        occluder.positions.resize(vertices.size());
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            occluder.positions[i] = occluder.model_view_projection * glm::vec4(vertices[i].position, 1.0f);
+        }
+
+        const auto &positions = occluder.positions;
+        if (indices.empty()) {
+            for (size_t i = 0; i + 2 < positions.size(); i += 3) {
+                setup_triangle(positions[i], positions[i + 1], positions[i + 2], occluder.triangles);
+            }
+            return;
+        }
+
+        for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+            if (indices[i] >= positions.size() || indices[i + 1] >= positions.size() ||
+                indices[i + 2] >= positions.size()) {
+                continue;
+            }
+            setup_triangle(positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]],
+                           occluder.triangles);
+        }
+    }
+
+    void OcclusionCuller::setup_triangle(const glm::vec4 &a, const glm::vec4 &b, const glm::vec4 &c,
+                                         std::vector<Triangle> &triangles) const {
+        bool inside = true;
+        for (uint32_t plane = 0; plane < k_clip_planes; ++plane) {
+            const float da = clip_distance(a, plane);
+            const float db = clip_distance(b, plane);
+            const float dc = clip_distance(c, plane);
+            if (da < 0.0f && db < 0.0f && dc < 0.0f) {
+                return;
+            }
+            inside = inside && da >= 0.0f && db >= 0.0f && dc >= 0.0f;
+        }
+
+        const auto to_screen = [this](const glm::vec4 &vertex) {
+            const float inverse_w = 1.0f / vertex.w;
+            return glm::vec3((vertex.x * inverse_w * 0.5f + 0.5f) * static_cast<float>(_width),
+                             (vertex.y * inverse_w * 0.5f + 0.5f) * static_cast<float>(_height),
+                             vertex.z * inverse_w);
+        };
+
+        if (inside) {
+            add_triangle(to_screen(a), to_screen(b), to_screen(c), triangles);
+            return;
+        }
+
+        std::array<glm::vec4, k_max_clip_vertices> polygon{a, b, c};
+        std::array<glm::vec4, k_max_clip_vertices> clipped{};
+        uint32_t count = 3;
+
+        for (uint32_t plane = 0; plane < k_clip_planes && count >= 3; ++plane) {
+            uint32_t clipped_count = 0;
+            for (uint32_t i = 0; i < count; ++i) {
+                const glm::vec4 &current = polygon[i];
+                const glm::vec4 &next = polygon[(i + 1) % count];
+                const float current_distance = clip_distance(current, plane);
+                const float next_distance = clip_distance(next, plane);
+
+                if (current_distance >= 0.0f) {
+                    clipped[clipped_count++] = current;
+                }
+                if ((current_distance >= 0.0f) != (next_distance >= 0.0f)) {
+                    const float t = current_distance / (current_distance - next_distance);
+                    clipped[clipped_count++] = current + (next - current) * t;
+                }
+            }
+
+            polygon = clipped;
+            count = clipped_count;
+        }
+
+        if (count < 3) {
+            return;
+        }
+
+        const glm::vec3 first = to_screen(polygon[0]);
+        glm::vec3 previous = to_screen(polygon[1]);
+        for (uint32_t i = 2; i < count; ++i) {
+            const glm::vec3 current = to_screen(polygon[i]);
+            add_triangle(first, previous, current, triangles);
+            previous = current;
+        }
+    }
+
+    void OcclusionCuller::add_triangle(const glm::vec3 &a, glm::vec3 b, glm::vec3 c,
+                                       std::vector<Triangle> &triangles) const {
+        float area = (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+        if (std::abs(area) < 1e-6f) {
+            return;
+        }
+
+        // both faces are drawn, a back face hides what is behind it just as well
+        if (area < 0.0f) {
+            std::swap(b, c);
+            area = -area;
+        }
+
+        const float min_x = std::min({a.x, b.x, c.x});
+        const float max_x = std::max({a.x, b.x, c.x});
+        const float min_y = std::min({a.y, b.y, c.y});
+        const float max_y = std::max({a.y, b.y, c.y});
+        if (max_x < 0.0f || max_y < 0.0f || min_x >= static_cast<float>(_width) ||
+            min_y >= static_cast<float>(_height)) {
+            return;
+        }
+
+        Triangle triangle;
+
+        const glm::vec3 *vertices[3] = {&a, &b, &c};
+        for (uint32_t edge = 0; edge < 3; ++edge) {
+            const glm::vec3 &from = *vertices[edge];
+            const glm::vec3 &to = *vertices[(edge + 1) % 3];
+            // written so the edge shared with a neighbour comes out exactly negated there, together with the
+            // inclusive test below no pixel center on it is missed by both triangles
+            triangle.edge_a[edge] = from.y - to.y;
+            triangle.edge_b[edge] = to.x - from.x;
+            triangle.edge_c[edge] = from.x * to.y - to.x * from.y;
+        }
+
+        const glm::vec3 ab = b - a;
+        const glm::vec3 ac = c - a;
+        const float depth_x = (ab.z * ac.y - ac.z * ab.y) / area;
+        const float depth_y = (ab.x * ac.z - ac.x * ab.z) / area;
+        // the depth is sampled at pixel centers, moving it to the far corner keeps the whole pixel behind it
+        const float depth_bias = (std::abs(depth_x) + std::abs(depth_y)) * 0.5f;
+        triangle.depth = glm::vec3(depth_x, depth_y, a.z - depth_x * a.x - depth_y * a.y + depth_bias);
+
+        const auto pixel = [](const float value, const uint32_t size) {
+            return static_cast<uint32_t>(std::clamp(value, 0.0f, static_cast<float>(size - 1)));
+        };
+        triangle.min_tile_x = static_cast<uint16_t>(pixel(min_x, _width) / k_tile_width);
+        triangle.max_tile_x = static_cast<uint16_t>(pixel(max_x, _width) / k_tile_width);
+        triangle.min_tile_y = static_cast<uint16_t>(pixel(min_y, _height) / k_tile_height);
+        triangle.max_tile_y = static_cast<uint16_t>(pixel(max_y, _height) / k_tile_height);
+
+        triangles.push_back(triangle);
+    }
+
+    void OcclusionCuller::rasterize_band(const uint32_t first_tile_row, const uint32_t end_tile_row) {
+        std::fill(_depth.begin() + static_cast<ptrdiff_t>(first_tile_row) * _tiles_x * k_tile_size,
+                  _depth.begin() + static_cast<ptrdiff_t>(end_tile_row) * _tiles_x * k_tile_size, k_cleared_depth);
+
+        for (uint32_t i = 0; i < _occluder_count; ++i) {
+            for (const auto &triangle: _occluders[i].triangles) {
+                const uint32_t first = std::max<uint32_t>(triangle.min_tile_y, first_tile_row);
+                const uint32_t end = std::min<uint32_t>(triangle.max_tile_y + 1u, end_tile_row);
+                for (uint32_t tile_y = first; tile_y < end; ++tile_y) {
+                    for (uint32_t tile_x = triangle.min_tile_x; tile_x <= triangle.max_tile_x; ++tile_x) {
+                        rasterize_tile(triangle, tile_x, tile_y);
+                    }
+                }
+            }
+        }
+    }
+
+    void OcclusionCuller::rasterize_tile(const Triangle &triangle, const uint32_t tile_x, const uint32_t tile_y) {
+        const float x0 = static_cast<float>(tile_x * k_tile_width) + 0.5f;
+        const float y0 = static_cast<float>(tile_y * k_tile_height) + 0.5f;
+        const float x1 = x0 + static_cast<float>(k_tile_width - 1);
+        const float y1 = y0 + static_cast<float>(k_tile_height - 1);
+
+        // the edge functions peak at a corner, a tile no pixel center of which is inside every edge is skipped
+        for (uint32_t edge = 0; edge < 3; ++edge) {
+            const float a = triangle.edge_a[edge];
+            const float b = triangle.edge_b[edge];
+            if (a * (a > 0.0f ? x1 : x0) + b * (b > 0.0f ? y1 : y0) + triangle.edge_c[edge] < 0.0f) {
+                return;
+            }
+        }
+
+        float *tile = _depth.data() + (static_cast<size_t>(tile_y) * _tiles_x + tile_x) * k_tile_size;
+
+#if defined(STAR_OCCLUSION_SSE)
+        static_assert(k_tile_width == 8, "the SSE path covers a tile row with two registers");
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 x_low = _mm_add_ps(_mm_set1_ps(x0), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+        const __m128 x_high = _mm_add_ps(x_low, _mm_set1_ps(4.0f));
+
+        const __m128 a0 = _mm_set1_ps(triangle.edge_a.x);
+        const __m128 a1 = _mm_set1_ps(triangle.edge_a.y);
+        const __m128 a2 = _mm_set1_ps(triangle.edge_a.z);
+        const __m128 depth_x = _mm_set1_ps(triangle.depth.x);
+
+        const __m128 e0_low = _mm_mul_ps(a0, x_low);
+        const __m128 e0_high = _mm_mul_ps(a0, x_high);
+        const __m128 e1_low = _mm_mul_ps(a1, x_low);
+        const __m128 e1_high = _mm_mul_ps(a1, x_high);
+        const __m128 e2_low = _mm_mul_ps(a2, x_low);
+        const __m128 e2_high = _mm_mul_ps(a2, x_high);
+        const __m128 z_low = _mm_mul_ps(depth_x, x_low);
+        const __m128 z_high = _mm_mul_ps(depth_x, x_high);
+
+        for (uint32_t row = 0; row < k_tile_height; ++row) {
+            const float y = y0 + static_cast<float>(row);
+            const __m128 row0 = _mm_set1_ps(triangle.edge_b.x * y + triangle.edge_c.x);
+            const __m128 row1 = _mm_set1_ps(triangle.edge_b.y * y + triangle.edge_c.y);
+            const __m128 row2 = _mm_set1_ps(triangle.edge_b.z * y + triangle.edge_c.z);
+            const __m128 row_z = _mm_set1_ps(triangle.depth.y * y + triangle.depth.z);
+
+            float *pixels = tile + row * k_tile_width;
+
+            const __m128 inside_low = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(e0_low, row0), zero), _mm_cmpge_ps(_mm_add_ps(e1_low, row1), zero)),
+                _mm_cmpge_ps(_mm_add_ps(e2_low, row2), zero));
+            const __m128 inside_high = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(_mm_add_ps(e0_high, row0), zero),
+                           _mm_cmpge_ps(_mm_add_ps(e1_high, row1), zero)),
+                _mm_cmpge_ps(_mm_add_ps(e2_high, row2), zero));
+
+            const __m128 current_low = _mm_loadu_ps(pixels);
+            const __m128 current_high = _mm_loadu_ps(pixels + 4);
+            const __m128 nearest_low = _mm_min_ps(current_low, _mm_add_ps(z_low, row_z));
+            const __m128 nearest_high = _mm_min_ps(current_high, _mm_add_ps(z_high, row_z));
+
+            _mm_storeu_ps(pixels, _mm_or_ps(_mm_and_ps(inside_low, nearest_low),
+                                            _mm_andnot_ps(inside_low, current_low)));
+            _mm_storeu_ps(pixels + 4, _mm_or_ps(_mm_and_ps(inside_high, nearest_high),
+                                                _mm_andnot_ps(inside_high, current_high)));
+        }
+#else
+        for (uint32_t row = 0; row < k_tile_height; ++row) {
+            const float y = y0 + static_cast<float>(row);
+            float *pixels = tile + row * k_tile_width;
+
+            for (uint32_t column = 0; column < k_tile_width; ++column) {
+                const float x = x0 + static_cast<float>(column);
+                const glm::vec3 edges = triangle.edge_a * x + triangle.edge_b * y + triangle.edge_c;
+                if (edges.x >= 0.0f && edges.y >= 0.0f && edges.z >= 0.0f) {
+                    const float depth = triangle.depth.x * x + triangle.depth.y * y + triangle.depth.z;
+                    pixels[column] = std::min(pixels[column], depth);
+                }
+            }
+        }
+#endif
+    }
+
+    void OcclusionCuller::build_pyramid_rows(const uint32_t first_row, const uint32_t end_row) {
+        const uint32_t width = _level_sizes[0].x;
+
+        for (uint32_t y = first_row; y < end_row; ++y) {
+            const uint32_t pixel_y = y * 2;
+            const uint32_t tile_y = pixel_y / k_tile_height;
+            const uint32_t row = pixel_y % k_tile_height;
+            float *texels = _pyramid.data() + static_cast<size_t>(y) * width;
+
+            for (uint32_t x = 0; x < width; ++x) {
+                const uint32_t pixel_x = x * 2;
+                const float *pixels = _depth.data() +
+                                      (static_cast<size_t>(tile_y) * _tiles_x + pixel_x / k_tile_width) *
+                                      k_tile_size + row * k_tile_width + pixel_x % k_tile_width;
+
+                texels[x] = std::max(std::max(pixels[0], pixels[1]),
+                                     std::max(pixels[k_tile_width], pixels[k_tile_width + 1]));
+            }
+        }
+    }
+
+    void OcclusionCuller::build_pyramid_level(const uint32_t level) {
+        const glm::uvec2 source_size = _level_sizes[level - 1];
+        const glm::uvec2 size = _level_sizes[level];
+        const float *source = _pyramid.data() + _level_offsets[level - 1];
+        float *target = _pyramid.data() + _level_offsets[level];
+
+        for (uint32_t y = 0; y < size.y; ++y) {
+            const uint32_t y0 = y * 2;
+            const uint32_t y1 = std::min(y0 + 1, source_size.y - 1);
+
+            for (uint32_t x = 0; x < size.x; ++x) {
+                const uint32_t x0 = x * 2;
+                const uint32_t x1 = std::min(x0 + 1, source_size.x - 1);
+
+                target[y * size.x + x] = std::max(
+                    std::max(source[y0 * source_size.x + x0], source[y0 * source_size.x + x1]),
+                    std::max(source[y1 * source_size.x + x0], source[y1 * source_size.x + x1]));
+            }
+        }
+    }
+
+    bool OcclusionCuller::is_visible(const Aabb &aabb) const {
+        if (!_rasterized || _occluder_count == 0) {
+            return true;
+        }
+
+        // the corners are the min corner plus any combination of the three edges
+        const glm::vec3 size = aabb.max - aabb.min;
+        const glm::vec4 origin = _view_projection * glm::vec4(aabb.min, 1.0f);
+        const glm::vec4 edges[3] = {_view_projection[0] * size.x, _view_projection[1] * size.y,
+                                    _view_projection[2] * size.z};
+
+        glm::vec2 min(std::numeric_limits<float>::max());
+        glm::vec2 max(std::numeric_limits<float>::lowest());
+        float depth = std::numeric_limits<float>::max();
+
+        for (uint32_t corner = 0; corner < 8; ++corner) {
+            glm::vec4 clip = origin;
+            if (corner & 1) clip += edges[0];
+            if (corner & 2) clip += edges[1];
+            if (corner & 4) clip += edges[2];
+
+            // boxes reaching through the near plane are close enough to always draw
+            if (clip.w <= 0.0f || clip.z < -clip.w) {
+                return true;
+            }
+
+            const float inverse_w = 1.0f / clip.w;
+            const glm::vec2 screen((clip.x * inverse_w * 0.5f + 0.5f) * static_cast<float>(_width),
+                                   (clip.y * inverse_w * 0.5f + 0.5f) * static_cast<float>(_height));
+            min = glm::min(min, screen);
+            max = glm::max(max, screen);
+            depth = std::min(depth, clip.z * inverse_w);
+        }
+
+        return is_rect_visible(min, max, depth);
+    }
+
+    bool OcclusionCuller::is_rect_visible(const glm::vec2 &min, const glm::vec2 &max, const float depth) const {
+        if (max.x < 0.0f || max.y < 0.0f || min.x >= static_cast<float>(_width) ||
+            min.y >= static_cast<float>(_height)) {
+            // off screen is for the frustum test to decide
+            return true;
+        }
+
+        // the occluders only cover the pixels whose centers they cover, one pixel of margin keeps boxes peeking
+        // out from behind an edge by less than a pixel
+        const auto pixel = [](const float value, const uint32_t size) {
+            return static_cast<uint32_t>(std::clamp(value, 0.0f, static_cast<float>(size - 1)));
+        };
+        const uint32_t pixel_x0 = pixel(std::floor(min.x) - 1.0f, _width);
+        const uint32_t pixel_y0 = pixel(std::floor(min.y) - 1.0f, _height);
+        const uint32_t pixel_x1 = pixel(std::floor(max.x) + 1.0f, _width);
+        const uint32_t pixel_y1 = pixel(std::floor(max.y) + 1.0f, _height);
+
+        uint32_t level = 0;
+        uint32_t x0 = pixel_x0 / 2;
+        uint32_t y0 = pixel_y0 / 2;
+        uint32_t x1 = pixel_x1 / 2;
+        uint32_t y1 = pixel_y1 / 2;
+        while ((x1 - x0 >= k_max_test_texels || y1 - y0 >= k_max_test_texels) && level + 1 < _level_sizes.size()) {
+            x0 /= 2;
+            y0 /= 2;
+            x1 /= 2;
+            y1 /= 2;
+            ++level;
+        }
+
+        const uint32_t width = _level_sizes[level].x;
+        const float *texels = _pyramid.data() + _level_offsets[level];
+        for (uint32_t y = y0; y <= y1; ++y) {
+            for (uint32_t x = x0; x <= x1; ++x) {
+                if (texels[y * width + x] >= depth) {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    size_t OcclusionCuller::cull(const std::span<const BoundingSphere> spheres, const std::span<uint8_t> visible,
+                                 ThreadPool *pool) const {
+        return cull_volumes(*this, spheres, visible, pool);
+    }
+
+    size_t OcclusionCuller::cull(const std::span<const Aabb> aabbs, const std::span<uint8_t> visible,
+                                 ThreadPool *pool) const {
+        return cull_volumes(*this, aabbs, visible, pool);
+    }
+
+    float OcclusionCuller::get_depth(const uint32_t x, const uint32_t y) const {
+        if (x >= _width || y >= _height) {
+            return k_cleared_depth;
+        }
+
+        const size_t tile = static_cast<size_t>(y / k_tile_height) * _tiles_x + x / k_tile_width;
+        return _depth[tile * k_tile_size + (y % k_tile_height) * k_tile_width + x % k_tile_width];
+    }
+}
@@ -0,0 +1,505 @@
+#include "star/core/common.hpp"
+#include "star/render/render_chain.hpp"
+
+namespace star {
+    namespace {
+        constexpr uint32_t k_backbuffer_resource = 0;
+
+        bool is_depth_format(const bgfx::TextureFormat::Enum format) {
+            return format > bgfx::TextureFormat::UnknownDepth && format < bgfx::TextureFormat::Count;
+        }
+
+        // a write that clears the attachment does not care what earlier passes left in it
+        bool clears(const uint16_t clear_flags, const RenderTargetDesc &desc) {
+            return (clear_flags & (is_depth_format(desc.format) ? BGFX_CLEAR_DEPTH : BGFX_CLEAR_COLOR)) != 0;
+        }
+
+        void push_unique(std::vector<uint32_t> &values, const uint32_t value) {
+            if (std::ranges::find(values, value) == values.end()) {
+                values.push_back(value);
+            }
+        }
+    }
+
+    glm::uvec2 RenderTargetDesc::get_size(const glm::uvec2 &backbuffer_size) const {
+        if (!is_relative()) {
+            return {width, height};
+        }
+        return glm::max(glm::uvec2(glm::vec2(backbuffer_size) * scale), glm::uvec2(1));
+    }
+
+    RenderPassBuilder::RenderPassBuilder(RenderChain &chain, const uint32_t pass)
+        : _chain(chain), _pass(pass) {
+    }
+
+    RenderResource RenderPassBuilder::create(const std::string &name, const RenderTargetDesc &desc) {
+        return _chain.add_resource(_pass, name, desc);
+    }
+
+    RenderResource RenderPassBuilder::read(const std::string &name) {
+        return _chain.use_resource(_pass, name, false);
+    }
+
+    RenderResource RenderPassBuilder::write(const std::string &name) {
+        return _chain.use_resource(_pass, name, true);
+    }
+
+    void RenderPassBuilder::set_clear(const uint16_t flags, const uint32_t rgba, const float depth,
+                                      const uint8_t stencil) {
+        auto &pass = _chain._passes[_pass];
+        pass.clear_flags = flags;
+        pass.clear_rgba = rgba;
+        pass.clear_depth = depth;
+        pass.clear_stencil = stencil;
+    }
+
+    void RenderPassBuilder::set_view_mode(const bgfx::ViewMode::Enum mode) {
+        _chain._passes[_pass].view_mode = mode;
+    }
+
+    void RenderPassBuilder::set_side_effect() {
+        _chain._passes[_pass].side_effect = true;
+    }
+
+    RenderChain::RenderChain() = default;
+
+    RenderChain::~RenderChain() {
+        shutdown();
+    }
+
+    void RenderChain::add_pass(const std::string &name, SetupFunction setup, ExecuteFunction execute) {
+        const auto it = std::ranges::find(_passes, name, &Pass::name);
+        Pass &pass = it != _passes.end() ? *it : _passes.emplace_back();
+
+        release_framebuffer(pass);
+        pass = Pass{};
+        pass.name = name;
+        pass.setup = std::move(setup);
+        pass.execute = std::move(execute);
+        _dirty = true;
+    }
+
+    bool RenderChain::remove_pass(const std::string &name) {
+        const auto it = std::ranges::find(_passes, name, &Pass::name);
+        if (it == _passes.end()) {
+            return false;
+        }
+
+        release_framebuffer(*it);
+        _passes.erase(it);
+        _dirty = true;
+        return true;
+    }
+
+    bool RenderChain::has_pass(const std::string &name) const {
+        return std::ranges::find(_passes, name, &Pass::name) != _passes.end();
+    }
+
+    void RenderChain::add_view(const std::string &name, const void *owner, ViewFunction configure) {
+        _views.push_back({name, owner, std::move(configure)});
+        _views_dirty = true;
+    }
+
+    void RenderChain::remove_views(const void *owner) {
+        const auto removed = std::erase_if(_views, [owner](const View &view) {
+            return view.owner == owner;
+        });
+        _views_dirty = _views_dirty || removed > 0;
+    }
+
+    void RenderChain::clear_views() {
+        _views_dirty = _views_dirty || !_views.empty();
+        _views.clear();
+    }
+
+    void RenderChain::import_texture(const std::string &name, const bgfx::TextureHandle handle,
+                                     const RenderTargetDesc &desc) {
+        if (name == k_backbuffer) {
+            spdlog::error("RenderChain::import_texture - '{}' is reserved", name);
+            return;
+        }
+
+        const auto it = std::ranges::find(_imports, name, &Resource::name);
+        Resource &resource = it != _imports.end() ? *it : _imports.emplace_back();
+        resource.name = name;
+        resource.desc = desc;
+        resource.imported = true;
+        resource.imported_handle = handle;
+        _dirty = true;
+    }
+
+    bool RenderChain::remove_texture(const std::string &name) {
+        const auto removed = std::erase_if(_imports, [&name](const Resource &resource) {
+            return resource.name == name;
+        });
+        _dirty = _dirty || removed > 0;
+        return removed > 0;
+    }
+
+    void RenderChain::invalidate() {
+        _dirty = true;
+    }
+
+    RenderResource RenderChain::add_resource(const uint32_t pass, const std::string &name,
+                                             const RenderTargetDesc &desc) {
+        if (find_resource(name).is_valid()) {
+            spdlog::error("RenderChain - Pass '{}' creates '{}' which already exists", _passes[pass].name, name);
+            return {};
+        }
+
+        _resources.push_back({name, desc});
+        _passes[pass].creates.push_back(static_cast<uint32_t>(_resources.size() - 1));
+        return {static_cast<uint32_t>(_resources.size() - 1)};
+    }
+
+    RenderResource RenderChain::use_resource(const uint32_t pass, const std::string &name, const bool write) {
+        const RenderResource resource = find_resource(name);
+        if (!resource.is_valid()) {
+            spdlog::error("RenderChain - Pass '{}' uses the unknown texture '{}'", _passes[pass].name, name);
+            return {};
+        }
+
+        push_unique(write ? _passes[pass].writes : _passes[pass].reads, resource.index);
+        return resource;
+    }
+
+    bgfx::ViewId RenderChain::compile(const bgfx::ViewId first_view, const glm::uvec2 &backbuffer_size) {
+        const bool resized = backbuffer_size != _backbuffer_size;
+        _backbuffer_size = backbuffer_size;
+        _stats.rebuilt_pass_count = 0;
+        _stats.configured_view_count = 0;
+
+        std::vector<uint8_t> resized_textures;
+        if (_dirty || !_compiled) {
+            for (auto &pass: _passes) {
+                release_framebuffer(pass);
+            }
+            release_textures();
+            setup_passes();
+            cull_passes();
+            allocate_textures();
+            _dirty = false;
+        } else if (resized) {
+            resize_textures(resized_textures);
+        }
+
+        bgfx::ViewId view_id = assign_views(first_view, resized);
+        for (auto &pass: _passes) {
+            if (pass.culled) {
+                pass.view_id.reset();
+                continue;
+            }
+
+            pass.view_id = view_id++;
+
+            // setting a view up again is cheap, only the framebuffers of resized textures are recreated
+            const bool rebuild = !bgfx::isValid(pass.framebuffer) || uses_texture(pass, resized_textures);
+            if (rebuild) {
+                release_framebuffer(pass);
+            }
+            configure_pass(pass);
+            if (rebuild && bgfx::isValid(pass.framebuffer)) {
+                ++_stats.rebuilt_pass_count;
+            }
+        }
+
+        // views the chain no longer uses would keep drawing whatever was configured on them
+        if (_compiled && first_view == _first_view) {
+            for (bgfx::ViewId id = view_id; id < _end_view; ++id) {
+                bgfx::resetView(id);
+            }
+        }
+
+        _first_view = first_view;
+        _end_view = view_id;
+        _compiled = true;
+        return view_id;
+    }
+
+    bgfx::ViewId RenderChain::assign_views(const bgfx::ViewId first_view, const bool resized) {
+        bgfx::ViewId view_id = first_view;
+        for (auto &view: _views) {
+            // a view keeping its id only has to follow the backbuffer
+            if (view.view_id != view_id || resized) {
+                view.view_id = view_id;
+                if (view.configure) {
+                    view.configure(view_id);
+                }
+                ++_stats.configured_view_count;
+            }
+            ++view_id;
+        }
+
+        _views_dirty = false;
+        _stats.view_count = static_cast<uint32_t>(_views.size());
+        return view_id;
+    }
+
+    void RenderChain::setup_passes() {
+        _resources.clear();
+        _resources.push_back({k_backbuffer, {}, true});
+        _resources.insert(_resources.end(), _imports.begin(), _imports.end());
+
+        for (uint32_t i = 0; i < _passes.size(); ++i) {
+            auto &pass = _passes[i];
+            const std::string name = std::move(pass.name);
+            auto setup = std::move(pass.setup);
+            auto execute = std::move(pass.execute);
+
+            pass = Pass{};
+            pass.name = name;
+            pass.setup = std::move(setup);
+            pass.execute = std::move(execute);
+
+            if (pass.setup) {
+                RenderPassBuilder builder(*this, i);
+                pass.setup(builder);
+            }
+        }
+    }
+
+    void RenderChain::cull_passes() {
+        // walking back from the outputs, a pass survives when a later survivor needs something it writes
+        std::vector<uint8_t> needed(_resources.size(), 0);
+        _stats.culled_pass_count = 0;
+
+        for (auto it = _passes.rbegin(); it != _passes.rend(); ++it) {
+            auto &pass = *it;
+
+            const bool output = std::ranges::any_of(pass.writes, [this](const uint32_t resource) {
+                return _resources[resource].imported;
+            });
+            const bool used = std::ranges::any_of(pass.writes, [&needed](const uint32_t resource) {
+                return needed[resource] != 0;
+            });
+
+            pass.culled = !pass.side_effect && !output && !used;
+            if (pass.culled) {
+                ++_stats.culled_pass_count;
+                continue;
+            }
+
+            // attachments that are not cleared keep what the passes before drew into them
+            for (const uint32_t resource: pass.writes) {
+                needed[resource] = !clears(pass.clear_flags, _resources[resource].desc);
+            }
+            for (const uint32_t resource: pass.reads) {
+                needed[resource] = 1;
+            }
+        }
+
+        for (uint32_t i = 0; i < _passes.size(); ++i) {
+            if (_passes[i].culled) {
+                continue;
+            }
+
+            const auto extend = [this, i](const uint32_t index) {
+                auto &resource = _resources[index];
+                resource.first_pass = std::min(resource.first_pass, i);
+                resource.last_pass = std::max(resource.last_pass, i);
+            };
+            std::ranges::for_each(_passes[i].reads, extend);
+            std::ranges::for_each(_passes[i].writes, extend);
+        }
+    }
+
+    void RenderChain::allocate_textures() {
+        std::vector<uint32_t> transients;
+        for (uint32_t i = 0; i < _resources.size(); ++i) {
+            if (!_resources[i].imported && _resources[i].first_pass != UINT32_MAX) {
+                transients.push_back(i);
+            }
+        }
+
+        std::ranges::stable_sort(transients, {}, [this](const uint32_t index) {
+            return _resources[index].first_pass;
+        });
+
+        for (const uint32_t index: transients) {
+            auto &resource = _resources[index];
+
+            // a texture with the same description is free once its last user ran
+            const auto it = std::ranges::find_if(_textures, [&resource](const Texture &texture) {
+                return texture.desc == resource.desc && texture.last_pass < resource.first_pass;
+            });
+
+            if (it != _textures.end()) {
+                it->last_pass = resource.last_pass;
+                resource.texture = static_cast<uint32_t>(it - _textures.begin());
+                continue;
+            }
+
+            Texture texture;
+            texture.desc = resource.desc;
+            texture.size = resource.desc.get_size(_backbuffer_size);
+            texture.last_pass = resource.last_pass;
+            texture.handle = bgfx::createTexture2D(static_cast<uint16_t>(texture.size.x),
+                                                   static_cast<uint16_t>(texture.size.y), false, 1,
+                                                   resource.desc.format, resource.desc.flags);
+            if (!bgfx::isValid(texture.handle)) {
+                spdlog::error("RenderChain::allocate_textures - Failed to create '{}' of {}x{}", resource.name,
+                              texture.size.x, texture.size.y);
+            }
+
+            resource.texture = static_cast<uint32_t>(_textures.size());
+            _textures.push_back(texture);
+        }
+
+        _stats.pass_count = static_cast<uint32_t>(_passes.size());
+        _stats.transient_count = static_cast<uint32_t>(transients.size());
+        _stats.texture_count = static_cast<uint32_t>(_textures.size());
+    }
+
+    void RenderChain::resize_textures(std::vector<uint8_t> &resized) {
+        resized.assign(_textures.size(), 0);
+
+        for (size_t i = 0; i < _textures.size(); ++i) {
+            auto &texture = _textures[i];
+            const glm::uvec2 size = texture.desc.get_size(_backbuffer_size);
+            if (!texture.desc.is_relative() || size == texture.size) {
+                continue;
+            }
+
+            if (bgfx::isValid(texture.handle)) {
+                bgfx::destroy(texture.handle);
+            }
+
+            texture.size = size;
+            texture.handle = bgfx::createTexture2D(static_cast<uint16_t>(size.x), static_cast<uint16_t>(size.y),
+                                                   false, 1, texture.desc.format, texture.desc.flags);
+            resized[i] = 1;
+        }
+    }
+
+    bool RenderChain::uses_texture(const Pass &pass, const std::vector<uint8_t> &textures) const {
+        if (textures.empty()) {
+            return false;
+        }
+
+        return std::ranges::any_of(pass.writes, [this, &textures](const uint32_t resource) {
+            const uint32_t texture = _resources[resource].texture;
+            return texture != UINT32_MAX && textures[texture] != 0;
+        });
+    }
+
+    void RenderChain::configure_pass(Pass &pass) {
+        std::vector<bgfx::TextureHandle> attachments;
+        glm::uvec2 size = _backbuffer_size;
+
+        for (const uint32_t index: pass.writes) {
+            if (index == k_backbuffer_resource) {
+                continue;
+            }
+
+            const auto &resource = _resources[index];
+            const bgfx::TextureHandle handle = get_texture(RenderResource{index});
+            if (!bgfx::isValid(handle)) {
+                continue;
+            }
+
+            if (attachments.empty()) {
+                size = resource.imported ? resource.desc.get_size(_backbuffer_size) : _textures[resource.texture].size;
+            }
+            attachments.push_back(handle);
+        }
+
+        if (!attachments.empty() && std::ranges::find(pass.writes, k_backbuffer_resource) != pass.writes.end()) {
+            spdlog::warn("RenderChain - Pass '{}' writes the backbuffer next to textures, it only draws into the "
+                         "textures", pass.name);
+        }
+
+        if (!attachments.empty() && !bgfx::isValid(pass.framebuffer)) {
+            pass.framebuffer = bgfx::createFrameBuffer(static_cast<uint8_t>(attachments.size()), attachments.data(),
+                                                       false);
+        }
+
+        const bgfx::ViewId view_id = *pass.view_id;
+        pass.size = size;
+        bgfx::setViewName(view_id, pass.name.c_str());
+        bgfx::setViewFrameBuffer(view_id, pass.framebuffer);
+        bgfx::setViewRect(view_id, 0, 0, static_cast<uint16_t>(size.x), static_cast<uint16_t>(size.y));
+        bgfx::setViewClear(view_id, pass.clear_flags, pass.clear_rgba, pass.clear_depth, pass.clear_stencil);
+        bgfx::setViewMode(view_id, pass.view_mode);
+    }
+
+    void RenderChain::release_framebuffer(Pass &pass) {
+        if (bgfx::isValid(pass.framebuffer)) {
+            bgfx::destroy(pass.framebuffer);
+            pass.framebuffer = BGFX_INVALID_HANDLE;
+        }
+    }
+
+    void RenderChain::release_textures() {
+        for (auto &texture: _textures) {
+            if (bgfx::isValid(texture.handle)) {
+                bgfx::destroy(texture.handle);
+            }
+        }
+        _textures.clear();
+    }
+
+    void RenderChain::render(bgfx::Encoder &encoder) const {
+        for (const auto &pass: _passes) {
+            if (pass.culled || !pass.view_id) {
+                continue;
+            }
+
+            // the clear of a view only happens when something reaches it
+            encoder.touch(*pass.view_id);
+            if (pass.execute) {
+                pass.execute({*pass.view_id, encoder, *this, pass.size});
+            }
+        }
+    }
+
+    void RenderChain::shutdown() {
+        for (auto &pass: _passes) {
+            release_framebuffer(pass);
+            pass.view_id.reset();
+        }
+        for (auto &view: _views) {
+            view.view_id.reset();
+        }
+        release_textures();
+        _resources.clear();
+        _compiled = false;
+        _dirty = true;
+    }
+
+    RenderResource RenderChain::find_resource(const std::string &name) const {
+        const auto it = std::ranges::find(_resources, name, &Resource::name);
+        if (it == _resources.end()) {
+            return {};
+        }
+        return {static_cast<uint32_t>(it - _resources.begin())};
+    }
+
+    bgfx::TextureHandle RenderChain::get_texture(const RenderResource resource) const {
+        if (!resource.is_valid() || resource.index >= _resources.size()) {
+            return BGFX_INVALID_HANDLE;
+        }
+
+        const auto &entry = _resources[resource.index];
+        if (entry.imported) {
+            return entry.imported_handle;
+        }
+        if (entry.texture >= _textures.size()) {
+            return BGFX_INVALID_HANDLE;
+        }
+        return _textures[entry.texture].handle;
+    }
+
+    bgfx::TextureHandle RenderChain::get_texture(const std::string &name) const {
+        return get_texture(find_resource(name));
+    }
+
+    std::optional<bgfx::ViewId> RenderChain::get_view_id(const std::string &name) const {
+        const auto it = std::ranges::find(_passes, name, &Pass::name);
+        return it != _passes.end() ? it->view_id : std::nullopt;
+    }
+
+    bool RenderChain::is_pass_culled(const std::string &name) const {
+        const auto it = std::ranges::find(_passes, name, &Pass::name);
+        return it != _passes.end() && it->culled;
+    }
+}
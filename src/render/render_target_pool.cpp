@@ -0,0 +1,192 @@
+#include "star/core/common.hpp"
+#include "star/render/render_target_pool.hpp"
+
+namespace star {
+    namespace {
+        const RenderTarget k_invalid_target{};
+
+        uint32_t round_up(const uint32_t value) {
+            const uint32_t granularity = RenderTargetPool::k_size_granularity;
+            return std::max((value + granularity - 1) / granularity, 1u) * granularity;
+        }
+    }
+
+    RenderTargetPool::RenderTargetPool() = default;
+
+    RenderTargetPool::~RenderTargetPool() {
+        shutdown();
+    }
+
+    glm::uvec2 RenderTargetPool::get_bucket_size(const glm::uvec2 &size) {
+        return {round_up(size.x), round_up(size.y)};
+    }
+
+    RenderTargetId RenderTargetPool::acquire(const glm::uvec2 &size, const bgfx::TextureFormat::Enum color_format,
+                                             const bgfx::TextureFormat::Enum depth_format, const uint64_t flags) {
+        const glm::uvec2 bucket = get_bucket_size(size);
+
+        // taking the most recently released one lets the others age out
+        uint32_t best = RenderTargetId::k_invalid;
+        for (uint32_t i = 0; i < _entries.size(); ++i) {
+            const auto &entry = _entries[i];
+            if (entry.acquired || !entry.target.is_valid() || entry.release_frame >= _frame ||
+                entry.target.size != bucket || entry.color_format != color_format ||
+                entry.depth_format != depth_format || entry.flags != flags) {
+                continue;
+            }
+
+            if (best == RenderTargetId::k_invalid || entry.release_frame > _entries[best].release_frame) {
+                best = i;
+            }
+        }
+
+        if (best != RenderTargetId::k_invalid) {
+            _entries[best].acquired = true;
+            return {best, _entries[best].generation};
+        }
+
+        Entry entry;
+        entry.color_format = color_format;
+        entry.depth_format = depth_format;
+        entry.flags = flags;
+        if (!create(entry, bucket)) {
+            spdlog::error("RenderTargetPool::acquire - Failed to create a {}x{} target", bucket.x, bucket.y);
+            return {};
+        }
+        entry.acquired = true;
+        ++_created_count;
+
+        if (!_free_slots.empty()) {
+            const uint32_t slot = _free_slots.back();
+            _free_slots.pop_back();
+            entry.generation = _entries[slot].generation;
+            _entries[slot] = entry;
+            return {slot, entry.generation};
+        }
+
+        _entries.push_back(entry);
+        return {static_cast<uint32_t>(_entries.size() - 1)};
+    }
+
+    void RenderTargetPool::release(const RenderTargetId id) {
+        if (!find(id)) {
+            return;
+        }
+
+        auto &entry = _entries[id.index];
+        entry.acquired = false;
+        entry.release_frame = _frame;
+        ++entry.generation;
+    }
+
+    const RenderTarget &RenderTargetPool::get(const RenderTargetId id) const {
+        const Entry *entry = find(id);
+        return entry ? entry->target : k_invalid_target;
+    }
+
+    bool RenderTargetPool::fits(const RenderTargetId id, const glm::uvec2 &size,
+                                const bgfx::TextureFormat::Enum color_format,
+                                const bgfx::TextureFormat::Enum depth_format, const uint64_t flags) const {
+        const Entry *entry = find(id);
+        if (!entry) {
+            return false;
+        }
+
+        return size.x <= entry->target.size.x && size.y <= entry->target.size.y &&
+               entry->color_format == color_format && entry->depth_format == depth_format && entry->flags == flags;
+    }
+
+    const RenderTargetPool::Entry *RenderTargetPool::find(const RenderTargetId id) const {
+        if (!id.is_valid() || id.index >= _entries.size()) {
+            return nullptr;
+        }
+
+        const auto &entry = _entries[id.index];
+        return entry.acquired && entry.generation == id.generation ? &entry : nullptr;
+    }
+
+    void RenderTargetPool::update() {
+        ++_frame;
+
+        for (uint32_t i = 0; i < _entries.size(); ++i) {
+            auto &entry = _entries[i];
+            if (entry.acquired || !entry.target.is_valid() || _frame - entry.release_frame <= _max_idle_frames) {
+                continue;
+            }
+
+            destroy(entry);
+            _free_slots.push_back(i);
+        }
+    }
+
+    void RenderTargetPool::shutdown() {
+        for (auto &entry: _entries) {
+            destroy(entry);
+        }
+        _entries.clear();
+        _free_slots.clear();
+    }
+
+    void RenderTargetPool::set_max_idle_frames(const uint32_t frames) {
+        _max_idle_frames = frames;
+    }
+
+    uint32_t RenderTargetPool::get_target_count() const {
+        return static_cast<uint32_t>(std::ranges::count_if(_entries, [](const Entry &entry) {
+            return entry.target.is_valid();
+        }));
+    }
+
+    uint32_t RenderTargetPool::get_free_count() const {
+        return static_cast<uint32_t>(std::ranges::count_if(_entries, [](const Entry &entry) {
+            return entry.target.is_valid() && !entry.acquired;
+        }));
+    }
+
+    bool RenderTargetPool::create(Entry &entry, const glm::uvec2 &size) const {
+        auto &target = entry.target;
+        target.size = size;
+        target.color = bgfx::createTexture2D(static_cast<uint16_t>(size.x), static_cast<uint16_t>(size.y), false, 1,
+                                             entry.color_format, entry.flags);
+
+        std::array<bgfx::TextureHandle, 2> attachments{target.color, BGFX_INVALID_HANDLE};
+        uint8_t attachment_count = 1;
+
+        if (entry.depth_format != bgfx::TextureFormat::Count) {
+            // only ever attached, a write-only target lets the backend skip storing it
+            target.depth = bgfx::createTexture2D(static_cast<uint16_t>(size.x), static_cast<uint16_t>(size.y), false,
+                                                 1, entry.depth_format, BGFX_TEXTURE_RT_WRITE_ONLY);
+            attachments[attachment_count++] = target.depth;
+        }
+
+        if (std::any_of(attachments.begin(), attachments.begin() + attachment_count,
+                        [](const bgfx::TextureHandle handle) { return !bgfx::isValid(handle); })) {
+            destroy(entry);
+            return false;
+        }
+
+        // the pool destroys the textures itself, they are tracked separately from the framebuffer
+        target.framebuffer = bgfx::createFrameBuffer(attachment_count, attachments.data(), false);
+        if (!target.is_valid()) {
+            destroy(entry);
+            return false;
+        }
+
+        return true;
+    }
+
+    void RenderTargetPool::destroy(Entry &entry) {
+        auto &target = entry.target;
+        if (bgfx::isValid(target.framebuffer)) {
+            bgfx::destroy(target.framebuffer);
+        }
+        if (bgfx::isValid(target.color)) {
+            bgfx::destroy(target.color);
+        }
+        if (bgfx::isValid(target.depth)) {
+            bgfx::destroy(target.depth);
+        }
+        target = RenderTarget{};
+        entry.acquired = false;
+    }
+}
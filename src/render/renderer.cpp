@@ -1,6 +1,7 @@
 #include "star/render/renderer.hpp"
 #include "star/scene/scene.hpp"
 #include "star/app/app.hpp"
+#include "star/render/render_chain.hpp"
 #include <spdlog/spdlog.h>
 
 namespace star {
@@ -18,6 +19,10 @@ namespace star {
     void Renderer::shutdown() {
         spdlog::debug("Shutting down renderer: {}", get_renderer_name());
 
+        if (_app) {
+            _app->get_render_chain().remove_views(this);
+        }
+        _view_id.reset();
         _camera.reset();
         _scene.reset();
         _app.reset();
@@ -26,13 +31,15 @@ namespace star {
     void Renderer::update(float delta_time) {
     }
 
-    bgfx::ViewId Renderer::render_reset(bgfx::ViewId view_id) {
+    void Renderer::render_reset(RenderChain &chain) {
+        _view_id.reset();
         if (!_visible) {
-            return view_id;
+            return;
         }
 
-        _view_id = view_id;
-        return view_id + 1;
+        chain.add_view(get_renderer_name(), this, [this](const bgfx::ViewId view_id) {
+            _view_id = view_id;
+        });
     }
 
     void Renderer::render(bgfx::ViewId view_id, bgfx::Encoder *encoder) {
@@ -1,4 +1,5 @@
 #include "star/render/renderer_components.hpp"
+#include "star/render/draw_bucket.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/constants.hpp>
 
@@ -8,15 +9,62 @@ namespace star {
     MeshRenderer::~MeshRenderer() = default;
 
     void MeshRenderer::set_mesh(Mesh &&mesh) {
-        _mesh = std::make_shared<Mesh>(std::move(mesh));
+        set_mesh(std::make_shared<Mesh>(std::move(mesh)));
     }
 
     void MeshRenderer::set_mesh(std::shared_ptr<Mesh> mesh) {
-        _mesh = mesh;
+        _lods.clear();
+        _lods.push_back({std::move(mesh), 0.0f});
     }
 
     Mesh *MeshRenderer::get_mesh() const {
-        return _mesh.get();
+        return get_lod_mesh(0);
+    }
+
+    void MeshRenderer::set_lods(std::vector<MeshLod> lods) {
+        std::ranges::stable_sort(lods, [](const MeshLod &a, const MeshLod &b) {
+            return a.screen_size > b.screen_size;
+        });
+        _lods = std::move(lods);
+    }
+
+    const std::vector<MeshLod> &MeshRenderer::get_lods() const {
+        return _lods;
+    }
+
+    uint32_t MeshRenderer::get_lod_count() const {
+        return static_cast<uint32_t>(_lods.size());
+    }
+
+    Mesh *MeshRenderer::get_lod_mesh(const uint32_t lod) const {
+        return lod < _lods.size() ? _lods[lod].mesh.get() : nullptr;
+    }
+
+    void MeshRenderer::set_lod_hysteresis(const float hysteresis) {
+        _lod_hysteresis = std::clamp(hysteresis, 0.0f, 0.9f);
+    }
+
+    float MeshRenderer::get_lod_hysteresis() const {
+        return _lod_hysteresis;
+    }
+
+    uint32_t MeshRenderer::select_lod(const float screen_size, const uint32_t current_lod) const {
+        const auto count = static_cast<uint32_t>(_lods.size());
+        const auto find_lod = [this, count, screen_size](const float scale) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (screen_size >= _lods[i].screen_size * scale) {
+                    return i;
+                }
+            }
+            return count;
+        };
+
+        if (current_lod > count) {
+            return find_lod(1.0f);
+        }
+
+        // keep the current level until the size is past the neighbouring threshold by the hysteresis margin
+        return std::clamp(current_lod, find_lod(1.0f - _lod_hysteresis), find_lod(1.0f + _lod_hysteresis));
     }
 
     void MeshRenderer::set_material(std::shared_ptr<Material> material) {
@@ -27,6 +75,10 @@ namespace star {
         return _material.get();
     }
 
+    const std::shared_ptr<Material> &MeshRenderer::get_shared_material() const {
+        return _material;
+    }
+
     void MeshRenderer::set_visible(bool visible) {
         _visible = visible;
     }
@@ -35,6 +87,14 @@ namespace star {
         return _visible;
     }
 
+    void MeshRenderer::set_cast_shadows(bool cast) {
+        _cast_shadows = cast;
+    }
+
+    bool MeshRenderer::get_cast_shadows() const {
+        return _cast_shadows;
+    }
+
     void MeshRenderer::set_layer(uint8_t layer) {
         _layer = layer;
     }
@@ -43,16 +103,29 @@ namespace star {
         return _layer;
     }
 
-    uint32_t MeshRenderer::generate_sort_key() const {
+    void MeshRenderer::set_tint(const glm::vec4 &tint) {
+        _tint = tint;
+    }
+
+    const glm::vec4 &MeshRenderer::get_tint() const {
+        return _tint;
+    }
+
+    uint64_t MeshRenderer::generate_sort_key(const float depth, const uint32_t lod) const {
         uint32_t material_key = 0;
 
         if (_material) {
             material_key = _material->generate_sort_key();
         }
 
-        uint32_t layer_key = static_cast<uint32_t>(_layer) << 28;
+        const Mesh *mesh = get_lod_mesh(lod);
+        const uint32_t mesh_key = mesh ? mesh->get_sort_id() : 0;
+
+        if (_material && _material->is_translucent()) {
+            return DrawKey::make_translucent(_layer, material_key, mesh_key, depth);
+        }
 
-        return layer_key | material_key;
+        return DrawKey::make_opaque(_layer, material_key, mesh_key, depth);
     }
 
     bool MeshRenderer::render(bgfx::Encoder *encoder) {
@@ -60,7 +133,8 @@ namespace star {
             return false;
         }
 
-        return _mesh->draw(encoder);
+        const Mesh *mesh = get_mesh();
+        return mesh && mesh->draw(encoder);
     }
 
     Light::Light() = default;
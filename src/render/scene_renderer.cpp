@@ -36,10 +36,10 @@ namespace star {
         }
     }
 
-    bgfx::ViewId SceneRendererComponent::render_reset(bgfx::ViewId view_id) {
-        if (!_renderer) return view_id;
-
-        return _renderer->render_reset(view_id);
+    void SceneRendererComponent::render_reset(RenderChain &chain) {
+        if (_renderer) {
+            _renderer->render_reset(chain);
+        }
     }
 
     ForwardRenderer &SceneRendererComponent::get_renderer() {
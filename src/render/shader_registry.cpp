@@ -0,0 +1,260 @@
+#include "star/core/common.hpp"
+#include "star/render/shader_registry.hpp"
+
+namespace star {
+    namespace {
+        constexpr uint64_t k_fnv_offset = 0xcbf29ce484222325ull;
+        constexpr uint64_t k_fnv_prime = 0x100000001b3ull;
+
+        uint64_t hash_bytes(const void *data, const size_t size, uint64_t hash = k_fnv_offset) {
+            const auto *bytes = static_cast<const uint8_t *>(data);
+            for (size_t i = 0; i < size; ++i) {
+                hash ^= bytes[i];
+                hash *= k_fnv_prime;
+            }
+            return hash;
+        }
+
+        const bgfx::EmbeddedShader::Data *find_embedded_data(const bgfx::EmbeddedShader &shader,
+                                                             const bgfx::RendererType::Enum type) {
+            for (const auto &data: shader.data) {
+                if (data.type == bgfx::RendererType::Count) {
+                    break;
+                }
+                if (data.type == type && data.size > 1) {
+                    return &data;
+                }
+            }
+            return nullptr;
+        }
+
+        struct UniformSlot {
+            const char *name;
+            bgfx::UniformType::Enum type;
+        };
+
+        struct SamplerSlot {
+            const char *name;
+            uint8_t stage;
+        };
+
+        // the material interface every engine shader shares
+        constexpr std::array k_material_uniforms{
+            UniformSlot{"u_color", bgfx::UniformType::Vec4},
+            UniformSlot{"u_baseColor", bgfx::UniformType::Vec4},
+            UniformSlot{"u_emissive", bgfx::UniformType::Vec4},
+            UniformSlot{"u_materialParams", bgfx::UniformType::Vec4},
+            UniformSlot{"u_tint", bgfx::UniformType::Vec4},
+        };
+
+        constexpr std::array k_material_samplers{
+            SamplerSlot{"s_texColor", 0},
+            SamplerSlot{"s_texNormal", 1},
+            SamplerSlot{"s_texMetallicRoughness", 2},
+            SamplerSlot{"s_texEmissive", 3},
+        };
+    }
+
+    ShaderRegistry &ShaderRegistry::get() {
+        static ShaderRegistry registry;
+        return registry;
+    }
+
+    ShaderRegistry::ShaderRegistry() = default;
+
+    // handles left at exit belong to a bgfx context that is already gone
+    ShaderRegistry::~ShaderRegistry() = default;
+
+    std::shared_ptr<const ShaderProgram> ShaderRegistry::acquire(const bgfx::Memory *vs_data,
+                                                                 const bgfx::Memory *fs_data) {
+        if (!vs_data || !fs_data) {
+            spdlog::error("ShaderRegistry::acquire - Invalid shader data");
+            return nullptr;
+        }
+
+        const uint64_t hash = hash_bytes(fs_data->data, fs_data->size,
+                                         hash_bytes(vs_data->data, vs_data->size));
+
+        const bgfx::ShaderHandle vsh = bgfx::createShader(vs_data);
+        const bgfx::ShaderHandle fsh = bgfx::createShader(fs_data);
+
+        if (auto program = find(hash)) {
+            // creating the shaders is the only way to hand the memory back to bgfx
+            bgfx::destroy(vsh);
+            bgfx::destroy(fsh);
+            return program;
+        }
+
+        return link(hash, vsh, fsh);
+    }
+
+    std::shared_ptr<const ShaderProgram> ShaderRegistry::acquire(const bgfx::EmbeddedShader &vs,
+                                                                 const bgfx::EmbeddedShader &fs) {
+        const bgfx::RendererType::Enum type = bgfx::getRendererType();
+        const auto *vs_data = find_embedded_data(vs, type);
+        const auto *fs_data = find_embedded_data(fs, type);
+
+        if (!vs_data || !fs_data) {
+            spdlog::error("ShaderRegistry::acquire - No embedded binaries of {} or {} for the renderer",
+                          vs.name, fs.name);
+            return nullptr;
+        }
+
+        const uint64_t hash = hash_bytes(fs_data->data, fs_data->size,
+                                         hash_bytes(vs_data->data, vs_data->size));
+        if (auto program = find(hash)) {
+            return program;
+        }
+
+        return link(hash, bgfx::createEmbeddedShader(&vs, type, vs.name),
+                    bgfx::createEmbeddedShader(&fs, type, fs.name));
+    }
+
+    ShaderUniform ShaderRegistry::get_uniform(const std::string &name, const bgfx::UniformType::Enum type,
+                                              const uint16_t num) {
+        std::lock_guard lock(_mutex);
+
+        auto it = _uniforms.find(name);
+        if (it == _uniforms.end()) {
+            ShaderUniform uniform{bgfx::createUniform(name.c_str(), type, num), UniformId(name), name, type, num};
+            if (!uniform.is_valid()) {
+                spdlog::error("ShaderRegistry::get_uniform - Failed to create uniform {}", name);
+                return uniform;
+            }
+            it = _uniforms.emplace(name, std::move(uniform)).first;
+        } else if (it->second.type != type || it->second.num != num) {
+            spdlog::warn("ShaderRegistry::get_uniform - Uniform {} is already registered with another type", name);
+        }
+
+        return it->second;
+    }
+
+    ShaderSampler ShaderRegistry::get_sampler(const std::string &name, const uint8_t stage) {
+        std::lock_guard lock(_mutex);
+
+        auto it = _samplers.find(name);
+        if (it == _samplers.end()) {
+            ShaderSampler sampler{
+                bgfx::createUniform(name.c_str(), bgfx::UniformType::Sampler, 1), UniformId(name), name, stage
+            };
+            if (!sampler.is_valid()) {
+                spdlog::error("ShaderRegistry::get_sampler - Failed to create sampler {}", name);
+                return sampler;
+            }
+            it = _samplers.emplace(name, std::move(sampler)).first;
+        }
+
+        ShaderSampler sampler = it->second;
+        sampler.stage = stage;
+        return sampler;
+    }
+
+    size_t ShaderRegistry::get_program_count() const {
+        std::lock_guard lock(_mutex);
+
+        return std::ranges::count_if(_programs, [](const auto &entry) {
+            return !entry.second.expired();
+        });
+    }
+
+    size_t ShaderRegistry::get_uniform_count() const {
+        std::lock_guard lock(_mutex);
+        return _uniforms.size() + _samplers.size();
+    }
+
+    void ShaderRegistry::shutdown() {
+        std::lock_guard lock(_mutex);
+
+        // their last Shader would otherwise destroy the handle after bgfx is gone
+        size_t alive = 0;
+        for (const auto &entry: _programs | std::views::values) {
+            if (const auto program = entry.lock()) {
+                program->destroy();
+                ++alive;
+            }
+        }
+        if (alive > 0) {
+            spdlog::warn("ShaderRegistry - {} programs were still referenced at shutdown and are destroyed", alive);
+        }
+
+        for (auto &uniform: _uniforms | std::views::values) {
+            bgfx::destroy(uniform.handle);
+        }
+        for (auto &sampler: _samplers | std::views::values) {
+            bgfx::destroy(sampler.handle);
+        }
+
+        _uniforms.clear();
+        _samplers.clear();
+        _programs.clear();
+    }
+
+    std::shared_ptr<const ShaderProgram> ShaderRegistry::find(const uint64_t hash) {
+        std::lock_guard lock(_mutex);
+
+        const auto it = _programs.find(hash);
+        if (it == _programs.end()) {
+            return nullptr;
+        }
+
+        auto program = it->second.lock();
+        if (!program) {
+            _programs.erase(it);
+        }
+        return program;
+    }
+
+    std::shared_ptr<const ShaderProgram> ShaderRegistry::link(const uint64_t hash, const bgfx::ShaderHandle vsh,
+                                                              const bgfx::ShaderHandle fsh) {
+        if (!bgfx::isValid(vsh) || !bgfx::isValid(fsh)) {
+            spdlog::error("ShaderRegistry::link - Failed to create shader handles");
+            if (bgfx::isValid(vsh)) {
+                bgfx::destroy(vsh);
+            }
+            if (bgfx::isValid(fsh)) {
+                bgfx::destroy(fsh);
+            }
+            return nullptr;
+        }
+
+        auto program = std::make_shared<ShaderProgram>();
+        program->hash = hash;
+        program->handle = bgfx::createProgram(vsh, fsh, true);
+
+        if (!bgfx::isValid(program->handle)) {
+            spdlog::error("ShaderRegistry::link - Failed to create shader program");
+            return nullptr;
+        }
+
+        init_slots(*program);
+
+        std::lock_guard lock(_mutex);
+
+        // another thread linked the same binaries in the meantime, keep the first one
+        auto &entry = _programs[hash];
+        if (auto existing = entry.lock()) {
+            return existing;
+        }
+
+        entry = program;
+        return program;
+    }
+
+    void ShaderRegistry::init_slots(ShaderProgram &program) {
+        for (const auto &[name, type]: k_material_uniforms) {
+            program.uniforms.push_back(get_uniform(name, type));
+        }
+
+        for (const auto &[name, stage]: k_material_samplers) {
+            program.samplers.push_back(get_sampler(name, stage));
+        }
+
+        std::ranges::sort(program.uniforms, {}, &ShaderUniform::id);
+        std::ranges::sort(program.samplers, {}, &ShaderSampler::id);
+
+        if (std::ranges::adjacent_find(program.uniforms, {}, &ShaderUniform::id) != program.uniforms.end() ||
+            std::ranges::adjacent_find(program.samplers, {}, &ShaderSampler::id) != program.samplers.end()) {
+            spdlog::error("ShaderRegistry::init_slots - Two uniform names of program {:#x} share a hash", program.hash);
+        }
+    }
+}
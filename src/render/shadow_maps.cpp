@@ -0,0 +1,708 @@
+#include "star/core/common.hpp"
+#include "star/render/shadow_maps.hpp"
+#include "star/graphics/shaders.hpp"
+#include "star/render/encoder_state.hpp"
+#include "star/render/light_clusters.hpp"
+#include "star/render/render_chain.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/render/shader_registry.hpp"
+#include "star/render/static_batcher.hpp"
+#include "star/scene/transform.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace star {
+    namespace {
+        constexpr uint8_t k_static_stage = 7;
+        constexpr uint8_t k_dynamic_stage = 8;
+
+        constexpr uint16_t k_instance_stride = sizeof(glm::mat4);
+
+        constexpr uint64_t k_atlas_flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_COMPARE_LEQUAL | BGFX_SAMPLER_UVW_CLAMP;
+
+        // the log split needs a positive start, orthographic cameras may put the near plane behind the eye
+        constexpr float k_min_split_depth = 0.05f;
+
+        // splits past the last cascade, the shaders stop sampling there
+        constexpr float k_no_split = std::numeric_limits<float>::max();
+
+        constexpr uint64_t k_fnv_offset = 0xcbf29ce484222325ull;
+        constexpr uint64_t k_fnv_prime = 0x100000001b3ull;
+
+        uint64_t hash_combine(uint64_t hash, const uint64_t value) {
+            hash ^= value;
+            hash *= k_fnv_prime;
+            return hash;
+        }
+
+        uint64_t caster_state(const Material &material) {
+            uint64_t state = BGFX_STATE_WRITE_Z | BGFX_STATE_DEPTH_TEST_LESS;
+            switch (material.get_cull_mode()) {
+                case CullMode::None:
+                    break;
+                case CullMode::CW:
+                    state |= BGFX_STATE_CULL_CW;
+                    break;
+                case CullMode::CCW:
+                    state |= BGFX_STATE_CULL_CCW;
+                    break;
+            }
+            return state;
+        }
+
+        bool casts_shadows(const MeshRenderer &renderer) {
+            const Mesh *mesh = renderer.get_mesh();
+            const Material *material = renderer.get_material();
+            return renderer.is_visible() && renderer.get_cast_shadows() && mesh && mesh->is_valid() && material &&
+                   !material->is_translucent();
+        }
+
+        glm::vec3 unproject(const glm::mat4 &inverse_projection, const float x, const float y, const float z) {
+            const glm::vec4 point = inverse_projection * glm::vec4(x, y, z, 1.0f);
+            return glm::vec3(point) / point.w;
+        }
+    }
+
+    ShadowMaps::ShadowMaps() = default;
+
+    ShadowMaps::~ShadowMaps() {
+        shutdown();
+    }
+
+    bool ShadowMaps::init(const ShadowSettings &settings) {
+        shutdown();
+
+        if (settings.cascade_count == 0 || settings.cascade_count > k_max_cascades || settings.resolution == 0) {
+            spdlog::error("ShadowMaps::init - Between 1 and {} cascades of a positive resolution are supported",
+                          k_max_cascades);
+            return false;
+        }
+
+        const auto *caps = bgfx::getCaps();
+        if ((caps->supported & BGFX_CAPS_TEXTURE_COMPARE_LEQUAL) == 0) {
+            spdlog::error("ShadowMaps::init - Depth compare samplers are not supported by the renderer");
+            return false;
+        }
+
+        _settings = settings;
+
+        const uint32_t columns = _settings.cascade_count > 1 ? 2 : 1;
+        const uint32_t rows = _settings.cascade_count > 2 ? 2 : 1;
+        if (columns * _settings.resolution > caps->limits.maxTextureSize) {
+            spdlog::error("ShadowMaps::init - A {} atlas of {} texels exceeds the texture limits",
+                          _settings.cascade_count, _settings.resolution);
+            return false;
+        }
+
+        _atlas_width = static_cast<uint16_t>(columns * _settings.resolution);
+        _atlas_height = static_cast<uint16_t>(rows * _settings.resolution);
+
+        constexpr uint32_t k_framebuffer_format = BGFX_CAPS_FORMAT_TEXTURE_FRAMEBUFFER;
+        _atlas_format = (caps->formats[bgfx::TextureFormat::D32F] & k_framebuffer_format)
+                            ? bgfx::TextureFormat::D32F
+                            : bgfx::TextureFormat::D16;
+
+        // the dynamic atlas comes with the views or from the chain, whichever the owner sets up
+        _static_atlas = bgfx::createTexture2D(_atlas_width, _atlas_height, false, 1, _atlas_format, k_atlas_flags);
+        if (!bgfx::isValid(_static_atlas)) {
+            spdlog::error("ShadowMaps::init - Failed to create the shadow atlas");
+            shutdown();
+            return false;
+        }
+
+        if (!_depth_shader.load(k_shadow_vs, k_shadow_fs) ||
+            !_depth_instanced_shader.load(k_shadow_instanced_vs, k_shadow_fs)) {
+            spdlog::error("ShadowMaps::init - Failed to load the depth programs");
+            shutdown();
+            return false;
+        }
+
+        auto &registry = ShaderRegistry::get();
+        _static_sampler = registry.get_sampler("s_shadowStatic", k_static_stage);
+        _dynamic_sampler = registry.get_sampler("s_shadowDynamic", k_dynamic_stage);
+        _matrix_uniform = registry.get_uniform("u_shadowMatrix", bgfx::UniformType::Mat4, k_max_cascades);
+        _split_uniform = registry.get_uniform("u_shadowSplits", bgfx::UniformType::Vec4);
+        _param_uniform = registry.get_uniform("u_shadowParams", bgfx::UniformType::Vec4);
+        _offset_uniform = registry.get_uniform("u_shadowOffsets", bgfx::UniformType::Vec4);
+
+        _cascades = {};
+        _static_redraws = 0;
+        return true;
+    }
+
+    void ShadowMaps::shutdown() {
+        destroy_view_targets();
+        if (bgfx::isValid(_static_atlas)) {
+            bgfx::destroy(_static_atlas);
+            _static_atlas = BGFX_INVALID_HANDLE;
+        }
+        _dynamic_atlas = BGFX_INVALID_HANDLE;
+        _chain = nullptr;
+
+        _depth_shader.reset();
+        _depth_instanced_shader.reset();
+        _has_views = false;
+        _active = false;
+        _params = glm::vec4(0.0f);
+        _casters.clear();
+        _caster_bounds.clear();
+        _caster_visible.clear();
+        _caster_order.clear();
+    }
+
+    bool ShadowMaps::is_valid() const {
+        return bgfx::isValid(_static_atlas) && _depth_shader.is_valid();
+    }
+
+    void ShadowMaps::render_reset(RenderChain &chain, const void *owner) {
+        _has_views = false;
+        if (!is_valid()) {
+            return;
+        }
+
+        if (!create_view_targets()) {
+            spdlog::error("ShadowMaps::render_reset - Failed to create the dynamic shadow atlas");
+            return;
+        }
+
+        for (uint32_t pass = 0; pass < 2; ++pass) {
+            const bool is_static = pass == 0;
+            for (uint32_t cascade = 0; cascade < _settings.cascade_count; ++cascade) {
+                std::string name = (is_static ? "Shadow Static " : "Shadow Dynamic ") + std::to_string(cascade);
+                chain.add_view(name, owner, [this, name, is_static, cascade](const bgfx::ViewId view_id) {
+                    bgfx::setViewName(view_id, name.c_str());
+                    bgfx::setViewFrameBuffer(view_id, is_static ? _static_framebuffer : _dynamic_framebuffer);
+                    set_cascade_rect(view_id, cascade);
+                    bgfx::setViewClear(view_id, BGFX_CLEAR_DEPTH, 0, 1.0f, 0);
+                    bgfx::setViewMode(view_id, bgfx::ViewMode::Sequential);
+
+                    (is_static ? _static_views : _dynamic_views)[cascade] = view_id;
+                    _has_views = true;
+
+                    if (is_static && cascade == 0) {
+                        // the cached depth is gone when the views were reset or moved
+                        invalidate_static();
+                    }
+                });
+            }
+        }
+    }
+
+    void ShadowMaps::add_passes(RenderChain &chain, const std::string &prefix) {
+        _has_views = false;
+        if (!is_valid()) {
+            return;
+        }
+
+        destroy_view_targets();
+        _chain = &chain;
+
+        _static_atlas_name = prefix + " Shadow Static Atlas";
+        _dynamic_atlas_name = prefix + " Shadow Dynamic Atlas";
+        _dynamic_clear_pass_name = prefix + " Shadow Dynamic Clear";
+        for (uint32_t cascade = 0; cascade < k_max_cascades; ++cascade) {
+            _static_pass_names[cascade] = prefix + " Shadow Static " + std::to_string(cascade);
+            _dynamic_pass_names[cascade] = prefix + " Shadow Dynamic " + std::to_string(cascade);
+        }
+
+        const RenderTargetDesc desc{_atlas_width, _atlas_height, glm::vec2(1.0f), _atlas_format, k_atlas_flags};
+        chain.import_texture(_static_atlas_name, _static_atlas, desc);
+
+        // the chain touches the passes every frame, a static cascade is only cleared in the frame render redrew it
+        for (uint32_t cascade = 0; cascade < _settings.cascade_count; ++cascade) {
+            chain.add_pass(_static_pass_names[cascade], [this](RenderPassBuilder &builder) {
+                builder.write(_static_atlas_name);
+            }, [this, cascade](const RenderPassContext &context) {
+                set_cascade_rect(context.view_id, cascade);
+                bgfx::setViewClear(context.view_id, _static_redrawn[cascade] ? BGFX_CLEAR_DEPTH : BGFX_CLEAR_NONE, 0,
+                                   1.0f, 0);
+                _static_redrawn[cascade] = false;
+            });
+        }
+
+        // each cascade only covers its own part of the atlas, one pass clears all of it
+        chain.add_pass(_dynamic_clear_pass_name, [this, desc](RenderPassBuilder &builder) {
+            builder.create(_dynamic_atlas_name, desc);
+            builder.write(_dynamic_atlas_name);
+            builder.set_clear(BGFX_CLEAR_DEPTH, 0, 1.0f);
+        }, nullptr);
+
+        for (uint32_t cascade = 0; cascade < _settings.cascade_count; ++cascade) {
+            chain.add_pass(_dynamic_pass_names[cascade], [this](RenderPassBuilder &builder) {
+                builder.write(_dynamic_atlas_name);
+            }, [this, cascade](const RenderPassContext &context) {
+                set_cascade_rect(context.view_id, cascade);
+            });
+        }
+
+        _static_redrawn = {};
+        invalidate_static();
+    }
+
+    void ShadowMaps::remove_passes(RenderChain &chain) {
+        if (_chain != &chain) {
+            return;
+        }
+
+        for (uint32_t cascade = 0; cascade < k_max_cascades; ++cascade) {
+            chain.remove_pass(_static_pass_names[cascade]);
+            chain.remove_pass(_dynamic_pass_names[cascade]);
+        }
+        chain.remove_pass(_dynamic_clear_pass_name);
+        chain.remove_texture(_static_atlas_name);
+
+        _chain = nullptr;
+        _dynamic_atlas = BGFX_INVALID_HANDLE;
+        _has_views = false;
+    }
+
+    void ShadowMaps::read_atlases(RenderPassBuilder &builder) const {
+        if (_chain) {
+            builder.read(_static_atlas_name);
+            builder.read(_dynamic_atlas_name);
+        }
+    }
+
+    bool ShadowMaps::create_view_targets() {
+        if (bgfx::isValid(_static_framebuffer) && bgfx::isValid(_dynamic_framebuffer)) {
+            return true;
+        }
+
+        destroy_view_targets();
+
+        // the framebuffers leave the atlases alone, the static one outlives them
+        _dynamic_atlas = bgfx::createTexture2D(_atlas_width, _atlas_height, false, 1, _atlas_format, k_atlas_flags);
+        if (bgfx::isValid(_dynamic_atlas)) {
+            _static_framebuffer = bgfx::createFrameBuffer(1, &_static_atlas, false);
+            _dynamic_framebuffer = bgfx::createFrameBuffer(1, &_dynamic_atlas, false);
+        }
+
+        if (!bgfx::isValid(_static_framebuffer) || !bgfx::isValid(_dynamic_framebuffer)) {
+            destroy_view_targets();
+            return false;
+        }
+        return true;
+    }
+
+    void ShadowMaps::destroy_view_targets() {
+        for (auto *framebuffer: {&_static_framebuffer, &_dynamic_framebuffer}) {
+            if (bgfx::isValid(*framebuffer)) {
+                bgfx::destroy(*framebuffer);
+                *framebuffer = BGFX_INVALID_HANDLE;
+            }
+        }
+
+        // with passes the handle belongs to the chain
+        if (!_chain && bgfx::isValid(_dynamic_atlas)) {
+            bgfx::destroy(_dynamic_atlas);
+        }
+        _dynamic_atlas = BGFX_INVALID_HANDLE;
+    }
+
+    bool ShadowMaps::update_pass_views() {
+        if (!_chain) {
+            return _has_views;
+        }
+
+        _has_views = false;
+        for (uint32_t cascade = 0; cascade < _settings.cascade_count; ++cascade) {
+            const auto static_view = _chain->get_view_id(_static_pass_names[cascade]);
+            const auto dynamic_view = _chain->get_view_id(_dynamic_pass_names[cascade]);
+            if (!static_view || !dynamic_view) {
+                return false;
+            }
+            _static_views[cascade] = *static_view;
+            _dynamic_views[cascade] = *dynamic_view;
+        }
+
+        _dynamic_atlas = _chain->get_texture(_dynamic_atlas_name);
+        _has_views = bgfx::isValid(_dynamic_atlas);
+        return _has_views;
+    }
+
+    void ShadowMaps::set_cascade_rect(const bgfx::ViewId view_id, const uint32_t cascade) const {
+        const uint16_t resolution = _settings.resolution;
+        bgfx::setViewRect(view_id, static_cast<uint16_t>(cascade % 2 * resolution),
+                          static_cast<uint16_t>(cascade / 2 * resolution), resolution, resolution);
+    }
+
+    void ShadowMaps::render(const EntityRegistry &registry, const StaticBatcher *batcher, const glm::mat4 &view,
+                            const glm::mat4 &projection, const float near_clip, const float far_clip,
+                            bgfx::Encoder &encoder) {
+        _caster_draws = 0;
+
+        glm::vec3 direction;
+        _active = is_valid() && update_pass_views() && find_light(registry, direction);
+        if (!_active) {
+            _params = glm::vec4(0.0f);
+            return;
+        }
+
+        fit_cascades(direction, view, projection, near_clip, far_clip);
+
+        if (const uint64_t hash = hash_static_casters(registry, batcher); hash != _static_hash) {
+            _static_hash = hash;
+            invalidate_static();
+        }
+
+        EncoderState state(encoder);
+
+        const bool static_dirty = std::any_of(_cascades.begin(), _cascades.begin() + _settings.cascade_count,
+                                              [](const Cascade &cascade) { return cascade.static_dirty; });
+        if (static_dirty) {
+            collect_casters(registry, batcher, true);
+
+            for (uint32_t i = 0; i < _settings.cascade_count; ++i) {
+                auto &cascade = _cascades[i];
+                if (!cascade.static_dirty) {
+                    continue;
+                }
+
+                const bgfx::ViewId view_id = _static_views[i];
+                _static_redrawn[i] = true;
+                bgfx::setViewTransform(view_id, &cascade.view[0][0], &cascade.projection[0][0]);
+                encoder.touch(view_id);
+                draw_casters(view_id, cascade, state);
+                cascade.static_dirty = false;
+                ++_static_redraws;
+            }
+        }
+
+        collect_casters(registry, batcher, false);
+
+        for (uint32_t i = 0; i < _settings.cascade_count; ++i) {
+            const auto &cascade = _cascades[i];
+            const bgfx::ViewId view_id = _dynamic_views[i];
+            bgfx::setViewTransform(view_id, &cascade.view[0][0], &cascade.projection[0][0]);
+            encoder.touch(view_id);
+            draw_casters(view_id, cascade, state);
+        }
+    }
+
+    void ShadowMaps::bind(EncoderState &state) const {
+        if (!is_valid()) {
+            return;
+        }
+
+        state.set_texture(_static_sampler.stage, _static_sampler.handle, _static_atlas);
+        state.set_texture(_dynamic_sampler.stage, _dynamic_sampler.handle, _dynamic_atlas);
+
+        auto &encoder = state.get_encoder();
+        encoder.setUniform(_matrix_uniform.handle, _shadow_matrices.data(), k_max_cascades);
+        encoder.setUniform(_split_uniform.handle, &_splits);
+        encoder.setUniform(_param_uniform.handle, &_params);
+        encoder.setUniform(_offset_uniform.handle, &_offsets);
+    }
+
+    void ShadowMaps::invalidate_static() {
+        for (auto &cascade: _cascades) {
+            cascade.static_dirty = true;
+        }
+    }
+
+    float ShadowMaps::get_cascade_split(const uint32_t cascade) const {
+        return cascade < _settings.cascade_count ? _cascades[cascade].split : 0.0f;
+    }
+
+    bool ShadowMaps::find_light(const EntityRegistry &registry, glm::vec3 &direction) const {
+        // the same light LightClusters flags as the shadow caster, it only looks at its first directional lights
+        uint32_t directional_count = 0;
+        for (const auto [entity, light]: registry.view<Light>().each()) {
+            if (!light.is_enabled() || light.get_type() != LightType::Directional) {
+                continue;
+            }
+            if (directional_count++ == LightClusters::k_max_directional_lights) {
+                break;
+            }
+            if (!light.get_cast_shadows()) {
+                continue;
+            }
+
+            glm::mat4 model(1.0f);
+            if (const auto *transform = registry.try_get<Transform>(entity)) {
+                model = transform->get_model_matrix();
+            }
+
+            direction = glm::normalize(glm::mat3(model) * glm::vec3(0.0f, 0.0f, -1.0f));
+            return true;
+        }
+        return false;
+    }
+
+    void ShadowMaps::fit_cascades(const glm::vec3 &direction, const glm::mat4 &view, const glm::mat4 &projection,
+                                  const float near_clip, const float far_clip) {
+        const auto *caps = bgfx::getCaps();
+        const uint32_t count = _settings.cascade_count;
+
+        if (direction != _light_direction) {
+            _light_direction = direction;
+            for (auto &cascade: _cascades) {
+                cascade.fitted = false;
+            }
+        }
+
+        const glm::vec3 up = std::abs(direction.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+        const glm::mat4 light_view = glm::lookAt(glm::vec3(0.0f), direction, up);
+
+        const float start = std::max(near_clip, k_min_split_depth);
+        const float end = std::max(std::min(far_clip, _settings.distance), start * 1.01f);
+
+        // corner lines of the camera frustum in view space, as a point per unit of view depth
+        const glm::mat4 inverse_projection = glm::inverse(projection);
+        const glm::mat4 inverse_view = glm::inverse(view);
+        std::array<glm::vec3, 4> line_start{};
+        std::array<glm::vec3, 4> line_step{};
+        for (uint32_t corner = 0; corner < 4; ++corner) {
+            const float x = (corner & 1) ? 1.0f : -1.0f;
+            const float y = (corner & 2) ? 1.0f : -1.0f;
+            const glm::vec3 a = unproject(inverse_projection, x, y, 0.0f);
+            const glm::vec3 b = unproject(inverse_projection, x, y, 1.0f);
+            line_step[corner] = (b - a) / (a.z - b.z);
+            line_start[corner] = a + line_step[corner] * a.z;
+        }
+
+        const uint32_t columns = count > 1 ? 2 : 1;
+        const uint32_t rows = count > 2 ? 2 : 1;
+        const float sign_y = caps->originBottomLeft ? 0.5f : -0.5f;
+        const float depth_scale = caps->homogeneousDepth ? 0.5f : 1.0f;
+        const float depth_offset = caps->homogeneousDepth ? 0.5f : 0.0f;
+
+        _splits = glm::vec4(k_no_split);
+        _offsets = glm::vec4(0.0f);
+
+        float split_begin = start;
+        for (uint32_t i = 0; i < count; ++i) {
+            auto &cascade = _cascades[i];
+
+            const float t = static_cast<float>(i + 1) / static_cast<float>(count);
+            const float uniform_split = start + (end - start) * t;
+            const float log_split = start * std::pow(end / start, t);
+            const float split_end = glm::mix(uniform_split, log_split, _settings.split_lambda);
+
+            // a sphere around the slice keeps the cascade size fixed while the camera turns
+            std::array<glm::vec3, 8> corners{};
+            glm::vec3 center(0.0f);
+            for (uint32_t corner = 0; corner < 8; ++corner) {
+                const float depth = corner < 4 ? split_begin : split_end;
+                const glm::vec3 point = line_start[corner % 4] + line_step[corner % 4] * depth;
+                corners[corner] = glm::vec3(inverse_view * glm::vec4(point, 1.0f));
+                center += corners[corner];
+            }
+            center /= 8.0f;
+
+            float radius = 0.0f;
+            for (const auto &corner: corners) {
+                radius = std::max(radius, glm::length(corner - center));
+            }
+            radius = std::ceil(radius * 16.0f) / 16.0f;
+
+            const float half_size = radius * (1.0f + _settings.refit_threshold);
+            const float texel = 2.0f * half_size / static_cast<float>(_settings.resolution);
+
+            glm::vec3 light_center = glm::vec3(light_view * glm::vec4(center, 1.0f));
+            light_center.x = std::floor(light_center.x / texel) * texel;
+            light_center.y = std::floor(light_center.y / texel) * texel;
+
+            const glm::vec3 drift = glm::abs(light_center - cascade.center);
+            const float max_drift = radius * _settings.refit_threshold;
+            if (!cascade.fitted || cascade.radius != radius || drift.x > max_drift || drift.y > max_drift ||
+                drift.z > max_drift) {
+                cascade.center = light_center;
+                cascade.radius = radius;
+                cascade.fitted = true;
+                cascade.static_dirty = true;
+
+                const glm::vec3 &c = cascade.center;
+                const float near_plane = -c.z - half_size - _settings.caster_distance;
+                const float far_plane = -c.z + half_size;
+
+                cascade.view = light_view;
+                cascade.projection = caps->homogeneousDepth
+                                         ? glm::orthoRH_NO(c.x - half_size, c.x + half_size, c.y - half_size,
+                                                           c.y + half_size, near_plane, far_plane)
+                                         : glm::orthoRH_ZO(c.x - half_size, c.x + half_size, c.y - half_size,
+                                                           c.y + half_size, near_plane, far_plane);
+
+                // culling planes expect a -1..1 clip depth whatever the renderer uses
+                cascade.frustum = Frustum::from_matrix(
+                    glm::orthoRH_NO(c.x - half_size, c.x + half_size, c.y - half_size, c.y + half_size, near_plane,
+                                    far_plane) * light_view);
+
+                const auto column = static_cast<float>(i % 2);
+                const auto row = static_cast<float>(i / 2);
+                glm::mat4 atlas(1.0f);
+                atlas[0][0] = 0.5f / static_cast<float>(columns);
+                atlas[1][1] = sign_y / static_cast<float>(rows);
+                atlas[2][2] = depth_scale;
+                atlas[3][0] = (column + 0.5f) / static_cast<float>(columns);
+                atlas[3][1] = caps->originBottomLeft
+                                  ? 1.0f - (row + 0.5f) / static_cast<float>(rows)
+                                  : (row + 0.5f) / static_cast<float>(rows);
+                atlas[3][2] = depth_offset;
+
+                cascade.shadow_matrix = atlas * cascade.projection * cascade.view;
+            }
+
+            cascade.split = split_end;
+            _shadow_matrices[i] = cascade.shadow_matrix;
+            _splits[static_cast<int>(i)] = split_end;
+            _offsets[static_cast<int>(i)] = texel * _settings.normal_bias;
+            split_begin = split_end;
+        }
+
+        _params = glm::vec4(static_cast<float>(count), _settings.depth_bias, 1.0f / static_cast<float>(_atlas_width),
+                            1.0f / static_cast<float>(_atlas_height));
+    }
+
+    uint64_t ShadowMaps::hash_static_casters(const EntityRegistry &registry, const StaticBatcher *batcher) const {
+        uint64_t hash = k_fnv_offset;
+
+        const auto statics = registry.view<MeshRenderer, StaticTag>(entt::exclude<StaticBatched>);
+        for (const auto [entity, renderer]: statics.each()) {
+            if (!casts_shadows(renderer)) {
+                continue;
+            }
+
+            const auto *transform = registry.try_get<Transform>(entity);
+            hash = hash_combine(hash, static_cast<uint64_t>(entt::to_integral(entity)));
+            hash = hash_combine(hash, reinterpret_cast<uintptr_t>(renderer.get_mesh()));
+            hash = hash_combine(hash, transform ? transform->get_version() : 0);
+        }
+
+        if (batcher) {
+            for (const auto &batch: batcher->get_batches()) {
+                hash = hash_combine(hash, reinterpret_cast<uintptr_t>(batch.get()));
+                hash = hash_combine(hash, reinterpret_cast<uintptr_t>(batch->renderer.get_mesh()));
+                hash = hash_combine(hash, batch->entity_count);
+            }
+        }
+
+        return hash;
+    }
+
+    void ShadowMaps::collect_casters(const EntityRegistry &registry, const StaticBatcher *batcher,
+                                     const bool static_casters) {
+        _casters.clear();
+        _caster_bounds.clear();
+
+        const auto add_caster = [this](const MeshRenderer &renderer, const glm::mat4 &model,
+                                       const BoundingSphere &bounds) {
+            const Mesh *mesh = renderer.get_mesh();
+            const glm::mat4 transform = mesh->get_vertex_format() == VertexFormat::Standard
+                                            ? model
+                                            : model * mesh->get_dequantization_matrix();
+
+            _casters.push_back({mesh, transform, caster_state(*renderer.get_material())});
+            _caster_bounds.push_back(bounds);
+        };
+
+        const auto add_entity = [&registry, &add_caster](const Entity entity, const MeshRenderer &renderer) {
+            if (!casts_shadows(renderer)) {
+                return;
+            }
+
+            glm::mat4 model(1.0f);
+            if (const auto *transform = registry.try_get<Transform>(entity)) {
+                model = transform->get_model_matrix();
+            }
+
+            const auto *bounds = registry.try_get<WorldBounds>(entity);
+            add_caster(renderer, model, bounds && bounds->is_valid()
+                                            ? bounds->get_sphere()
+                                            : renderer.get_mesh()->get_bounding_sphere().transform(model));
+        };
+
+        if (static_casters) {
+            const auto statics = registry.view<MeshRenderer, StaticTag>(entt::exclude<StaticBatched>);
+            for (const auto [entity, renderer]: statics.each()) {
+                add_entity(entity, renderer);
+            }
+
+            if (batcher) {
+                for (const auto &batch: batcher->get_batches()) {
+                    if (casts_shadows(batch->renderer)) {
+                        add_caster(batch->renderer, glm::mat4(1.0f),
+                                   batch->renderer.get_mesh()->get_bounding_sphere());
+                    }
+                }
+            }
+        } else {
+            const auto dynamics = registry.view<MeshRenderer>(entt::exclude<StaticTag>);
+            for (const auto [entity, renderer]: dynamics.each()) {
+                add_entity(entity, renderer);
+            }
+        }
+
+        // grouped by mesh so runs of the same mesh can be instanced
+        _caster_order.resize(_casters.size());
+        std::iota(_caster_order.begin(), _caster_order.end(), 0u);
+        std::ranges::sort(_caster_order, [this](const uint32_t a, const uint32_t b) {
+            const auto &lhs = _casters[a];
+            const auto &rhs = _casters[b];
+            return lhs.mesh != rhs.mesh ? std::less<>()(lhs.mesh, rhs.mesh) : lhs.state < rhs.state;
+        });
+
+        _caster_visible.resize(_casters.size());
+    }
+
+    void ShadowMaps::draw_casters(const bgfx::ViewId view_id, const Cascade &cascade, EncoderState &state) {
+        if (_casters.empty() || cascade.frustum.cull(_caster_bounds, _caster_visible) == 0) {
+            return;
+        }
+
+        const bool instancing = (bgfx::getCaps()->supported & BGFX_CAPS_INSTANCING) != 0 &&
+                                _depth_instanced_shader.is_valid();
+        auto &encoder = state.get_encoder();
+        const auto count = static_cast<uint32_t>(_caster_order.size());
+
+        uint32_t begin = 0;
+        while (begin < count) {
+            const auto &first = _casters[_caster_order[begin]];
+
+            uint32_t end = begin + 1;
+            while (end < count && _casters[_caster_order[end]].mesh == first.mesh &&
+                   _casters[_caster_order[end]].state == first.state) {
+                ++end;
+            }
+
+            uint32_t visible = 0;
+            for (uint32_t i = begin; i < end; ++i) {
+                visible += _caster_visible[_caster_order[i]];
+            }
+
+            bgfx::InstanceDataBuffer instance_data{};
+            if (instancing && visible > 1 && bgfx::getAvailInstanceDataBuffer(visible, k_instance_stride) == visible) {
+                bgfx::allocInstanceDataBuffer(&instance_data, visible, k_instance_stride);
+
+                uint8_t *data = instance_data.data;
+                for (uint32_t i = begin; i < end; ++i) {
+                    const uint32_t index = _caster_order[i];
+                    if (_caster_visible[index]) {
+                        std::memcpy(data, &_casters[index].transform[0][0], sizeof(glm::mat4));
+                        data += k_instance_stride;
+                    }
+                }
+
+                first.mesh->draw(state);
+                encoder.setInstanceDataBuffer(&instance_data);
+                state.set_state(first.state);
+                state.submit(view_id, _depth_instanced_shader.get_handle());
+                _caster_draws += visible;
+            } else if (visible > 0) {
+                for (uint32_t i = begin; i < end; ++i) {
+                    const auto &caster = _casters[_caster_order[i]];
+                    if (!_caster_visible[_caster_order[i]]) {
+                        continue;
+                    }
+
+                    encoder.setTransform(&caster.transform[0][0]);
+                    caster.mesh->draw(state);
+                    state.set_state(caster.state);
+                    state.submit(view_id, _depth_shader.get_handle());
+                    ++_caster_draws;
+                }
+            }
+
+            begin = end;
+        }
+    }
+}
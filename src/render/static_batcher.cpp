@@ -0,0 +1,312 @@
+#include "star/render/static_batcher.hpp"
+#include "star/render/mesh_optimizer.hpp"
+#include "star/scene/transform.hpp"
+#include <spdlog/spdlog.h>
+
+namespace star {
+    namespace {
+        // a batch is drawn with 16 bit indices
+        constexpr size_t k_max_batch_vertices = std::numeric_limits<uint16_t>::max() + 1;
+    }
+
+    StaticBatcher::StaticBatcher() = default;
+
+    StaticBatcher::~StaticBatcher() {
+        // joins a bake still in flight before the members it writes to go away
+        _worker.reset();
+    }
+
+    void StaticBatcher::init(Scene &scene, App &app) {
+        _scene = &scene;
+        _worker = std::make_unique<ThreadPool>(1);
+
+        auto &registry = scene.get_registry();
+        registry.on_construct<StaticTag>().connect<&StaticBatcher::on_static_changed>(*this);
+        registry.on_destroy<StaticTag>().connect<&StaticBatcher::on_static_changed>(*this);
+        registry.on_construct<MeshRenderer>().connect<&StaticBatcher::on_renderer_changed>(*this);
+        registry.on_destroy<MeshRenderer>().connect<&StaticBatcher::on_renderer_changed>(*this);
+
+        mark_dirty();
+    }
+
+    void StaticBatcher::shutdown() {
+        if (!_scene) {
+            return;
+        }
+
+        _worker.reset();
+
+        auto &registry = _scene->get_registry();
+        registry.on_construct<StaticTag>().disconnect(*this);
+        registry.on_destroy<StaticTag>().disconnect(*this);
+        registry.on_construct<MeshRenderer>().disconnect(*this);
+        registry.on_destroy<MeshRenderer>().disconnect(*this);
+        registry.clear<StaticBatched>();
+
+        _result.reset();
+        _baked.clear();
+        _batches.clear();
+        _scene = nullptr;
+    }
+
+    void StaticBatcher::update(float delta_time) {
+        if (!_scene) {
+            return;
+        }
+
+        std::optional<BakeResult> result;
+        bool building;
+        {
+            std::lock_guard lock(_result_mutex);
+            result.swap(_result);
+            building = _building;
+        }
+
+        if (result) {
+            apply(std::move(*result));
+        }
+
+        // while a bake is in flight the baked sources are older than the scene by design
+        if (building) {
+            return;
+        }
+
+        if (!_dirty && sources_changed()) {
+            mark_dirty();
+        }
+
+        if (_dirty) {
+            start_bake();
+        }
+    }
+
+    void StaticBatcher::build() {
+        if (!_scene) {
+            return;
+        }
+
+        _worker->wait_idle();
+        {
+            std::lock_guard lock(_result_mutex);
+            _result.reset();
+        }
+
+        BakeResult result{_generation, gather_sources()};
+        result.geometry = bake(result.sources);
+        _dirty = false;
+        apply(std::move(result));
+    }
+
+    void StaticBatcher::mark_dirty() {
+        _dirty = true;
+        ++_generation;
+    }
+
+    bool StaticBatcher::is_building() const {
+        return _building;
+    }
+
+    const std::vector<std::unique_ptr<StaticBatch> > &StaticBatcher::get_batches() const {
+        return _batches;
+    }
+
+    std::vector<StaticBatcher::Source> StaticBatcher::gather_sources() const {
+        std::vector<Source> sources;
+        size_t skipped = 0;
+
+        auto &registry = _scene->get_registry();
+        for (const auto entity: registry.view<StaticTag, MeshRenderer>()) {
+            const auto &mesh_renderer = registry.get<MeshRenderer>(entity);
+            // entities with LODs keep switching them, a batch only holds one level
+            if (!mesh_renderer.is_visible() || mesh_renderer.get_lods().size() != 1) {
+                continue;
+            }
+
+            const auto &mesh = mesh_renderer.get_lods().front().mesh;
+            const auto &material = mesh_renderer.get_shared_material();
+            if (!mesh || !material || material->is_translucent()) {
+                continue;
+            }
+
+            if (!mesh->has_cpu_data()) {
+                ++skipped;
+                continue;
+            }
+
+            // a mesh that alone overflows the 16 bit batch indices draws individually
+            if (mesh->get_cpu_vertices().size() > k_max_batch_vertices) {
+                continue;
+            }
+
+            Source &source = sources.emplace_back();
+            source.entity = entity;
+            source.mesh = mesh;
+            source.material = material;
+            source.tint = mesh_renderer.get_tint();
+            source.layer = mesh_renderer.get_layer();
+
+            if (const auto *transform = registry.try_get<Transform>(entity)) {
+                source.model = transform->get_model_matrix();
+                source.transform_version = transform->get_version();
+            }
+        }
+
+        if (skipped > 0) {
+            spdlog::debug("StaticBatcher - {} static entities have no CPU side mesh data and draw individually",
+                          skipped);
+        }
+
+        return sources;
+    }
+
+    std::vector<StaticBatcher::BakedGeometry> StaticBatcher::bake(const std::vector<Source> &sources) {
+        std::vector<uint32_t> order(sources.size());
+        std::iota(order.begin(), order.end(), 0u);
+        std::ranges::stable_sort(order, [&sources](const uint32_t a, const uint32_t b) {
+            if (sources[a].layer != sources[b].layer) {
+                return sources[a].layer < sources[b].layer;
+            }
+            return sources[a].material.get() < sources[b].material.get();
+        });
+
+        std::vector<BakedGeometry> geometry;
+        std::vector<uint16_t> sequential;
+
+        for (const uint32_t index: order) {
+            const Source &source = sources[index];
+            const auto &vertices = source.mesh->get_cpu_vertices();
+            const auto *indices = &source.mesh->get_cpu_indices();
+
+            if (indices->empty()) {
+                sequential.resize(vertices.size());
+                std::iota(sequential.begin(), sequential.end(), static_cast<uint16_t>(0));
+                indices = &sequential;
+            }
+
+            BakedGeometry *target = geometry.empty() ? nullptr : &geometry.back();
+            if (!target || target->material != source.material || target->layer != source.layer ||
+                target->vertices.size() + vertices.size() > k_max_batch_vertices) {
+                target = &geometry.emplace_back();
+                target->material = source.material;
+                target->layer = source.layer;
+            }
+
+            const glm::mat3 normal_matrix = glm::transpose(glm::inverse(glm::mat3(source.model)));
+            const auto base = static_cast<uint16_t>(target->vertices.size());
+
+            for (const auto &vertex: vertices) {
+                Vertex baked = vertex;
+                baked.position = glm::vec3(source.model * glm::vec4(vertex.position, 1.0f));
+
+                const glm::vec3 normal = normal_matrix * vertex.normal;
+                const float length = glm::length(normal);
+                baked.normal = length > 0.0f ? normal / length : vertex.normal;
+                baked.color = vertex.color * source.tint;
+
+                target->vertices.push_back(baked);
+            }
+
+            // a mirroring transform turns the triangles around, swapping two corners keeps them front facing
+            const bool mirrored = glm::determinant(glm::mat3(source.model)) < 0.0f;
+            const size_t first_index = target->indices.size();
+            for (const uint16_t i: *indices) {
+                target->indices.push_back(static_cast<uint16_t>(base + i));
+            }
+            if (mirrored) {
+                for (size_t i = first_index; i + 2 < target->indices.size(); i += 3) {
+                    std::swap(target->indices[i + 1], target->indices[i + 2]);
+                }
+            }
+
+            ++target->entity_count;
+        }
+
+        for (auto &baked: geometry) {
+            MeshOptimizer::optimize(baked.vertices, baked.indices);
+        }
+
+        return geometry;
+    }
+
+    void StaticBatcher::start_bake() {
+        _dirty = false;
+        _building = true;
+
+        _worker->submit([this, generation = _generation, sources = gather_sources()]() mutable {
+            auto geometry = bake(sources);
+
+            std::lock_guard lock(_result_mutex);
+            _result = BakeResult{generation, std::move(sources), std::move(geometry)};
+            _building = false;
+        });
+    }
+
+    void StaticBatcher::apply(BakeResult &&result) {
+        // the static entities changed while this was baking, the next bake replaces it
+        if (result.generation != _generation) {
+            return;
+        }
+
+        std::vector<std::unique_ptr<StaticBatch> > batches;
+        batches.reserve(result.geometry.size());
+
+        for (auto &baked: result.geometry) {
+            auto mesh = std::make_shared<Mesh>();
+            if (!mesh->create(baked.vertices, baked.indices)) {
+                spdlog::error("StaticBatcher - Failed to create a batch of {} vertices", baked.vertices.size());
+                continue;
+            }
+
+            auto batch = std::make_unique<StaticBatch>();
+            batch->renderer.set_mesh(std::move(mesh));
+            batch->renderer.set_material(baked.material);
+            batch->renderer.set_layer(baked.layer);
+            batch->entity_count = baked.entity_count;
+            batches.push_back(std::move(batch));
+        }
+
+        auto &registry = _scene->get_registry();
+        registry.clear<StaticBatched>();
+        for (const auto &source: result.sources) {
+            if (registry.valid(source.entity)) {
+                registry.emplace_or_replace<StaticBatched>(source.entity);
+            }
+        }
+
+        _batches = std::move(batches);
+        _baked = std::move(result.sources);
+
+        spdlog::debug("StaticBatcher - Baked {} entities into {} batches", _baked.size(), _batches.size());
+    }
+
+    bool StaticBatcher::sources_changed() const {
+        const auto &registry = _scene->get_registry();
+
+        return std::ranges::any_of(_baked, [&registry](const Source &source) {
+            if (!registry.valid(source.entity)) {
+                return true;
+            }
+
+            const auto *mesh_renderer = registry.try_get<MeshRenderer>(source.entity);
+            if (!mesh_renderer || !mesh_renderer->is_visible() || mesh_renderer->get_lods().size() != 1 ||
+                mesh_renderer->get_mesh() != source.mesh.get() ||
+                mesh_renderer->get_material() != source.material.get() ||
+                mesh_renderer->get_tint() != source.tint || mesh_renderer->get_layer() != source.layer) {
+                return true;
+            }
+
+            const auto *transform = registry.try_get<Transform>(source.entity);
+            return transform && transform->get_version() != source.transform_version;
+        });
+    }
+
+    void StaticBatcher::on_static_changed(EntityRegistry &registry, Entity entity) {
+        mark_dirty();
+    }
+
+    void StaticBatcher::on_renderer_changed(EntityRegistry &registry, const Entity entity) {
+        if (registry.all_of<StaticTag>(entity)) {
+            mark_dirty();
+        }
+    }
+}
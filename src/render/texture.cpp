@@ -1,53 +1,320 @@
 #include "star/core/common.hpp"
 #include "star/render/texture.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <bimg/bimg.h>
+#include <bimg/decode.h>
+#include <bx/allocator.h>
 
 namespace star {
-    TextureSampler::TextureSampler(const std::string &sampler_name, uint8_t texture_stage)
-        : name(sampler_name)
-          , stage(texture_stage) {
-        sampler = bgfx::createUniform(name.c_str(), bgfx::UniformType::Sampler, 1);
+    namespace {
+        bx::AllocatorI &get_allocator() {
+            // malloc based, safe to use from the workers and from the render thread freeing the images
+            static bx::DefaultAllocator allocator;
+            return allocator;
+        }
+
+        void release_image(void *, void *user_data) {
+            bimg::imageFree(static_cast<bimg::ImageContainer *>(user_data));
+        }
+
+        bool read_file(const std::string &path, std::vector<uint8_t> &data) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file) {
+                return false;
+            }
+
+            const auto size = static_cast<size_t>(file.tellg());
+            data.resize(size);
+            file.seekg(0);
+            return size > 0 && file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(size));
+        }
+
+        bool can_generate_mips(const bimg::ImageContainer &image) {
+            if (image.m_numMips > 1 || image.m_cubeMap || image.m_depth > 1 || image.m_numLayers > 1) {
+                return false;
+            }
+
+            // block compressed and float images are left alone, those come with their mips or go without
+            switch (image.m_format) {
+                case bimg::TextureFormat::RGBA8:
+                case bimg::TextureFormat::BGRA8:
+                case bimg::TextureFormat::RGB8:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        // 2x2 box filter, the last row or column is repeated for odd sizes
+        void downsample_rgba8(const bimg::ImageMip &src, const bimg::ImageMip &dst) {
+            auto *out = const_cast<uint8_t *>(dst.m_data);
+            for (uint32_t y = 0; y < dst.m_height; ++y) {
+                const uint32_t y0 = std::min(y * 2, src.m_height - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, src.m_height - 1);
+
+                for (uint32_t x = 0; x < dst.m_width; ++x) {
+                    const uint32_t x0 = std::min(x * 2, src.m_width - 1);
+                    const uint32_t x1 = std::min(x * 2 + 1, src.m_width - 1);
+
+                    for (uint32_t c = 0; c < 4; ++c) {
+                        const uint32_t sum = src.m_data[(y0 * src.m_width + x0) * 4 + c] +
+                                             src.m_data[(y0 * src.m_width + x1) * 4 + c] +
+                                             src.m_data[(y1 * src.m_width + x0) * 4 + c] +
+                                             src.m_data[(y1 * src.m_width + x1) * 4 + c];
+                        out[(y * dst.m_width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+        }
+
+        // takes ownership of the source, returns an RGBA8 image with the full mip chain or null
+        bimg::ImageContainer *generate_mips(bimg::ImageContainer *source) {
+            bimg::ImageContainer *rgba = source;
+            if (source->m_format != bimg::TextureFormat::RGBA8) {
+                rgba = bimg::imageConvert(&get_allocator(), bimg::TextureFormat::RGBA8, *source);
+                bimg::imageFree(source);
+                if (!rgba) {
+                    return nullptr;
+                }
+            }
+
+            bimg::ImageContainer *mipped = bimg::imageAlloc(&get_allocator(), bimg::TextureFormat::RGBA8,
+                                                            static_cast<uint16_t>(rgba->m_width),
+                                                            static_cast<uint16_t>(rgba->m_height), 1, 1, false,
+                                                            true);
+            if (!mipped) {
+                bimg::imageFree(rgba);
+                return nullptr;
+            }
+
+            bimg::ImageMip src;
+            bimg::ImageMip dst;
+            bimg::imageGetRawData(*rgba, 0, 0, rgba->m_data, rgba->m_size, src);
+            bimg::imageGetRawData(*mipped, 0, 0, mipped->m_data, mipped->m_size, dst);
+            std::memcpy(const_cast<uint8_t *>(dst.m_data), src.m_data, src.m_size);
+            bimg::imageFree(rgba);
+
+            for (uint8_t lod = 1; lod < mipped->m_numMips; ++lod) {
+                bimg::imageGetRawData(*mipped, 0, lod - 1, mipped->m_data, mipped->m_size, src);
+                bimg::imageGetRawData(*mipped, 0, lod, mipped->m_data, mipped->m_size, dst);
+                downsample_rgba8(src, dst);
+            }
+            return mipped;
+        }
     }
 
-    TextureSampler::~TextureSampler() {
+    bgfx::TextureHandle TextureSampler::get_handle() const {
+        return texture ? texture->get_handle() : handle;
+    }
+
+    bool TextureSampler::is_valid() const {
+        return bgfx::isValid(sampler) && bgfx::isValid(get_handle());
+    }
+
+    Texture::Texture(std::string path, const bgfx::TextureHandle placeholder)
+        : _path(std::move(path)), _placeholder(placeholder) {
+    }
+
+    Texture::~Texture() {
         destroy();
     }
 
-    TextureSampler::TextureSampler(TextureSampler &&other) noexcept
-        : handle(other.handle)
-          , sampler(other.sampler)
-          , name(std::move(other.name))
-          , stage(other.stage)
-          , flags(other.flags) {
-        other.handle = BGFX_INVALID_HANDLE;
-        other.sampler = BGFX_INVALID_HANDLE;
+    bgfx::TextureHandle Texture::get_handle() const {
+        if (bgfx::isValid(_handle)) {
+            return _handle;
+        }
+        return _placeholder;
+    }
+
+    void Texture::destroy() {
+        if (bgfx::isValid(_handle)) {
+            bgfx::destroy(_handle);
+            _handle = BGFX_INVALID_HANDLE;
+        }
+        _placeholder = BGFX_INVALID_HANDLE;
     }
 
-    TextureSampler &TextureSampler::operator=(TextureSampler &&other) noexcept {
-        if (this != &other) {
-            destroy();
+    TextureCache::TextureCache(const size_t thread_count)
+        : _pool(std::make_unique<ThreadPool>(thread_count)) {
+    }
 
-            handle = other.handle;
-            sampler = other.sampler;
-            name = std::move(other.name);
-            stage = other.stage;
-            flags = other.flags;
+    TextureCache::~TextureCache() {
+        shutdown();
+    }
 
-            other.handle = BGFX_INVALID_HANDLE;
-            other.sampler = BGFX_INVALID_HANDLE;
+    void TextureCache::init(App &app) {
+        _cancelled = false;
+        if (!bgfx::isValid(_placeholder)) {
+            // white, so the material colors show through until the texture arrives
+            constexpr uint32_t white = 0xffffffff;
+            _placeholder = bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8, BGFX_TEXTURE_NONE,
+                                                 bgfx::copy(&white, sizeof(white)));
         }
-        return *this;
     }
 
-    bool TextureSampler::is_valid() const {
-        return bgfx::isValid(sampler);
+    void TextureCache::shutdown() {
+        _cancelled = true;
+        wait_idle();
+        clear();
+
+        if (bgfx::isValid(_placeholder)) {
+            bgfx::destroy(_placeholder);
+            _placeholder = BGFX_INVALID_HANDLE;
+        }
+    }
+
+    void TextureCache::update(float delta_time) {
+        upload_pending();
+        evict_unused();
+    }
+
+    std::string TextureCache::normalize_path(const std::string &path) {
+        return std::filesystem::path(path).lexically_normal().generic_string();
+    }
+
+    std::shared_ptr<Texture> TextureCache::load(const std::string &path, const TextureLoadOptions &options) {
+        if (!bgfx::isValid(_placeholder)) {
+            spdlog::error("TextureCache::load - {} loaded before init", path);
+            return nullptr;
+        }
+
+        std::shared_ptr<Texture> texture;
+        {
+            std::lock_guard lock(_mutex);
+
+            auto &entry = _textures[normalize_path(path)];
+            if (entry) {
+                return entry;
+            }
+
+            entry = std::make_shared<Texture>(path, _placeholder);
+            texture = entry;
+        }
+
+        ++_loading_count;
+        _pool->submit([this, texture, options] {
+            decode(texture, options);
+        });
+        return texture;
     }
 
-    void TextureSampler::destroy() {
-        if (is_valid()) {
-            bgfx::destroy(sampler);
-            sampler = BGFX_INVALID_HANDLE;
+    void TextureCache::decode(const std::shared_ptr<Texture> &texture, const TextureLoadOptions &options) {
+        if (_cancelled) {
+            --_loading_count;
+            return;
         }
 
-        handle = BGFX_INVALID_HANDLE;
+        std::vector<uint8_t> data;
+        bimg::ImageContainer *image = nullptr;
+        if (!read_file(texture->get_path(), data)) {
+            spdlog::error("TextureCache::load - Failed to read {}", texture->get_path());
+        } else {
+            bx::Error error;
+            image = bimg::imageParse(&get_allocator(), data.data(), static_cast<uint32_t>(data.size()),
+                                     bimg::TextureFormat::Count, &error);
+            if (!image) {
+                spdlog::error("TextureCache::load - Failed to decode {}", texture->get_path());
+            } else if (options.generate_mips && can_generate_mips(*image)) {
+                image = generate_mips(image);
+                if (!image) {
+                    spdlog::error("TextureCache::load - Failed to generate the mips of {}", texture->get_path());
+                }
+            }
+        }
+
+        if (!image) {
+            texture->_state = TextureState::Failed;
+            --_loading_count;
+            return;
+        }
+
+        std::lock_guard lock(_mutex);
+        _decoded.push_back({texture, image, options.flags});
+    }
+
+    size_t TextureCache::upload_pending() {
+        std::vector<Decoded> decoded;
+        {
+            std::lock_guard lock(_mutex);
+            decoded.swap(_decoded);
+        }
+
+        for (auto &[texture, image, flags]: decoded) {
+            const auto format = static_cast<bgfx::TextureFormat::Enum>(image->m_format);
+            const auto width = static_cast<uint16_t>(image->m_width);
+            const auto height = static_cast<uint16_t>(image->m_height);
+            const auto depth = static_cast<uint16_t>(image->m_depth);
+            const auto layers = static_cast<uint16_t>(image->m_numLayers);
+            const bool has_mips = image->m_numMips > 1;
+
+            if (!bgfx::isTextureValid(depth, image->m_cubeMap, layers, format, flags)) {
+                spdlog::error("TextureCache::upload_pending - {} has a format the renderer can not sample",
+                              texture->get_path());
+                bimg::imageFree(image);
+                texture->_state = TextureState::Failed;
+                --_loading_count;
+                continue;
+            }
+
+            // bgfx frees the decoded image once the renderer consumed it
+            const bgfx::Memory *memory = bgfx::makeRef(image->m_data, image->m_size, release_image, image);
+
+            if (image->m_cubeMap) {
+                texture->_handle = bgfx::createTextureCube(width, has_mips, layers, format, flags, memory);
+            } else if (depth > 1) {
+                texture->_handle = bgfx::createTexture3D(width, height, depth, has_mips, format, flags, memory);
+            } else {
+                texture->_handle = bgfx::createTexture2D(width, height, has_mips, layers, format, flags, memory);
+            }
+
+            texture->_size = glm::uvec3(width, height, depth);
+            texture->_mip_count = image->m_numMips;
+            texture->_format = format;
+            texture->_state = bgfx::isValid(texture->_handle) ? TextureState::Ready : TextureState::Failed;
+            --_loading_count;
+
+            if (bgfx::isValid(texture->_handle)) {
+                bgfx::setName(texture->_handle, texture->get_path().c_str(),
+                              static_cast<int32_t>(texture->get_path().size()));
+            }
+        }
+        return decoded.size();
+    }
+
+    void TextureCache::wait_idle() const {
+        _pool->wait_idle();
+    }
+
+    size_t TextureCache::evict_unused() {
+        std::lock_guard lock(_mutex);
+        return std::erase_if(_textures, [](const auto &entry) {
+            return entry.second.use_count() == 1;
+        });
+    }
+
+    void TextureCache::clear() {
+        std::lock_guard lock(_mutex);
+
+        for (auto &[texture, image, flags]: _decoded) {
+            bimg::imageFree(image);
+            texture->_state = TextureState::Failed;
+            --_loading_count;
+        }
+        _decoded.clear();
+
+        // materials may hold on to some of them past the renderer's shutdown
+        for (auto &[path, texture]: _textures) {
+            texture->destroy();
+        }
+        _textures.clear();
+    }
+
+    size_t TextureCache::get_size() const {
+        std::lock_guard lock(_mutex);
+        return _textures.size();
+    }
+
+    size_t TextureCache::get_loading_count() const {
+        return _loading_count;
     }
 }
@@ -0,0 +1,323 @@
+#include "star/scene/bounds.hpp"
+#include "star/scene/transform.hpp"
+#include <algorithm>
+
+#if defined(__AVX__)
+#define STAR_BOUNDS_AVX
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STAR_BOUNDS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace star {
+    static_assert(sizeof(BoundingSphere) == sizeof(float) * 4, "BoundingSphere must stay tightly packed");
+
+    namespace {
+        glm::vec4 normalize_plane(const glm::vec4 &plane) {
+            const float length = glm::length(glm::vec3(plane));
+            return length > 0.0f ? plane / length : plane;
+        }
+
+        struct PlaneSoA {
+            std::array<float, Frustum::Count> x;
+            std::array<float, Frustum::Count> y;
+            std::array<float, Frustum::Count> z;
+            std::array<float, Frustum::Count> w;
+            std::array<float, Frustum::Count> abs_x;
+            std::array<float, Frustum::Count> abs_y;
+            std::array<float, Frustum::Count> abs_z;
+        };
+
+        PlaneSoA to_soa(const Frustum &frustum, const uint32_t plane_count) {
+            PlaneSoA soa{};
+            for (uint32_t i = 0; i < plane_count; ++i) {
+                const auto &plane = frustum.get_plane(static_cast<Frustum::Plane>(i));
+                soa.x[i] = plane.x;
+                soa.y[i] = plane.y;
+                soa.z[i] = plane.z;
+                soa.w[i] = plane.w;
+                soa.abs_x[i] = std::abs(plane.x);
+                soa.abs_y[i] = std::abs(plane.y);
+                soa.abs_z[i] = std::abs(plane.z);
+            }
+            return soa;
+        }
+
+        size_t write_mask(const uint32_t mask, const uint32_t lanes, uint8_t *visible) {
+            size_t count = 0;
+            for (uint32_t lane = 0; lane < lanes; ++lane) {
+                visible[lane] = static_cast<uint8_t>(mask >> lane & 1);
+                count += visible[lane];
+            }
+            return count;
+        }
+    }
+
+    Aabb Aabb::transform(const glm::mat4 &matrix) const {
+        const glm::vec3 center = glm::vec3(matrix * glm::vec4(get_center(), 1.0f));
+        const glm::vec3 extents = get_extents();
+
+        glm::vec3 world_extents(0.0f);
+        for (int axis = 0; axis < 3; ++axis) {
+            world_extents += glm::abs(glm::vec3(matrix[axis])) * extents[axis];
+        }
+
+        return {center - world_extents, center + world_extents};
+    }
+
+    BoundingSphere BoundingSphere::transform(const glm::mat4 &matrix) const {
+        const float scale = std::max({
+            glm::length(glm::vec3(matrix[0])), glm::length(glm::vec3(matrix[1])), glm::length(glm::vec3(matrix[2]))
+        });
+
+        return {glm::vec3(matrix * glm::vec4(center, 1.0f)), radius * scale};
+    }
+
+    Frustum::Frustum() {
+        _planes.fill(glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+
+    Frustum Frustum::from_matrix(const glm::mat4 &view_projection) {
+        const auto row = [&view_projection](const int i) {
+            return glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i],
+                             view_projection[3][i]);
+        };
+
+        const glm::vec4 x = row(0);
+        const glm::vec4 y = row(1);
+        const glm::vec4 z = row(2);
+        const glm::vec4 w = row(3);
+
+        Frustum frustum;
+        frustum._planes[Left] = normalize_plane(w + x);
+        frustum._planes[Right] = normalize_plane(w - x);
+        frustum._planes[Bottom] = normalize_plane(w + y);
+        frustum._planes[Top] = normalize_plane(w - y);
+        frustum._planes[Near] = normalize_plane(w + z);
+        frustum._planes[Far] = normalize_plane(w - z);
+        return frustum;
+    }
+
+    bool Frustum::intersects(const BoundingSphere &sphere, const uint32_t plane_count) const {
+        for (uint32_t i = 0; i < plane_count; ++i) {
+            const auto &plane = _planes[i];
+            if (glm::dot(glm::vec3(plane), sphere.center) + plane.w < -sphere.radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool Frustum::intersects(const Aabb &aabb, const uint32_t plane_count) const {
+        const glm::vec3 center = aabb.get_center();
+        const glm::vec3 extents = aabb.get_extents();
+
+        for (uint32_t i = 0; i < plane_count; ++i) {
+            const auto &plane = _planes[i];
+            const glm::vec3 normal(plane);
+            const float distance = glm::dot(normal, center) + plane.w;
+            const float projected = glm::dot(glm::abs(normal), extents);
+            if (distance + projected < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    size_t Frustum::cull(const std::span<const BoundingSphere> spheres, const std::span<uint8_t> visible,
+                         uint32_t plane_count) const {
+        plane_count = std::min<uint32_t>(plane_count, Count);
+        const size_t count = std::min(spheres.size(), visible.size());
+        size_t visible_count = 0;
+        size_t i = 0;
+
+#if defined(STAR_BOUNDS_AVX)
+        const PlaneSoA planes = to_soa(*this, plane_count);
+
+        for (; i + 8 <= count; i += 8) {
+            const auto *data = reinterpret_cast<const float *>(spheres.data() + i);
+
+            const __m256 t0 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(data + 0)),
+                                                   _mm_loadu_ps(data + 16), 1);
+            const __m256 t1 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(data + 4)),
+                                                   _mm_loadu_ps(data + 20), 1);
+            const __m256 t2 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(data + 8)),
+                                                   _mm_loadu_ps(data + 24), 1);
+            const __m256 t3 = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(data + 12)),
+                                                   _mm_loadu_ps(data + 28), 1);
+
+            const __m256 u0 = _mm256_unpacklo_ps(t0, t1);
+            const __m256 u1 = _mm256_unpackhi_ps(t0, t1);
+            const __m256 u2 = _mm256_unpacklo_ps(t2, t3);
+            const __m256 u3 = _mm256_unpackhi_ps(t2, t3);
+
+            const __m256 cx = _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 cy = _mm256_shuffle_ps(u0, u2, _MM_SHUFFLE(3, 2, 3, 2));
+            const __m256 cz = _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(1, 0, 1, 0));
+            const __m256 neg_radius = _mm256_sub_ps(_mm256_setzero_ps(),
+                                                    _mm256_shuffle_ps(u1, u3, _MM_SHUFFLE(3, 2, 3, 2)));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (uint32_t p = 0; p < plane_count; ++p) {
+                __m256 distance = _mm256_mul_ps(cx, _mm256_set1_ps(planes.x[p]));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cy, _mm256_set1_ps(planes.y[p])));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cz, _mm256_set1_ps(planes.z[p])));
+                distance = _mm256_add_ps(distance, _mm256_set1_ps(planes.w[p]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, neg_radius, _CMP_GE_OQ));
+            }
+
+            visible_count += write_mask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), 8, visible.data() + i);
+        }
+#elif defined(STAR_BOUNDS_SSE)
+        const PlaneSoA planes = to_soa(*this, plane_count);
+
+        for (; i + 4 <= count; i += 4) {
+            const auto *data = reinterpret_cast<const float *>(spheres.data() + i);
+
+            __m128 cx = _mm_loadu_ps(data + 0);
+            __m128 cy = _mm_loadu_ps(data + 4);
+            __m128 cz = _mm_loadu_ps(data + 8);
+            __m128 radius = _mm_loadu_ps(data + 12);
+            _MM_TRANSPOSE4_PS(cx, cy, cz, radius);
+
+            const __m128 neg_radius = _mm_sub_ps(_mm_setzero_ps(), radius);
+
+            __m128 inside = _mm_cmpeq_ps(neg_radius, neg_radius);
+            for (uint32_t p = 0; p < plane_count; ++p) {
+                __m128 distance = _mm_mul_ps(cx, _mm_set1_ps(planes.x[p]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(planes.y[p])));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(planes.z[p])));
+                distance = _mm_add_ps(distance, _mm_set1_ps(planes.w[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, neg_radius));
+            }
+
+            visible_count += write_mask(static_cast<uint32_t>(_mm_movemask_ps(inside)), 4, visible.data() + i);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            visible[i] = intersects(spheres[i], plane_count) ? 1 : 0;
+            visible_count += visible[i];
+        }
+
+        return visible_count;
+    }
+
+    size_t Frustum::cull(const std::span<const Aabb> aabbs, const std::span<uint8_t> visible,
+                         uint32_t plane_count) const {
+        plane_count = std::min<uint32_t>(plane_count, Count);
+        const size_t count = std::min(aabbs.size(), visible.size());
+        size_t visible_count = 0;
+        size_t i = 0;
+
+#if defined(STAR_BOUNDS_AVX)
+        const PlaneSoA planes = to_soa(*this, plane_count);
+        const __m256 half = _mm256_set1_ps(0.5f);
+
+        for (; i + 8 <= count; i += 8) {
+            const Aabb *b = aabbs.data() + i;
+
+            const auto load = [b](auto member, const int axis) {
+                return _mm256_setr_ps((b[0].*member)[axis], (b[1].*member)[axis], (b[2].*member)[axis],
+                                      (b[3].*member)[axis], (b[4].*member)[axis], (b[5].*member)[axis],
+                                      (b[6].*member)[axis], (b[7].*member)[axis]);
+            };
+
+            const __m256 min_x = load(&Aabb::min, 0), max_x = load(&Aabb::max, 0);
+            const __m256 min_y = load(&Aabb::min, 1), max_y = load(&Aabb::max, 1);
+            const __m256 min_z = load(&Aabb::min, 2), max_z = load(&Aabb::max, 2);
+
+            const __m256 cx = _mm256_mul_ps(_mm256_add_ps(min_x, max_x), half);
+            const __m256 cy = _mm256_mul_ps(_mm256_add_ps(min_y, max_y), half);
+            const __m256 cz = _mm256_mul_ps(_mm256_add_ps(min_z, max_z), half);
+            const __m256 ex = _mm256_mul_ps(_mm256_sub_ps(max_x, min_x), half);
+            const __m256 ey = _mm256_mul_ps(_mm256_sub_ps(max_y, min_y), half);
+            const __m256 ez = _mm256_mul_ps(_mm256_sub_ps(max_z, min_z), half);
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (uint32_t p = 0; p < plane_count; ++p) {
+                __m256 distance = _mm256_mul_ps(cx, _mm256_set1_ps(planes.x[p]));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cy, _mm256_set1_ps(planes.y[p])));
+                distance = _mm256_add_ps(distance, _mm256_mul_ps(cz, _mm256_set1_ps(planes.z[p])));
+                distance = _mm256_add_ps(distance, _mm256_set1_ps(planes.w[p]));
+
+                __m256 projected = _mm256_mul_ps(ex, _mm256_set1_ps(planes.abs_x[p]));
+                projected = _mm256_add_ps(projected, _mm256_mul_ps(ey, _mm256_set1_ps(planes.abs_y[p])));
+                projected = _mm256_add_ps(projected, _mm256_mul_ps(ez, _mm256_set1_ps(planes.abs_z[p])));
+
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(distance, projected),
+                                                             _mm256_setzero_ps(), _CMP_GE_OQ));
+            }
+
+            visible_count += write_mask(static_cast<uint32_t>(_mm256_movemask_ps(inside)), 8, visible.data() + i);
+        }
+#elif defined(STAR_BOUNDS_SSE)
+        const PlaneSoA planes = to_soa(*this, plane_count);
+        const __m128 half = _mm_set1_ps(0.5f);
+
+        for (; i + 4 <= count; i += 4) {
+            const Aabb *b = aabbs.data() + i;
+
+            const auto load = [b](auto member, const int axis) {
+                return _mm_setr_ps((b[0].*member)[axis], (b[1].*member)[axis], (b[2].*member)[axis],
+                                   (b[3].*member)[axis]);
+            };
+
+            const __m128 min_x = load(&Aabb::min, 0), max_x = load(&Aabb::max, 0);
+            const __m128 min_y = load(&Aabb::min, 1), max_y = load(&Aabb::max, 1);
+            const __m128 min_z = load(&Aabb::min, 2), max_z = load(&Aabb::max, 2);
+
+            const __m128 cx = _mm_mul_ps(_mm_add_ps(min_x, max_x), half);
+            const __m128 cy = _mm_mul_ps(_mm_add_ps(min_y, max_y), half);
+            const __m128 cz = _mm_mul_ps(_mm_add_ps(min_z, max_z), half);
+            const __m128 ex = _mm_mul_ps(_mm_sub_ps(max_x, min_x), half);
+            const __m128 ey = _mm_mul_ps(_mm_sub_ps(max_y, min_y), half);
+            const __m128 ez = _mm_mul_ps(_mm_sub_ps(max_z, min_z), half);
+
+            __m128 inside = _mm_cmpeq_ps(half, half);
+            for (uint32_t p = 0; p < plane_count; ++p) {
+                __m128 distance = _mm_mul_ps(cx, _mm_set1_ps(planes.x[p]));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cy, _mm_set1_ps(planes.y[p])));
+                distance = _mm_add_ps(distance, _mm_mul_ps(cz, _mm_set1_ps(planes.z[p])));
+                distance = _mm_add_ps(distance, _mm_set1_ps(planes.w[p]));
+
+                __m128 projected = _mm_mul_ps(ex, _mm_set1_ps(planes.abs_x[p]));
+                projected = _mm_add_ps(projected, _mm_mul_ps(ey, _mm_set1_ps(planes.abs_y[p])));
+                projected = _mm_add_ps(projected, _mm_mul_ps(ez, _mm_set1_ps(planes.abs_z[p])));
+
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(distance, projected), _mm_setzero_ps()));
+            }
+
+            visible_count += write_mask(static_cast<uint32_t>(_mm_movemask_ps(inside)), 4, visible.data() + i);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            visible[i] = intersects(aabbs[i], plane_count) ? 1 : 0;
+            visible_count += visible[i];
+        }
+
+        return visible_count;
+    }
+
+    bool WorldBounds::update(const Transform *transform, const Aabb &local_aabb, const BoundingSphere &local_sphere) {
+        const uint32_t version = transform ? transform->get_version() : 0;
+        if (_valid && version == _transform_version && local_aabb == _local_aabb && local_sphere == _local_sphere) {
+            return false;
+        }
+
+        const glm::mat4 model = transform ? transform->get_model_matrix() : glm::mat4(1.0f);
+        _aabb = local_aabb.transform(model);
+        _sphere = local_sphere.transform(model);
+        _local_aabb = local_aabb;
+        _local_sphere = local_sphere;
+        _transform_version = version;
+        _valid = true;
+        return true;
+    }
+
+    void WorldBounds::invalidate() {
+        _valid = false;
+    }
+}
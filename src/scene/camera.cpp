@@ -2,6 +2,7 @@
 #include "star/scene/transform.hpp"
 #include "star/scene/scene.hpp"
 #include "star/app/app.hpp"
+#include "star/render/render_chain.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <bgfx/bgfx.h>
 #include <spdlog/spdlog.h>
@@ -12,6 +13,7 @@
 namespace star {
     CameraImpl::CameraImpl(Camera &camera, const glm::mat4 &projection_matrix) noexcept
         : _camera(camera), _enabled(true),
+          _culling_filter(std::make_unique<Culling3D>()),
           _projection_matrix(projection_matrix) {
     }
 
@@ -23,6 +25,8 @@ namespace star {
         _scene = &scene;
         _app = &app;
 
+        update_render_target();
+
         for (const auto &component: _components) {
             component->init(_camera, scene, app);
         }
@@ -33,6 +37,12 @@ namespace star {
             (*it)->shutdown();
         }
 
+        if (_app != nullptr) {
+            _app->get_render_chain().remove_views(this);
+            _app->get_render_target_pool().release(_target);
+        }
+        _target = {};
+
         _scene = nullptr;
         _app = nullptr;
     }
@@ -80,39 +90,82 @@ namespace star {
         _clear_flags = flags;
     }
 
-    bgfx::ViewId CameraImpl::render_reset(bgfx::ViewId view_id) {
-        _view_id = view_id;
+    void CameraImpl::set_render_target(const glm::uvec2 &size, const bgfx::TextureFormat::Enum color_format,
+                                       const bgfx::TextureFormat::Enum depth_format) {
+        _target_size = glm::max(size, glm::uvec2(1));
+        _target_color_format = color_format;
+        _target_depth_format = depth_format;
+        update_render_target();
+    }
 
-        if (_app != nullptr) {
-            auto &window = _app->get_window();
-            auto size = window.get_size();
-            uint16_t width = size.x;
-            uint16_t height = size.y;
+    void CameraImpl::clear_render_target() {
+        _target_size.reset();
+        update_render_target();
+    }
+
+    const RenderTarget *CameraImpl::get_render_target() const {
+        if (!_app || !_target.is_valid()) {
+            return nullptr;
+        }
+        return &_app->get_render_target_pool().get(_target);
+    }
+
+    bgfx::FrameBufferHandle CameraImpl::get_framebuffer() const {
+        if (const RenderTarget *target = get_render_target()) {
+            return target->framebuffer;
+        }
+        return BGFX_INVALID_HANDLE;
+    }
 
-            uint16_t vx = static_cast<uint16_t>(_viewport.x * width);
-            uint16_t vy = static_cast<uint16_t>(_viewport.y * height);
-            uint16_t vw = static_cast<uint16_t>(_viewport.z * width);
-            uint16_t vh = static_cast<uint16_t>(_viewport.w * height);
+    glm::uvec2 CameraImpl::get_render_size() const {
+        if (_target_size) {
+            return *_target_size;
+        }
+        return _app ? _app->get_window().get_size() : glm::uvec2(0);
+    }
 
-            bgfx::setViewRect(_view_id, vx, vy, vw, vh);
-            bgfx::setViewClear(_view_id, _clear_flags,
-                               static_cast<uint32_t>(_clear_color.r * 255) << 24 |
-                               static_cast<uint32_t>(_clear_color.g * 255) << 16 |
-                               static_cast<uint32_t>(_clear_color.b * 255) << 8 |
-                               static_cast<uint32_t>(_clear_color.a * 255),
-                               1.0f, 0);
+    void CameraImpl::update_render_target() {
+        _matrices_dirty = true;
+        if (!_app || (!_target_size && !_target.is_valid())) {
+            return;
+        }
 
-            const glm::mat4 &view = get_view_matrix();
-            const glm::mat4 &proj = get_projection_matrix();
+        const bool size_changed = _target_size != _reset_target_size;
+        _reset_target_size = _target_size;
 
-            bgfx::setViewTransform(_view_id, &view[0][0], &proj[0][0]);
+        auto &pool = _app->get_render_target_pool();
+        const bool keep = _target_size && pool.fits(_target, *_target_size, _target_color_format,
+                                                    _target_depth_format, BGFX_TEXTURE_RT | BGFX_SAMPLER_UV_CLAMP) &&
+                          pool.get(_target).size == RenderTargetPool::get_bucket_size(*_target_size);
+
+        if (!keep) {
+            pool.release(_target);
+            _target = _target_size
+                          ? pool.acquire(*_target_size, _target_color_format, _target_depth_format)
+                          : RenderTargetId{};
         }
 
-        for (const auto &component: _components) {
-            _view_id = component->render_reset(_view_id);
+        // the views pick up the new framebuffer and rect on the next reset, an unchanged target needs none
+        if (!keep || size_changed) {
+            _app->request_render_reset();
+        }
+    }
+
+    void CameraImpl::render_reset(RenderChain &chain) {
+        // the renderers set the camera up on views of their own, a camera without any still gets one
+        if (_app != nullptr && _components.empty()) {
+            chain.add_view("Camera", this, [this](const bgfx::ViewId view_id) {
+                configure_view(view_id, "Camera");
+
+                const glm::mat4 view = get_view_matrix();
+                const glm::mat4 proj = get_projection_matrix();
+                bgfx::setViewTransform(view_id, &view[0][0], &proj[0][0]);
+            });
         }
 
-        return _view_id + 1;
+        for (const auto &component: _components) {
+            component->render_reset(chain);
+        }
     }
 
     void CameraImpl::render() const {
@@ -132,6 +185,8 @@ namespace star {
             component->update(delta_time);
         }
 
+        // the transform may have moved since the last frame
+        _matrices_dirty = true;
         update_matrices();
     }
 
@@ -171,17 +226,44 @@ namespace star {
 
     void CameraImpl::set_culling_filter(std::unique_ptr<ICullingFilter> &&filter) {
         _culling_filter = std::move(filter);
+        _matrices_dirty = true;
     }
 
     const ICullingFilter *CameraImpl::get_culling_filter() const {
+        if (_matrices_dirty) {
+            update_matrices();
+        }
         return _culling_filter.get();
     }
 
+    const Frustum &CameraImpl::get_frustum() const {
+        if (_matrices_dirty) {
+            update_matrices();
+        }
+        return _frustum;
+    }
+
+    float CameraImpl::get_screen_size(const BoundingSphere &sphere) const {
+        if (_matrices_dirty) {
+            update_matrices();
+        }
+
+        if (_projection_type == ProjectionType::Orthographic) {
+            return sphere.radius * _projection_matrix[1][1];
+        }
+
+        const float distance = -(_view_matrix * glm::vec4(sphere.center, 1.0f)).z;
+        if (distance <= sphere.radius) {
+            return std::numeric_limits<float>::max();
+        }
+
+        return sphere.radius * _projection_matrix[1][1] / distance;
+    }
+
     glm::vec3 CameraImpl::screen_to_world_point(const glm::vec2 &screen_pos, float depth) const {
         if (!_app) return glm::vec3(0.0f);
 
-        auto &window = _app->get_window();
-        auto size = window.get_size();
+        const glm::uvec2 size = get_render_size();
 
         float width = static_cast<float>(size.x);
         float height = static_cast<float>(size.y);
@@ -205,8 +287,7 @@ namespace star {
     glm::vec2 CameraImpl::world_to_screen_point(const glm::vec3 &world_pos) const {
         if (!_app) return glm::vec2(0.0f);
 
-        auto &window = _app->get_window();
-        auto size = window.get_size();
+        const glm::uvec2 size = get_render_size();
 
         float width = static_cast<float>(size.x);
         float height = static_cast<float>(size.y);
@@ -224,8 +305,7 @@ namespace star {
     glm::vec3 CameraImpl::screen_to_viewport_point(const glm::vec2 &screen_pos) const {
         if (!_app) return glm::vec3(0.0f);
 
-        auto &window = _app->get_window();
-        auto size = window.get_size();
+        const glm::uvec2 size = get_render_size();
 
         float width = static_cast<float>(size.x);
         float height = static_cast<float>(size.y);
@@ -239,8 +319,7 @@ namespace star {
     glm::vec2 CameraImpl::viewport_to_screen_point(const glm::vec3 &viewport_pos) const {
         if (!_app) return glm::vec2(0.0f);
 
-        auto &window = _app->get_window();
-        auto size = window.get_size();
+        const glm::uvec2 size = get_render_size();
 
         float width = static_cast<float>(size.x);
         float height = static_cast<float>(size.y);
@@ -270,9 +349,26 @@ namespace star {
         return ray;
     }
 
+    void CameraImpl::set_view_rect(const bgfx::ViewId view_id) const {
+        const glm::uvec2 size = get_render_size();
+        uint16_t width = size.x;
+        uint16_t height = size.y;
+
+        uint16_t vx = static_cast<uint16_t>(_viewport.x * width);
+        uint16_t vy = static_cast<uint16_t>(_viewport.y * height);
+        uint16_t vw = static_cast<uint16_t>(_viewport.z * width);
+        uint16_t vh = static_cast<uint16_t>(_viewport.w * height);
+
+        bgfx::setViewRect(view_id, vx, vy, vw, vh);
+    }
+
     void CameraImpl::configure_view(bgfx::ViewId view_id, const std::string &name) const {
         bgfx::setViewName(view_id, name.c_str());
-        bgfx::setViewFrameBuffer(view_id, BGFX_INVALID_HANDLE);
+        // components may put views of their own in front, so the rect is not always the one set up above
+        if (_app != nullptr) {
+            set_view_rect(view_id);
+        }
+        bgfx::setViewFrameBuffer(view_id, get_framebuffer());
         bgfx::setViewMode(view_id, bgfx::ViewMode::Sequential);
         bgfx::setViewClear(view_id, _clear_flags,
                            static_cast<uint32_t>(_clear_color.r * 255) << 24 |
@@ -310,8 +406,7 @@ namespace star {
         if (_projection_type == ProjectionType::Perspective) {
             float aspect = 1.0f;
             if (_app) {
-                auto &window = _app->get_window();
-                auto size = window.get_size();
+                const glm::uvec2 size = get_render_size();
 
                 float width = static_cast<float>(size.x) * _viewport.z;
                 float height = static_cast<float>(size.y) * _viewport.w;
@@ -337,6 +432,12 @@ namespace star {
             );
         }
 
+        const glm::mat4 view_projection = _projection_matrix * _view_matrix;
+        _frustum = Frustum::from_matrix(view_projection);
+        if (_culling_filter) {
+            _culling_filter->set_view_projection(view_projection);
+        }
+
         _matrices_dirty = false;
     }
 
@@ -375,6 +476,14 @@ namespace star {
         return _impl->get_projection_type();
     }
 
+    float Camera::get_near_clip() const {
+        return _impl->get_near_clip();
+    }
+
+    float Camera::get_far_clip() const {
+        return _impl->get_far_clip();
+    }
+
     void Camera::set_viewport(const glm::vec4 &viewport) {
         _impl->set_viewport(viewport);
     }
@@ -399,8 +508,25 @@ namespace star {
         return _impl->get_clear_flags();
     }
 
-    bgfx::ViewId Camera::render_reset(bgfx::ViewId view_id) {
-        return _impl->render_reset(view_id);
+    void Camera::set_render_target(const glm::uvec2 &size, const bgfx::TextureFormat::Enum color_format,
+                                   const bgfx::TextureFormat::Enum depth_format) {
+        _impl->set_render_target(size, color_format, depth_format);
+    }
+
+    void Camera::clear_render_target() {
+        _impl->clear_render_target();
+    }
+
+    const RenderTarget *Camera::get_render_target() const {
+        return _impl->get_render_target();
+    }
+
+    glm::uvec2 Camera::get_render_size() const {
+        return _impl->get_render_size();
+    }
+
+    void Camera::render_reset(RenderChain &chain) {
+        _impl->render_reset(chain);
     }
 
     void Camera::render() const {
@@ -433,6 +559,14 @@ namespace star {
         return _impl->get_culling_filter();
     }
 
+    const Frustum &Camera::get_frustum() const {
+        return _impl->get_frustum();
+    }
+
+    float Camera::get_screen_size(const BoundingSphere &sphere) const {
+        return _impl->get_screen_size(sphere);
+    }
+
     glm::vec3 Camera::screen_to_world_point(const glm::vec2 &screen_pos, float depth) const {
         return _impl->screen_to_world_point(screen_pos, depth);
     }
@@ -469,11 +603,56 @@ namespace star {
         return _impl->is_enabled();
     }
 
-    bool Culling2D::is_visible(const glm::vec3 &position, float radius) const {
-        return true;
+    size_t ICullingFilter::cull(const std::span<const BoundingSphere> spheres, const std::span<uint8_t> visible) const {
+        const size_t count = std::min(spheres.size(), visible.size());
+        size_t visible_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            visible[i] = is_visible(spheres[i].center, spheres[i].radius) ? 1 : 0;
+            visible_count += visible[i];
+        }
+        return visible_count;
+    }
+
+    size_t ICullingFilter::cull(const std::span<const Aabb> aabbs, const std::span<uint8_t> visible) const {
+        const size_t count = std::min(aabbs.size(), visible.size());
+        size_t visible_count = 0;
+        for (size_t i = 0; i < count; ++i) {
+            const auto &aabb = aabbs[i];
+            visible[i] = is_visible(aabb.get_center(), glm::length(aabb.get_extents())) ? 1 : 0;
+            visible_count += visible[i];
+        }
+        return visible_count;
+    }
+
+    void Culling2D::set_view_projection(const glm::mat4 &view_projection) {
+        _frustum = Frustum::from_matrix(view_projection);
+    }
+
+    bool Culling2D::is_visible(const glm::vec3 &position, const float radius) const {
+        return _frustum.intersects(BoundingSphere{position, radius}, Frustum::Near);
+    }
+
+    size_t Culling2D::cull(const std::span<const BoundingSphere> spheres, const std::span<uint8_t> visible) const {
+        return _frustum.cull(spheres, visible, Frustum::Near);
+    }
+
+    size_t Culling2D::cull(const std::span<const Aabb> aabbs, const std::span<uint8_t> visible) const {
+        return _frustum.cull(aabbs, visible, Frustum::Near);
+    }
+
+    void Culling3D::set_view_projection(const glm::mat4 &view_projection) {
+        _frustum = Frustum::from_matrix(view_projection);
+    }
+
+    bool Culling3D::is_visible(const glm::vec3 &position, const float radius) const {
+        return _frustum.intersects(BoundingSphere{position, radius});
+    }
+
+    size_t Culling3D::cull(const std::span<const BoundingSphere> spheres, const std::span<uint8_t> visible) const {
+        return _frustum.cull(spheres, visible);
     }
 
-    bool Culling3D::is_visible(const glm::vec3 &position, float radius) const {
-        return true;
+    size_t Culling3D::cull(const std::span<const Aabb> aabbs, const std::span<uint8_t> visible) const {
+        return _frustum.cull(aabbs, visible);
     }
 }
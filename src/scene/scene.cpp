@@ -25,9 +25,9 @@ namespace star {
             component->init(_scene, app);
         }
 
-        auto &cams = _registry.storage<Camera>();
-        for (auto itr = cams.rbegin(), last = cams.rend(); itr != last; ++itr) {
-            itr->get_impl()->init(_scene, app);
+        for (auto [entity, cam]: _registry.view<Camera>().each()) {
+            cam.get_impl()->set_entity(entity);
+            cam.get_impl()->init(_scene, app);
         }
 
         _registry.on_construct<Camera>().connect<&SceneImpl::on_camera_constructed>(*this);
@@ -37,6 +37,7 @@ namespace star {
     void SceneImpl::on_camera_constructed(EntityRegistry &registry, const Entity entity) const {
         if (_app) {
             const auto &cam = registry.get<Camera>(entity);
+            cam.get_impl()->set_entity(entity);
             cam.get_impl()->init(_scene, *_app);
         }
     }
@@ -67,8 +68,10 @@ namespace star {
         }
     }
 
-    void SceneImpl::update(const float delta_time) const {
+    void SceneImpl::update(const float delta_time) {
+        // the editor keeps moving entities while the scene is paused, and the renderers cull with these bounds
         if (_paused) {
+            update_world_bounds();
             return;
         }
 
@@ -84,16 +87,30 @@ namespace star {
         if (_delegate) {
             _delegate->on_scene_updated(delta_time);
         }
+
+        update_world_bounds();
     }
 
-    bgfx::ViewId SceneImpl::render_reset(bgfx::ViewId view_id) {
-        _view_id = view_id;
+    void SceneImpl::update_world_bounds() {
+        for (const auto entity: _registry.view<MeshRenderer>()) {
+            const Mesh *mesh = _registry.get<MeshRenderer>(entity).get_mesh();
+            if (!mesh) {
+                continue;
+            }
 
-        for (auto &component: _components) {
-            _view_id = component->render_reset(_view_id);
+            auto &bounds = _registry.get_or_emplace<WorldBounds>(entity);
+            bounds.update(_registry.try_get<Transform>(entity), mesh->get_aabb(), mesh->get_bounding_sphere());
+        }
+    }
+
+    void SceneImpl::render_reset(RenderChain &chain) {
+        for (const auto entity: _registry.view<Camera>()) {
+            _registry.get<Camera>(entity).render_reset(chain);
         }
 
-        return _view_id;
+        for (auto &component: _components) {
+            component->render_reset(chain);
+        }
     }
 
     void SceneImpl::set_paused(bool paused) {
@@ -190,14 +207,6 @@ namespace star {
         return _registry;
     }
 
-    void SceneImpl::set_view_id(bgfx::ViewId view_id) {
-        _view_id = view_id;
-    }
-
-    bgfx::ViewId SceneImpl::get_view_id() const {
-        return _view_id;
-    }
-
     std::string SceneImpl::to_string() const {
         return "Scene(" + _name + ")";
     }
@@ -223,8 +232,8 @@ namespace star {
         _impl->update(delta_time);
     }
 
-    bgfx::ViewId Scene::render_reset(bgfx::ViewId view_id) {
-        return _impl->render_reset(view_id);
+    void Scene::render_reset(RenderChain &chain) {
+        _impl->render_reset(chain);
     }
 
     void Scene::set_paused(bool paused) const {
@@ -309,6 +318,12 @@ namespace star {
         _app = nullptr;
     }
 
+    void SceneAppComponent::render_reset(RenderChain &chain) {
+        if (_auto_render_reset) {
+            _scene->render_reset(chain);
+        }
+    }
+
     Scene *SceneAppComponent::get_scene() {
         return _scene.get();
     }
@@ -148,8 +148,13 @@ namespace star {
         return rotated_vector * inv_scale;
     }
 
-    void Transform::mark_dirty() const {
+    uint32_t Transform::get_version() const {
+        return _version;
+    }
+
+    void Transform::mark_dirty() {
         _matrix_dirty = true;
+        ++_version;
     }
 
     void Transform::update_matrices() const {
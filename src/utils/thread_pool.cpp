@@ -0,0 +1,107 @@
+#include "star/core/common.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <latch>
+
+namespace star {
+    ThreadPool::ThreadPool(size_t thread_count) {
+        if (thread_count == 0) {
+            thread_count = std::max<size_t>(1, get_hardware_thread_count() - 1);
+        }
+
+        _threads.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            _threads.emplace_back(&ThreadPool::worker_loop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(_mutex);
+            _stopping = true;
+        }
+        _task_available.notify_all();
+
+        for (auto &thread: _threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+    }
+
+    size_t ThreadPool::get_thread_count() const {
+        return _threads.size();
+    }
+
+    void ThreadPool::submit(Task &&task) {
+        {
+            std::lock_guard lock(_mutex);
+            _tasks.push_back(std::move(task));
+        }
+        _task_available.notify_one();
+    }
+
+    void ThreadPool::parallel_for(const size_t job_count, const std::function<void(size_t)> &job) {
+        if (job_count == 0) {
+            return;
+        }
+
+        std::atomic<size_t> next_job{0};
+        const auto run_jobs = [&next_job, &job, job_count] {
+            for (size_t i = next_job++; i < job_count; i = next_job++) {
+                job(i);
+            }
+        };
+
+        const size_t helper_count = std::min(job_count - 1, _threads.size());
+        std::latch helpers_done(static_cast<std::ptrdiff_t>(helper_count));
+
+        for (size_t i = 0; i < helper_count; ++i) {
+            submit([&run_jobs, &helpers_done] {
+                run_jobs();
+                helpers_done.count_down();
+            });
+        }
+
+        run_jobs();
+        helpers_done.wait();
+    }
+
+    void ThreadPool::wait_idle() {
+        std::unique_lock lock(_mutex);
+        _idle.wait(lock, [this] { return _tasks.empty() && _active_tasks == 0; });
+    }
+
+    size_t ThreadPool::get_hardware_thread_count() {
+        return std::max<size_t>(1, std::thread::hardware_concurrency());
+    }
+
+    void ThreadPool::worker_loop() {
+        while (true) {
+            Task task;
+            {
+                std::unique_lock lock(_mutex);
+                _task_available.wait(lock, [this] { return _stopping || !_tasks.empty(); });
+
+                if (_stopping && _tasks.empty()) {
+                    return;
+                }
+
+                task = std::move(_tasks.front());
+                _tasks.pop_front();
+                ++_active_tasks;
+            }
+
+            task();
+            // whatever the task captured is released before wait_idle may return
+            task = nullptr;
+
+            {
+                std::lock_guard lock(_mutex);
+                --_active_tasks;
+                if (_tasks.empty() && _active_tasks == 0) {
+                    _idle.notify_all();
+                }
+            }
+        }
+    }
+}
@@ -1,5 +0,0 @@
-#include <catch2/catch_test_macros.hpp>
-
-TEST_CASE("Test", "[core]") {
-    REQUIRE(1 + 1 == 2);
-}
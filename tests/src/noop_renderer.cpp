@@ -0,0 +1,41 @@
+#include "star/render/mesh.hpp"
+#include "star/render/shader_registry.hpp"
+#include <bgfx/bgfx.h>
+#include <catch2/reporters/catch_reporter_event_listener.hpp>
+#include <catch2/reporters/catch_reporter_registrars.hpp>
+
+namespace star {
+    namespace {
+        // meshes and uniforms are created through bgfx, the Noop renderer hands out handles without a window
+        class NoopRendererListener final : public Catch::EventListenerBase {
+        public:
+            using EventListenerBase::EventListenerBase;
+
+            void testRunStarting(const Catch::TestRunInfo &) override {
+                bgfx::Init init;
+                init.type = bgfx::RendererType::Noop;
+                init.resolution.width = 320;
+                init.resolution.height = 192;
+                init.resolution.reset = BGFX_RESET_NONE;
+
+                _initialized = bgfx::init(init);
+                if (_initialized) {
+                    Vertex::init();
+                }
+            }
+
+            void testRunEnded(const Catch::TestRunStats &) override {
+                if (_initialized) {
+                    ShaderRegistry::get().shutdown();
+                    bgfx::shutdown();
+                    _initialized = false;
+                }
+            }
+
+        private:
+            bool _initialized{false};
+        };
+    }
+}
+
+CATCH_REGISTER_LISTENER(star::NoopRendererListener)
@@ -0,0 +1,105 @@
+#include "star/render/draw_bucket.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace star {
+    namespace {
+        // the order of the indices add handed out once the bucket is sorted
+        std::vector<uint32_t> sorted_order(const std::vector<uint64_t> &keys) {
+            DrawBucket bucket;
+            for (const uint64_t key: keys) {
+                bucket.add(key, {});
+            }
+            bucket.sort();
+
+            std::vector<uint32_t> order;
+            for (const auto &item: bucket.get_items()) {
+                order.push_back(item.index);
+            }
+            return order;
+        }
+    }
+
+    TEST_CASE("DrawKey sorts opaque draws front to back inside a material", "[render][draw_bucket]") {
+        const uint32_t material = DrawKey::make_material_key(0, 3, 7);
+
+        const std::vector keys{
+            DrawKey::make_opaque(0, material, 1, 0.9f),
+            DrawKey::make_opaque(0, material, 1, 0.1f),
+            DrawKey::make_opaque(0, material, 1, 0.5f),
+        };
+        CHECK(sorted_order(keys) == std::vector<uint32_t>{1, 2, 0});
+
+        // the program groups draws before their depth does
+        const uint32_t other_program = DrawKey::make_material_key(0, 2, 7);
+        CHECK(DrawKey::make_opaque(0, other_program, 1, 0.9f) < DrawKey::make_opaque(0, material, 1, 0.1f));
+    }
+
+    TEST_CASE("DrawKey sorts translucent draws back to front", "[render][draw_bucket]") {
+        const uint32_t material = DrawKey::make_material_key(1, 3, 7);
+
+        const std::vector keys{
+            DrawKey::make_translucent(0, material, 1, 0.1f),
+            DrawKey::make_translucent(0, material, 1, 0.9f),
+            DrawKey::make_translucent(0, DrawKey::make_material_key(1, 0, 0), 1, 0.5f),
+        };
+        CHECK(sorted_order(keys) == std::vector<uint32_t>{1, 2, 0});
+        CHECK(DrawKey::is_translucent(keys[0]));
+    }
+
+    TEST_CASE("DrawKey orders by layer, then translucency, then program", "[render][draw_bucket]") {
+        const uint32_t first_program = DrawKey::make_material_key(0, 0, 0);
+        const uint32_t last_program = DrawKey::make_material_key(0, (1u << DrawKey::k_program_bits) - 1,
+                                                                 (1u << DrawKey::k_material_bits) - 1);
+
+        const uint64_t translucent = DrawKey::make_translucent(0, first_program, 0, 0.0f);
+        const uint64_t next_layer = DrawKey::make_opaque(1, first_program, 0, 0.0f);
+        CHECK(translucent < next_layer);
+
+        const uint64_t opaque = DrawKey::make_opaque(0, last_program, 1, 1.0f);
+        CHECK_FALSE(DrawKey::is_translucent(opaque));
+        CHECK(opaque < DrawKey::make_translucent(0, first_program, 0, 1.0f));
+    }
+
+    TEST_CASE("DrawBucket keeps the add order of equal keys", "[render][draw_bucket]") {
+        const uint64_t low = DrawKey::make_opaque(0, DrawKey::make_material_key(0, 1, 1), 1, 0.25f);
+        const uint64_t high = DrawKey::make_opaque(2, DrawKey::make_material_key(0, 1, 1), 1, 0.25f);
+
+        CHECK(sorted_order({high, low, high, low, low, high}) == std::vector<uint32_t>{1, 3, 4, 0, 2, 5});
+        // every key equal, every pass is skipped
+        CHECK(sorted_order({low, low, low}) == std::vector<uint32_t>{0, 1, 2});
+    }
+
+    TEST_CASE("DrawBucket sorts like std::stable_sort", "[render][draw_bucket]") {
+        std::mt19937_64 random(1234);
+        // few distinct values per byte so equal digits and equal keys both turn up
+        std::uniform_int_distribution<uint64_t> digit(0, 3);
+
+        for (const size_t count: {2, 17, 256, 4096}) {
+            DrawBucket bucket;
+            std::vector<DrawItem> expected;
+            for (size_t i = 0; i < count; ++i) {
+                uint64_t key = random();
+                // mix in keys whose low bytes repeat
+                if (i % 3 == 0) {
+                    key = (key & 0xFFFF000000000000) | digit(random) << 8;
+                }
+
+                expected.push_back({key, static_cast<uint32_t>(i)});
+                bucket.add(key, {});
+            }
+
+            bucket.sort();
+            std::ranges::stable_sort(expected, {}, &DrawItem::key);
+
+            const auto items = bucket.get_items();
+            REQUIRE(items.size() == expected.size());
+            for (size_t i = 0; i < items.size(); ++i) {
+                CHECK(items[i].key == expected[i].key);
+                CHECK(items[i].index == expected[i].index);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "star/render/encoder_state.hpp"
+#include "star/render/mesh.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+
+namespace star {
+    namespace {
+        // a triangle, a white texel and two samplers, enough for the encoder to bind
+        struct DrawResources {
+            bgfx::VertexBufferHandle vertices{BGFX_INVALID_HANDLE};
+            bgfx::IndexBufferHandle indices{BGFX_INVALID_HANDLE};
+            bgfx::TextureHandle texture{BGFX_INVALID_HANDLE};
+            std::array<bgfx::UniformHandle, 2> samplers{};
+
+            DrawResources() {
+                const std::array<Vertex, 3> triangle{};
+                const std::array<uint16_t, 3> triangle_indices{0, 1, 2};
+                constexpr uint32_t white = 0xffffffff;
+
+                vertices = bgfx::createVertexBuffer(bgfx::copy(triangle.data(), sizeof(triangle)),
+                                                    Vertex::get_layout(VertexFormat::Standard));
+                indices = bgfx::createIndexBuffer(bgfx::copy(triangle_indices.data(), sizeof(triangle_indices)));
+                texture = bgfx::createTexture2D(1, 1, false, 1, bgfx::TextureFormat::RGBA8, BGFX_TEXTURE_NONE,
+                                                bgfx::copy(&white, sizeof(white)));
+                samplers[0] = bgfx::createUniform("s_encoderStateTest0", bgfx::UniformType::Sampler);
+                samplers[1] = bgfx::createUniform("s_encoderStateTest1", bgfx::UniformType::Sampler);
+            }
+
+            ~DrawResources() {
+                bgfx::destroy(vertices);
+                bgfx::destroy(indices);
+                bgfx::destroy(texture);
+                for (const bgfx::UniformHandle sampler: samplers) {
+                    bgfx::destroy(sampler);
+                }
+            }
+
+            void draw(EncoderState &state, const uint8_t textures, const bool indexed = true) const {
+                state.set_vertex_buffer(0, vertices);
+                if (indexed) {
+                    state.set_index_buffer(indices);
+                }
+                for (uint8_t stage = 0; stage < textures; ++stage) {
+                    state.set_texture(stage, samplers[stage], texture);
+                }
+                state.set_state(BGFX_STATE_DEFAULT);
+                state.submit(0, BGFX_INVALID_HANDLE);
+            }
+        };
+    }
+
+    TEST_CASE("EncoderState skips the bindings the encoder still holds", "[render][encoder_state]") {
+        DrawResources resources;
+        bgfx::Encoder *encoder = bgfx::begin();
+        REQUIRE(encoder);
+
+        {
+            EncoderState state(*encoder);
+
+            resources.draw(state, 1);
+            CHECK(state.get_stats().issued == 4);
+            CHECK(state.get_stats().skipped == 0);
+
+            // the buffers and the texture stay bound, the state was discarded with the submit
+            resources.draw(state, 1);
+            CHECK(state.get_stats().issued == 5);
+            CHECK(state.get_stats().skipped == 3);
+
+            // the texture the draw does not ask for is cleared
+            resources.draw(state, 0);
+            CHECK(state.get_stats().issued == 7);
+            CHECK(state.get_stats().skipped == 5);
+            CHECK(state.get_stats().submits == 3);
+
+            // nothing is skipped after a reset
+            state.reset();
+            resources.draw(state, 1);
+            CHECK(state.get_stats().issued == 11);
+            CHECK(state.get_stats().skipped == 5);
+        }
+
+        bgfx::end(encoder);
+        bgfx::frame();
+    }
+
+    TEST_CASE("EncoderState issues a binding that changed", "[render][encoder_state]") {
+        DrawResources resources;
+        bgfx::Encoder *encoder = bgfx::begin();
+        REQUIRE(encoder);
+
+        {
+            EncoderState state(*encoder);
+            resources.draw(state, 0);
+
+            state.set_vertex_buffer(0, resources.vertices, 1);
+            state.set_index_buffer(resources.indices, 0, 3);
+            state.set_index_buffer(resources.indices, 0, 3);
+            CHECK(state.get_stats().issued == 5);
+            CHECK(state.get_stats().skipped == 1);
+        }
+
+        bgfx::end(encoder);
+        bgfx::frame();
+    }
+
+    TEST_CASE("EncoderState drops the buffers and textures a draw no longer uses", "[render][encoder_state]") {
+        DrawResources resources;
+        bgfx::Encoder *encoder = bgfx::begin();
+        REQUIRE(encoder);
+
+        {
+            EncoderState state(*encoder);
+
+            resources.draw(state, 2);
+            CHECK(state.get_stats().issued == 5);
+
+            // the index buffer goes through a discard that also takes the vertex stream, which is bound again.
+            // Both samplers stay valid while their textures are cleared
+            resources.draw(state, 0, false);
+            CHECK(state.get_stats().issued == 10);
+            CHECK(state.get_stats().skipped == 1);
+
+            // the vertex stream is still tracked, the index buffer and the textures are bound again
+            resources.draw(state, 2);
+            CHECK(state.get_stats().issued == 14);
+            CHECK(state.get_stats().skipped == 2);
+            CHECK(state.get_stats().submits == 3);
+        }
+
+        bgfx::end(encoder);
+        bgfx::frame();
+    }
+}
@@ -0,0 +1,98 @@
+#include "star/scene/bounds.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
+
+namespace star {
+    namespace {
+        // looking down -z from the origin, 60 degrees wide, 0.5 to 50 deep
+        Frustum make_frustum() {
+            const glm::mat4 projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.5f, 50.0f);
+            const glm::mat4 view = glm::lookAt(glm::vec3(0.0f), glm::vec3(0.0f, 0.0f, -1.0f),
+                                               glm::vec3(0.0f, 1.0f, 0.0f));
+            return Frustum::from_matrix(projection * view);
+        }
+
+        // a count that is no multiple of the SIMD width, so the scalar tail runs as well
+        constexpr size_t k_volume_count = 203;
+
+        // spread around the frustum on an uneven grid, so that no volume sits exactly on a plane
+        glm::vec3 volume_center(const size_t i) {
+            return {
+                static_cast<float>(i % 7) * 7.31f - 21.9f,
+                static_cast<float>(i / 7 % 5) * 5.17f - 10.3f,
+                static_cast<float>(i / 35) * -11.43f + 9.7f
+            };
+        }
+    }
+
+    TEST_CASE("Frustum culls spheres like the single sphere test", "[render][frustum]") {
+        const Frustum frustum = make_frustum();
+
+        std::vector<BoundingSphere> spheres(k_volume_count);
+        for (size_t i = 0; i < spheres.size(); ++i) {
+            spheres[i] = {volume_center(i), 0.4f + static_cast<float>(i % 3) * 1.3f};
+        }
+
+        for (const uint32_t plane_count: {static_cast<uint32_t>(Frustum::Count), 4u}) {
+            std::vector<uint8_t> visible(spheres.size(), 2);
+            const size_t visible_count = frustum.cull(spheres, visible, plane_count);
+
+            size_t expected_count = 0;
+            for (size_t i = 0; i < spheres.size(); ++i) {
+                const bool expected = frustum.intersects(spheres[i], plane_count);
+                expected_count += expected ? 1 : 0;
+                CHECK(visible[i] == (expected ? 1 : 0));
+            }
+
+            CHECK(visible_count == expected_count);
+            CHECK(visible_count > 0);
+            CHECK(visible_count < spheres.size());
+        }
+    }
+
+    TEST_CASE("Frustum culls boxes like the single box test", "[render][frustum]") {
+        const Frustum frustum = make_frustum();
+
+        std::vector<Aabb> aabbs(k_volume_count);
+        for (size_t i = 0; i < aabbs.size(); ++i) {
+            const glm::vec3 extents(0.3f + static_cast<float>(i % 4) * 0.9f, 0.7f, 0.5f + static_cast<float>(i % 3));
+            aabbs[i] = {volume_center(i) - extents, volume_center(i) + extents};
+        }
+
+        for (const uint32_t plane_count: {static_cast<uint32_t>(Frustum::Count), 4u}) {
+            std::vector<uint8_t> visible(aabbs.size(), 2);
+            const size_t visible_count = frustum.cull(aabbs, visible, plane_count);
+
+            size_t expected_count = 0;
+            for (size_t i = 0; i < aabbs.size(); ++i) {
+                const bool expected = frustum.intersects(aabbs[i], plane_count);
+                expected_count += expected ? 1 : 0;
+                CHECK(visible[i] == (expected ? 1 : 0));
+            }
+
+            CHECK(visible_count == expected_count);
+            CHECK(visible_count > 0);
+            CHECK(visible_count < aabbs.size());
+        }
+    }
+
+    TEST_CASE("Frustum keeps what is in front and drops what is behind", "[render][frustum]") {
+        const Frustum frustum = make_frustum();
+
+        const std::vector<BoundingSphere> spheres{
+            {{0.0f, 0.0f, -10.0f}, 1.0f},
+            {{0.0f, 0.0f, 10.0f}, 1.0f},
+            {{0.0f, 0.0f, -60.0f}, 1.0f},
+            {{0.0f, 0.0f, -50.5f}, 1.0f},
+        };
+
+        std::vector<uint8_t> visible(spheres.size());
+        CHECK(frustum.cull(spheres, visible) == 2);
+        CHECK(visible == std::vector<uint8_t>{1, 0, 0, 1});
+
+        // without the near and far planes the distance no longer matters
+        CHECK(frustum.cull(spheres, visible, 4) == 3);
+        CHECK(visible == std::vector<uint8_t>{1, 0, 1, 1});
+    }
+}
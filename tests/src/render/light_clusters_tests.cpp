@@ -0,0 +1,154 @@
+#include "star/render/light_clusters.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/scene/transform.hpp"
+#include "star/utils/thread_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace star {
+    namespace {
+        // 4x4 tiles and 8 slices between 0.1 and 100, slice 5 covers view depths of about 7.5 to 17.8
+        LightClusterSettings make_settings() {
+            LightClusterSettings settings;
+            settings.clusters_x = 4;
+            settings.clusters_y = 4;
+            settings.clusters_z = 8;
+            settings.max_lights = 64;
+            return settings;
+        }
+
+        constexpr float k_near = 0.1f;
+        constexpr float k_far = 100.0f;
+
+        // the camera sits at the origin and looks down -z, so the view matrix is the identity
+        glm::mat4 make_projection() {
+            return glm::perspective(glm::radians(60.0f), 1.0f, k_near, k_far);
+        }
+
+        Entity add_light(EntityRegistry &registry, const LightType type, const glm::vec3 &position,
+                         const float range) {
+            const Entity entity = registry.create();
+            auto &light = registry.emplace<Light>(entity);
+            light.set_type(type);
+            light.set_range(range);
+            registry.emplace<Transform>(entity, position);
+            return entity;
+        }
+
+        uint32_t total_cluster_lights(const LightClusters &clusters) {
+            const auto &settings = clusters.get_settings();
+            uint32_t total = 0;
+            for (uint32_t z = 0; z < settings.clusters_z; ++z) {
+                for (uint32_t y = 0; y < settings.clusters_y; ++y) {
+                    for (uint32_t x = 0; x < settings.clusters_x; ++x) {
+                        total += clusters.get_cluster_light_count(x, y, z);
+                    }
+                }
+            }
+            return total;
+        }
+    }
+
+    TEST_CASE("LightClusters assigns a point light to the froxels it touches", "[render][light_clusters]") {
+        LightClusters clusters;
+        REQUIRE(clusters.init(make_settings()));
+
+        EntityRegistry registry;
+        add_light(registry, LightType::Point, {0.0f, 0.0f, -10.0f}, 0.5f);
+        clusters.collect(registry);
+        clusters.build(glm::mat4(1.0f), make_projection(), k_near, k_far);
+
+        CHECK(clusters.get_light_count() == 1);
+        CHECK(clusters.get_directional_light_count() == 0);
+
+        // the light sits on the corner the four middle tiles share
+        CHECK(clusters.get_cluster_light_count(1, 1, 5) == 1);
+        CHECK(clusters.get_cluster_light_count(2, 1, 5) == 1);
+        CHECK(clusters.get_cluster_light_count(1, 2, 5) == 1);
+        CHECK(clusters.get_cluster_light_count(2, 2, 5) == 1);
+
+        // neither the outer tiles nor the slices in front or behind it
+        CHECK(clusters.get_cluster_light_count(0, 0, 5) == 0);
+        CHECK(clusters.get_cluster_light_count(3, 3, 5) == 0);
+        CHECK(clusters.get_cluster_light_count(1, 1, 4) == 0);
+        CHECK(clusters.get_cluster_light_count(1, 1, 6) == 0);
+
+        CHECK(clusters.get_index_count() == total_cluster_lights(clusters));
+        clusters.shutdown();
+    }
+
+    TEST_CASE("LightClusters leaves lights outside the view and directional lights unassigned",
+              "[render][light_clusters]") {
+        LightClusters clusters;
+        REQUIRE(clusters.init(make_settings()));
+
+        EntityRegistry registry;
+        add_light(registry, LightType::Point, {0.0f, 0.0f, 10.0f}, 2.0f);
+        add_light(registry, LightType::Point, {0.0f, 0.0f, -150.0f}, 2.0f);
+        add_light(registry, LightType::Directional, {0.0f, 0.0f, -10.0f}, 0.0f);
+
+        // a disabled light and one without a range never reach the clusters
+        const Entity disabled = add_light(registry, LightType::Point, {0.0f, 0.0f, -10.0f}, 2.0f);
+        registry.get<Light>(disabled).set_enabled(false);
+        add_light(registry, LightType::Point, {0.0f, 0.0f, -10.0f}, 0.0f);
+
+        clusters.collect(registry);
+        clusters.build(glm::mat4(1.0f), make_projection(), k_near, k_far);
+
+        CHECK(clusters.get_light_count() == 3);
+        CHECK(clusters.get_directional_light_count() == 1);
+        CHECK(clusters.get_index_count() == 0);
+        CHECK(total_cluster_lights(clusters) == 0);
+        clusters.shutdown();
+    }
+
+    TEST_CASE("LightClusters assigns the same lights with and without the thread pool", "[render][light_clusters]") {
+        LightClusters clusters;
+        REQUIRE(clusters.init(make_settings()));
+
+        EntityRegistry registry;
+        for (uint32_t i = 0; i < 40; ++i) {
+            const glm::vec3 position(static_cast<float>(i % 5) * 3.1f - 6.2f, static_cast<float>(i % 3) * 2.3f - 2.3f,
+                                     -1.0f - static_cast<float>(i) * 1.7f);
+            const Entity entity = add_light(registry, i % 4 == 0 ? LightType::Spot : LightType::Point, position,
+                                            1.0f + static_cast<float>(i % 4));
+            registry.get<Light>(entity).set_outer_angle(25.0f);
+        }
+
+        const auto &settings = clusters.get_settings();
+        const size_t cluster_count = static_cast<size_t>(settings.clusters_x) * settings.clusters_y *
+                                     settings.clusters_z;
+
+        clusters.collect(registry);
+        clusters.build(glm::mat4(1.0f), make_projection(), k_near, k_far);
+
+        std::vector<uint32_t> serial;
+        serial.reserve(cluster_count);
+        for (uint32_t z = 0; z < settings.clusters_z; ++z) {
+            for (uint32_t y = 0; y < settings.clusters_y; ++y) {
+                for (uint32_t x = 0; x < settings.clusters_x; ++x) {
+                    serial.push_back(clusters.get_cluster_light_count(x, y, z));
+                }
+            }
+        }
+        const uint32_t serial_index_count = clusters.get_index_count();
+        CHECK(serial_index_count > 0);
+
+        ThreadPool pool(3);
+        clusters.build(glm::mat4(1.0f), make_projection(), k_near, k_far, &pool);
+
+        std::vector<uint32_t> parallel;
+        parallel.reserve(cluster_count);
+        for (uint32_t z = 0; z < settings.clusters_z; ++z) {
+            for (uint32_t y = 0; y < settings.clusters_y; ++y) {
+                for (uint32_t x = 0; x < settings.clusters_x; ++x) {
+                    parallel.push_back(clusters.get_cluster_light_count(x, y, z));
+                }
+            }
+        }
+
+        CHECK(clusters.get_index_count() == serial_index_count);
+        CHECK(parallel == serial);
+        clusters.shutdown();
+    }
+}
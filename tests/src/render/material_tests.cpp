@@ -0,0 +1,163 @@
+#include "star/render/material.hpp"
+#include "star/render/shader_registry.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <vector>
+
+namespace star {
+    namespace {
+        struct Visited {
+            uint16_t handle{0};
+            float first{0.0f};
+            uint16_t count{0};
+
+            bool operator==(const Visited &other) const = default;
+        };
+
+        // what apply would upload, in upload order
+        std::vector<Visited> visit(const MaterialParameterBlock &block, const MaterialParameterBlock *overrides) {
+            std::vector<Visited> visited;
+            block.for_each(overrides, [&](const bgfx::UniformHandle handle, const float *data, const uint16_t count) {
+                visited.push_back({handle.idx, data[0], count});
+            });
+            return visited;
+        }
+
+        bool set_vec4(MaterialParameterBlock &block, const uint16_t handle, const float value) {
+            const glm::vec4 data(value);
+            return block.set(bgfx::UniformHandle{handle}, bgfx::UniformType::Vec4, &data.x);
+        }
+    }
+
+    TEST_CASE("MaterialParameterBlock keeps its values sorted by handle", "[render][material]") {
+        MaterialParameterBlock block;
+        CHECK(set_vec4(block, 7, 1.0f));
+        CHECK(set_vec4(block, 2, 2.0f));
+        CHECK(set_vec4(block, 5, 3.0f));
+        CHECK(block.get_size() == 3);
+
+        CHECK(visit(block, nullptr) == std::vector<Visited>{{2, 2.0f, 1}, {5, 3.0f, 1}, {7, 1.0f, 1}});
+
+        // a second set replaces the value in place
+        CHECK(set_vec4(block, 5, 4.0f));
+        CHECK(block.get_size() == 3);
+        CHECK(block.get(bgfx::UniformHandle{5})[0] == 4.0f);
+
+        // a different size moves the value, the others keep theirs
+        const glm::mat4 matrix(6.0f);
+        CHECK(block.set(bgfx::UniformHandle{2}, bgfx::UniformType::Mat4, &matrix[0].x));
+        CHECK(block.get(bgfx::UniformHandle{2})[0] == 6.0f);
+        CHECK(block.get(bgfx::UniformHandle{5})[0] == 4.0f);
+        CHECK(block.get(bgfx::UniformHandle{7})[0] == 1.0f);
+
+        block.remove(bgfx::UniformHandle{5});
+        CHECK_FALSE(block.has(bgfx::UniformHandle{5}));
+        CHECK(block.get(bgfx::UniformHandle{5}) == nullptr);
+        CHECK(block.get(bgfx::UniformHandle{7})[0] == 1.0f);
+
+        block.clear();
+        CHECK(block.empty());
+    }
+
+    TEST_CASE("MaterialParameterBlock refuses values it cannot upload", "[render][material]") {
+        MaterialParameterBlock block;
+        const glm::vec4 value(1.0f);
+        CHECK_FALSE(block.set(bgfx::UniformHandle BGFX_INVALID_HANDLE, bgfx::UniformType::Vec4, &value.x));
+        CHECK_FALSE(block.set(bgfx::UniformHandle{1}, bgfx::UniformType::Vec4, nullptr));
+        CHECK_FALSE(block.set(bgfx::UniformHandle{1}, bgfx::UniformType::Sampler, &value.x));
+        CHECK(block.empty());
+    }
+
+    TEST_CASE("MaterialParameterBlock merges overrides once per uniform", "[render][material]") {
+        MaterialParameterBlock base;
+        set_vec4(base, 1, 1.0f);
+        set_vec4(base, 3, 3.0f);
+        set_vec4(base, 5, 5.0f);
+
+        MaterialParameterBlock overrides;
+        set_vec4(overrides, 0, 10.0f);
+        set_vec4(overrides, 3, 30.0f);
+        set_vec4(overrides, 6, 60.0f);
+
+        CHECK(visit(base, &overrides) == std::vector<Visited>{
+            {0, 10.0f, 1}, {1, 1.0f, 1}, {3, 30.0f, 1}, {5, 5.0f, 1}, {6, 60.0f, 1}
+        });
+
+        // empty sides fall back to the other block
+        const MaterialParameterBlock empty;
+        CHECK(visit(base, &empty) == visit(base, nullptr));
+        CHECK(visit(empty, &overrides) == visit(overrides, nullptr));
+    }
+
+    TEST_CASE("MaterialInstance overrides the uniforms of its parent", "[render][material]") {
+        const bgfx::UniformHandle color = ShaderRegistry::get().get_uniform("u_color", bgfx::UniformType::Vec4).handle;
+        const bgfx::UniformHandle emissive =
+                ShaderRegistry::get().get_uniform("u_emissive", bgfx::UniformType::Vec4).handle;
+
+        const auto parent = std::make_shared<UnlitMaterial>();
+        REQUIRE(parent->set_uniform(k_uniform_emissive, glm::vec4(0.5f)));
+        parent->set_color(glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+
+        const auto instance = std::make_shared<MaterialInstance>(parent);
+        CHECK(instance->get_parameters().empty());
+        CHECK(&instance->get_batch_material() == parent.get());
+        CHECK(instance->get_batch_color() == glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+
+        // a color override still batches with the parent and leaves the parent alone
+        REQUIRE(instance->set_uniform(k_uniform_color, glm::vec4(0.0f, 1.0f, 0.0f, 1.0f)));
+        CHECK(&instance->get_batch_material() == parent.get());
+        CHECK(instance->get_batch_color() == glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+        CHECK(parent->get_parameters().get(color)[0] == 1.0f);
+
+        std::vector<Visited> merged = visit(parent->get_parameters(), &instance->get_parameters());
+        CHECK(merged.size() == 2);
+        CHECK(std::ranges::find(merged, Visited{color.idx, 0.0f, 1}) != merged.end());
+        CHECK(std::ranges::find(merged, Visited{emissive.idx, 0.5f, 1}) != merged.end());
+
+        // any other override makes the instance a material of its own
+        REQUIRE(instance->set_uniform(k_uniform_emissive, glm::vec4(0.25f)));
+        CHECK(&instance->get_batch_material() == instance.get());
+
+        merged = visit(parent->get_parameters(), &instance->get_parameters());
+        CHECK(std::ranges::find(merged, Visited{emissive.idx, 0.25f, 1}) != merged.end());
+
+        // an instance of the instance starts from its overrides and shares its parent
+        const MaterialInstance nested(instance);
+        CHECK(nested.get_parent() == parent);
+        CHECK(nested.get_batch_color() == glm::vec4(0.0f, 1.0f, 0.0f, 1.0f));
+        CHECK(nested.get_parameters().get(emissive)[0] == 0.25f);
+
+        instance->clear_overrides();
+        CHECK(&instance->get_batch_material() == parent.get());
+        CHECK(instance->get_batch_color() == glm::vec4(1.0f, 0.0f, 0.0f, 1.0f));
+        CHECK(nested.get_parameters().get_size() == 2);
+    }
+
+    TEST_CASE("MaterialInstance carries its texture overrides to nested instances", "[render][material]") {
+        const auto parent = std::make_shared<UnlitMaterial>();
+        const auto instance = std::make_shared<MaterialInstance>(parent);
+
+        // a texture override alone keeps the instance out of its parent's batches
+        REQUIRE(instance->set_texture(k_sampler_color, bgfx::TextureHandle{1}));
+        CHECK(instance->get_parameters().empty());
+        CHECK(&instance->get_batch_material() == instance.get());
+
+        const MaterialInstance nested(instance);
+        CHECK(nested.get_parent() == parent);
+        CHECK(&nested.get_batch_material() == &nested);
+
+        // clearing drops the textures as well, the nested copy keeps its own
+        instance->clear_overrides();
+        CHECK(&instance->get_batch_material() == parent.get());
+        CHECK(&nested.get_batch_material() == &nested);
+    }
+
+    TEST_CASE("MaterialInstance without a parent draws nothing", "[render][material]") {
+        const MaterialInstance orphan(nullptr);
+        CHECK(orphan.get_parent() == nullptr);
+        CHECK(orphan.get_type() == MaterialType::Custom);
+        CHECK_FALSE(orphan.has_shader(ShaderVariant::Default));
+        CHECK(&orphan.get_batch_material() == &orphan);
+        CHECK(orphan.get_batch_color() == glm::vec4(1.0f));
+    }
+}
@@ -0,0 +1,64 @@
+#include "star/render/mesh_cache.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace star {
+    TEST_CASE("MeshCache shares one mesh per primitive and parameters", "[render][mesh_cache]") {
+        MeshCache cache;
+
+        const auto cube = cache.get_cube(2.0f);
+        REQUIRE(cube);
+        CHECK(cube->is_valid());
+        CHECK(cache.get_cube(2.0f) == cube);
+        CHECK(cache.get_size() == 1);
+
+        CHECK(cache.get_cube(3.0f) != cube);
+        CHECK(cache.get_sphere(2.0f, 8) != cache.get_sphere(2.0f, 12));
+        CHECK(cache.get_size() == 4);
+
+        // the build options are part of the key
+        const auto kept = cache.get_cube(2.0f, {.keep_cpu_data = true});
+        CHECK(kept != cube);
+        CHECK(kept->has_cpu_data());
+        CHECK(cache.get_cube(2.0f, {.optimize = true}) != cube);
+        CHECK(cache.get_cube(2.0f, {.format = VertexFormat::Half}) != cube);
+
+        cache.clear();
+        bgfx::frame();
+    }
+
+    TEST_CASE("MeshCache treats -0 and 0 as the same size", "[render][mesh_cache]") {
+        const MeshCacheKey zero{MeshPrimitive::Cube, glm::vec2(1.0f, 0.0f), 0, {}};
+        const MeshCacheKey negative_zero{MeshPrimitive::Cube, glm::vec2(1.0f, -0.0f), 0, {}};
+        REQUIRE(zero == negative_zero);
+        CHECK(MeshCacheKeyHash{}(zero) == MeshCacheKeyHash{}(negative_zero));
+
+        MeshCache cache;
+        const auto mesh = cache.get(negative_zero);
+        CHECK(cache.get(zero) == mesh);
+        CHECK(cache.get_cube(1.0f) == mesh);
+        CHECK(cache.get_size() == 1);
+
+        cache.clear();
+        bgfx::frame();
+    }
+
+    TEST_CASE("MeshCache only evicts the meshes nobody else holds", "[render][mesh_cache]") {
+        MeshCache cache;
+
+        auto held = cache.get_cube(1.0f);
+        cache.get_plane(1.0f, 2.0f);
+        cache.get_sphere(1.0f);
+        REQUIRE(cache.get_size() == 3);
+
+        CHECK(cache.evict_unused() == 2);
+        CHECK(cache.get_size() == 1);
+        CHECK(cache.get_cube(1.0f) == held);
+
+        // update evicts as well once the last outside reference is gone
+        held.reset();
+        cache.update(0.0f);
+        CHECK(cache.get_size() == 0);
+
+        bgfx::frame();
+    }
+}
@@ -0,0 +1,74 @@
+#include "star/render/renderer_components.hpp"
+#include "star/scene/camera.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+namespace star {
+    namespace {
+        // three levels handing over at half, a quarter and a tenth of the viewport height
+        MeshRenderer make_lod_renderer() {
+            MeshRenderer renderer;
+            renderer.set_lods({
+                {std::make_shared<Mesh>(), 0.1f},
+                {std::make_shared<Mesh>(), 0.5f},
+                {std::make_shared<Mesh>(), 0.25f},
+            });
+            return renderer;
+        }
+    }
+
+    TEST_CASE("MeshRenderer sorts its levels from the largest screen size down", "[render][lod]") {
+        const MeshRenderer renderer = make_lod_renderer();
+
+        REQUIRE(renderer.get_lod_count() == 3);
+        CHECK(renderer.get_lods()[0].screen_size == 0.5f);
+        CHECK(renderer.get_lods()[1].screen_size == 0.25f);
+        CHECK(renderer.get_lods()[2].screen_size == 0.1f);
+        CHECK(renderer.get_mesh() == renderer.get_lod_mesh(0));
+        CHECK(renderer.get_lod_mesh(3) == nullptr);
+    }
+
+    TEST_CASE("MeshRenderer picks the level of the screen size", "[render][lod]") {
+        const MeshRenderer renderer = make_lod_renderer();
+
+        CHECK(renderer.select_lod(2.0f) == 0);
+        CHECK(renderer.select_lod(0.5f) == 0);
+        CHECK(renderer.select_lod(0.3f) == 1);
+        CHECK(renderer.select_lod(0.15f) == 2);
+        // smaller than the last threshold, not drawn at all
+        CHECK(renderer.select_lod(0.05f) == renderer.get_lod_count());
+    }
+
+    TEST_CASE("MeshRenderer keeps its level inside the hysteresis margin", "[render][lod]") {
+        MeshRenderer renderer = make_lod_renderer();
+        renderer.set_lod_hysteresis(0.1f);
+
+        // shrinking below a threshold by less than the margin keeps the finer level
+        CHECK(renderer.select_lod(0.47f, 0) == 0);
+        CHECK(renderer.select_lod(0.44f, 0) == 1);
+
+        // growing past a threshold by less than the margin keeps the coarser level
+        CHECK(renderer.select_lod(0.52f, 1) == 1);
+        CHECK(renderer.select_lod(0.56f, 1) == 0);
+
+        // a jump across several levels is not held back by the one it came from
+        CHECK(renderer.select_lod(0.05f, 0) == renderer.get_lod_count());
+        CHECK(renderer.select_lod(0.6f, renderer.get_lod_count()) == 0);
+    }
+
+    TEST_CASE("Camera measures the screen size of a sphere", "[render][lod]") {
+        // a 90 degree field of view covers twice the distance, the size is the radius over the distance
+        Camera camera;
+        camera.set_perspective(90.0f, 0.1f, 100.0f);
+
+        CHECK(std::abs(camera.get_screen_size({{0.0f, 0.0f, -10.0f}, 1.0f}) - 0.1f) < 1e-5f);
+        CHECK(std::abs(camera.get_screen_size({{3.0f, 0.0f, -5.0f}, 1.0f}) - 0.2f) < 1e-5f);
+
+        // a sphere around the camera fills the view
+        CHECK(camera.get_screen_size({{0.0f, 0.0f, -0.5f}, 1.0f}) > 1.0f);
+
+        const MeshRenderer renderer = make_lod_renderer();
+        CHECK(renderer.select_lod(camera.get_screen_size({{0.0f, 0.0f, -3.0f}, 1.0f})) == 1);
+        CHECK(renderer.select_lod(camera.get_screen_size({{0.0f, 0.0f, -50.0f}, 1.0f})) == renderer.get_lod_count());
+    }
+}
@@ -0,0 +1,93 @@
+#include "star/render/mesh_optimizer.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <array>
+
+namespace star {
+    namespace {
+        // a grid of quads in row order, the cache reuses little of it
+        void make_grid(const uint16_t size, std::vector<Vertex> &vertices, std::vector<uint16_t> &indices) {
+            for (uint16_t y = 0; y <= size; ++y) {
+                for (uint16_t x = 0; x <= size; ++x) {
+                    Vertex vertex{};
+                    vertex.position = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f);
+                    vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                    vertices.push_back(vertex);
+                }
+            }
+
+            const uint16_t stride = size + 1;
+            for (uint16_t y = 0; y < size; ++y) {
+                for (uint16_t x = 0; x < size; ++x) {
+                    const auto corner = static_cast<uint16_t>(y * stride + x);
+                    indices.insert(indices.end(), {
+                                       corner, static_cast<uint16_t>(corner + 1),
+                                       static_cast<uint16_t>(corner + stride),
+                                       static_cast<uint16_t>(corner + 1), static_cast<uint16_t>(corner + stride + 1),
+                                       static_cast<uint16_t>(corner + stride)
+                                   });
+                }
+            }
+        }
+    }
+
+    TEST_CASE("MeshOptimizer leaves indices past the vertices unchanged", "[render][mesh]") {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        make_grid(4, vertices, indices);
+        indices[7] = static_cast<uint16_t>(vertices.size());
+        const auto original = indices;
+
+        std::vector<uint32_t> clusters{5};
+        MeshOptimizer::optimize_vertex_cache(indices, vertices.size(), &clusters);
+        CHECK(indices == original);
+        CHECK(clusters.empty());
+
+        MeshOptimizer::optimize_overdraw(indices, vertices, {0, 4});
+        CHECK(indices == original);
+
+        const auto vertex_count = vertices.size();
+        MeshOptimizer::optimize(vertices, indices);
+        CHECK(indices == original);
+        CHECK(vertices.size() == vertex_count);
+    }
+
+    TEST_CASE("MeshOptimizer leaves partial triangles unchanged", "[render][mesh]") {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        make_grid(4, vertices, indices);
+        indices.pop_back();
+        const auto original = indices;
+
+        MeshOptimizer::optimize_vertex_cache(indices, vertices.size());
+        CHECK(indices == original);
+
+        MeshOptimizer::optimize_overdraw(indices, vertices, {});
+        CHECK(indices == original);
+    }
+
+    TEST_CASE("MeshOptimizer keeps the triangles of a valid mesh", "[render][mesh]") {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        make_grid(16, vertices, indices);
+        const auto original = indices;
+
+        MeshOptimizer::optimize_vertex_cache(indices, vertices.size());
+        REQUIRE(indices.size() == original.size());
+        CHECK(MeshOptimizer::compute_acmr(indices, vertices.size()) <=
+              MeshOptimizer::compute_acmr(original, vertices.size()));
+
+        // the same triangles in another order, each one keeps its winding
+        const auto sorted_triangles = [](const std::vector<uint16_t> &list) {
+            std::vector<std::array<uint16_t, 3> > triangles;
+            for (size_t i = 0; i < list.size(); i += 3) {
+                std::array triangle{list[i], list[i + 1], list[i + 2]};
+                std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+                triangles.push_back(triangle);
+            }
+            std::ranges::sort(triangles);
+            return triangles;
+        };
+        CHECK(sorted_triangles(indices) == sorted_triangles(original));
+    }
+}
@@ -0,0 +1,97 @@
+#include "star/render/mesh_simplifier.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cmath>
+
+namespace star {
+    namespace {
+        // a flat unit square split into size by size quads, every edge on its outline is an open border
+        void make_plane(const uint16_t size, std::vector<Vertex> &vertices, std::vector<uint16_t> &indices) {
+            for (uint16_t y = 0; y <= size; ++y) {
+                for (uint16_t x = 0; x <= size; ++x) {
+                    Vertex vertex{};
+                    vertex.position = glm::vec3(static_cast<float>(x), static_cast<float>(y), 0.0f) /
+                                      static_cast<float>(size);
+                    vertex.normal = glm::vec3(0.0f, 0.0f, 1.0f);
+                    vertices.push_back(vertex);
+                }
+            }
+
+            const uint16_t stride = size + 1;
+            for (uint16_t y = 0; y < size; ++y) {
+                for (uint16_t x = 0; x < size; ++x) {
+                    const auto corner = static_cast<uint16_t>(y * stride + x);
+                    indices.insert(indices.end(), {
+                                       corner, static_cast<uint16_t>(corner + 1),
+                                       static_cast<uint16_t>(corner + stride),
+                                       static_cast<uint16_t>(corner + 1), static_cast<uint16_t>(corner + stride + 1),
+                                       static_cast<uint16_t>(corner + stride)
+                                   });
+                }
+            }
+        }
+
+        float covered_area(const std::vector<Vertex> &vertices, const std::vector<uint16_t> &indices) {
+            float area = 0.0f;
+            for (size_t t = 0; t + 2 < indices.size(); t += 3) {
+                const glm::vec3 &a = vertices[indices[t + 0]].position;
+                const glm::vec3 &b = vertices[indices[t + 1]].position;
+                const glm::vec3 &c = vertices[indices[t + 2]].position;
+                area += glm::cross(b - a, c - a).z * 0.5f;
+            }
+            return area;
+        }
+
+        bool uses_vertex(const std::vector<uint16_t> &indices, const uint16_t vertex) {
+            return std::ranges::find(indices, vertex) != indices.end();
+        }
+    }
+
+    TEST_CASE("MeshSimplifier keeps the outline of an open mesh", "[render][simplifier]") {
+        constexpr uint16_t size = 8;
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        make_plane(size, vertices, indices);
+
+        float error = -1.0f;
+        const auto simplified = MeshSimplifier::simplify(vertices, indices, 6, 0.01f, &error);
+
+        REQUIRE(simplified.size() % 3 == 0);
+        CHECK(simplified.size() < indices.size() / 2);
+        CHECK(error >= 0.0f);
+        CHECK(error <= 0.01f);
+
+        // the corners hold the border planes of two edges, none of them may move
+        constexpr uint16_t stride = size + 1;
+        CHECK(uses_vertex(simplified, 0));
+        CHECK(uses_vertex(simplified, size));
+        CHECK(uses_vertex(simplified, size * stride));
+        CHECK(uses_vertex(simplified, size * stride + size));
+
+        // no border vertex was pulled inwards, so the square is still covered without holes or folds
+        CHECK(std::abs(covered_area(vertices, simplified) - 1.0f) < 1e-4f);
+        for (size_t t = 0; t < simplified.size(); t += 3) {
+            const glm::vec3 &a = vertices[simplified[t + 0]].position;
+            const glm::vec3 &b = vertices[simplified[t + 1]].position;
+            const glm::vec3 &c = vertices[simplified[t + 2]].position;
+            CHECK(glm::cross(b - a, c - a).z > 0.0f);
+        }
+    }
+
+    TEST_CASE("MeshSimplifier keeps a feature past the error limit", "[render][simplifier]") {
+        std::vector<Vertex> vertices;
+        std::vector<uint16_t> indices;
+        make_plane(4, vertices, indices);
+
+        // the middle lifted half the width, collapsing it anywhere would flatten the tip
+        constexpr uint16_t tip = 2 * 5 + 2;
+        vertices[tip].position.z = 0.5f;
+
+        float error = -1.0f;
+        const auto simplified = MeshSimplifier::simplify(vertices, indices, 6, 0.01f, &error);
+
+        CHECK(simplified.size() < indices.size());
+        CHECK(error <= 0.01f);
+        CHECK(uses_vertex(simplified, tip));
+    }
+}
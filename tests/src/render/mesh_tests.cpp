@@ -0,0 +1,219 @@
+#include "star/render/mesh.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <bx/math.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace star {
+    namespace {
+        Vertex make_vertex(const glm::vec3 &position, const glm::vec3 &normal) {
+            return {position, normal, glm::vec2(0.25f, 0.75f), glm::vec4(1.0f)};
+        }
+
+        // a lopsided box of points with normals all around, so every axis and octahedron face is covered
+        std::vector<Vertex> make_points() {
+            std::vector<Vertex> vertices;
+            for (int i = 0; i < 64; ++i) {
+                const float t = static_cast<float>(i) / 63.0f;
+                const glm::vec3 position(-3.0f + 8.0f * t, 1.0f + std::sin(t * 7.0f), -0.5f + t * t);
+                const glm::vec3 normal = glm::normalize(glm::vec3(std::cos(t * 11.0f), std::sin(t * 5.0f),
+                                                                  std::cos(t * 3.0f) - 0.4f));
+                vertices.push_back(make_vertex(position, normal));
+            }
+            return vertices;
+        }
+
+        glm::vec3 decode_position(const PackedVertex &packed, const VertexFormat format) {
+            glm::vec3 position;
+            for (int i = 0; i < 3; ++i) {
+                position[i] = format == VertexFormat::Quantized
+                                  ? std::max(static_cast<float>(static_cast<int16_t>(packed.position[i])) / 32767.0f,
+                                             -1.0f)
+                                  : bx::halfToFloat(packed.position[i]);
+            }
+            return position;
+        }
+
+        // the inverse of the octahedral mapping the packed vertex shaders run
+        glm::vec3 decode_normal(const PackedVertex &packed) {
+            const glm::vec2 encoded(static_cast<float>(packed.normal[0]) / 32767.0f,
+                                    static_cast<float>(packed.normal[1]) / 32767.0f);
+            glm::vec3 normal(encoded, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+            if (normal.z < 0.0f) {
+                normal.x = (1.0f - std::abs(encoded.y)) * (encoded.x >= 0.0f ? 1.0f : -1.0f);
+                normal.y = (1.0f - std::abs(encoded.x)) * (encoded.y >= 0.0f ? 1.0f : -1.0f);
+            }
+            return glm::normalize(normal);
+        }
+
+        // packs like Mesh::create did, then maps the stored positions back through the mesh's matrix
+        float get_max_position_error(const Mesh &mesh, const std::vector<Vertex> &vertices) {
+            const glm::mat4 dequantization = mesh.get_dequantization_matrix();
+            const glm::vec4 packing(glm::vec3(dequantization[3]), dequantization[0][0]);
+
+            float error = 0.0f;
+            for (const auto &vertex: vertices) {
+                const PackedVertex packed = PackedVertex::pack(vertex, mesh.get_vertex_format(), packing);
+                const glm::vec3 position(dequantization *
+                                         glm::vec4(decode_position(packed, mesh.get_vertex_format()), 1.0f));
+                error = std::max(error, glm::length(position - vertex.position));
+            }
+            return error;
+        }
+    }
+
+    TEST_CASE("Quantized vertices dequantize within half a step of the bounds", "[render][mesh]") {
+        const auto vertices = make_points();
+        Mesh mesh;
+        REQUIRE(mesh.create(vertices, {.format = VertexFormat::Quantized}));
+        REQUIRE(mesh.get_vertex_format() == VertexFormat::Quantized);
+
+        // half a snorm16 step of the largest extent, on each of the three axes
+        const glm::vec3 extents = mesh.get_aabb().get_extents();
+        const float step = std::max({extents.x, extents.y, extents.z}) / 32767.0f;
+        CHECK(get_max_position_error(mesh, vertices) <= std::sqrt(3.0f) * 0.5f * step + 1e-6f);
+
+        // octahedral snorm16 normals keep their direction to a small fraction of a degree
+        for (const auto &vertex: vertices) {
+            const PackedVertex packed = PackedVertex::pack(vertex, VertexFormat::Quantized, glm::vec4(1.0f));
+            CHECK(glm::dot(decode_normal(packed), vertex.normal) > 0.99999f);
+        }
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("Half vertices dequantize within the half precision of their offset", "[render][mesh]") {
+        const auto vertices = make_points();
+        Mesh mesh;
+        REQUIRE(mesh.create(vertices, {.format = VertexFormat::Half}));
+        REQUIRE(mesh.get_vertex_format() == VertexFormat::Half);
+
+        // stored relative to the center without scaling, 11 significant bits of the largest offset
+        const glm::mat4 dequantization = mesh.get_dequantization_matrix();
+        CHECK(dequantization[0][0] == 1.0f);
+        CHECK(glm::vec3(dequantization[3]) == mesh.get_aabb().get_center());
+
+        const float offset = glm::length(mesh.get_aabb().get_extents());
+        CHECK(get_max_position_error(mesh, vertices) <= offset * std::ldexp(1.0f, -11) + 1e-6f);
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("Auto picks Quantized unless the bounds are a single point", "[render][mesh]") {
+        // flat along one axis still has extents to quantize against
+        const std::vector flat{
+            make_vertex({0.0f, 0.0f, 2.0f}, {0.0f, 0.0f, 1.0f}),
+            make_vertex({1.0f, 0.0f, 2.0f}, {0.0f, 0.0f, 1.0f}),
+            make_vertex({0.0f, 1.0f, 2.0f}, {0.0f, 0.0f, 1.0f}),
+        };
+        Mesh plane;
+        REQUIRE(plane.create(flat, {.format = VertexFormat::Auto}));
+        CHECK(plane.get_vertex_format() == VertexFormat::Quantized);
+        CHECK(get_max_position_error(plane, flat) < 1e-4f);
+
+        // a single point has none, the scale would divide by zero, so it falls back to Half
+        const std::vector point(3, make_vertex({4.0f, -2.0f, 1.0f}, {0.0f, 1.0f, 0.0f}));
+        Mesh degenerate;
+        REQUIRE(degenerate.create(point, {.format = VertexFormat::Auto}));
+        CHECK(degenerate.get_vertex_format() == VertexFormat::Half);
+        CHECK(degenerate.get_dequantization_matrix()[0][0] == 1.0f);
+        CHECK(get_max_position_error(degenerate, point) == 0.0f);
+
+        // the Standard format keeps floats and an identity matrix
+        Mesh standard;
+        REQUIRE(standard.create(flat));
+        CHECK(standard.get_vertex_format() == VertexFormat::Standard);
+        CHECK(standard.get_dequantization_matrix() == glm::mat4(1.0f));
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("DynamicMesh grows the drawn range and the bounds with every update", "[render][mesh]") {
+        DynamicMesh mesh;
+        REQUIRE(mesh.create(8, 0));
+        CHECK(mesh.get_vertex_count() == 0);
+
+        const std::vector first{
+            make_vertex({0.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}),
+            make_vertex({1.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}),
+        };
+        REQUIRE(mesh.update_vertices(0, first));
+        CHECK(mesh.get_vertex_count() == 2);
+        CHECK(mesh.get_aabb().min == glm::vec3(0.0f));
+        CHECK(mesh.get_aabb().max == glm::vec3(1.0f, 1.0f, 0.0f));
+
+        // an update past the end extends the range over the gap, the bounds only take the written vertices
+        const std::vector later{
+            make_vertex({-2.0f, 0.5f, 3.0f}, {0.0f, 0.0f, 1.0f}),
+            make_vertex({0.5f, 4.0f, -1.0f}, {0.0f, 0.0f, 1.0f}),
+        };
+        REQUIRE(mesh.update_vertices(10, later));
+        CHECK(mesh.get_vertex_count() == 12);
+        CHECK(mesh.get_aabb().min == glm::vec3(-2.0f, 0.0f, -1.0f));
+        CHECK(mesh.get_aabb().max == glm::vec3(1.0f, 4.0f, 3.0f));
+
+        // rewriting inside the range keeps the count and never shrinks the bounds
+        REQUIRE(mesh.update_vertices(1, first));
+        CHECK(mesh.get_vertex_count() == 12);
+        CHECK(mesh.get_aabb().min == glm::vec3(-2.0f, 0.0f, -1.0f));
+        CHECK(mesh.get_aabb().max == glm::vec3(1.0f, 4.0f, 3.0f));
+
+        // the first index update creates the buffer the capacity left out
+        const std::vector<uint16_t> indices{0, 1, 10, 1, 11, 10};
+        REQUIRE(mesh.update_indices(0, indices));
+        CHECK(mesh.get_index_count() == 6);
+
+        // the draw counts move freely, the bounds stay until replaced
+        mesh.set_draw_counts(4, 3);
+        CHECK(mesh.get_vertex_count() == 4);
+        CHECK(mesh.get_index_count() == 3);
+        CHECK(mesh.get_aabb().max == glm::vec3(1.0f, 4.0f, 3.0f));
+
+        mesh.set_bounds({glm::vec3(0.0f), glm::vec3(1.0f)});
+        CHECK(mesh.get_aabb().max == glm::vec3(1.0f));
+        CHECK(mesh.get_bounding_sphere().center == glm::vec3(0.5f));
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("DynamicMesh without indices draws no index range", "[render][mesh]") {
+        DynamicMesh mesh;
+        CHECK_FALSE(mesh.update_vertices(0, make_points()));
+
+        REQUIRE(mesh.create(make_points(), {}));
+        CHECK(mesh.get_vertex_count() == 64);
+        mesh.set_draw_counts(32, 12);
+        CHECK(mesh.get_vertex_count() == 32);
+        CHECK(mesh.get_index_count() == 0);
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("TransientMesh stops being valid once its frame is submitted", "[render][mesh]") {
+        // the other tests submit frames without reporting them
+        TransientMesh::end_frame(bgfx::frame());
+
+        const auto vertices = make_points();
+        const std::vector<uint16_t> indices{0, 1, 2, 2, 1, 3};
+
+        TransientMesh mesh;
+        CHECK_FALSE(mesh.is_valid());
+        REQUIRE(mesh.update(vertices, indices));
+        CHECK(mesh.is_valid());
+        CHECK(mesh.get_vertex_count() == 64);
+        CHECK(mesh.get_index_count() == 6);
+
+        TransientMesh::end_frame(bgfx::frame());
+        CHECK_FALSE(mesh.is_valid());
+
+        // filled again in the next frame it is valid until that one ends
+        REQUIRE(mesh.update(vertices));
+        CHECK(mesh.is_valid());
+        CHECK(mesh.get_index_count() == 0);
+        mesh.clear();
+        CHECK_FALSE(mesh.is_valid());
+
+        TransientMesh::end_frame(bgfx::frame());
+    }
+}
@@ -0,0 +1,83 @@
+#include "star/render/occlusion_culler.hpp"
+#include "star/render/mesh.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace star {
+    namespace {
+        // the camera sits at the origin looking down -z, the occluder is a 4 unit cube spanning z -3 to -7
+        const glm::mat4 k_view_projection = glm::perspective(glm::radians(60.0f), 320.0f / 192.0f, 0.1f, 100.0f);
+        const glm::mat4 k_occluder_model = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 0.0f, -5.0f));
+
+        Aabb make_box(const glm::vec3 &center, const glm::vec3 &extents) {
+            return {center - extents, center + extents};
+        }
+
+        struct OccluderScene {
+            OcclusionCuller culler;
+            Mesh occluder;
+
+            OccluderScene()
+                : occluder(Mesh::create_cube(4.0f, {.keep_cpu_data = true})) {
+                REQUIRE(culler.init());
+                REQUIRE(occluder.has_cpu_data());
+
+                culler.begin(k_view_projection);
+                REQUIRE(culler.add_occluder(occluder, k_occluder_model));
+                culler.rasterize();
+            }
+        };
+    }
+
+    TEST_CASE("OcclusionCuller hides a box behind an occluder", "[render][occlusion]") {
+        OccluderScene scene;
+
+        CHECK(scene.culler.get_triangle_count() > 0);
+        CHECK(scene.culler.get_depth(scene.culler.get_width() / 2, scene.culler.get_height() / 2) < 1.0f);
+
+        CHECK_FALSE(scene.culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(1.0f))));
+        // the same box in front of the occluder
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -1.5f), glm::vec3(0.2f))));
+
+        const Aabb boxes[] = {
+            make_box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(1.0f)),
+            make_box(glm::vec3(0.0f, 0.0f, -1.5f), glm::vec3(0.2f)),
+        };
+        uint8_t visible[] = {1, 1};
+        CHECK(scene.culler.cull(boxes, visible) == 1);
+        CHECK(visible[0] == 0);
+        CHECK(visible[1] == 1);
+    }
+
+    TEST_CASE("OcclusionCuller keeps a partially covered box visible", "[render][occlusion]") {
+        OccluderScene scene;
+
+        // the near face of the occluder covers |x| < 2 / 3 of the depth, the box reaches past that on the right
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(14.0f, 0.0f, -20.0f), glm::vec3(2.0f, 1.0f, 1.0f))));
+        // and fully past it
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(16.0f, 0.0f, -20.0f), glm::vec3(1.0f))));
+        // while the same box well inside the silhouette is hidden
+        CHECK_FALSE(scene.culler.is_visible(make_box(glm::vec3(5.0f, 0.0f, -20.0f), glm::vec3(1.0f))));
+    }
+
+    TEST_CASE("OcclusionCuller keeps boxes crossing the near plane visible", "[render][occlusion]") {
+        OccluderScene scene;
+
+        // reaches from in front of the occluder through the near plane and behind the camera
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -2.0f), glm::vec3(0.5f, 0.5f, 2.5f))));
+        // mostly behind the occluder, only its near end is in front of it
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -15.0f), glm::vec3(0.5f, 0.5f, 15.05f))));
+        // straddles the near plane only
+        CHECK(scene.culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -0.1f), glm::vec3(0.5f, 0.5f, 0.05f))));
+    }
+
+    TEST_CASE("OcclusionCuller draws everything without occluders", "[render][occlusion]") {
+        OcclusionCuller culler;
+        REQUIRE(culler.init());
+
+        culler.begin(k_view_projection);
+        culler.rasterize();
+
+        CHECK(culler.is_visible(make_box(glm::vec3(0.0f, 0.0f, -20.0f), glm::vec3(1.0f))));
+    }
+}
@@ -0,0 +1,186 @@
+#include "star/render/render_chain.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace star {
+    namespace {
+        const glm::uvec2 k_backbuffer_size{320, 192};
+
+        // a pass creating every texture of creates, reading reads and writing the created ones and writes
+        void add_pass(RenderChain &chain, const std::string &name, std::vector<std::string> creates,
+                      std::vector<std::string> reads, std::vector<std::string> writes,
+                      const RenderTargetDesc &desc = {}, const uint16_t clear_flags = BGFX_CLEAR_COLOR) {
+            chain.add_pass(name, [=](RenderPassBuilder &builder) {
+                for (const auto &texture: creates) {
+                    builder.create(texture, desc);
+                }
+                for (const auto &texture: reads) {
+                    builder.read(texture);
+                }
+                for (const auto &texture: creates) {
+                    builder.write(texture);
+                }
+                for (const auto &texture: writes) {
+                    builder.write(texture);
+                }
+                builder.set_clear(clear_flags);
+            }, [](const RenderPassContext &) {
+            });
+        }
+    }
+
+    TEST_CASE("RenderChain culls the passes nothing depends on", "[render][render_chain]") {
+        RenderChain chain;
+        add_pass(chain, "scene", {"color"}, {}, {});
+        add_pass(chain, "unused", {"debug"}, {}, {});
+        add_pass(chain, "present", {}, {"color"}, {RenderChain::k_backbuffer});
+
+        const bgfx::ViewId end = chain.compile(1, k_backbuffer_size);
+
+        CHECK(end == 3);
+        CHECK(chain.get_stats().culled_pass_count == 1);
+        CHECK(chain.is_pass_culled("unused"));
+        CHECK_FALSE(chain.get_view_id("unused").has_value());
+        CHECK(chain.get_view_id("scene") == bgfx::ViewId{1});
+        CHECK(chain.get_view_id("present") == bgfx::ViewId{2});
+
+        // the culled pass's texture is never allocated
+        CHECK(chain.get_stats().transient_count == 1);
+        CHECK(chain.get_stats().texture_count == 1);
+        CHECK_FALSE(bgfx::isValid(chain.get_texture("debug")));
+    }
+
+    TEST_CASE("RenderChain keeps passes with side effects and passes writing imports", "[render][render_chain]") {
+        RenderChain chain;
+        chain.import_texture("readback", BGFX_INVALID_HANDLE, {});
+        add_pass(chain, "export", {}, {}, {"readback"});
+        chain.add_pass("capture", [](RenderPassBuilder &builder) {
+            builder.create("scratch", {});
+            builder.write("scratch");
+            builder.set_side_effect();
+        }, [](const RenderPassContext &) {
+        });
+
+        chain.compile(0, k_backbuffer_size);
+
+        CHECK(chain.get_stats().culled_pass_count == 0);
+        CHECK_FALSE(chain.is_pass_culled("export"));
+        CHECK_FALSE(chain.is_pass_culled("capture"));
+    }
+
+    TEST_CASE("RenderChain keeps the earlier writer of an attachment that is not cleared", "[render][render_chain]") {
+        SECTION("loaded") {
+            RenderChain chain;
+            add_pass(chain, "opaque", {"color"}, {}, {});
+            add_pass(chain, "translucent", {}, {}, {"color"}, {}, BGFX_CLEAR_NONE);
+            add_pass(chain, "present", {}, {"color"}, {RenderChain::k_backbuffer});
+
+            chain.compile(0, k_backbuffer_size);
+            CHECK(chain.get_stats().culled_pass_count == 0);
+        }
+
+        SECTION("cleared") {
+            RenderChain chain;
+            add_pass(chain, "opaque", {"color"}, {}, {});
+            add_pass(chain, "overwrite", {}, {}, {"color"});
+            add_pass(chain, "present", {}, {"color"}, {RenderChain::k_backbuffer});
+
+            chain.compile(0, k_backbuffer_size);
+            CHECK(chain.is_pass_culled("opaque"));
+            CHECK_FALSE(chain.is_pass_culled("overwrite"));
+        }
+    }
+
+    TEST_CASE("RenderChain shares textures between transients that are never alive together",
+              "[render][render_chain]") {
+        RenderChain chain;
+        // a lives in passes 0-1, b in 1-2 and c in 2-3, so only a and c can share
+        add_pass(chain, "first", {"a"}, {}, {});
+        add_pass(chain, "second", {"b"}, {"a"}, {});
+        add_pass(chain, "third", {"c"}, {"b"}, {});
+        add_pass(chain, "present", {}, {"c"}, {RenderChain::k_backbuffer});
+
+        chain.compile(0, k_backbuffer_size);
+
+        CHECK(chain.get_stats().transient_count == 3);
+        CHECK(chain.get_stats().texture_count == 2);
+
+        const bgfx::TextureHandle a = chain.get_texture("a");
+        const bgfx::TextureHandle b = chain.get_texture("b");
+        const bgfx::TextureHandle c = chain.get_texture("c");
+        REQUIRE(bgfx::isValid(a));
+        REQUIRE(bgfx::isValid(b));
+        CHECK(a.idx == c.idx);
+        CHECK(a.idx != b.idx);
+    }
+
+    TEST_CASE("RenderChain does not share textures with another description", "[render][render_chain]") {
+        RenderChain chain;
+        add_pass(chain, "first", {"a"}, {}, {});
+        add_pass(chain, "second", {"b"}, {"a"}, {});
+        add_pass(chain, "third", {"c"}, {"b"}, {}, RenderTargetDesc{.scale = glm::vec2(0.5f)});
+        add_pass(chain, "present", {}, {"c"}, {RenderChain::k_backbuffer});
+
+        chain.compile(0, k_backbuffer_size);
+
+        CHECK(chain.get_stats().transient_count == 3);
+        CHECK(chain.get_stats().texture_count == 3);
+        CHECK(chain.get_texture("a").idx != chain.get_texture("c").idx);
+    }
+
+    TEST_CASE("RenderChain only rebuilds the passes of textures following the backbuffer", "[render][render_chain]") {
+        RenderChain chain;
+        add_pass(chain, "fixed", {"lut"}, {}, {}, RenderTargetDesc{.width = 32, .height = 32});
+        add_pass(chain, "scene", {"color"}, {"lut"}, {});
+        add_pass(chain, "present", {}, {"color"}, {RenderChain::k_backbuffer});
+
+        chain.compile(0, k_backbuffer_size);
+        const bgfx::TextureHandle lut = chain.get_texture("lut");
+
+        chain.compile(0, k_backbuffer_size * 2u);
+
+        // scene attaches the resized color, present draws into the backbuffer
+        CHECK(chain.get_stats().rebuilt_pass_count == 1);
+        CHECK(chain.get_texture("lut").idx == lut.idx);
+    }
+
+    TEST_CASE("RenderChain gives the views the ids in front of the passes", "[render][render_chain]") {
+        RenderChain chain;
+        std::vector<bgfx::ViewId> configured;
+        const auto record = [&configured](const bgfx::ViewId view_id) { configured.push_back(view_id); };
+
+        const int camera = 0;
+        const int overlay = 0;
+        chain.add_view("camera prepass", &camera, record);
+        chain.add_view("camera", &camera, record);
+        chain.add_view("overlay", &overlay, record);
+        add_pass(chain, "present", {}, {}, {RenderChain::k_backbuffer});
+
+        CHECK(chain.compile(1, k_backbuffer_size) == 5);
+        CHECK(configured == std::vector<bgfx::ViewId>{1, 2, 3});
+        CHECK(chain.get_view_id("present") == bgfx::ViewId{4});
+        CHECK(chain.get_stats().view_count == 3);
+
+        // views keeping their id are left alone
+        configured.clear();
+        chain.invalidate();
+        chain.compile(1, k_backbuffer_size);
+        CHECK(configured.empty());
+        CHECK(chain.get_stats().configured_view_count == 0);
+
+        // the views after the removed ones move up and are configured again
+        chain.remove_views(&camera);
+        CHECK(chain.is_dirty());
+        CHECK(chain.compile(1, k_backbuffer_size) == 3);
+        CHECK(configured == std::vector<bgfx::ViewId>{1});
+        CHECK(chain.get_view_id("present") == bgfx::ViewId{2});
+
+        // a resize configures every view again
+        configured.clear();
+        chain.compile(1, k_backbuffer_size * 2u);
+        CHECK(configured == std::vector<bgfx::ViewId>{1});
+
+        chain.clear_views();
+        CHECK(chain.compile(1, k_backbuffer_size * 2u) == 2);
+        CHECK(chain.get_stats().view_count == 0);
+    }
+}
@@ -0,0 +1,90 @@
+#include "star/render/render_target_pool.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace star {
+    namespace {
+        constexpr uint64_t k_flags = BGFX_TEXTURE_RT | BGFX_SAMPLER_UV_CLAMP;
+    }
+
+    TEST_CASE("RenderTargetPool rounds sizes up to the bucket", "[render][render_target_pool]") {
+        CHECK(RenderTargetPool::get_bucket_size({0, 0}) == glm::uvec2(64, 64));
+        CHECK(RenderTargetPool::get_bucket_size({64, 65}) == glm::uvec2(64, 128));
+        CHECK(RenderTargetPool::get_bucket_size({1, 130}) == glm::uvec2(64, 192));
+    }
+
+    TEST_CASE("RenderTargetPool fits smaller sizes of the same formats", "[render][render_target_pool]") {
+        RenderTargetPool pool;
+        const RenderTargetId id = pool.acquire({100, 50});
+        REQUIRE(pool.get(id).is_valid());
+        CHECK(pool.get(id).size == glm::uvec2(128, 64));
+
+        CHECK(pool.fits(id, {100, 50}, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8, k_flags));
+        CHECK(pool.fits(id, {128, 10}, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8, k_flags));
+        CHECK_FALSE(pool.fits(id, {129, 50}, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8, k_flags));
+        CHECK_FALSE(pool.fits(id, {100, 50}, bgfx::TextureFormat::RGBA16F, bgfx::TextureFormat::D24S8, k_flags));
+        CHECK_FALSE(pool.fits(id, {100, 50}, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::Count, k_flags));
+
+        pool.release(id);
+        CHECK_FALSE(pool.fits(id, {100, 50}, bgfx::TextureFormat::RGBA8, bgfx::TextureFormat::D24S8, k_flags));
+
+        pool.shutdown();
+        bgfx::frame();
+    }
+
+    TEST_CASE("RenderTargetPool hands a released target out again from the next frame on",
+              "[render][render_target_pool]") {
+        RenderTargetPool pool;
+        const RenderTargetId first = pool.acquire({256, 256});
+        REQUIRE(first.is_valid());
+        pool.release(first);
+
+        // the GPU may still draw into it this frame
+        const RenderTargetId second = pool.acquire({256, 256});
+        REQUIRE(second.is_valid());
+        CHECK(second.index != first.index);
+        CHECK(pool.get_created_count() == 2);
+
+        pool.update();
+        const RenderTargetId third = pool.acquire({200, 220});
+        CHECK(third.index == first.index);
+        CHECK(pool.get_created_count() == 2);
+        CHECK(pool.get(third).is_valid());
+
+        // the id kept past its release neither reads nor releases the slot's new owner
+        CHECK(third.generation != first.generation);
+        CHECK_FALSE(pool.get(first).is_valid());
+        pool.release(first);
+        CHECK(pool.get(third).is_valid());
+        CHECK(pool.get_free_count() == 0);
+
+        pool.shutdown();
+        bgfx::frame();
+    }
+
+    TEST_CASE("RenderTargetPool destroys targets that sat idle", "[render][render_target_pool]") {
+        RenderTargetPool pool;
+        pool.set_max_idle_frames(2);
+
+        const RenderTargetId id = pool.acquire({64, 64});
+        REQUIRE(id.is_valid());
+        pool.release(id);
+        CHECK(pool.get_free_count() == 1);
+
+        pool.update();
+        pool.update();
+        CHECK(pool.get_target_count() == 1);
+
+        pool.update();
+        CHECK(pool.get_target_count() == 0);
+
+        // the freed slot is reused and the old id stays stale
+        const RenderTargetId reused = pool.acquire({64, 64});
+        CHECK(reused.index == id.index);
+        CHECK(pool.get(reused).is_valid());
+        CHECK_FALSE(pool.get(id).is_valid());
+        CHECK(pool.get_created_count() == 2);
+
+        pool.shutdown();
+        bgfx::frame();
+    }
+}
@@ -0,0 +1,77 @@
+#include "star/render/shader_registry.hpp"
+#include "star/graphics/shaders.hpp"
+#include <catch2/catch_test_macros.hpp>
+
+namespace star {
+    TEST_CASE("ShaderRegistry links the same binaries once", "[render][shader_registry]") {
+        auto &registry = ShaderRegistry::get();
+        const size_t programs = registry.get_program_count();
+
+        Shader first;
+        REQUIRE(first.load(k_simple_vs, k_simple_fs));
+        Shader second;
+        REQUIRE(second.load(k_simple_vs, k_simple_fs));
+        CHECK(second.get_handle().idx == first.get_handle().idx);
+        CHECK(second.get_hash() == first.get_hash());
+        CHECK(registry.get_program_count() == programs + 1);
+
+        // other binaries are a program of their own
+        Shader standard;
+        REQUIRE(standard.load(k_standard_vs, k_standard_fs));
+        CHECK(standard.get_hash() != first.get_hash());
+        CHECK(registry.get_program_count() == programs + 2);
+
+        // the slots are shared by name, every program reads the same handles
+        const ShaderUniform *color = first.get_uniform("u_color");
+        REQUIRE(color);
+        CHECK(standard.get_uniform("u_color")->handle.idx == color->handle.idx);
+        CHECK(registry.get_uniform("u_color", bgfx::UniformType::Vec4).handle.idx == color->handle.idx);
+        REQUIRE(first.get_sampler("s_texNormal"));
+        CHECK(first.get_sampler("s_texNormal")->stage == 1);
+    }
+
+    TEST_CASE("ShaderRegistry releases a program with its last Shader", "[render][shader_registry]") {
+        auto &registry = ShaderRegistry::get();
+        const size_t programs = registry.get_program_count();
+
+        Shader shader;
+        REQUIRE(shader.load(k_simple_vs, k_simple_fs));
+        Shader copy = shader;
+        CHECK(copy.get_handle().idx == shader.get_handle().idx);
+
+        shader.reset();
+        CHECK_FALSE(shader.is_valid());
+        CHECK(copy.is_valid());
+        CHECK(registry.get_program_count() == programs + 1);
+
+        // the copy was the last one, the next load links again
+        copy.reset();
+        CHECK(registry.get_program_count() == programs);
+
+        REQUIRE(shader.load(k_simple_vs, k_simple_fs));
+        CHECK(registry.get_program_count() == programs + 1);
+
+        bgfx::frame();
+    }
+
+    TEST_CASE("ShaderRegistry destroys the programs still referenced at shutdown", "[render][shader_registry]") {
+        auto &registry = ShaderRegistry::get();
+
+        Shader shader;
+        REQUIRE(shader.load(k_simple_vs, k_simple_fs));
+
+        // the Shader outlives the registry's handles, its own release has nothing left to destroy
+        registry.shutdown();
+        CHECK_FALSE(shader.is_valid());
+        CHECK(shader.get_uniform("u_color") == nullptr);
+        CHECK(registry.get_program_count() == 0);
+        CHECK(registry.get_uniform_count() == 0);
+
+        // the registry starts over on the next load
+        Shader again;
+        REQUIRE(again.load(k_simple_vs, k_simple_fs));
+        CHECK(again.get_uniform("u_color") != nullptr);
+
+        bgfx::frame();
+    }
+}
@@ -0,0 +1,232 @@
+#include "star/render/static_batcher.hpp"
+#include "star/app/app.hpp"
+#include "star/render/material.hpp"
+#include "star/scene/transform.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <thread>
+#include <tuple>
+
+namespace star {
+    namespace {
+        constexpr float k_epsilon = 1e-4f;
+
+        bool near(const glm::vec3 &a, const glm::vec3 &b) {
+            return glm::all(glm::lessThan(glm::abs(a - b), glm::vec3(k_epsilon)));
+        }
+
+        bool near(const glm::vec4 &a, const glm::vec4 &b) {
+            return glm::all(glm::lessThan(glm::abs(a - b), glm::vec4(k_epsilon)));
+        }
+
+        Vertex make_vertex(const glm::vec3 &position) {
+            return {position, glm::vec3(0.0f, 0.0f, 1.0f), glm::vec2(0.0f), glm::vec4(0.5f, 0.5f, 0.5f, 1.0f)};
+        }
+
+        // a unit quad in the xy plane facing +z, counter clockwise
+        std::shared_ptr<Mesh> make_quad() {
+            const std::vector vertices{
+                make_vertex({0.0f, 0.0f, 0.0f}), make_vertex({1.0f, 0.0f, 0.0f}),
+                make_vertex({1.0f, 1.0f, 0.0f}), make_vertex({0.0f, 1.0f, 0.0f}),
+            };
+            const std::vector<uint16_t> indices{0, 1, 2, 0, 2, 3};
+
+            auto mesh = std::make_shared<Mesh>();
+            REQUIRE(mesh->create(vertices, indices, {.keep_cpu_data = true}));
+            return mesh;
+        }
+
+        StaticBatcher::Source make_source(std::shared_ptr<Mesh> mesh, std::shared_ptr<Material> material,
+                                          const glm::mat4 &model) {
+            StaticBatcher::Source source;
+            source.mesh = std::move(mesh);
+            source.material = std::move(material);
+            source.model = model;
+            return source;
+        }
+
+        // the corner positions of a triangle, rotated so the smallest comes first without changing the winding
+        using Triangle = std::array<glm::vec3, 3>;
+
+        Triangle canonical(Triangle triangle) {
+            const auto less = [](const glm::vec3 &a, const glm::vec3 &b) {
+                return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z);
+            };
+            std::ranges::rotate(triangle, std::ranges::min_element(triangle, less));
+            return triangle;
+        }
+
+        std::vector<Triangle> get_triangles(const StaticBatcher::BakedGeometry &geometry) {
+            std::vector<Triangle> triangles;
+            for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3) {
+                triangles.push_back(canonical({
+                    geometry.vertices[geometry.indices[i]].position,
+                    geometry.vertices[geometry.indices[i + 1]].position,
+                    geometry.vertices[geometry.indices[i + 2]].position
+                }));
+            }
+            return triangles;
+        }
+
+        bool contains(const std::vector<Triangle> &triangles, const Triangle &triangle) {
+            const Triangle expected = canonical(triangle);
+            return std::ranges::any_of(triangles, [&expected](const Triangle &other) {
+                return near(other[0], expected[0]) && near(other[1], expected[1]) && near(other[2], expected[2]);
+            });
+        }
+
+        // every triangle winds counter clockwise around the normal of its first corner
+        bool is_front_facing(const StaticBatcher::BakedGeometry &geometry) {
+            for (size_t i = 0; i + 2 < geometry.indices.size(); i += 3) {
+                const Vertex &a = geometry.vertices[geometry.indices[i]];
+                const Vertex &b = geometry.vertices[geometry.indices[i + 1]];
+                const Vertex &c = geometry.vertices[geometry.indices[i + 2]];
+                if (glm::dot(glm::cross(b.position - a.position, c.position - a.position), a.normal) <= 0.0f) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void wait_for_bake(const StaticBatcher &batcher) {
+            while (batcher.is_building()) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+
+    TEST_CASE("StaticBatcher bakes the transform and the tint into the vertices", "[render][static_batcher]") {
+        const auto material = std::make_shared<UnlitMaterial>();
+        const glm::mat4 model = glm::rotate(glm::translate(glm::mat4(1.0f), glm::vec3(1.0f, 2.0f, 3.0f)),
+                                            glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)) *
+                                glm::scale(glm::mat4(1.0f), glm::vec3(2.0f));
+
+        auto source = make_source(make_quad(), material, model);
+        source.tint = glm::vec4(1.0f, 0.0f, 0.5f, 1.0f);
+
+        const auto geometry = StaticBatcher::bake({source});
+        REQUIRE(geometry.size() == 1);
+        CHECK(geometry[0].material == material);
+        CHECK(geometry[0].entity_count == 1);
+        REQUIRE(geometry[0].vertices.size() == 4);
+
+        for (const auto &corner: {glm::vec3(0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(1.0f, 1.0f, 0.0f)}) {
+            const glm::vec3 expected(model * glm::vec4(corner, 1.0f));
+            CHECK(std::ranges::any_of(geometry[0].vertices, [&expected](const Vertex &vertex) {
+                return near(vertex.position, expected);
+            }));
+        }
+
+        // the scale does not reach the normal, the rotation does
+        for (const auto &vertex: geometry[0].vertices) {
+            CHECK(near(vertex.normal, glm::vec3(0.0f, -1.0f, 0.0f)));
+            CHECK(near(vertex.color, glm::vec4(0.5f, 0.0f, 0.25f, 1.0f)));
+        }
+    }
+
+    TEST_CASE("StaticBatcher rebases the indices of every source", "[render][static_batcher]") {
+        const auto material = std::make_shared<UnlitMaterial>();
+        const auto quad = make_quad();
+        const glm::mat4 left = glm::translate(glm::mat4(1.0f), glm::vec3(-5.0f, 0.0f, 0.0f));
+        const glm::mat4 right = glm::translate(glm::mat4(1.0f), glm::vec3(5.0f, 0.0f, 0.0f));
+
+        const auto geometry = StaticBatcher::bake({make_source(quad, material, left),
+                                                   make_source(quad, material, right)});
+        REQUIRE(geometry.size() == 1);
+        CHECK(geometry[0].entity_count == 2);
+        CHECK(geometry[0].vertices.size() == 8);
+        REQUIRE(geometry[0].indices.size() == 12);
+        CHECK(std::ranges::all_of(geometry[0].indices, [](const uint16_t index) { return index < 8; }));
+
+        const auto triangles = get_triangles(geometry[0]);
+        for (const glm::vec3 offset: {glm::vec3(-5.0f, 0.0f, 0.0f), glm::vec3(5.0f, 0.0f, 0.0f)}) {
+            CHECK(contains(triangles, {offset, offset + glm::vec3(1.0f, 0.0f, 0.0f),
+                                       offset + glm::vec3(1.0f, 1.0f, 0.0f)}));
+            CHECK(contains(triangles, {offset, offset + glm::vec3(1.0f, 1.0f, 0.0f),
+                                       offset + glm::vec3(0.0f, 1.0f, 0.0f)}));
+        }
+
+        // another material starts a geometry of its own
+        const auto other = std::make_shared<UnlitMaterial>();
+        CHECK(StaticBatcher::bake({make_source(quad, material, left), make_source(quad, other, right)}).size() == 2);
+    }
+
+    TEST_CASE("StaticBatcher keeps mirrored sources front facing", "[render][static_batcher]") {
+        const auto material = std::make_shared<UnlitMaterial>();
+        const glm::mat4 mirror = glm::scale(glm::mat4(1.0f), glm::vec3(-1.0f, 1.0f, 1.0f));
+
+        const auto plain = StaticBatcher::bake({make_source(make_quad(), material, glm::mat4(1.0f))});
+        REQUIRE(plain.size() == 1);
+        CHECK(is_front_facing(plain[0]));
+
+        const auto mirrored = StaticBatcher::bake({make_source(make_quad(), material, mirror)});
+        REQUIRE(mirrored.size() == 1);
+        CHECK(is_front_facing(mirrored[0]));
+        CHECK(contains(get_triangles(mirrored[0]), {
+            glm::vec3(0.0f), glm::vec3(-1.0f, 1.0f, 0.0f), glm::vec3(-1.0f, 0.0f, 0.0f)
+        }));
+    }
+
+    TEST_CASE("StaticBatcher splits a geometry before its indices overflow", "[render][static_batcher]") {
+        const auto material = std::make_shared<UnlitMaterial>();
+
+        // non-indexed, the bake numbers the vertices itself
+        std::vector<Vertex> vertices(39999);
+        for (size_t i = 0; i < vertices.size(); ++i) {
+            vertices[i] = make_vertex({i % 3 == 1 ? 1.0f : 0.0f, static_cast<float>(i / 3 + (i % 3 == 2)), 0.0f});
+        }
+        const auto mesh = std::make_shared<Mesh>();
+        REQUIRE(mesh->create(vertices, {.keep_cpu_data = true}));
+
+        const auto geometry = StaticBatcher::bake({make_source(mesh, material, glm::mat4(1.0f)),
+                                                   make_source(mesh, material, glm::mat4(1.0f))});
+        REQUIRE(geometry.size() == 2);
+        for (const auto &baked: geometry) {
+            CHECK(baked.entity_count == 1);
+            CHECK(baked.vertices.size() == vertices.size());
+            CHECK(baked.indices.size() == vertices.size());
+        }
+    }
+
+    TEST_CASE("StaticBatcher drops a bake the scene changed under", "[render][static_batcher]") {
+        App app;
+        Scene scene;
+        scene.init(app);
+        auto &batcher = scene.add_scene_component<StaticBatcher>();
+
+        const Entity entity = scene.create_entity();
+        scene.add_component<Transform>(entity);
+        scene.add_component<StaticTag>(entity);
+        auto &renderer = scene.add_component<MeshRenderer>(entity);
+        renderer.set_mesh(make_quad());
+        renderer.set_material(std::make_shared<UnlitMaterial>());
+
+        // a change right after the bake started makes its result stale
+        batcher.update(0.0f);
+        batcher.mark_dirty();
+        wait_for_bake(batcher);
+
+        batcher.update(0.0f);
+        CHECK(batcher.get_batches().empty());
+        CHECK_FALSE(scene.has_component<StaticBatched>(entity));
+
+        // the update that dropped it started the next one
+        wait_for_bake(batcher);
+        batcher.update(0.0f);
+        REQUIRE(batcher.get_batches().size() == 1);
+        CHECK(scene.has_component<StaticBatched>(entity));
+
+        // a moved source is baked again
+        scene.get_registry().get<Transform>(entity).set_position(glm::vec3(1.0f));
+        batcher.update(0.0f);
+        wait_for_bake(batcher);
+        batcher.update(0.0f);
+        CHECK(batcher.get_batches().size() == 1);
+
+        scene.shutdown();
+        bgfx::frame();
+    }
+}
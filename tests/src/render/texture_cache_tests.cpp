@@ -0,0 +1,131 @@
+#include "star/render/texture.hpp"
+#include "star/app/app.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <filesystem>
+#include <fstream>
+
+namespace star {
+    namespace {
+        // a white 4x4 BGRA8 DDS, the simplest file bimg parses without a decoder library
+        std::filesystem::path write_test_image() {
+            constexpr uint32_t size = 4;
+            std::array<uint32_t, 32> header{};
+            header[0] = 0x20534444; // "DDS "
+            header[1] = 124;
+            // caps, height, width, pitch and pixel format
+            header[2] = 0x100f;
+            header[3] = size;
+            header[4] = size;
+            header[5] = size * 4;
+            // pixel format: 32 bit rgb with alpha
+            header[19] = 32;
+            header[20] = 0x41;
+            header[22] = 32;
+            header[23] = 0x00ff0000;
+            header[24] = 0x0000ff00;
+            header[25] = 0x000000ff;
+            header[26] = 0xff000000;
+            // a plain texture
+            header[27] = 0x1000;
+
+            const std::array<uint32_t, size * size> pixels = [] {
+                std::array<uint32_t, size * size> white{};
+                white.fill(0xffffffff);
+                return white;
+            }();
+
+            const auto directory = std::filesystem::temp_directory_path() / "star_texture_cache_tests";
+            std::filesystem::create_directories(directory);
+            const auto path = directory / "white.dds";
+
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(header.data()), sizeof(header));
+            file.write(reinterpret_cast<const char *>(pixels.data()), sizeof(pixels));
+            return path;
+        }
+    }
+
+    TEST_CASE("TextureCache refuses loads before init", "[render][texture]") {
+        TextureCache cache(1);
+        CHECK(cache.load("textures/missing.png") == nullptr);
+        CHECK(cache.get_size() == 0);
+    }
+
+    TEST_CASE("TextureCache hands out one texture per normalized path", "[render][texture]") {
+        App app;
+        TextureCache cache(1);
+        cache.init(app);
+
+        const auto texture = cache.load("textures/missing.png");
+        REQUIRE(texture);
+        CHECK(cache.load("textures/../textures/./missing.png") == texture);
+        CHECK(cache.load("textures//missing.png") == texture);
+        CHECK(cache.load("textures/other.png") != texture);
+        CHECK(cache.get_size() == 2);
+
+        // a file that can not be read fails and keeps the placeholder bound
+        cache.wait_idle();
+        CHECK(texture->get_state() == TextureState::Failed);
+        CHECK(texture->get_handle().idx == cache.get_placeholder().idx);
+        CHECK(cache.get_loading_count() == 0);
+
+        cache.shutdown();
+        bgfx::frame();
+    }
+
+    TEST_CASE("TextureCache binds the placeholder until the texture is uploaded", "[render][texture]") {
+        App app;
+        TextureCache cache(1);
+        cache.init(app);
+        REQUIRE(bgfx::isValid(cache.get_placeholder()));
+
+        const auto texture = cache.load(write_test_image().string());
+        REQUIRE(texture);
+
+        // decoded on the worker, but nothing reaches bgfx before the upload
+        cache.wait_idle();
+        CHECK(texture->get_state() == TextureState::Loading);
+        CHECK(texture->get_handle().idx == cache.get_placeholder().idx);
+        CHECK(cache.get_loading_count() == 1);
+
+        CHECK(cache.upload_pending() == 1);
+        CHECK(texture->is_ready());
+        CHECK(bgfx::isValid(texture->get_handle()));
+        CHECK(texture->get_handle().idx != cache.get_placeholder().idx);
+        CHECK(texture->get_size() == glm::uvec3(4, 4, 1));
+        CHECK(texture->get_mip_count() == 3);
+        CHECK(cache.get_loading_count() == 0);
+
+        cache.shutdown();
+        bgfx::frame();
+    }
+
+    TEST_CASE("TextureCache evicts the textures nobody references", "[render][texture]") {
+        App app;
+        TextureCache cache(1);
+        cache.init(app);
+
+        auto kept = cache.load("textures/kept.png");
+        auto dropped = cache.load("textures/dropped.png");
+        REQUIRE(kept);
+        REQUIRE(dropped);
+        cache.wait_idle();
+
+        CHECK(cache.evict_unused() == 0);
+        CHECK(cache.get_size() == 2);
+
+        dropped.reset();
+        CHECK(cache.evict_unused() == 1);
+        CHECK(cache.get_size() == 1);
+        CHECK(cache.load("textures/kept.png") == kept);
+
+        // a path loaded again after its eviction gets a new texture
+        const auto reloaded = cache.load("textures/dropped.png");
+        REQUIRE(reloaded);
+        CHECK(cache.get_size() == 2);
+
+        cache.shutdown();
+        bgfx::frame();
+    }
+}
@@ -0,0 +1,52 @@
+#include "star/scene/scene.hpp"
+#include "star/app/app.hpp"
+#include "star/render/renderer_components.hpp"
+#include "star/scene/bounds.hpp"
+#include "star/scene/transform.hpp"
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+
+namespace star {
+    namespace {
+        bool near(const glm::vec3 &a, const glm::vec3 &b) {
+            return glm::all(glm::lessThan(glm::abs(a - b), glm::vec3(1e-4f)));
+        }
+    }
+
+    TEST_CASE("Scene keeps the world bounds current while paused", "[scene]") {
+        App app;
+        Scene scene;
+        scene.init(app);
+
+        const std::vector<Vertex> vertices{
+            {{-1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, glm::vec2(0.0f), glm::vec4(1.0f)},
+            {{1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, glm::vec2(0.0f), glm::vec4(1.0f)},
+            {{0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}, glm::vec2(0.0f), glm::vec4(1.0f)},
+        };
+        const auto mesh = std::make_shared<Mesh>();
+        REQUIRE(mesh->create(vertices));
+        const glm::vec3 center = mesh->get_bounding_sphere().center;
+
+        const Entity entity = scene.create_entity();
+        scene.add_component<Transform>(entity);
+        scene.add_component<MeshRenderer>(entity).set_mesh(mesh);
+
+        scene.update(0.0f);
+        const auto *bounds = scene.get_component<WorldBounds>(entity);
+        REQUIRE(bounds);
+        CHECK(near(bounds->get_sphere().center, center));
+
+        // a paused scene skips its components, the culling bounds still follow the transform
+        scene.set_paused(true);
+        scene.get_registry().get<Transform>(entity).set_position(glm::vec3(10.0f, 0.0f, 0.0f));
+        scene.update(0.0f);
+        bounds = scene.get_component<WorldBounds>(entity);
+        REQUIRE(bounds);
+        CHECK(bounds->is_valid());
+        CHECK(near(bounds->get_sphere().center, center + glm::vec3(10.0f, 0.0f, 0.0f)));
+
+        scene.shutdown();
+        bgfx::frame();
+    }
+}